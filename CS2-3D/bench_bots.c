@@ -0,0 +1,70 @@
+#include "world.h"
+#include "../common/jobs.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Bot load test: the world full of bots fighting autopilot players, run with
+// the job system at 1, 2, 4... threads. Reports the tick time and how many
+// bots one core could run at 64 Hz, and checks that every thread count ends
+// in exactly the same world.
+// Usage: bench_bots [bots] [ticks] [max threads] [players]
+
+static uint64_t TargetChecksum(const World *world) {
+    uint64_t hash = 1469598103934665603ull;
+    for (int i = 0; i < world->botCount; i++) {
+        const Target *t = &world->targets[i];
+        uint64_t values[] = { (uint64_t)(int64_t)(t->position.x*1000.0f), (uint64_t)(int64_t)(t->position.z*1000.0f), (uint64_t)t->health };
+        for (int v = 0; v < 3; v++) hash = (hash ^ values[v])*1099511628211ull;
+    }
+    for (int i = 0; i < world->playerCount; i++) hash = (hash ^ (uint64_t)world->players[i].health)*1099511628211ull;
+    return hash;
+}
+
+int main(int argc, char **argv) {
+    int bots = (argc > 1) ? atoi(argv[1]) : MAX_TARGETS;
+    int ticks = (argc > 2) ? atoi(argv[2]) : 2000;
+    int maxThreads = (argc > 3) ? atoi(argv[3]) : JobSystemCoreCount();
+    int players = (argc > 4) ? atoi(argv[4]) : 16;
+    if (bots > MAX_TARGETS) bots = MAX_TARGETS;
+    if (players > MAX_PLAYERS) players = MAX_PLAYERS;
+
+    static World world;
+    static PlayerInput inputs[MAX_PLAYERS];
+    printf("%d bots, %d players, %d ticks, %d cores\n", bots, players, ticks, JobSystemCoreCount());
+
+    uint64_t expected = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        WorldInit(&world, 9);
+        WorldSetBots(&world, bots);
+        for (int i = 0; i < players; i++) WorldAddPlayer(&world, "Bot");
+        JobSystem *jobs = JobSystemCreate(threads);
+        world.jobs = jobs;
+
+        long long steals = JobSystemSteals(jobs);
+        double elapsed = 0.0;
+        for (int t = 0; t < ticks; t++) {
+            for (int i = 0; i < world.playerCount; i++) inputs[i] = WorldAutopilot(&world, i);
+            double start = BenchNowSeconds();
+            WorldStep(&world, inputs, WORLD_DT);
+            elapsed += BenchNowSeconds() - start;
+        }
+        steals = JobSystemSteals(jobs) - steals;
+
+        uint64_t checksum = TargetChecksum(&world);
+        if (threads == 1) expected = checksum;
+        double tickMs = elapsed*1e3/ticks;
+        // Threads past the core count share cores, so they add no capacity
+        int cores = JobSystemCoreCount();
+        if (cores > JobSystemSize(jobs)) cores = JobSystemSize(jobs);
+        double botsPerCore = (double)bots*(1000.0/WORLD_TICK_RATE)/tickMs/cores;
+        printf("  %2d threads: %.3f ms per tick, %.0f bots per core at %d Hz, %.1f steals per tick%s\n",
+               threads, tickMs, botsPerCore, WORLD_TICK_RATE, (double)steals/ticks, checksum == expected ? "" : "  MISMATCH");
+        fflush(stdout);
+
+        WorldFree(&world);
+        JobSystemDestroy(jobs);
+        if (checksum != expected) return 1;
+    }
+    return 0;
+}
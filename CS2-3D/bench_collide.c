@@ -0,0 +1,147 @@
+#include "collide.h"
+#include "raymath.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Moving boxes against generated maps: 1000 bodies walking, jumping and
+// falling for a few seconds of 64 Hz ticks. A sample of bodies is replayed
+// with every wall tested instead of the BVH broadphase, and no body may end
+// inside a wall.
+// Usage: bench_collide [bodies] [ticks]
+
+static unsigned int benchSeed = 12345;
+
+typedef struct {
+    Vector3 position;
+    Vector3 velocity;
+} Body;
+
+static const Vector3 bodyHalf = { 0.3f, 1.05f, 0.3f };
+
+// MoveAndSlide with SweepBoxLinear as the only collision query
+static Vector3 MoveAndSlideLinear(const Wall *walls, int wallCount, Vector3 center, Vector3 motion, bool *floor) {
+    for (int slide = 0; slide < COLLIDE_MAX_SLIDES; slide++) {
+        if (Vector3LengthSqr(motion) == 0.0f) break;
+        float t;
+        Vector3 normal;
+        if (!SweepBoxLinear(walls, wallCount, center, bodyHalf, motion, &t, &normal)) return Vector3Add(center, motion);
+        center = Vector3Add(Vector3Add(center, Vector3Scale(motion, t)), Vector3Scale(normal, COLLIDE_SKIN));
+        if (normal.y > 0.7f) *floor = true;
+        motion = Vector3Scale(motion, 1.0f - t);
+        motion = Vector3Subtract(motion, Vector3Scale(normal, Vector3DotProduct(motion, normal)));
+    }
+    return center;
+}
+
+static void StepBody(Body *b, Vector3 moved, bool floor, int tick, int index, float dt) {
+    b->position = moved;
+    if (floor) b->velocity.y = 0.0f;
+    b->velocity.y -= 18.0f*dt;
+    if (floor && (tick + index) % 50 == 0) b->velocity.y = 8.0f;
+}
+
+static bool InsideAnyWall(const Wall *walls, int wallCount, Vector3 center) {
+    for (int i = 0; i < wallCount; i++) {
+        Vector3 d = Vector3Subtract(center, walls[i].position);
+        // A little tolerance for the skin and float rounding
+        if (fabsf(d.x) < walls[i].size.x*0.5f + bodyHalf.x - 1e-3f &&
+            fabsf(d.y) < walls[i].size.y*0.5f + bodyHalf.y - 1e-3f &&
+            fabsf(d.z) < walls[i].size.z*0.5f + bodyHalf.z - 1e-3f) return true;
+    }
+    return false;
+}
+
+static bool Run(int wallCount, int bodyCount, int ticks, bool compare) {
+    benchSeed = 12345;
+    float half = sqrtf((float)wallCount*16.0f)*0.5f;
+    Wall *walls = malloc(wallCount*sizeof(Wall));
+    BoundingBox *boxes = malloc(wallCount*sizeof(BoundingBox));
+    walls[0] = (Wall){ (Vector3){ 0, -0.5f, 0 }, (Vector3){ half*2, 1, half*2 }, GRAY, DARKGRAY };
+    for (int i = 1; i < wallCount; i++) {
+        Vector3 size = { BenchRandomFloat(&benchSeed, 0.5f, 4), BenchRandomFloat(&benchSeed, 0.5f, 3), BenchRandomFloat(&benchSeed, 0.5f, 4) };
+        walls[i] = (Wall){ (Vector3){ BenchRandomFloat(&benchSeed, -half, half), size.y*0.5f, BenchRandomFloat(&benchSeed, -half, half) }, size, GRAY, DARKGRAY };
+    }
+    for (int i = 0; i < wallCount; i++) {
+        boxes[i] = (BoundingBox){ Vector3Subtract(walls[i].position, Vector3Scale(walls[i].size, 0.5f)),
+                                  Vector3Add(walls[i].position, Vector3Scale(walls[i].size, 0.5f)) };
+    }
+    Bvh bvh = { 0 };
+    if (!BvhBuild(&bvh, boxes, wallCount)) {
+        fprintf(stderr, "out of memory building the wall BVH\n");
+        free(boxes);
+        free(walls);
+        return false;
+    }
+
+    // Bodies start high enough to clear every wall and fall onto the map
+    Body *bodies = malloc(bodyCount*sizeof(Body));
+    Body *reference = malloc(bodyCount*sizeof(Body));
+    for (int i = 0; i < bodyCount; i++) {
+        float angle = BenchRandomFloat(&benchSeed, 0, 2*PI);
+        bodies[i].position = (Vector3){ BenchRandomFloat(&benchSeed, -half, half)*0.9f, BenchRandomFloat(&benchSeed, 4.5f, 8), BenchRandomFloat(&benchSeed, -half, half)*0.9f };
+        bodies[i].velocity = (Vector3){ 6.0f*sinf(angle), 0, 6.0f*cosf(angle) };
+    }
+    memcpy(reference, bodies, bodyCount*sizeof(Body));
+
+    const float dt = 1.0f/64.0f;
+    double start = BenchNowSeconds();
+    for (int t = 0; t < ticks; t++) {
+        for (int i = 0; i < bodyCount; i++) {
+            MoveResult move = MoveAndSlide(&bvh, walls, bodies[i].position, bodyHalf, Vector3Scale(bodies[i].velocity, dt));
+            StepBody(&bodies[i], move.position, move.hitFloor, t, i, dt);
+        }
+    }
+    double fast = BenchNowSeconds() - start;
+    double moves = (double)ticks*bodyCount;
+
+    int inside = 0;
+    for (int i = 0; i < bodyCount; i++) inside += InsideAnyWall(walls, wallCount, bodies[i].position);
+
+    printf("%7d walls: %7.0f ns per move, %6.2f ms per tick for %d bodies, %d inside walls",
+           wallCount, fast*1e9/moves, fast*1e3/ticks, bodyCount, inside);
+
+    // The brute-force replay is slow, so it only covers a sample
+    if (compare) {
+        int sample = bodyCount < 100 ? bodyCount : 100;
+        memcpy(bodies, reference, sample*sizeof(Body));
+        for (int t = 0; t < ticks; t++) {
+            for (int i = 0; i < sample; i++) {
+                MoveResult move = MoveAndSlide(&bvh, walls, bodies[i].position, bodyHalf, Vector3Scale(bodies[i].velocity, dt));
+                StepBody(&bodies[i], move.position, move.hitFloor, t, i, dt);
+            }
+        }
+        start = BenchNowSeconds();
+        for (int t = 0; t < ticks; t++) {
+            for (int i = 0; i < sample; i++) {
+                bool floor = false;
+                Vector3 moved = MoveAndSlideLinear(walls, wallCount, reference[i].position, Vector3Scale(reference[i].velocity, dt), &floor);
+                StepBody(&reference[i], moved, floor, t, i, dt);
+            }
+        }
+        double linear = BenchNowSeconds() - start;
+        int diverged = 0;
+        for (int i = 0; i < sample; i++) diverged += Vector3Distance(bodies[i].position, reference[i].position) > 1e-3f;
+        printf("\n               every wall: %7.0f ns per move (%.0fx slower), %d of %d bodies diverged",
+               linear*1e9/((double)ticks*sample), linear*moves/(fast*ticks*sample), diverged, sample);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    BvhFree(&bvh);
+    free(reference);
+    free(bodies);
+    free(boxes);
+    free(walls);
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int bodyCount = (argc > 1) ? atoi(argv[1]) : 1000;
+    int ticks = (argc > 2) ? atoi(argv[2]) : 320;
+
+    // The cost per move should stay flat as the map grows
+    if (!Run(1000, bodyCount, ticks, false) || !Run(10000, bodyCount, ticks, true) || !Run(100000, bodyCount, ticks, false)) return 1;
+    return 0;
+}
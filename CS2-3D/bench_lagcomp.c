@@ -0,0 +1,108 @@
+#include "lagcomp.h"
+#include "raymath.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Rewound shots against moving targets: checks CastShotRewound against the
+// brute-force CastShotLinear on targets placed where the history says they
+// were, then measures how many rewound shots fit in one 64 Hz tick.
+// Usage: bench_lagcomp [shots]
+
+static unsigned int benchSeed = 12345;
+
+#define TICKS 200
+
+// Targets strafe along x; one dies part way through
+static Vector3 TargetPosition(int target, float tick) {
+    float z = -15.0f + 3.0f*(float)target;
+    float x = 12.0f*sinf(tick*0.05f + (float)target);
+    return (Vector3){ x, 0.0f, z };
+}
+
+static bool TargetAlive(int target, int tick) {
+    return !(target == 3 && tick > TICKS - 10);
+}
+
+static void PlaceTargets(Target *targets, int tick) {
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        targets[i].position = TargetPosition(i, (float)tick);
+        targets[i].active = true;
+        targets[i].health = TargetAlive(i, tick) ? 100 : 0;
+    }
+}
+
+static bool SameShot(ShotHit a, ShotHit b) {
+    if (a.kind != b.kind) return false;
+    if (a.kind == SHOT_MISS) return true;
+    return a.index == b.index || fabsf(a.collision.distance - b.collision.distance) < 1e-3f;
+}
+
+static Ray RandomShot(void) {
+    Ray ray;
+    ray.position = (Vector3){ BenchRandomFloat(&benchSeed, -5, 5), 1.5f, 20.0f };
+    ray.direction = Vector3Normalize((Vector3){ BenchRandomFloat(&benchSeed, -0.6f, 0.6f), BenchRandomFloat(&benchSeed, -0.08f, 0.02f), -1.0f });
+    return ray;
+}
+
+int main(int argc, char **argv) {
+    int shots = (argc > 1) ? atoi(argv[1]) : 1000000;
+
+    // A few walls between the shooter and the targets
+    BoundingBox walls[4] = {
+        { { -30, -1, -30 }, { 30, 0, 30 } },
+        { { -8, 0, 2 }, { -4, 3, 3 } },
+        { { 3, 0, -4 }, { 6, 2, -3 } },
+        { { -1, 0, 8 }, { 1, 1, 9 } },
+    };
+    Wall wallList[4];
+    for (int i = 0; i < 4; i++) {
+        wallList[i].position = Vector3Scale(Vector3Add(walls[i].min, walls[i].max), 0.5f);
+        wallList[i].size = Vector3Subtract(walls[i].max, walls[i].min);
+    }
+    Bvh bvh = { 0 };
+    if (!BvhBuild(&bvh, walls, 4)) {
+        fprintf(stderr, "out of memory building the wall BVH\n");
+        return 1;
+    }
+
+    static LagHistory history;
+    Target targets[MAX_TARGETS];
+    LagHistoryClear(&history);
+    for (int tick = 1; tick <= TICKS; tick++) {
+        PlaceTargets(targets, tick);
+        LagHistoryRecord(&history, (uint32_t)tick, targets);
+    }
+
+    // Correctness at whole ticks, where no interpolation is involved
+    int checks = 20000, mismatches = 0;
+    for (int i = 0; i < checks; i++) {
+        int tick = TICKS - (int)BenchRandomFloat(&benchSeed, 0, LAG_HISTORY_TICKS - 1);
+        Ray ray = RandomShot();
+        LagFrame frame;
+        LagHistoryRewind(&history, (uint32_t)tick, 0.0f, &frame);
+        PlaceTargets(targets, tick);
+        ShotHit rewound = CastShotRewound(&bvh, &frame, ray, 1000.0f);
+        ShotHit linear = CastShotLinear(wallList, 4, targets, MAX_TARGETS, ray, 1000.0f);
+        if (!SameShot(rewound, linear)) mismatches++;
+    }
+
+    int hits = 0;
+    double start = BenchNowSeconds();
+    for (int i = 0; i < shots; i++) {
+        uint32_t tick = (uint32_t)(TICKS - (int)BenchRandomFloat(&benchSeed, 0, LAG_HISTORY_TICKS + 4));
+        LagFrame frame;
+        LagHistoryRewind(&history, tick, BenchRandomFloat(&benchSeed, 0, 1), &frame);
+        ShotHit shot = CastShotRewound(&bvh, &frame, RandomShot(), 1000.0f);
+        hits += (shot.kind == SHOT_HEAD || shot.kind == SHOT_BODY);
+    }
+    double elapsed = BenchNowSeconds() - start;
+
+    printf("history: %d ticks, %zu bytes\n", LAG_HISTORY_TICKS, sizeof(LagHistory));
+    printf("rewound shots: %.0f/s (%.0f ns each), %.0f per 64 Hz tick\n", shots/elapsed, elapsed*1e9/shots, shots/elapsed/64.0);
+    printf("target hits: %d / %d\n", hits, shots);
+    printf("mismatches vs linear: %d / %d\n", mismatches, checks);
+
+    BvhFree(&bvh);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+#include "mapfile.h"
+#include "raymath.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Map startup cost: reading the text form and building the BVH, as a loader
+// without a compiled format would, against opening the compiled map. Both
+// must answer the same raycasts.
+// Usage: bench_map [walls]
+
+static unsigned int benchSeed = 12345;
+
+int main(int argc, char **argv) {
+    int count = (argc > 1) ? atoi(argv[1]) : 100000;
+    const char *textPath = "bench_map.txt";
+    const char *mapPath = "bench_map.map";
+
+    float half = sqrtf((float)count*16.0f)*0.5f;
+    FILE *file = fopen(textPath, "w");
+    if (!file) return 1;
+    fprintf(file, "wall 0 -0.5 0 %.1f 1 %.1f 505050\n", half*2, half*2);
+    for (int i = 1; i < count; i++) {
+        fprintf(file, "wall %.2f %.2f %.2f %.2f %.2f %.2f 808080\n", BenchRandomFloat(&benchSeed, -half, half), BenchRandomFloat(&benchSeed, 0.25f, 3),
+                BenchRandomFloat(&benchSeed, -half, half), BenchRandomFloat(&benchSeed, 0.5f, 4), BenchRandomFloat(&benchSeed, 0.5f, 6), BenchRandomFloat(&benchSeed, 0.5f, 4));
+    }
+    fprintf(file, "spawn 0 0 0 0\n");
+    fclose(file);
+
+    // Text: parse every line, then build the BVH
+    double start = BenchNowSeconds();
+    Wall *walls;
+    MapSpawn *spawns;
+    int wallCount, spawnCount;
+    char error[160];
+    if (!MapLoadText(textPath, &walls, &wallCount, &spawns, &spawnCount, error, sizeof(error))) {
+        fprintf(stderr, "%s\n", error);
+        return 1;
+    }
+    double parsed = BenchNowSeconds();
+    BoundingBox *boxes = malloc(wallCount*sizeof(BoundingBox));
+    for (int i = 0; i < wallCount; i++) {
+        Vector3 h = Vector3Scale(walls[i].size, 0.5f);
+        boxes[i] = (BoundingBox){ Vector3Subtract(walls[i].position, h), Vector3Add(walls[i].position, h) };
+    }
+    Bvh built = { 0 };
+    if (!BvhBuild(&built, boxes, wallCount)) {
+        fprintf(stderr, "out of memory building the wall BVH\n");
+        return 1;
+    }
+    double textTime = BenchNowSeconds() - start;
+    double parseTime = parsed - start;
+
+    start = BenchNowSeconds();
+    if (!MapFileWrite(mapPath, walls, wallCount, spawns, spawnCount)) return 1;
+    double writeTime = BenchNowSeconds() - start;
+
+    // Compiled: map the file; the first raycast then only touches the pages it needs
+    const int opens = 20;
+    MapFile map;
+    double openTime = 0.0;
+    for (int i = 0; i < opens; i++) {
+        start = BenchNowSeconds();
+        if (!MapFileOpen(&map, mapPath, error, sizeof(error))) {
+            fprintf(stderr, "%s\n", error);
+            return 1;
+        }
+        openTime += BenchNowSeconds() - start;
+        if (i < opens - 1) MapFileClose(&map);
+    }
+    openTime /= opens;
+
+    int rays = 20000, mismatches = 0;
+    for (int i = 0; i < rays; i++) {
+        Ray ray = { (Vector3){ BenchRandomFloat(&benchSeed, -half, half), 2.0f, BenchRandomFloat(&benchSeed, -half, half) },
+                    Vector3Normalize((Vector3){ BenchRandomFloat(&benchSeed, -1, 1), BenchRandomFloat(&benchSeed, -0.2f, 0.05f), BenchRandomFloat(&benchSeed, -1, 1) }) };
+        RayCollision a, b;
+        int itemA = -1, itemB = -1;
+        bool hitA = BvhRaycast(&built, ray, 1000.0f, &a, &itemA);
+        bool hitB = BvhRaycast(&map.bvh, ray, 1000.0f, &b, &itemB);
+        if (hitA != hitB || itemA != itemB) mismatches++;
+    }
+
+    printf("walls: %d  file: %.1f MB  bvh nodes: %d\n", map.wallCount, map.size/1048576.0, map.bvh.nodeCount);
+    printf("text + bvh build: %8.2f ms (parse %.2f ms)\n", textTime*1e3, parseTime*1e3);
+    printf("compile + write:  %8.2f ms\n", writeTime*1e3);
+    printf("open compiled:    %8.3f ms (average of %d, includes validation)\n", openTime*1e3, opens);
+    printf("raycast mismatches: %d / %d\n", mismatches, rays);
+
+    MapFileClose(&map);
+    BvhFree(&built);
+    free(boxes);
+    free(walls);
+    free(spawns);
+    remove(textPath);
+    remove(mapPath);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+#include "navgrid.h"
+#include "raymath.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Path queries on a large generated map: plain A* against the hierarchical
+// search, the LRU cache on a workload that repeats itself, and one shared
+// flow field against a path per agent for a crowd heading to the same spot.
+// Usage: bench_nav [walls] [queries] [map size]
+
+#define FLAT_QUERIES 200
+#define CACHE_PAIRS 512
+#define CROWD 1000
+#define CROWD_TICKS 64
+
+static unsigned int seed = 12345;
+
+static Vector3 RandomOpenPoint(const NavGrid *nav, float half) {
+    for (;;) {
+        Vector3 p = { BenchRandomFloat(&seed, -half, half), 0.0f, BenchRandomFloat(&seed, -half, half) };
+        if (NavWalkable(nav, NavCellAt(nav, p))) return NavCellCenter(nav, NavCellAt(nav, p));
+    }
+}
+
+static float PathLength(const Vector3 *points, int count) {
+    float length = 0.0f;
+    for (int i = 1; i < count; i++) length += Vector3Distance(points[i - 1], points[i]);
+    return length;
+}
+
+int main(int argc, char **argv) {
+    int wallCount = (argc > 1) ? atoi(argv[1]) : 8000;
+    int queries = (argc > 2) ? atoi(argv[2]) : 5000;
+    float half = ((argc > 3) ? (float)atof(argv[3]) : 512.0f)*0.5f;
+    if (wallCount < 1) wallCount = 1;
+
+    // A floor, scattered boxes and some long walls to route around
+    Wall *walls = malloc(wallCount*sizeof(Wall));
+    walls[0] = (Wall){ (Vector3){ 0, -0.5f, 0 }, (Vector3){ half*2, 1, half*2 }, GRAY, DARKGRAY };
+    for (int i = 1; i < wallCount; i++) {
+        Vector3 size = { BenchRandomFloat(&seed, 0.5f, 4), BenchRandomFloat(&seed, 0.5f, 6), BenchRandomFloat(&seed, 0.5f, 4) };
+        if (i % 100 == 0) {
+            if (i % 200 == 0) size.x = BenchRandomFloat(&seed, 40, 120);
+            else size.z = BenchRandomFloat(&seed, 40, 120);
+            size.y = 4.0f;
+        }
+        walls[i] = (Wall){ (Vector3){ BenchRandomFloat(&seed, -half, half), size.y*0.5f, BenchRandomFloat(&seed, -half, half) }, size, GRAY, DARKGRAY };
+    }
+
+    static NavGrid nav;
+    double start = BenchNowSeconds();
+    if (!NavGridBuild(&nav, walls, wallCount)) {
+        fprintf(stderr, "out of memory building the nav grid\n");
+        return 1;
+    }
+    double buildMs = (BenchNowSeconds() - start)*1e3;
+    int cells = nav.cellsX*nav.cellsZ, blocked = 0;
+    for (int i = 0; i < cells; i++) blocked += nav.blocked[i];
+    printf("%d walls, %dx%d cells (%.0f%% blocked), %d entrances, %d edges, built in %.1f ms\n",
+           wallCount, nav.cellsX, nav.cellsZ, 100.0*blocked/cells, nav.nodeCount, nav.edgeCount, buildMs);
+
+    Vector3 *from = malloc(queries*sizeof(Vector3));
+    Vector3 *to = malloc(queries*sizeof(Vector3));
+    for (int i = 0; i < queries; i++) {
+        from[i] = RandomOpenPoint(&nav, half);
+        to[i] = RandomOpenPoint(&nav, half);
+    }
+    static Vector3 points[NAV_MAX_CELLS_PER_AXIS*4];
+    int maxPoints = NAV_MAX_CELLS_PER_AXIS*4;
+
+    // Plain A* on the first few, keeping the lengths to rate the other
+    int flatQueries = (queries < FLAT_QUERIES) ? queries : FLAT_QUERIES;
+    float flatLength[FLAT_QUERIES];
+    start = BenchNowSeconds();
+    for (int i = 0; i < flatQueries; i++) {
+        int count = NavFindPathFlat(&nav, from[i], to[i], points, maxPoints);
+        flatLength[i] = count ? PathLength(points, count) : -1.0f;
+    }
+    double flatSeconds = BenchNowSeconds() - start;
+
+    int found = 0, missing = 0, compared = 0;
+    double longer = 0.0;
+    start = BenchNowSeconds();
+    for (int i = 0; i < queries; i++) {
+        int count = NavFindPath(&nav, from[i], to[i], points, maxPoints);
+        found += count > 0;
+        if (i >= flatQueries || flatLength[i] < 0.0f) continue;
+        if (count == 0) {
+            missing++;
+        } else if (flatLength[i] > 0.0f) {
+            longer += PathLength(points, count)/flatLength[i] - 1.0;
+            compared++;
+        }
+    }
+    double hpaSeconds = BenchNowSeconds() - start;
+    printf("  flat A*:         %9.0f queries/s\n", flatQueries/flatSeconds);
+    printf("  hierarchical A*: %9.0f queries/s (%.1fx), %d of %d found, paths %.1f%% longer%s\n",
+           queries/hpaSeconds, (queries/hpaSeconds)/(flatQueries/flatSeconds), found, queries,
+           compared ? 100.0*longer/compared : 0.0, missing ? "  MISSING PATHS" : "");
+
+    // Agents going back and forth between a few hundred spots
+    start = BenchNowSeconds();
+    for (int i = 0; i < queries; i++) {
+        int pair = (int)BenchRandomFloat(&seed, 0, CACHE_PAIRS - 1);
+        NavCachedPath(&nav, from[pair % queries], to[pair % queries], points, NAV_CACHED_POINTS);
+    }
+    double cacheSeconds = BenchNowSeconds() - start;
+    printf("  cached:          %9.0f queries/s, %.0f%% hits\n",
+           queries/cacheSeconds, 100.0*nav.cacheHits/(double)(nav.cacheHits + nav.cacheMisses));
+
+    // A crowd around one goal: a field for it, then every agent reads it each tick
+    Vector3 goal = RandomOpenPoint(&nav, half*0.5f);
+    float reach = NAV_FLOW_RADIUS*nav.cellSize;
+    static Vector3 crowd[CROWD];
+    for (int i = 0; i < CROWD; i++) {
+        do {
+            crowd[i] = (Vector3){ goal.x + BenchRandomFloat(&seed, -reach, reach), 0.0f, goal.z + BenchRandomFloat(&seed, -reach, reach) };
+        } while (!NavWalkable(&nav, NavCellAt(&nav, crowd[i])));
+    }
+    start = BenchNowSeconds();
+    const NavFlowField *field = NavFlowTo(&nav, NavCellAt(&nav, goal), 0);
+    double fieldMs = (BenchNowSeconds() - start)*1e3;
+
+    int steering = 0;
+    start = BenchNowSeconds();
+    for (int tick = 0; tick < CROWD_TICKS; tick++) {
+        field = NavFlowTo(&nav, NavCellAt(&nav, goal), 0);
+        for (int i = 0; i < CROWD; i++) steering += Vector3LengthSqr(NavFlowDirection(&nav, field, crowd[i])) > 0.0f;
+    }
+    double flowSeconds = BenchNowSeconds() - start;
+
+    start = BenchNowSeconds();
+    for (int i = 0; i < CROWD; i++) NavFindPath(&nav, crowd[i], goal, points, maxPoints);
+    double crowdSeconds = BenchNowSeconds() - start;
+    printf("  flow field:      %.2f ms to build, %.0f agent lookups/s (%d of %d agents steered)\n",
+           fieldMs, (double)CROWD*CROWD_TICKS/flowSeconds, steering/CROWD_TICKS, CROWD);
+    printf("  path per agent:  %.2f ms for the crowd, the field is %.0fx cheaper for a tick\n",
+           crowdSeconds*1e3, crowdSeconds*1e3/(fieldMs + flowSeconds*1e3/CROWD_TICKS));
+
+    NavGridFree(&nav);
+    free(from);
+    free(to);
+    free(walls);
+    return missing ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+#include "particles.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Particle update cost for the old fixed array with an active flag (scans for
+// a free slot on every spawn, walks every slot on every update), a packed
+// array of structs with one branchy loop, and the bucketed SoA pool at each
+// SIMD level. The SoA levels are also checked against each other.
+// Usage: bench_particles [ticks]
+
+typedef struct {
+    Vector3 position;
+    Vector3 velocity;
+    Color color;
+    float size;
+    float life;
+    ParticleType type;
+} Particle;
+
+static void UpdateParticle(Particle *p, float dt) {
+    p->life -= dt;
+    p->position.x += p->velocity.x*dt;
+    p->position.y += p->velocity.y*dt;
+    p->position.z += p->velocity.z*dt;
+
+    if (p->type == PARTICLE_BLOOD) {
+        p->velocity.y -= GRAVITY*dt;
+    } else if (p->type == PARTICLE_EXPLOSION) {
+        p->size += dt*10.0f;
+        float a = p->life*255.0f*5.0f;
+        p->color.a = (unsigned char)(a < 0.0f ? 0.0f : (a > 255.0f ? 255.0f : a));
+    } else if (p->type == PARTICLE_SMOKE) {
+        p->velocity.y += 2.0f*dt;
+        p->size += dt*2.0f;
+    }
+}
+
+#define LEGACY_CAPACITY 131072
+#define BENCH_CAPACITY (1 << 20)
+
+static Particle legacy[LEGACY_CAPACITY];
+static bool legacyActive[LEGACY_CAPACITY];
+static int legacyCount;
+
+static void LegacySpawn(Particle particle) {
+    for (int i = 0; i < LEGACY_CAPACITY; i++) {
+        if (!legacyActive[i]) {
+            legacy[i] = particle;
+            legacyActive[i] = true;
+            legacyCount++;
+            return;
+        }
+    }
+}
+
+static void LegacyUpdate(float dt) {
+    for (int i = 0; i < LEGACY_CAPACITY; i++) {
+        if (!legacyActive[i]) continue;
+        UpdateParticle(&legacy[i], dt);
+        if (legacy[i].life <= 0) { legacyActive[i] = false; legacyCount--; }
+    }
+}
+
+static Particle *aos;
+static int aosCount;
+
+static void AosSpawn(Particle particle) {
+    aos[aosCount++] = particle;
+}
+
+static void AosUpdate(float dt) {
+    int i = 0;
+    while (i < aosCount) {
+        UpdateParticle(&aos[i], dt);
+        if (aos[i].life <= 0) aos[i] = aos[--aosCount];
+        else i++;
+    }
+}
+
+static ParticlePool pool;
+
+static void PoolSpawn(Particle p) {
+    ParticlePoolSpawn(&pool, p.position, p.velocity, p.color, p.size, p.life, p.type);
+}
+
+static void PoolUpdate(float dt) {
+    ParticlePoolUpdate(&pool, dt);
+}
+
+static int LegacyLive(void) { return legacyCount; }
+static int AosLive(void) { return aosCount; }
+static int PoolLive(void) { return pool.count; }
+
+static unsigned int benchSeed;
+
+// Lifetimes of 0.2-2 s at 64 Hz, so a few percent of particles die and get
+// replaced every tick, like a busy firefight
+#define BENCH_DT (1.0f/64.0f)
+
+static Particle RandomParticle(void) {
+    Particle p;
+    p.position = (Vector3){ BenchRandomFloat(&benchSeed, -30, 30), BenchRandomFloat(&benchSeed, 0, 3), BenchRandomFloat(&benchSeed, -30, 30) };
+    p.velocity = (Vector3){ BenchRandomFloat(&benchSeed, -5, 5), BenchRandomFloat(&benchSeed, -5, 5), BenchRandomFloat(&benchSeed, -5, 5) };
+    p.color = ORANGE;
+    p.size = 0.2f;
+    p.life = BenchRandomFloat(&benchSeed, 0.2f, 2.0f);
+    p.type = (ParticleType)(benchSeed & 3);
+    return p;
+}
+
+typedef struct {
+    void (*spawn)(Particle p);
+    void (*update)(float dt);
+    int (*live)(void);
+} Store;
+
+typedef struct {
+    double spawnNs;
+    double tickUs;
+} StoreResult;
+
+// Update time only; respawning back up to the live count is not timed
+static StoreResult Run(Store store, int live, int ticks) {
+    StoreResult result;
+    benchSeed = 777;
+
+    double start = BenchNowSeconds();
+    for (int i = 0; i < live; i++) store.spawn(RandomParticle());
+    result.spawnNs = (BenchNowSeconds() - start)*1e9/live;
+
+    double updateTime = 0.0;
+    for (int t = 0; t < ticks; t++) {
+        start = BenchNowSeconds();
+        store.update(BENCH_DT);
+        updateTime += BenchNowSeconds() - start;
+        while (store.live() < live) store.spawn(RandomParticle());
+    }
+    result.tickUs = updateTime*1e6/ticks;
+    return result;
+}
+
+static bool SameBuckets(const ParticlePool *a, const ParticlePool *b) {
+    for (int t = 0; t < PARTICLE_TYPE_COUNT; t++) {
+        const ParticleBucket *x = &a->buckets[t], *y = &b->buckets[t];
+        int n = x->count;
+        if (n != y->count) return false;
+        if (n == 0) continue;
+        if (memcmp(x->x, y->x, n*sizeof(float)) || memcmp(x->y, y->y, n*sizeof(float)) || memcmp(x->z, y->z, n*sizeof(float)) ||
+            memcmp(x->vx, y->vx, n*sizeof(float)) || memcmp(x->vy, y->vy, n*sizeof(float)) || memcmp(x->vz, y->vz, n*sizeof(float)) ||
+            memcmp(x->size, y->size, n*sizeof(float)) || memcmp(x->life, y->life, n*sizeof(float)) ||
+            memcmp(x->color, y->color, n*sizeof(Color))) return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int ticks = (argc > 1) ? atoi(argv[1]) : 100;
+    const int sizes[] = { 1000, 10000, 100000, 1000000 };
+    const ParticleSimd levels[] = { PARTICLE_SIMD_SCALAR, PARTICLE_SIMD_SSE2, PARTICLE_SIMD_AVX2 };
+    const int levelCount = (int)(sizeof(levels)/sizeof(levels[0]));
+    ParticleSimd best = ParticleSimdActive();
+
+    aos = malloc(BENCH_CAPACITY*sizeof(Particle));
+    if (!aos) return 1;
+
+    // Parity: every available level must leave the same particles behind
+    int mismatches = 0;
+    ParticlePool reference;
+    ParticlePoolInit(&reference, BENCH_CAPACITY);
+    for (int l = 0; l < levelCount; l++) {
+        if (!ParticleSimdSet(levels[l])) continue;
+        ParticlePoolInit(&pool, BENCH_CAPACITY);
+        Run((Store){ PoolSpawn, PoolUpdate, PoolLive }, 10007, 64);
+        if (l == 0) { ParticlePool swap = reference; reference = pool; pool = swap; }
+        else if (!SameBuckets(&reference, &pool)) { printf("mismatch: %s differs from scalar\n", ParticleSimdName(levels[l])); mismatches++; }
+        ParticlePoolFree(&pool);
+    }
+    ParticlePoolFree(&reference);
+
+    printf("ticks: %d  default kernels: %s\n", ticks, ParticleSimdName(best));
+    printf("%8s  %12s %12s  %12s %12s", "live", "legacy spawn", "pool spawn", "legacy tick", "aos tick");
+    for (int l = 0; l < levelCount; l++) printf(" %9s tick", ParticleSimdName(levels[l]));
+    printf("\n");
+
+    for (int s = 0; s < (int)(sizeof(sizes)/sizeof(sizes[0])); s++) {
+        int live = sizes[s];
+        printf("%8d", live);
+
+        if (live <= LEGACY_CAPACITY) {
+            memset(legacyActive, 0, sizeof(legacyActive));
+            legacyCount = 0;
+            StoreResult old = Run((Store){ LegacySpawn, LegacyUpdate, LegacyLive }, live, ticks);
+            printf("  %9.1f ns", old.spawnNs);
+            ParticleSimdSet(best);
+            ParticlePoolInit(&pool, BENCH_CAPACITY);
+            printf(" %9.1f ns  %9.1f us", Run((Store){ PoolSpawn, PoolUpdate, PoolLive }, live, 1).spawnNs, old.tickUs);
+            ParticlePoolFree(&pool);
+        } else {
+            printf("  %12s %12s  %12s", "-", "-", "-");
+        }
+
+        aosCount = 0;
+        printf(" %9.1f us", Run((Store){ AosSpawn, AosUpdate, AosLive }, live, ticks).tickUs);
+
+        for (int l = 0; l < levelCount; l++) {
+            if (!ParticleSimdSet(levels[l])) { printf(" %14s", "n/a"); continue; }
+            ParticlePoolInit(&pool, BENCH_CAPACITY);
+            printf(" %11.1f us", Run((Store){ PoolSpawn, PoolUpdate, PoolLive }, live, ticks).tickUs);
+            ParticlePoolFree(&pool);
+        }
+        printf("\n");
+    }
+
+    free(aos);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+#include "world.h"
+#include "hitscan.h"
+#include "raymath.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Grenade stress test. First the blast query on its own: thousands of targets
+// and explosions, with the target grid against checking every pair. Then the
+// whole world: every tick the pool is topped up to the requested number of
+// live grenades with fuses spread over two seconds, so hundreds go off per
+// second, and WorldStep is timed per projectile.
+// Usage: bench_projectiles [projectiles] [ticks]
+
+static unsigned int benchSeed = 12345;
+
+#define QUERY_TARGETS 4096
+#define QUERY_BLASTS 2000
+#define BLAST_RADIUS 8.0f
+
+static bool BenchBlastQuery(void) {
+    static Target targets[QUERY_TARGETS];
+    static Vector3 blasts[QUERY_BLASTS];
+    static int nearby[QUERY_TARGETS];
+    benchSeed = 12345;
+    for (int i = 0; i < QUERY_TARGETS; i++) {
+        targets[i] = (Target){ (Vector3){ BenchRandomFloat(&benchSeed, -200, 200), 0, BenchRandomFloat(&benchSeed, -200, 200) }, true, 100, 0, 0, i + 1 };
+    }
+    for (int i = 0; i < QUERY_BLASTS; i++) blasts[i] = (Vector3){ BenchRandomFloat(&benchSeed, -200, 200), BenchRandomFloat(&benchSeed, 0, 3), BenchRandomFloat(&benchSeed, -200, 200) };
+
+    TargetGrid grid = { 0 };
+    double start = BenchNowSeconds();
+    if (!BuildTargetGrid(&grid, targets, QUERY_TARGETS)) {
+        fprintf(stderr, "out of memory building the target grid\n");
+        return false;
+    }
+    long long gridHits = 0;
+    for (int b = 0; b < QUERY_BLASTS; b++) {
+        Vector3 reach = { BLAST_RADIUS, BLAST_RADIUS, BLAST_RADIUS };
+        BoundingBox box = { Vector3Subtract(blasts[b], reach), Vector3Add(blasts[b], reach) };
+        int count = TargetGridQueryBox(&grid, box, nearby, QUERY_TARGETS);
+        for (int n = 0; n < count; n++) gridHits += Vector3Distance(targets[nearby[n]].position, blasts[b]) < BLAST_RADIUS;
+    }
+    double gridTime = BenchNowSeconds() - start;
+
+    start = BenchNowSeconds();
+    long long pairHits = 0;
+    for (int b = 0; b < QUERY_BLASTS; b++) {
+        for (int i = 0; i < QUERY_TARGETS; i++) pairHits += Vector3Distance(targets[i].position, blasts[b]) < BLAST_RADIUS;
+    }
+    double pairTime = BenchNowSeconds() - start;
+
+    printf("blasts: %d explosions, %d targets\n", QUERY_BLASTS, QUERY_TARGETS);
+    printf("  grid:      %8.0f ns per explosion (build included), %lld hits\n", gridTime*1e9/QUERY_BLASTS, gridHits);
+    printf("  all pairs: %8.0f ns per explosion (%.0fx slower), %lld hits%s\n",
+           pairTime*1e9/QUERY_BLASTS, pairTime/gridTime, pairHits, pairHits == gridHits ? "" : "  MISMATCH");
+    fflush(stdout);
+    TargetGridFree(&grid);
+    return true;
+}
+
+// Returns how many were thrown; each one goes off once its fuse runs out
+static int TopUp(World *world, int live) {
+    ProjectilePool *pool = &world->projectiles;
+    int thrown = 0;
+    while (pool->count < live) {
+        Projectile *p = ProjectilePoolSpawn(pool);
+        if (!p) break;
+        thrown++;
+        float angle = BenchRandomFloat(&benchSeed, 0, 2*PI);
+        float speed = BenchRandomFloat(&benchSeed, 5, 20);
+        p->position = (Vector3){ BenchRandomFloat(&benchSeed, -25, 25), BenchRandomFloat(&benchSeed, 1, 4), BenchRandomFloat(&benchSeed, -25, 25) };
+        p->previous = p->position;
+        p->velocity = (Vector3){ speed*sinf(angle), BenchRandomFloat(&benchSeed, 0, 8), speed*cosf(angle) };
+        p->halfSize = 0.2f;
+        p->bounce = 0.5f;
+        p->friction = 0.7f;
+        p->timer = BenchRandomFloat(&benchSeed, 0.1f, 2.0f);
+        p->radius = BLAST_RADIUS;
+        p->damage = 80;
+        p->owner = 0;
+        p->weapon = WPN_GRENADE;
+    }
+    return thrown;
+}
+
+static void BenchWorld(int live, int ticks) {
+    static World world;
+    static PlayerInput inputs[MAX_PLAYERS];
+    benchSeed = 12345;
+    WorldInit(&world, 1);
+    WorldAddPlayer(&world, "Player");
+    inputs[0].selectWeapon = -1;
+
+    long long updated = 0;
+    long long thrown = 0;
+    double elapsed = 0.0;
+    for (int t = 0; t < ticks; t++) {
+        thrown += TopUp(&world, live);
+        // Dead targets come back so blasts keep finding some
+        for (int i = 0; i < MAX_TARGETS; i++) {
+            Target *target = &world.targets[i];
+            if (!target->active) *target = (Target){ target->position, true, 100, 0, 0, target->id };
+        }
+
+        updated += world.projectiles.count;
+
+        double start = BenchNowSeconds();
+        WorldStep(&world, inputs, WORLD_DT);
+        elapsed += BenchNowSeconds() - start;
+    }
+
+    printf("world: %d live projectiles, %d ticks\n", live, ticks);
+    printf("  %6.0f ns per projectile per tick, %.3f ms per tick, about %.0f explosions per second\n",
+           elapsed*1e9/(double)updated, elapsed*1e3/ticks, (double)thrown*WORLD_TICK_RATE/ticks);
+    fflush(stdout);
+    WorldFree(&world);
+}
+
+int main(int argc, char **argv) {
+    int live = (argc > 1) ? atoi(argv[1]) : 4000;
+    int ticks = (argc > 2) ? atoi(argv[2]) : 640;
+    if (live > MAX_PROJECTILES) live = MAX_PROJECTILES;
+
+    if (!BenchBlastQuery()) return 1;
+    BenchWorld(live / 10, ticks);
+    BenchWorld(live, ticks);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "hitscan.h"
+#include "raymath.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Shot-ray throughput on generated maps: BVH walls + target grid against the
+// brute-force loop, with a correctness check on a sample of rays.
+// Usage: bench_ray [walls] [targets] [rays]
+
+static unsigned int benchSeed = 12345;
+
+static Ray RandomShot(float half) {
+    Ray ray;
+    ray.position = (Vector3){ BenchRandomFloat(&benchSeed, -half, half), 2.0f, BenchRandomFloat(&benchSeed, -half, half) };
+    ray.direction = Vector3Normalize((Vector3){ BenchRandomFloat(&benchSeed, -1, 1), BenchRandomFloat(&benchSeed, -0.15f, 0.05f), BenchRandomFloat(&benchSeed, -1, 1) });
+    return ray;
+}
+
+static bool SameShot(ShotHit a, ShotHit b) {
+    if (a.kind != b.kind) return false;
+    if (a.kind == SHOT_MISS) return true;
+    return a.index == b.index || fabsf(a.collision.distance - b.collision.distance) < 1e-4f;
+}
+
+int main(int argc, char **argv) {
+    int wallCount = (argc > 1) ? atoi(argv[1]) : 20000;
+    int targetCount = (argc > 2) ? atoi(argv[2]) : 1000;
+    int rayCount = (argc > 3) ? atoi(argv[3]) : 200000;
+
+    // Roughly constant density: a box every 16 square metres
+    float half = sqrtf((float)wallCount*16.0f)*0.5f;
+
+    Wall *walls = malloc(wallCount*sizeof(Wall));
+    BoundingBox *boxes = malloc(wallCount*sizeof(BoundingBox));
+    walls[0] = (Wall){ (Vector3){ 0, -0.5f, 0 }, (Vector3){ half*2, 1, half*2 }, GRAY, DARKGRAY };
+    for (int i = 1; i < wallCount; i++) {
+        Vector3 size = { BenchRandomFloat(&benchSeed, 0.5f, 4), BenchRandomFloat(&benchSeed, 0.5f, 6), BenchRandomFloat(&benchSeed, 0.5f, 4) };
+        walls[i] = (Wall){ (Vector3){ BenchRandomFloat(&benchSeed, -half, half), size.y*0.5f, BenchRandomFloat(&benchSeed, -half, half) }, size, GRAY, DARKGRAY };
+    }
+    for (int i = 0; i < wallCount; i++) {
+        boxes[i] = (BoundingBox){ Vector3Subtract(walls[i].position, Vector3Scale(walls[i].size, 0.5f)),
+                                  Vector3Add(walls[i].position, Vector3Scale(walls[i].size, 0.5f)) };
+    }
+
+    Target *targets = calloc(targetCount, sizeof(Target));
+    for (int i = 0; i < targetCount; i++) {
+        targets[i].position = (Vector3){ BenchRandomFloat(&benchSeed, -half, half), 0, BenchRandomFloat(&benchSeed, -half, half) };
+        targets[i].active = true;
+        targets[i].health = 100;
+    }
+
+    Bvh bvh = { 0 };
+    TargetGrid grid = { 0 };
+
+    double start = BenchNowSeconds();
+    if (!BvhBuild(&bvh, boxes, wallCount)) {
+        fprintf(stderr, "out of memory building the wall BVH\n");
+        return 1;
+    }
+    double buildBvh = BenchNowSeconds() - start;
+
+    start = BenchNowSeconds();
+    if (!BuildTargetGrid(&grid, targets, targetCount)) {
+        fprintf(stderr, "out of memory building the target grid\n");
+        return 1;
+    }
+    double buildGrid = BenchNowSeconds() - start;
+
+    int checkCount = rayCount < 2000 ? rayCount : 2000;
+    int mismatches = 0;
+    benchSeed = 777;
+    start = BenchNowSeconds();
+    for (int i = 0; i < checkCount; i++) {
+        Ray ray = RandomShot(half);
+        ShotHit linear = CastShotLinear(walls, wallCount, targets, targetCount, ray, 1000.0f);
+        ShotHit fast = CastShot(&bvh, &grid, targets, ray, 1000.0f);
+        if (!SameShot(linear, fast)) mismatches++;
+    }
+    double linearTime = BenchNowSeconds() - start;
+
+    int hits[4] = { 0 };
+    benchSeed = 999;
+    start = BenchNowSeconds();
+    for (int i = 0; i < rayCount; i++) {
+        ShotHit shot = CastShot(&bvh, &grid, targets, RandomShot(half), 1000.0f);
+        hits[shot.kind]++;
+    }
+    double fastTime = BenchNowSeconds() - start;
+
+    printf("walls: %d  targets: %d  bvh nodes: %d\n", wallCount, targetCount, bvh.nodeCount);
+    printf("build: bvh %.2f ms, target grid %.3f ms (%dx%d cells)\n", buildBvh*1e3, buildGrid*1e3, grid.cellsX, grid.cellsZ);
+    printf("linear:      %10.0f rays/s (%d rays incl. bvh check)\n", checkCount/linearTime, checkCount);
+    printf("bvh + grid:  %10.0f rays/s (%d rays)\n", rayCount/fastTime, rayCount);
+    printf("hits: wall %d, head %d, body %d, miss %d\n", hits[SHOT_WALL], hits[SHOT_HEAD], hits[SHOT_BODY], hits[SHOT_MISS]);
+    printf("mismatches vs linear: %d / %d\n", mismatches, checkCount);
+
+    BvhFree(&bvh);
+    TargetGridFree(&grid);
+    free(targets);
+    free(boxes);
+    free(walls);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,616 @@
+#include "world.h"
+#include "hitscan.h"
+#include "raymath.h"
+#include "../common/bench.h"
+#include "../common/hudtext.h"
+#include "staticmesh.h"
+#include "navgrid.h"
+#include "cull.h"
+#include "stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Seeded CS2 scenarios for the `bench` build target: the hitscan ray loop,
+// culling the hitscan map's chunks and targets from a wandering camera,
+// particle spawning and updating, grenade explosions, the kill feed, the
+// HUD text with and without the layout cache, baking the static meshes, a
+// world full of bots and path queries with and without the path cache.
+// Prints a table and writes the results as JSON for comparing commits.
+// Usage: cs2_bench_suite [out.json] [repeats]
+
+static unsigned int benchSeed = 12345;
+
+static uint64_t FloatBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// A generated map with targets spread over it, as in bench_ray
+#define RAY_WALLS 20000
+#define RAY_TARGETS 1000
+
+typedef struct {
+    Wall *walls;
+    Target *targets;
+    Bvh bvh;
+    TargetGrid grid;
+    float half;
+} RayBench;
+
+static bool InitRays(RayBench *b) {
+    benchSeed = 12345;
+    b->half = sqrtf((float)RAY_WALLS*16.0f)*0.5f;
+    b->walls = malloc(RAY_WALLS*sizeof(Wall));
+    BoundingBox *boxes = malloc(RAY_WALLS*sizeof(BoundingBox));
+    b->walls[0] = (Wall){ (Vector3){ 0, -0.5f, 0 }, (Vector3){ b->half*2, 1, b->half*2 }, GRAY, DARKGRAY };
+    for (int i = 1; i < RAY_WALLS; i++) {
+        Vector3 size = { BenchRandomFloat(&benchSeed, 0.5f, 4), BenchRandomFloat(&benchSeed, 0.5f, 6), BenchRandomFloat(&benchSeed, 0.5f, 4) };
+        b->walls[i] = (Wall){ (Vector3){ BenchRandomFloat(&benchSeed, -b->half, b->half), size.y*0.5f, BenchRandomFloat(&benchSeed, -b->half, b->half) }, size, GRAY, DARKGRAY };
+    }
+    for (int i = 0; i < RAY_WALLS; i++) {
+        boxes[i] = (BoundingBox){ Vector3Subtract(b->walls[i].position, Vector3Scale(b->walls[i].size, 0.5f)),
+                                  Vector3Add(b->walls[i].position, Vector3Scale(b->walls[i].size, 0.5f)) };
+    }
+    b->targets = calloc(RAY_TARGETS, sizeof(Target));
+    for (int i = 0; i < RAY_TARGETS; i++) {
+        b->targets[i].position = (Vector3){ BenchRandomFloat(&benchSeed, -b->half, b->half), 0, BenchRandomFloat(&benchSeed, -b->half, b->half) };
+        b->targets[i].active = true;
+        b->targets[i].health = 100;
+    }
+    bool built = BvhBuild(&b->bvh, boxes, RAY_WALLS) && BuildTargetGrid(&b->grid, b->targets, RAY_TARGETS);
+    free(boxes);
+    return built;
+}
+
+static void FreeRays(RayBench *b) {
+    BvhFree(&b->bvh);
+    TargetGridFree(&b->grid);
+    free(b->targets);
+    free(b->walls);
+}
+
+static void SetupRays(void *ctx) {
+    (void)ctx;
+    benchSeed = 999;
+}
+
+static uint64_t RunRays(void *ctx, long long ops) {
+    RayBench *b = ctx;
+    uint64_t hash = BENCH_HASH_START;
+    for (long long i = 0; i < ops; i++) {
+        Ray ray;
+        ray.position = (Vector3){ BenchRandomFloat(&benchSeed, -b->half, b->half), 2.0f, BenchRandomFloat(&benchSeed, -b->half, b->half) };
+        ray.direction = Vector3Normalize((Vector3){ BenchRandomFloat(&benchSeed, -1, 1), BenchRandomFloat(&benchSeed, -0.15f, 0.05f), BenchRandomFloat(&benchSeed, -1, 1) });
+        ShotHit shot = CastShot(&b->bvh, &b->grid, b->targets, ray, 1000.0f);
+        hash = BenchHash(hash, (uint64_t)shot.kind | ((uint64_t)(uint32_t)shot.index << 8));
+    }
+    return hash;
+}
+
+// Explosion-sized bursts into the pool and 64 Hz updates, as grenades and
+// shots produce them
+typedef struct {
+    ParticlePool pool;
+} ParticleBench;
+
+static void SetupParticles(void *ctx) {
+    ParticleBench *b = ctx;
+    ParticlePoolClear(&b->pool);
+    benchSeed = 4242;
+}
+
+// One operation is one particle spawned and then updated for its lifetime
+static uint64_t RunParticles(void *ctx, long long ops) {
+    ParticleBench *b = ctx;
+    uint64_t hash = BENCH_HASH_START;
+    long long spawned = 0;
+    while (spawned < ops) {
+        for (int burst = 0; burst < 8; burst++) {
+            Vector3 at = { BenchRandomFloat(&benchSeed, -20, 20), BenchRandomFloat(&benchSeed, 0, 3), BenchRandomFloat(&benchSeed, -20, 20) };
+            for (int i = 0; i < 30 && spawned < ops; i++, spawned++) {
+                Vector3 velocity = { BenchRandomFloat(&benchSeed, -5, 5), BenchRandomFloat(&benchSeed, -5, 5), BenchRandomFloat(&benchSeed, -5, 5) };
+                ParticlePoolSpawn(&b->pool, at, velocity, ORANGE, 0.5f, 0.6f, (ParticleType)(i % PARTICLE_TYPE_COUNT));
+            }
+        }
+        ParticlePoolUpdate(&b->pool, WORLD_DT);
+        hash = BenchHash(hash, (uint64_t)b->pool.count);
+    }
+    while (b->pool.count > 0) ParticlePoolUpdate(&b->pool, WORLD_DT);
+    return hash;
+}
+
+// The world kept full of grenades going off around the targets
+#define NADE_LIVE 2000
+
+typedef struct {
+    World world;
+    PlayerInput inputs[MAX_PLAYERS];
+} GrenadeBench;
+
+static void SetupGrenades(void *ctx) {
+    GrenadeBench *b = ctx;
+    WorldFree(&b->world);
+    WorldInit(&b->world, 7);
+    WorldAddPlayer(&b->world, "Player");
+    memset(b->inputs, 0, sizeof(b->inputs));
+    b->inputs[0].selectWeapon = -1;
+    benchSeed = 31337;
+}
+
+// One operation is one tick of one live projectile
+static uint64_t RunGrenades(void *ctx, long long ops) {
+    GrenadeBench *b = ctx;
+    World *world = &b->world;
+    long long done = 0;
+    while (done < ops) {
+        while (world->projectiles.count < NADE_LIVE) {
+            Projectile *p = ProjectilePoolSpawn(&world->projectiles);
+            float angle = BenchRandomFloat(&benchSeed, 0, 2*PI);
+            p->position = (Vector3){ BenchRandomFloat(&benchSeed, -25, 25), BenchRandomFloat(&benchSeed, 1, 4), BenchRandomFloat(&benchSeed, -25, 25) };
+            p->previous = p->position;
+            p->velocity = (Vector3){ 10*sinf(angle), BenchRandomFloat(&benchSeed, 0, 8), 10*cosf(angle) };
+            p->halfSize = 0.2f;
+            p->bounce = 0.5f;
+            p->friction = 0.7f;
+            p->timer = BenchRandomFloat(&benchSeed, 0.1f, 2.0f);
+            p->radius = 8.0f;
+            p->damage = 80;
+            p->weapon = WPN_GRENADE;
+        }
+        for (int i = 0; i < MAX_TARGETS; i++) {
+            Target *t = &world->targets[i];
+            if (!t->active) *t = (Target){ t->position, true, 100, 0, 0, t->id };
+        }
+        done += world->projectiles.count;
+        WorldStep(world, b->inputs, WORLD_DT);
+    }
+    uint64_t hash = BENCH_HASH_START;
+    for (int i = 0; i < MAX_TARGETS; i++) hash = BenchHash(hash, (uint64_t)world->targets[i].health);
+    for (int i = 0; i < world->projectiles.count; i++) hash = BenchHash(hash, FloatBits(world->projectiles.items[i].position.y));
+    return hash;
+}
+
+// Drawing the feed needs a window, so this covers its world side: a kill
+// going onto the stream and the feed read back from it, with the stats
+// thread taking the same events off a ring. A game makes a few events a
+// tick, far fewer than the thread can take; here a repeat is one ring's
+// worth of kills, and setup waits for the thread to empty the ring, so no
+// kill is dropped and only the game's side is timed.
+typedef struct {
+    World world;
+    StatsPipeline *stats;
+    uint16_t names[4];
+} KillFeedBench;
+
+static void SetupKillFeed(void *ctx) {
+    KillFeedBench *b = ctx;
+    static const char *names[] = { "Player", "Bot", "Enemy", "Someone with a long name" };
+    for (int i = 0; i < 4; i++) b->names[i] = NameIntern(&b->world.names, names[i]);
+    b->world.killFeed.count = 0;
+    b->world.tick = 0;
+    if (b->stats) StatsWait(b->stats);
+}
+
+static uint64_t RunKillFeed(void *ctx, long long ops) {
+    KillFeedBench *b = ctx;
+    uint64_t hash = BENCH_HASH_START;
+    for (long long i = 0; i < ops; i++) {
+        WorldEmit(&b->world, EVENT_KILL, b->names[i % 4], b->names[(i + 1) % 4], (WeaponType)(i % 4), 0, (i % 3) == 0);
+        b->world.tick++;
+        float timeLeft;
+        const GameEvent *oldest = WorldKillFeed(&b->world, MAX_KILLFEED - 1, &timeLeft);
+        if (oldest) hash = BenchHash(hash, (uint64_t)(unsigned char)NameLookup(&b->world.names, oldest->actor)[0]);
+    }
+    return hash;
+}
+
+// The CPU side of the game's HUD text each frame: HP, ammo, the help line and
+// a full kill feed, each name measured and drawn as main.c does. HP changes
+// every second, ammo every few frames and the feed every few seconds. The
+// font is shaped like Raylib's default one, since there is no window to load
+// it from. Uncached repeats what DrawText and MeasureText do on the CPU every
+// call: a linear glyph search per letter (two when drawing) and one draw per
+// glyph. Cached, only changed strings are laid out and the frame is one batch.
+#define HUD_GLYPHS 224
+
+typedef struct {
+    HudText hud;
+    Rectangle recs[HUD_GLYPHS];
+    GlyphInfo glyphs[HUD_GLYPHS];
+    HudGlyphQuad scratch[256];      // where uncached glyphs are written
+    bool cached;
+} HudBench;
+
+static void SetupHud(void *ctx) {
+    HudBench *b = ctx;
+    for (int i = 0; i < HUD_GLYPHS; i++) {
+        b->recs[i] = (Rectangle){ (float)(i % 16)*8, (float)(i/16)*12, (float)(1 + i % 6), 10 };
+        b->glyphs[i] = (GlyphInfo){ .value = 32 + i };
+    }
+    Font font = { 10, HUD_GLYPHS, 0, { 1, 128, 256, 1, 0 }, b->recs, b->glyphs };
+    HudTextFree(&b->hud);
+    HudTextInit(&b->hud, font);
+}
+
+// GetGlyphIndex
+static int FindGlyph(const Font *font, int codepoint) {
+    int fallback = 0;
+    for (int i = 0; i < font->glyphCount; i++) {
+        if (font->glyphs[i].value == '?') fallback = i;
+        if (font->glyphs[i].value == codepoint) return i;
+    }
+    return fallback;
+}
+
+// MeasureTextEx for one line of ASCII
+static int MeasureUncached(const Font *font, const char *text, int size) {
+    float width = 0.0f;
+    int letters = 0;
+    for (; text[letters] != '\0'; letters++) {
+        int index = FindGlyph(font, (unsigned char)text[letters]);
+        width += font->glyphs[index].advanceX != 0 ? (float)font->glyphs[index].advanceX : font->recs[index].width + (float)font->glyphs[index].offsetX;
+    }
+    return (int)(width*(float)size/(float)font->baseSize + (float)((letters > 0 ? letters - 1 : 0)*(size/10)));
+}
+
+// DrawTextEx: each glyph is looked up, then again by DrawTextCodepoint, and
+// handed to DrawTexturePro on its own
+static int DrawUncached(HudBench *b, const char *text, int x, int y, int size) {
+    const Font *font = &b->hud.font;
+    float scale = (float)size/(float)font->baseSize;
+    float offset = 0.0f;
+    int count = 0;
+    for (int i = 0; text[i] != '\0'; i++) {
+        int codepoint = (unsigned char)text[i];
+        int index = FindGlyph(font, codepoint);
+        if (codepoint != ' ') {
+            int drawn = FindGlyph(font, codepoint);
+            const Rectangle *rec = &font->recs[drawn];
+            b->scratch[count & 255].source = *rec;
+            b->scratch[count & 255].dest = (Rectangle){ (float)x + offset + (float)font->glyphs[drawn].offsetX*scale,
+                                                        (float)y + (float)font->glyphs[drawn].offsetY*scale, rec->width*scale, rec->height*scale };
+            count++;
+        }
+        offset += (font->glyphs[index].advanceX != 0 ? (float)font->glyphs[index].advanceX*scale : font->recs[index].width*scale) + (float)(size/10);
+    }
+    return count;
+}
+
+static int HudMeasure(HudBench *b, const char *text, int size) {
+    if (b->cached) return HudTextMeasure(&b->hud, text, size);
+    return MeasureUncached(&b->hud.font, text, size);
+}
+
+static void HudDraw(HudBench *b, const char *text, int x, int y, int size, uint64_t *hash) {
+    int count;
+    if (b->cached) {
+        int before = b->hud.queueCount;
+        HudTextDraw(&b->hud, text, x, y, size, WHITE);
+        count = b->hud.queueCount - before;
+    } else {
+        count = DrawUncached(b, text, x, y, size);
+        b->hud.flushes += count;
+        b->hud.flushedQuads += count;
+    }
+    *hash = BenchHash(*hash, (uint64_t)count + (uint64_t)x);
+}
+
+static uint64_t RunHud(void *ctx, long long ops) {
+    HudBench *b = ctx;
+    static const char *names[] = { "Player", "Bot", "Enemy", "xX_Sniper_Xx", "Someone with a long name", "Rusher" };
+    uint64_t hash = BENCH_HASH_START;
+    char text[64];
+    for (long long frame = 0; frame < ops; frame++) {
+        snprintf(text, sizeof(text), "HP: %03d", 100 - (int)(frame/64 % 100));
+        HudDraw(b, text, 20, 670, 40, &hash);
+        snprintf(text, sizeof(text), "%d / %d", 30 - (int)(frame/8 % 30), 90);
+        HudDraw(b, text, 1100, 670, 40, &hash);
+        HudDraw(b, "1:AK 2:USP 3:KNF 4:HE 5:DGL 6:SMG | F:INSPECT R:RELOAD T:RESET", 20, 20, 20, &hash);
+
+        int kfY = 20;
+        for (int k = 0; k < MAX_KILLFEED; k++) {
+            const char *victim = names[(frame/300 + k) % 6];
+            const char *killer = names[(frame/300 + k + 1) % 6];
+            int victimWidth = HudMeasure(b, victim, 20);
+            int killerWidth = HudMeasure(b, killer, 20);
+            HudDraw(b, victim, 1250 - victimWidth, kfY + 5, 20, &hash);
+            HudDraw(b, "AK", 1200 - victimWidth, kfY + 8, 10, &hash);
+            HudDraw(b, killer, 1150 - victimWidth - killerWidth, kfY + 5, 20, &hash);
+            kfY += 35;
+        }
+
+        if (b->cached) {
+            // What HudTextFlush does, minus the GL calls
+            b->hud.flushes++;
+            b->hud.flushedQuads += b->hud.queueCount;
+            b->hud.queueCount = 0;
+        }
+    }
+    return hash;
+}
+
+// Every target a bot, fighting autopilot players on one thread (bench_bots
+// covers threads); one operation is one bot for one tick
+typedef struct {
+    World world;
+    PlayerInput inputs[MAX_PLAYERS];
+} BotBench;
+
+static void SetupBots(void *ctx) {
+    BotBench *b = ctx;
+    WorldFree(&b->world);
+    WorldInit(&b->world, 11);
+    WorldSetBots(&b->world, MAX_TARGETS);
+    for (int i = 0; i < 16; i++) WorldAddPlayer(&b->world, "Bot");
+}
+
+static uint64_t RunBots(void *ctx, long long ops) {
+    BotBench *b = ctx;
+    World *world = &b->world;
+    for (long long done = 0; done < ops; done += world->botCount) {
+        for (int i = 0; i < world->playerCount; i++) b->inputs[i] = WorldAutopilot(world, i);
+        WorldStep(world, b->inputs, WORLD_DT);
+    }
+    uint64_t hash = BENCH_HASH_START;
+    for (int i = 0; i < world->botCount; i++) hash = BenchHash(hash, FloatBits(world->targets[i].position.x));
+    return hash;
+}
+
+// Frustum and occlusion culling on the hitscan map baked into chunks; one
+// operation is one frame from a camera at eye height somewhere on the map,
+// testing every chunk and target.
+typedef struct {
+    RayBench *map;
+    StaticMesh mesh;
+    Culler cull;
+    long long frames;
+    long long totals[CULL_KIND_COUNT][3];
+} CullBench;
+
+static void SetupCull(void *ctx) {
+    CullBench *b = ctx;
+    benchSeed = 9090;
+    b->frames = 0;
+    memset(b->totals, 0, sizeof(b->totals));
+}
+
+static uint64_t RunCull(void *ctx, long long ops) {
+    CullBench *b = ctx;
+    float half = b->map->half;
+    uint64_t hash = BENCH_HASH_START;
+    for (long long i = 0; i < ops; i++) {
+        Camera3D camera = { 0 };
+        camera.position = (Vector3){ BenchRandomFloat(&benchSeed, -half, half), 1.7f, BenchRandomFloat(&benchSeed, -half, half) };
+        float yaw = BenchRandomFloat(&benchSeed, 0.0f, 2.0f*PI);
+        camera.target = Vector3Add(camera.position, (Vector3){ cosf(yaw), BenchRandomFloat(&benchSeed, -0.2f, 0.2f), sinf(yaw) });
+        camera.up = (Vector3){ 0, 1, 0 };
+        camera.fovy = 75.0f;
+        camera.projection = CAMERA_PERSPECTIVE;
+        CullBegin(&b->cull, camera, 16.0f/9.0f, &b->map->bvh, b->map->walls);
+
+        int drawn = 0;
+        for (int c = 0; c < b->mesh.chunkCount; c++) drawn += CullBox(&b->cull, b->mesh.chunks[c].bounds, CULL_WALLS);
+        for (int t = 0; t < RAY_TARGETS; t++) {
+            Vector3 pos = b->map->targets[t].position;
+            BoundingBox box = { { pos.x - 0.7f, 0.0f, pos.z - 0.25f }, { pos.x + 0.7f, 2.75f, pos.z + 0.25f } };
+            drawn += CullBox(&b->cull, box, CULL_TARGETS);
+        }
+        hash = BenchHash(hash, (uint64_t)drawn);
+        for (int k = 0; k < CULL_KIND_COUNT; k++) {
+            b->totals[k][0] += b->cull.counters[k].submitted;
+            b->totals[k][1] += b->cull.counters[k].frustumCulled;
+            b->totals[k][2] += b->cull.counters[k].occluded;
+        }
+        b->frames++;
+    }
+    return hash;
+}
+
+// Baking a map of random boxes into the static meshes; one operation is one
+// box. This only runs when the map changes. Drawing it afterwards is one draw
+// per chunk and sends nothing, where before every wall was re-sent each frame.
+#define STATIC_BOXES 100000
+
+typedef struct {
+    StaticMesh mesh;
+    Wall walls[STATIC_BOXES];
+    uint32_t version;
+} StaticBench;
+
+static void SetupStatic(void *ctx) {
+    StaticBench *b = ctx;
+    benchSeed = 4242;
+    for (int i = 0; i < STATIC_BOXES; i++) {
+        Vector3 size = { BenchRandomFloat(&benchSeed, 0.5f, 4), BenchRandomFloat(&benchSeed, 0.5f, 6), BenchRandomFloat(&benchSeed, 0.5f, 4) };
+        b->walls[i] = (Wall){ (Vector3){ BenchRandomFloat(&benchSeed, -500, 500), size.y*0.5f, BenchRandomFloat(&benchSeed, -500, 500) }, size, GRAY, DARKGRAY };
+    }
+}
+
+static uint64_t RunStatic(void *ctx, long long ops) {
+    StaticBench *b = ctx;
+    StaticMeshUpdate(&b->mesh, b->walls, (int)ops, ++b->version);
+    uint64_t hash = BENCH_HASH_START;
+    for (int i = 0; i < b->mesh.chunkCount; i++) {
+        const StaticChunk *chunk = &b->mesh.chunks[i];
+        hash = BenchHash(hash, (uint64_t)chunk->indexCount);
+        hash = BenchHash(hash, FloatBits(chunk->vertices[chunk->vertexCount - 1].x));
+    }
+    return hash;
+}
+
+// Hierarchical A* on a generated 512 m map, as in bench_nav; one operation
+// is one query. The cached run repeats NAV_BENCH_PAIRS start and goal pairs.
+#define NAV_BENCH_WALLS 8000
+#define NAV_BENCH_PAIRS 512
+
+typedef struct {
+    NavGrid nav;
+    bool cached;
+    Vector3 from[NAV_BENCH_PAIRS], to[NAV_BENCH_PAIRS];
+    Vector3 points[NAV_CACHED_POINTS];
+} NavBench;
+
+static Vector3 RandomOpenCell(const NavGrid *nav) {
+    for (;;) {
+        int cell = NavCellAt(nav, (Vector3){ BenchRandomFloat(&benchSeed, -256, 256), 0.0f, BenchRandomFloat(&benchSeed, -256, 256) });
+        if (NavWalkable(nav, cell)) return NavCellCenter(nav, cell);
+    }
+}
+
+static bool InitNav(NavBench *b) {
+    benchSeed = 777;
+    Wall *walls = malloc(NAV_BENCH_WALLS*sizeof(Wall));
+    walls[0] = (Wall){ (Vector3){ 0, -0.5f, 0 }, (Vector3){ 512, 1, 512 }, GRAY, DARKGRAY };
+    for (int i = 1; i < NAV_BENCH_WALLS; i++) {
+        Vector3 size = { BenchRandomFloat(&benchSeed, 0.5f, 4), BenchRandomFloat(&benchSeed, 0.5f, 6), BenchRandomFloat(&benchSeed, 0.5f, 4) };
+        walls[i] = (Wall){ (Vector3){ BenchRandomFloat(&benchSeed, -256, 256), size.y*0.5f, BenchRandomFloat(&benchSeed, -256, 256) }, size, GRAY, DARKGRAY };
+    }
+    bool built = NavGridBuild(&b->nav, walls, NAV_BENCH_WALLS);
+    free(walls);
+    if (!built) return false;
+    for (int i = 0; i < NAV_BENCH_PAIRS; i++) {
+        b->from[i] = RandomOpenCell(&b->nav);
+        b->to[i] = RandomOpenCell(&b->nav);
+    }
+    return true;
+}
+
+static void SetupNav(void *ctx) {
+    NavBench *b = ctx;
+    benchSeed = 778;
+    NavClearCache(&b->nav);
+}
+
+static uint64_t RunNav(void *ctx, long long ops) {
+    NavBench *b = ctx;
+    uint64_t hash = BENCH_HASH_START;
+    for (long long i = 0; i < ops; i++) {
+        int count;
+        if (b->cached) {
+            int pair = (int)BenchRandomFloat(&benchSeed, 0, NAV_BENCH_PAIRS - 1);
+            count = NavCachedPath(&b->nav, b->from[pair], b->to[pair], b->points, NAV_CACHED_POINTS);
+        } else {
+            int pair = (int)(i % NAV_BENCH_PAIRS);
+            count = NavFindPath(&b->nav, b->from[pair], b->to[pair], b->points, NAV_CACHED_POINTS);
+        }
+        hash = BenchHash(hash, (uint64_t)count);
+        if (count > 0) hash = BenchHash(hash, FloatBits(b->points[count - 1].x));
+    }
+    return hash;
+}
+
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : "cs2_bench.json";
+    int repeats = (argc > 2) ? atoi(argv[2]) : 7;
+
+    static RayBench rays;
+    static CullBench cull;
+    static ParticleBench particles;
+    static GrenadeBench grenades;
+    static KillFeedBench killFeed;
+    static HudBench hud;
+    static StaticBench staticMesh;
+    static BotBench bots;
+    static NavBench nav;
+    BenchResult results[11];
+    int count = 0;
+
+    if (!InitRays(&rays)) {
+        fprintf(stderr, "out of memory building the wall BVH and target grid\n");
+        return 1;
+    }
+    results[count++] = BenchMeasure("hitscan", "ray", SetupRays, RunRays, &rays, 200000, repeats);
+    BenchPrint(&results[count - 1]);
+
+    cull.map = &rays;
+    StaticMeshUpdate(&cull.mesh, rays.walls, RAY_WALLS, 1);
+    results[count++] = BenchMeasure("cull", "frame", SetupCull, RunCull, &cull, 2000, repeats);
+    BenchPrint(&results[count - 1]);
+    const char *cullNames[] = { "chunks", "targets" };
+    for (int k = 0; k < 2; k++) {
+        printf("%22s %-8s %7.1f drawn, %7.1f off screen, %7.1f hidden per frame\n", "", cullNames[k],
+               (double)cull.totals[k][0]/cull.frames, (double)cull.totals[k][1]/cull.frames,
+               (double)cull.totals[k][2]/cull.frames);
+    }
+    StaticMeshFree(&cull.mesh);
+    FreeRays(&rays);
+
+    ParticlePoolInit(&particles.pool, MAX_PARTICLES);
+    results[count++] = BenchMeasure("particles", "particle", SetupParticles, RunParticles, &particles, 1000000, repeats);
+    BenchPrint(&results[count - 1]);
+    ParticlePoolFree(&particles.pool);
+
+    results[count++] = BenchMeasure("grenade_explosions", "projectile-tick", SetupGrenades, RunGrenades, &grenades, 1000000, repeats);
+    BenchPrint(&results[count - 1]);
+    WorldFree(&grenades.world);
+
+    WorldInit(&killFeed.world, 1);
+    killFeed.stats = StatsStart(NULL);
+    killFeed.world.events = killFeed.stats ? StatsEvents(killFeed.stats) : NULL;
+    results[count++] = BenchMeasure("kill_feed", "kill", SetupKillFeed, RunKillFeed, &killFeed, EVENT_RING_SIZE, repeats);
+    BenchPrint(&results[count - 1]);
+    if (killFeed.stats) {
+        StatsWait(killFeed.stats);
+        WeaponStats totals[MAX_WEAPONS], botTotals[MAX_WEAPONS];
+        long long counted = 0, botCounted = 0;
+        if (StatsRead(killFeed.stats, totals, botTotals)) {
+            for (int w = 0; w < MAX_WEAPONS; w++) {
+                counted += totals[w].kills;
+                botCounted += botTotals[w].kills;
+            }
+        }
+        printf("%22s %lld kills counted by the stats thread (%lld by bots), %lld dropped with the ring full\n", "",
+               counted + botCounted, botCounted, killFeed.world.events->dropped);
+        killFeed.world.events = NULL;
+        StatsStop(killFeed.stats);
+    }
+    WorldFree(&killFeed.world);
+
+    const char *hudNames[] = { "hud_text_uncached", "hud_text_cached" };
+    for (int cached = 0; cached < 2; cached++) {
+        hud.cached = cached;
+        results[count++] = BenchMeasure(hudNames[cached], "frame", SetupHud, RunHud, &hud, 20000, repeats);
+        BenchPrint(&results[count - 1]);
+        printf("%22s %.1f draws and %.0f glyphs per frame, %d layouts in the last run\n", "",
+               (double)hud.hud.flushes/20000, (double)hud.hud.flushedQuads/20000, hud.hud.misses);
+    }
+    HudTextFree(&hud.hud);
+
+    results[count++] = BenchMeasure("static_mesh_bake", "box", SetupStatic, RunStatic, &staticMesh, STATIC_BOXES, repeats);
+    BenchPrint(&results[count - 1]);
+    for (int boxes = 100; boxes <= STATIC_BOXES; boxes *= 10) {
+        StaticMeshUpdate(&staticMesh.mesh, staticMesh.walls, boxes, ++staticMesh.version);
+        printf("%22s %6d boxes: %d draws per frame, was %d instances and %d wire vertices sent per frame\n", "",
+               boxes, staticMesh.mesh.chunkCount, boxes, boxes*24);
+    }
+    StaticMeshFree(&staticMesh.mesh);
+
+    results[count++] = BenchMeasure("bots", "bot-tick", SetupBots, RunBots, &bots, 256000, repeats);
+    BenchPrint(&results[count - 1]);
+    WorldFree(&bots.world);
+
+    if (!InitNav(&nav)) {
+        fprintf(stderr, "out of memory building the nav grid\n");
+        return 1;
+    }
+    const char *navNames[] = { "nav_paths", "nav_paths_cached" };
+    for (int cached = 0; cached < 2; cached++) {
+        nav.cached = cached;
+        results[count++] = BenchMeasure(navNames[cached], "query", SetupNav, RunNav, &nav, 2000, repeats);
+        BenchPrint(&results[count - 1]);
+    }
+    printf("%22s %dx%d cells, %d entrances, %.0f%% cache hits\n", "", nav.nav.cellsX, nav.nav.cellsZ, nav.nav.nodeCount,
+           100.0*nav.nav.cacheHits/(double)(nav.nav.cacheHits + nav.nav.cacheMisses));
+    NavGridFree(&nav.nav);
+
+    if (!BenchWriteJson(path, "cs2", results, count)) {
+        fprintf(stderr, "could not write %s\n", path);
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (!results[i].reproducible) return 1;
+    }
+    return 0;
+}
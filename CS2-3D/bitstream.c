@@ -0,0 +1,63 @@
+#include "bitstream.h"
+#include <string.h>
+
+void BitWriterInit(BitWriter *w, uint8_t *data, int capacity) {
+    w->data = data;
+    w->capacity = capacity;
+    w->bitCount = 0;
+    w->overflow = false;
+    memset(data, 0, capacity);
+}
+
+void BitWrite(BitWriter *w, uint32_t value, int bits) {
+    if (w->bitCount + bits > w->capacity*8) {
+        w->overflow = true;
+        return;
+    }
+    for (int i = 0; i < bits; ) {
+        int bit = w->bitCount & 7;
+        int take = 8 - bit;
+        if (take > bits - i) take = bits - i;
+        uint32_t chunk = (value >> i) & ((1u << take) - 1);
+        w->data[w->bitCount >> 3] |= (uint8_t)(chunk << bit);
+        w->bitCount += take;
+        i += take;
+    }
+}
+
+void BitWriteBool(BitWriter *w, bool value) {
+    BitWrite(w, value ? 1 : 0, 1);
+}
+
+int BitWriterBytes(const BitWriter *w) {
+    return (w->bitCount + 7) >> 3;
+}
+
+void BitReaderInit(BitReader *r, const uint8_t *data, int size) {
+    r->data = data;
+    r->size = size;
+    r->bitPos = 0;
+    r->overflow = false;
+}
+
+uint32_t BitRead(BitReader *r, int bits) {
+    if (r->bitPos + bits > r->size*8) {
+        r->overflow = true;
+        return 0;
+    }
+    uint32_t value = 0;
+    for (int i = 0; i < bits; ) {
+        int bit = r->bitPos & 7;
+        int take = 8 - bit;
+        if (take > bits - i) take = bits - i;
+        uint32_t chunk = (r->data[r->bitPos >> 3] >> bit) & ((1u << take) - 1);
+        value |= chunk << i;
+        r->bitPos += take;
+        i += take;
+    }
+    return value;
+}
+
+bool BitReadBool(BitReader *r) {
+    return BitRead(r, 1) != 0;
+}
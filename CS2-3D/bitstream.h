@@ -0,0 +1,34 @@
+#ifndef CS2_BITSTREAM_H
+#define CS2_BITSTREAM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Packs values of any width up to 32 bits back to back, least significant
+// bit first. Writing past the end or reading past the end sets overflow
+// instead of touching memory outside the buffer.
+
+typedef struct {
+    uint8_t *data;
+    int capacity;   // bytes
+    int bitCount;
+    bool overflow;
+} BitWriter;
+
+typedef struct {
+    const uint8_t *data;
+    int size;       // bytes
+    int bitPos;
+    bool overflow;
+} BitReader;
+
+void BitWriterInit(BitWriter *w, uint8_t *data, int capacity);
+void BitWrite(BitWriter *w, uint32_t value, int bits);
+void BitWriteBool(BitWriter *w, bool value);
+int BitWriterBytes(const BitWriter *w);
+
+void BitReaderInit(BitReader *r, const uint8_t *data, int size);
+uint32_t BitRead(BitReader *r, int bits);
+bool BitReadBool(BitReader *r);
+
+#endif
@@ -0,0 +1,177 @@
+#include "botai.h"
+#include "collide.h"
+#include "raymath.h"
+
+// SplitMix64, so each bot draws from its own stream without shared state
+static float RandomUnit(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBull;
+    z ^= z >> 31;
+    return (float)(z >> 40)/16777216.0f;
+}
+
+static float WrapAngle(float angle) {
+    return atan2f(sinf(angle), cosf(angle));
+}
+
+bool BotAiLineOfSight(const Bvh *wallBvh, Vector3 from, Vector3 to) {
+    Vector3 d = Vector3Subtract(to, from);
+    float distance = Vector3Length(d);
+    if (distance < 1e-4f) return true;
+    Ray ray = { from, Vector3Scale(d, 1.0f/distance) };
+    RayCollision hit;
+    int item;
+    return !BvhRaycast(wallBvh, ray, distance, &hit, &item);
+}
+
+static bool CanSee(const BotView *view, Vector3 eye, int player, float *distance) {
+    const Player *p = &view->players[player];
+    if (!p->connected || p->health <= 0) return false;
+    *distance = Vector3Distance(eye, p->position);
+    return *distance <= BOT_SIGHT_RANGE && BotAiLineOfSight(view->wallBvh, eye, p->position);
+}
+
+// Keeps the current enemy while it stays in sight; otherwise tries the
+// nearest few players in range, closest first
+static int PickEnemy(const BotView *view, const BotBrain *brain, Vector3 eye, float *enemyDistance) {
+    if (brain->enemy >= 0 && brain->enemy < view->playerCount && CanSee(view, eye, brain->enemy, enemyDistance)) return brain->enemy;
+
+    int nearest[BOT_SIGHT_CHECKS];
+    float nearestDistance[BOT_SIGHT_CHECKS];
+    int count = 0;
+    for (int i = 0; i < view->playerCount; i++) {
+        const Player *p = &view->players[i];
+        if (!p->connected || p->health <= 0) continue;
+        float d = Vector3Distance(eye, p->position);
+        if (d > BOT_SIGHT_RANGE) continue;
+        if (count == BOT_SIGHT_CHECKS && d >= nearestDistance[count - 1]) continue;
+        int slot = (count < BOT_SIGHT_CHECKS) ? count++ : count - 1;
+        while (slot > 0 && nearestDistance[slot - 1] > d) {
+            nearest[slot] = nearest[slot - 1];
+            nearestDistance[slot] = nearestDistance[slot - 1];
+            slot--;
+        }
+        nearest[slot] = i;
+        nearestDistance[slot] = d;
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (BotAiLineOfSight(view->wallBvh, eye, view->players[nearest[i]].position)) {
+            *enemyDistance = nearestDistance[i];
+            return nearest[i];
+        }
+    }
+    return -1;
+}
+
+// Heading along the flow field of the nearest player in hunting range, or
+// zero when there is none
+static Vector3 Hunt(const BotView *view, Vector3 position) {
+    int hunted = -1;
+    float nearest = BOT_HUNT_RANGE*BOT_HUNT_RANGE;
+    for (int i = 0; i < view->playerCount; i++) {
+        if (!view->flows[i]) continue;
+        float dx = view->players[i].position.x - position.x, dz = view->players[i].position.z - position.z;
+        if (dx*dx + dz*dz < nearest) {
+            nearest = dx*dx + dz*dz;
+            hunted = i;
+        }
+    }
+    return (hunted >= 0) ? NavFlowDirection(view->nav, view->flows[hunted], position) : (Vector3){ 0.0f, 0.0f, 0.0f };
+}
+
+// Heading to the next waypoint of the bot's path, skipping the ones reached.
+// With no path left and the wander timer run out it asks for one to a random
+// open cell, which it gets next tick.
+static Vector3 FollowPath(const BotView *view, const BotBrain *brain, Vector3 position, BotIntent *intent, uint64_t *rng) {
+    if (intent->wanderTimer < -BOT_PATH_TIMEOUT) intent->pathNext = brain->pathLength;
+    while (intent->pathNext < brain->pathLength) {
+        float dx = brain->path[intent->pathNext].x - position.x, dz = brain->path[intent->pathNext].z - position.z;
+        float distance = sqrtf(dx*dx + dz*dz);
+        if (distance > BOT_WAYPOINT_RADIUS) return (Vector3){ dx/distance, 0.0f, dz/distance };
+        intent->pathNext++;
+    }
+
+    if (view->nav && intent->wanderTimer <= 0.0f) {
+        int x = (int)(RandomUnit(rng)*(float)view->nav->cellsX);
+        int z = (int)(RandomUnit(rng)*(float)view->nav->cellsZ);
+        int cell = z*view->nav->cellsX + x;
+        if (NavWalkable(view->nav, cell)) {
+            intent->wantPath = true;
+            intent->pathGoal = NavCellCenter(view->nav, cell);
+        }
+    }
+    return (Vector3){ 0.0f, 0.0f, 0.0f };
+}
+
+BotIntent BotAiThink(const BotView *view, const BotBrain *brain, const Target *self, int index) {
+    BotIntent intent = { .position = self->position, .yaw = brain->yaw, .wanderTimer = brain->wanderTimer, .enemy = -1,
+                         .shotWallDistance = BOT_RANGE, .pathNext = brain->pathNext };
+    if (!self->active || self->health <= 0) return intent;
+
+    uint64_t rng = view->seed ^ (uint64_t)(index + 1)*0xD1B54A32D192ED03ull;
+    Vector3 eye = { self->position.x, self->position.y + BOT_EYE_HEIGHT, self->position.z };
+
+    float enemyDistance = 0.0f;
+    intent.enemy = PickEnemy(view, brain, eye, &enemyDistance);
+
+    float desiredYaw = brain->yaw;
+    float speed = BOT_SPEED;
+    bool navigating = false;
+    intent.wanderTimer -= view->dt;
+    if (intent.enemy >= 0) {
+        Vector3 d = Vector3Subtract(view->players[intent.enemy].position, eye);
+        desiredYaw = atan2f(-d.x, d.z);
+        if (enemyDistance < BOT_KEEP_DISTANCE) speed = 0.0f;
+    } else {
+        Vector3 heading = Hunt(view, self->position);
+        if (heading.x == 0.0f && heading.z == 0.0f) heading = FollowPath(view, brain, self->position, &intent, &rng);
+        navigating = heading.x != 0.0f || heading.z != 0.0f;
+        if (navigating) {
+            desiredYaw = atan2f(-heading.x, heading.z);
+        } else if (intent.wanderTimer <= 0.0f) {
+            desiredYaw = RandomUnit(&rng)*2.0f*PI;
+            intent.wanderTimer = 2.0f + 3.0f*RandomUnit(&rng);
+        }
+    }
+
+    float turn = WrapAngle(desiredYaw - brain->yaw);
+    float maxTurn = BOT_TURN_RATE*view->dt;
+    intent.yaw = WrapAngle(brain->yaw + Clamp(turn, -maxTurn, maxTurn));
+    Vector3 forward = { -sinf(intent.yaw), 0.0f, cosf(intent.yaw) };
+
+    // A wall just ahead sends a wandering bot off sideways and makes a
+    // fighting one strafe instead of walking into it. Paths already keep
+    // clear of walls, so bots following one trust it.
+    Ray feeler = { { self->position.x, self->position.y + BOT_HALF_HEIGHT, self->position.z }, forward };
+    RayCollision hit;
+    int item;
+    if (speed > 0.0f && !navigating && BvhRaycast(view->wallBvh, feeler, BOT_FEELER_LENGTH + BOT_HALF_WIDTH, &hit, &item)) {
+        float side = (intent.enemy >= 0) ? ((index & 1) ? 1.0f : -1.0f) : ((RandomUnit(&rng) < 0.5f) ? 1.0f : -1.0f);
+        if (intent.enemy < 0) {
+            intent.yaw = WrapAngle(intent.yaw + side*0.5f*PI);
+            intent.wanderTimer = 1.0f + RandomUnit(&rng);
+        }
+        forward = (Vector3){ -forward.z*side, 0.0f, forward.x*side };
+    }
+
+    // Bots stay on their feet's height and only slide sideways along walls
+    Vector3 half = { BOT_HALF_WIDTH, BOT_HALF_HEIGHT, BOT_HALF_WIDTH };
+    Vector3 center = { self->position.x, self->position.y + BOT_HALF_HEIGHT + 0.05f, self->position.z };
+    MoveResult move = MoveAndSlide(view->wallBvh, view->walls, center, half, Vector3Scale(forward, speed*view->dt));
+    intent.position = (Vector3){ move.position.x, self->position.y, move.position.z };
+
+    if (intent.enemy >= 0 && brain->fireCooldown <= 0.0f && fabsf(WrapAngle(desiredYaw - intent.yaw)) < BOT_AIM_TOLERANCE) {
+        Vector3 aim = view->players[intent.enemy].position;
+        aim.y -= 0.5f;
+        Vector3 direction = Vector3Normalize(Vector3Subtract(aim, eye));
+        direction.x += (RandomUnit(&rng) - 0.5f)*BOT_SPREAD;
+        direction.y += (RandomUnit(&rng) - 0.5f)*BOT_SPREAD;
+        direction.z += (RandomUnit(&rng) - 0.5f)*BOT_SPREAD;
+        intent.fire = true;
+        intent.shot = (Ray){ eye, Vector3Normalize(direction) };
+        if (BvhRaycast(view->wallBvh, intent.shot, BOT_RANGE, &hit, &item)) intent.shotWallDistance = hit.distance;
+    }
+    return intent;
+}
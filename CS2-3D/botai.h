@@ -0,0 +1,79 @@
+#ifndef CS2_BOTAI_H
+#define CS2_BOTAI_H
+
+#include "game.h"
+#include "bvh.h"
+#include "navgrid.h"
+#include <stdint.h>
+
+// AI for the targets: each bot walks paths between random spots on the map
+// until it sees a player, then closes in and shoots. Players within hunting
+// range but out of sight are closed in on along their flow field.
+//
+// A tick is split in two. BotAiThink only reads the world as it was when
+// the tick started and returns that bot's intent (including its move,
+// already slid along the walls), so every bot can think at the same time on
+// any thread. The world then applies the intents in bot order on one
+// thread, so the result does not depend on the thread count.
+
+#define BOT_SIGHT_RANGE 40.0f
+#define BOT_SIGHT_CHECKS 4          // nearest players tested for line of sight
+#define BOT_KEEP_DISTANCE 10.0f     // stops closing in at this range
+#define BOT_SPEED 3.0f
+#define BOT_TURN_RATE 6.0f          // radians per second
+#define BOT_FEELER_LENGTH 1.5f
+#define BOT_HUNT_RANGE 24.0f        // follows the flow field to players this close
+#define BOT_HUNT_SLACK 2            // cells a player moves before their field is redone
+#define BOT_PATH_POINTS 16
+#define BOT_WAYPOINT_RADIUS 0.5f
+#define BOT_PATH_TIMEOUT 15.0f      // gives up on a path after this long
+#define BOT_FIRE_INTERVAL 0.6f
+#define BOT_AIM_TOLERANCE (10.0f*DEG2RAD)
+#define BOT_SPREAD 0.04f
+#define BOT_RANGE 60.0f
+#define BOT_DAMAGE 8
+#define BOT_EYE_HEIGHT 2.5f
+#define BOT_HALF_WIDTH 0.45f
+#define BOT_HALF_HEIGHT 1.4f
+
+typedef struct {
+    float yaw;              // heading, 0 walks down +Z like a player's view
+    float fireCooldown;
+    float wanderTimer;      // picks a new heading when it runs out
+    int enemy;              // player index, or -1
+    Vector3 path[BOT_PATH_POINTS];
+    int pathLength;
+    int pathNext;           // waypoint being walked to
+} BotBrain;
+
+typedef struct {
+    Vector3 position;       // after this tick's move
+    float yaw;
+    float wanderTimer;
+    int enemy;
+    bool fire;
+    Ray shot;
+    float shotWallDistance; // where the shot stops at a wall, or BOT_RANGE
+    int pathNext;
+    bool wantPath;          // the world finds a path to pathGoal after the tick
+    Vector3 pathGoal;
+} BotIntent;
+
+// What a bot can see of the world; the same for every bot in a tick
+typedef struct {
+    const Bvh *wallBvh;
+    const Wall *walls;
+    const Player *players;
+    int playerCount;
+    const NavGrid *nav;
+    const NavFlowField *flows[MAX_PLAYERS]; // towards each player, or NULL
+    uint64_t seed;          // mixed with the bot index for its random choices
+    float dt;
+} BotView;
+
+BotIntent BotAiThink(const BotView *view, const BotBrain *brain, const Target *self, int index);
+
+// No wall between the two points, tested with the BVH ray the hitscan uses
+bool BotAiLineOfSight(const Bvh *wallBvh, Vector3 from, Vector3 to);
+
+#endif
@@ -0,0 +1,226 @@
+#include "net.h"
+#include "snapshot.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Load generator for cs2_server: runs many bot clients from one process.
+// Each bot sends input every tick, decodes every snapshot against its own
+// copy of the base and checks the result against the server's hash.
+// Usage: cs2_bots [clients] [port] [seconds]
+
+#define SNAPSHOT_HISTORY 64
+#define STATS_INTERVAL 5.0
+
+typedef struct {
+    NetSocket sock;
+    bool connected;
+    int player;
+    uint32_t sequence;
+    uint32_t newestTick;
+    double lastConnect;
+    NetSnapshot *history;
+    PlayerInput input;
+    uint32_t rng;
+} Bot;
+
+typedef struct {
+    long long bytesIn;
+    long long bytesOut;
+    long long snapshots;
+    long long fullSnapshots;
+    long long hashMismatches;
+    long long missingBase;
+    long long serverTickMicros;
+    long long connectedTicks;
+} BotStats;
+
+static void SleepUntil(double when) {
+    double wait = when - BenchNowSeconds();
+    if (wait <= 0) return;
+    struct timespec ts = { (time_t)wait, (long)((wait - (double)(time_t)wait)*1e9) };
+    nanosleep(&ts, NULL);
+}
+
+static uint32_t BotRandom(Bot *bot) {
+    bot->rng ^= bot->rng << 13;
+    bot->rng ^= bot->rng >> 17;
+    bot->rng ^= bot->rng << 5;
+    return bot->rng;
+}
+
+// Wanders, turns and shoots at random, enough to keep every field moving
+static void BotThink(Bot *bot, uint32_t tick) {
+    PlayerInput *in = &bot->input;
+    if (tick % 32 == 0) {
+        in->forward = (float)((int)(BotRandom(bot) % 3) - 1);
+        in->right = (float)((int)(BotRandom(bot) % 3) - 1);
+    }
+    in->look.x = (float)((int)(BotRandom(bot) % 41) - 20);
+    in->look.y = (float)((int)(BotRandom(bot) % 9) - 4);
+    in->fireHeld = (BotRandom(bot) % 4) == 0;
+    in->firePressed = (BotRandom(bot) % 16) == 0;
+    in->jump = (BotRandom(bot) % 128) == 0;
+    in->reload = (BotRandom(bot) % 256) == 0;
+    in->inspect = false;
+    in->reset = false;
+    in->selectWeapon = (BotRandom(bot) % 640) == 0 ? (int)(BotRandom(bot) % 4) : -1;
+}
+
+static void HandleSnapshot(Bot *bot, BitReader *r, int size, BotStats *stats) {
+    uint32_t tick = BitRead(r, 32);
+    uint32_t baseTick = BitRead(r, 32);
+    uint32_t hash = BitRead(r, 32);
+    uint32_t tickMicros = BitRead(r, 16);
+    BitRead(r, 8);
+
+    static const NetSnapshot emptySnapshot;
+    const NetSnapshot *base = &emptySnapshot;
+    if (baseTick != 0) {
+        base = &bot->history[baseTick % SNAPSHOT_HISTORY];
+        if (base->tick != baseTick) {
+            stats->missingBase++;
+            return;
+        }
+    } else {
+        stats->fullSnapshots++;
+    }
+
+    NetSnapshot *out = &bot->history[tick % SNAPSHOT_HISTORY];
+    if (out == base) {
+        stats->missingBase++;
+        return;
+    }
+    if (!SnapshotReadDelta(r, base, out)) {
+        out->tick = 0;
+        stats->hashMismatches++;
+        return;
+    }
+    out->tick = tick;
+    if (SnapshotHash(out) != hash) {
+        out->tick = 0;
+        stats->hashMismatches++;
+        return;
+    }
+
+    stats->snapshots++;
+    stats->bytesIn += size;
+    stats->serverTickMicros += tickMicros;
+    if ((int32_t)(tick - bot->newestTick) > 0) bot->newestTick = tick;
+}
+
+static void PrintStats(const char *label, const BotStats *stats, int bots) {
+    double clientSeconds = (double)stats->connectedTicks/WORLD_TICK_RATE;
+    printf("%s bots %d  in %.1f KB/s per client  out %.2f KB/s per client  snapshots %.1f/s per client (%lld full)  "
+           "server tick %.3f ms  missing base %lld  hash mismatches %lld\n",
+           label, bots,
+           clientSeconds > 0 ? stats->bytesIn/clientSeconds/1024.0 : 0.0,
+           clientSeconds > 0 ? stats->bytesOut/clientSeconds/1024.0 : 0.0,
+           clientSeconds > 0 ? stats->snapshots/clientSeconds : 0.0, stats->fullSnapshots,
+           stats->snapshots ? stats->serverTickMicros/1e3/stats->snapshots : 0.0,
+           stats->missingBase, stats->hashMismatches);
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    int count = (argc > 1) ? atoi(argv[1]) : 64;
+    int port = (argc > 2) ? atoi(argv[2]) : NET_DEFAULT_PORT;
+    double duration = (argc > 3) ? atof(argv[3]) : 30.0;
+    if (count < 1) count = 1;
+    if (count > MAX_PLAYERS) count = MAX_PLAYERS;
+
+    if (!NetStartup()) return 1;
+    NetAddress server = NetLoopback((uint16_t)port);
+
+    Bot *bots = calloc(count, sizeof(Bot));
+    for (int i = 0; i < count; i++) {
+        if (!NetOpen(&bots[i].sock, 0)) {
+            fprintf(stderr, "cannot open a socket for bot %d\n", i);
+            return 1;
+        }
+        bots[i].history = calloc(SNAPSHOT_HISTORY, sizeof(NetSnapshot));
+        bots[i].rng = 0x9E3779B9u*(uint32_t)(i + 1);
+        bots[i].lastConnect = -1.0;
+        bots[i].input.selectWeapon = -1;
+    }
+
+    static uint8_t packet[NET_MAX_PACKET];
+    BotStats total = { 0 }, window = { 0 };
+    double start = BenchNowSeconds();
+    double nextTick = start;
+    double windowStart = start;
+    uint32_t tick = 0;
+
+    while (BenchNowSeconds() - start < duration) {
+        SleepUntil(nextTick);
+        nextTick += WORLD_DT;
+        double now = BenchNowSeconds();
+        tick++;
+
+        for (int i = 0; i < count; i++) {
+            Bot *bot = &bots[i];
+            NetAddress from;
+            int size;
+            while ((size = NetReceive(&bot->sock, &from, packet, sizeof(packet))) > 0) {
+                BitReader r;
+                BitReaderInit(&r, packet, size);
+                PacketType type = (PacketType)BitRead(&r, 8);
+                if (type == PACKET_ACCEPT) {
+                    bot->connected = true;
+                    bot->player = (int)BitRead(&r, 8);
+                } else if (type == PACKET_SNAPSHOT && bot->connected) {
+                    HandleSnapshot(bot, &r, size, &window);
+                }
+            }
+
+            BitWriter w;
+            BitWriterInit(&w, packet, 64);
+            if (!bot->connected) {
+                if (now - bot->lastConnect < 0.5) continue;
+                bot->lastConnect = now;
+                BitWrite(&w, PACKET_CONNECT, 8);
+                BitWrite(&w, NET_PROTOCOL, 32);
+            } else {
+                BotThink(bot, tick + (uint32_t)i);
+                // Bots aim at the newest state they have seen
+                bot->input.viewTick = bot->newestTick;
+                bot->input.viewFraction = 0.0f;
+                BitWrite(&w, PACKET_INPUT, 8);
+                BitWrite(&w, ++bot->sequence, 32);
+                BitWrite(&w, bot->newestTick, 32);
+                NetWriteInput(&w, &bot->input);
+                window.connectedTicks++;
+            }
+            NetSend(&bot->sock, server, packet, BitWriterBytes(&w));
+            window.bytesOut += BitWriterBytes(&w);
+        }
+
+        if (now - windowStart >= STATS_INTERVAL) {
+            PrintStats("     ", &window, count);
+            total.bytesIn += window.bytesIn;
+            total.bytesOut += window.bytesOut;
+            total.snapshots += window.snapshots;
+            total.fullSnapshots += window.fullSnapshots;
+            total.hashMismatches += window.hashMismatches;
+            total.missingBase += window.missingBase;
+            total.serverTickMicros += window.serverTickMicros;
+            total.connectedTicks += window.connectedTicks;
+            window = (BotStats){ 0 };
+            windowStart = now;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        uint8_t bye = PACKET_DISCONNECT;
+        if (bots[i].connected) NetSend(&bots[i].sock, server, &bye, 1);
+        NetClose(&bots[i].sock);
+        free(bots[i].history);
+    }
+    free(bots);
+    NetShutdown();
+
+    PrintStats("total", &total, count);
+    return total.hashMismatches ? 1 : 0;
+}
@@ -0,0 +1,312 @@
+#include "bvh.h"
+#include "raymath.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BVH_BINS 12
+#define BVH_MAX_SAH_DEPTH 40
+
+typedef struct {
+    Bvh *bvh;
+    const BoundingBox *input;
+    Vector3 *centroids;
+} BuildContext;
+
+static BoundingBox EmptyBox(void) {
+    return (BoundingBox){ (Vector3){ FLT_MAX, FLT_MAX, FLT_MAX }, (Vector3){ -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+}
+
+static BoundingBox BoxUnion(BoundingBox a, BoundingBox b) {
+    return (BoundingBox){ Vector3Min(a.min, b.min), Vector3Max(a.max, b.max) };
+}
+
+static BoundingBox BoxAddPoint(BoundingBox a, Vector3 p) {
+    return (BoundingBox){ Vector3Min(a.min, p), Vector3Max(a.max, p) };
+}
+
+static float BoxHalfArea(BoundingBox b) {
+    Vector3 e = Vector3Subtract(b.max, b.min);
+    if (e.x < 0 || e.y < 0 || e.z < 0) return 0.0f;
+    return e.x*e.y + e.y*e.z + e.z*e.x;
+}
+
+static float Axis(Vector3 v, int axis) {
+    return (axis == 0) ? v.x : (axis == 1) ? v.y : v.z;
+}
+
+static void SwapItems(BuildContext *ctx, int a, int b) {
+    int item = ctx->bvh->items[a];
+    ctx->bvh->items[a] = ctx->bvh->items[b];
+    ctx->bvh->items[b] = item;
+    Vector3 c = ctx->centroids[a];
+    ctx->centroids[a] = ctx->centroids[b];
+    ctx->centroids[b] = c;
+}
+
+// Quickselect so that [start, mid) has centroids <= [mid, end) along axis
+static void PartitionMedian(BuildContext *ctx, int start, int end, int mid, int axis) {
+    int lo = start, hi = end - 1;
+    while (lo < hi) {
+        float pivot = Axis(ctx->centroids[(lo + hi)/2], axis);
+        int i = lo, j = hi;
+        while (i <= j) {
+            while (Axis(ctx->centroids[i], axis) < pivot) i++;
+            while (Axis(ctx->centroids[j], axis) > pivot) j--;
+            if (i <= j) SwapItems(ctx, i++, j--);
+        }
+        if (mid <= j) hi = j;
+        else if (mid >= i) lo = i;
+        else break;
+    }
+}
+
+static int FindSahSplit(BuildContext *ctx, int start, int end, BoundingBox nodeBox, BoundingBox centroidBox) {
+    Vector3 extent = Vector3Subtract(centroidBox.max, centroidBox.min);
+    int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+    float axisMin = Axis(centroidBox.min, axis);
+    float axisExtent = Axis(extent, axis);
+    if (axisExtent <= 0.0f) return -1;
+
+    int binCount[BVH_BINS] = { 0 };
+    BoundingBox binBox[BVH_BINS];
+    for (int b = 0; b < BVH_BINS; b++) binBox[b] = EmptyBox();
+
+    float scale = BVH_BINS/axisExtent;
+    for (int i = start; i < end; i++) {
+        int b = (int)((Axis(ctx->centroids[i], axis) - axisMin)*scale);
+        if (b >= BVH_BINS) b = BVH_BINS - 1;
+        binCount[b]++;
+        binBox[b] = BoxUnion(binBox[b], ctx->input[ctx->bvh->items[i]]);
+    }
+
+    float rightArea[BVH_BINS];
+    int rightCount[BVH_BINS];
+    BoundingBox acc = EmptyBox();
+    int count = 0;
+    for (int b = BVH_BINS - 1; b > 0; b--) {
+        acc = BoxUnion(acc, binBox[b]);
+        count += binCount[b];
+        rightArea[b] = BoxHalfArea(acc);
+        rightCount[b] = count;
+    }
+
+    float bestCost = FLT_MAX;
+    int bestSplit = -1;
+    acc = EmptyBox();
+    count = 0;
+    for (int b = 1; b < BVH_BINS; b++) {
+        acc = BoxUnion(acc, binBox[b - 1]);
+        count += binCount[b - 1];
+        if (count == 0 || rightCount[b] == 0) continue;
+        float cost = BoxHalfArea(acc)*count + rightArea[b]*rightCount[b];
+        if (cost < bestCost) { bestCost = cost; bestSplit = b; }
+    }
+
+    int total = end - start;
+    if (bestSplit < 0) return -1;
+    if (total <= 2*BVH_LEAF_SIZE && bestCost >= BoxHalfArea(nodeBox)*total) return -1;
+
+    int mid = start;
+    for (int i = start; i < end; i++) {
+        int b = (int)((Axis(ctx->centroids[i], axis) - axisMin)*scale);
+        if (b >= BVH_BINS) b = BVH_BINS - 1;
+        if (b < bestSplit) SwapItems(ctx, i, mid++);
+    }
+    return (mid == start || mid == end) ? -1 : mid;
+}
+
+static void Subdivide(BuildContext *ctx, int nodeIndex, int start, int end, int depth) {
+    Bvh *bvh = ctx->bvh;
+    BoundingBox nodeBox = EmptyBox();
+    BoundingBox centroidBox = EmptyBox();
+    for (int i = start; i < end; i++) {
+        nodeBox = BoxUnion(nodeBox, ctx->input[bvh->items[i]]);
+        centroidBox = BoxAddPoint(centroidBox, ctx->centroids[i]);
+    }
+
+    BvhNode *node = &bvh->nodes[nodeIndex];
+    node->box = nodeBox;
+    node->first = start;
+    node->count = end - start;
+    if (end - start <= BVH_LEAF_SIZE) return;
+
+    int mid = (depth < BVH_MAX_SAH_DEPTH) ? FindSahSplit(ctx, start, end, nodeBox, centroidBox) : -1;
+    if (mid < 0) {
+        // Too deep or no useful SAH split: an even split keeps the depth at log2(n)
+        Vector3 extent = Vector3Subtract(centroidBox.max, centroidBox.min);
+        int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z ? 1 : 2);
+        mid = start + (end - start)/2;
+        PartitionMedian(ctx, start, end, mid, axis);
+    }
+
+    int left = bvh->nodeCount;
+    bvh->nodeCount += 2;
+    node->first = left;
+    node->count = 0;
+
+    Subdivide(ctx, left, start, mid, depth + 1);
+    Subdivide(ctx, left + 1, mid, end, depth + 1);
+}
+
+bool BvhBuild(Bvh *bvh, const BoundingBox *boxes, int count) {
+    BvhFree(bvh);
+    if (count <= 0) return true;
+
+    bvh->owned = true;
+    bvh->itemCount = count;
+    bvh->items = malloc(count*sizeof(int));
+    bvh->boxes = malloc(count*sizeof(BoundingBox));
+    bvh->nodes = malloc(2*count*sizeof(BvhNode));
+
+    BuildContext ctx = { bvh, boxes, malloc(count*sizeof(Vector3)) };
+    if (!bvh->items || !bvh->boxes || !bvh->nodes || !ctx.centroids) {
+        free(ctx.centroids);
+        BvhFree(bvh);
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        bvh->items[i] = i;
+        ctx.centroids[i] = Vector3Scale(Vector3Add(boxes[i].min, boxes[i].max), 0.5f);
+    }
+
+    bvh->nodeCount = 1;
+    Subdivide(&ctx, 0, 0, count, 0);
+    free(ctx.centroids);
+
+    for (int i = 0; i < count; i++) bvh->boxes[i] = boxes[bvh->items[i]];
+    return true;
+}
+
+void BvhFree(Bvh *bvh) {
+    if (bvh->owned) {
+        free(bvh->nodes);
+        free(bvh->boxes);
+        free(bvh->items);
+    }
+    memset(bvh, 0, sizeof(*bvh));
+}
+
+bool RayBoxSlab(Vector3 origin, Vector3 invDir, BoundingBox box, float maxDistance, float *tNear) {
+    float t1 = (box.min.x - origin.x)*invDir.x;
+    float t2 = (box.max.x - origin.x)*invDir.x;
+    float tmin = fminf(t1, t2), tmax = fmaxf(t1, t2);
+
+    t1 = (box.min.y - origin.y)*invDir.y;
+    t2 = (box.max.y - origin.y)*invDir.y;
+    tmin = fmaxf(tmin, fminf(t1, t2));
+    tmax = fminf(tmax, fmaxf(t1, t2));
+
+    t1 = (box.min.z - origin.z)*invDir.z;
+    t2 = (box.max.z - origin.z)*invDir.z;
+    tmin = fmaxf(tmin, fminf(t1, t2));
+    tmax = fminf(tmax, fmaxf(t1, t2));
+
+    if (tmax < 0.0f || tmin > tmax || tmin > maxDistance) return false;
+    *tNear = fmaxf(tmin, 0.0f);
+    return true;
+}
+
+RayCollision RayBoxCollision(Ray ray, BoundingBox box, float distance) {
+    RayCollision col = { 0 };
+    col.hit = true;
+    col.distance = distance;
+    col.point = Vector3Add(ray.position, Vector3Scale(ray.direction, distance));
+
+    // The face whose plane the hit point lies closest to
+    float faces[6] = {
+        fabsf(col.point.x - box.min.x), fabsf(col.point.x - box.max.x),
+        fabsf(col.point.y - box.min.y), fabsf(col.point.y - box.max.y),
+        fabsf(col.point.z - box.min.z), fabsf(col.point.z - box.max.z)
+    };
+    int best = 0;
+    for (int i = 1; i < 6; i++) if (faces[i] < faces[best]) best = i;
+
+    float sign = (best & 1) ? 1.0f : -1.0f;
+    if (best < 2) col.normal = (Vector3){ sign, 0, 0 };
+    else if (best < 4) col.normal = (Vector3){ 0, sign, 0 };
+    else col.normal = (Vector3){ 0, 0, sign };
+    return col;
+}
+
+bool BvhRaycast(const Bvh *bvh, Ray ray, float maxDistance, RayCollision *hit, int *item) {
+    if (bvh->nodeCount == 0) return false;
+
+    Vector3 inv = { 1.0f/ray.direction.x, 1.0f/ray.direction.y, 1.0f/ray.direction.z };
+    float best = maxDistance;
+    int bestBox = -1;
+    float t;
+
+    if (!RayBoxSlab(ray.position, inv, bvh->nodes[0].box, best, &t)) return false;
+
+    int stack[BVH_STACK_SIZE];
+    int sp = 0;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+        const BvhNode *node = &bvh->nodes[stack[--sp]];
+
+        if (node->count > 0) {
+            for (int i = node->first; i < node->first + node->count; i++) {
+                if (RayBoxSlab(ray.position, inv, bvh->boxes[i], best, &t) && (t < best || bestBox < 0)) {
+                    best = t;
+                    bestBox = i;
+                }
+            }
+            continue;
+        }
+
+        int a = node->first, b = node->first + 1;
+        float ta, tb;
+        bool hitA = RayBoxSlab(ray.position, inv, bvh->nodes[a].box, best, &ta);
+        bool hitB = RayBoxSlab(ray.position, inv, bvh->nodes[b].box, best, &tb);
+
+        if (hitA && hitB) {
+            if (ta > tb) { int s = a; a = b; b = s; }
+            if (sp + 2 > BVH_STACK_SIZE) break;
+            stack[sp++] = b;
+            stack[sp++] = a;
+        } else if (hitA || hitB) {
+            if (sp + 1 > BVH_STACK_SIZE) break;
+            stack[sp++] = hitA ? a : b;
+        }
+    }
+
+    if (bestBox < 0) return false;
+    if (hit) *hit = RayBoxCollision(ray, bvh->boxes[bestBox], best);
+    if (item) *item = bvh->items[bestBox];
+    return true;
+}
+
+static bool BoxesOverlap(BoundingBox a, BoundingBox b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+int BvhQueryBox(const Bvh *bvh, BoundingBox box, int *out, int maxOut) {
+    if (bvh->nodeCount == 0) return 0;
+
+    int stack[BVH_STACK_SIZE];
+    int sp = 0;
+    int found = 0;
+    stack[sp++] = 0;
+
+    while (sp > 0) {
+        const BvhNode *node = &bvh->nodes[stack[--sp]];
+        if (!BoxesOverlap(node->box, box)) continue;
+
+        if (node->count > 0) {
+            for (int i = node->first; i < node->first + node->count; i++) {
+                if (!BoxesOverlap(bvh->boxes[i], box)) continue;
+                if (found < maxOut) out[found] = bvh->items[i];
+                found++;
+            }
+        } else if (sp + 2 <= BVH_STACK_SIZE) {
+            stack[sp++] = node->first + 1;
+            stack[sp++] = node->first;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,45 @@
+#ifndef CS2_BVH_H
+#define CS2_BVH_H
+
+#include "raylib.h"
+
+// Static bounding volume hierarchy over axis-aligned boxes. Inner nodes keep
+// their two children next to each other (left = first, right = first + 1);
+// leaves reference a run of boxes, which are stored in leaf order so a leaf
+// test walks contiguous memory. Everything is flat POD arrays so a built tree
+// can be written to disk and used in place.
+
+#define BVH_LEAF_SIZE 4
+#define BVH_STACK_SIZE 96
+
+typedef struct {
+    BoundingBox box;
+    int first;
+    int count;
+} BvhNode;
+
+typedef struct {
+    BvhNode *nodes;
+    BoundingBox *boxes;
+    int *items;
+    int nodeCount;
+    int itemCount;
+    bool owned;
+} Bvh;
+
+// Returns false if out of memory, leaving the tree empty
+bool BvhBuild(Bvh *bvh, const BoundingBox *boxes, int count);
+void BvhFree(Bvh *bvh);
+
+// Nearest box hit by the ray within maxDistance; item is the index that was
+// passed to BvhBuild. A ray starting inside a box hits it at distance 0.
+bool BvhRaycast(const Bvh *bvh, Ray ray, float maxDistance, RayCollision *hit, int *item);
+
+// Writes up to maxOut items whose boxes overlap box and returns how many overlap
+int BvhQueryBox(const Bvh *bvh, BoundingBox box, int *out, int maxOut);
+
+// Slab test shared with the other spatial structures. invDir is 1/direction.
+bool RayBoxSlab(Vector3 origin, Vector3 invDir, BoundingBox box, float maxDistance, float *tNear);
+RayCollision RayBoxCollision(Ray ray, BoundingBox box, float distance);
+
+#endif
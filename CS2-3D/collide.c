@@ -0,0 +1,130 @@
+#include "collide.h"
+#include "raymath.h"
+#include <float.h>
+#include <math.h>
+
+static BoundingBox WallBox(const Wall *wall) {
+    Vector3 half = Vector3Scale(wall->size, 0.5f);
+    return (BoundingBox){ Vector3Subtract(wall->position, half), Vector3Add(wall->position, half) };
+}
+
+// Slab test of the moving centre against the wall grown by the box's half
+// extents. A box that already overlaps counts as hit at t = 0 if it is moving
+// further in across the face it is nearest to leaving by.
+static bool SweepOne(BoundingBox wall, Vector3 center, Vector3 half, Vector3 motion, float *t, Vector3 *normal) {
+    float c[3] = { center.x, center.y, center.z };
+    float m[3] = { motion.x, motion.y, motion.z };
+    float lo[3] = { wall.min.x - half.x, wall.min.y - half.y, wall.min.z - half.z };
+    float hi[3] = { wall.max.x + half.x, wall.max.y + half.y, wall.max.z + half.z };
+
+    float enter = -FLT_MAX, exit = FLT_MAX;
+    int axis = -1;
+    for (int a = 0; a < 3; a++) {
+        if (m[a] == 0.0f) {
+            if (c[a] <= lo[a] || c[a] >= hi[a]) return false;
+            continue;
+        }
+        float inv = 1.0f/m[a];
+        float t0 = (lo[a] - c[a])*inv;
+        float t1 = (hi[a] - c[a])*inv;
+        if (t0 > t1) { float s = t0; t0 = t1; t1 = s; }
+        if (t0 > enter) { enter = t0; axis = a; }
+        if (t1 < exit) exit = t1;
+    }
+    if (axis < 0 || enter >= exit || exit <= 0.0f || enter > 1.0f) return false;
+
+    float n[3] = { 0.0f, 0.0f, 0.0f };
+    if (enter >= 0.0f) {
+        n[axis] = (m[axis] > 0.0f) ? -1.0f : 1.0f;
+        *t = enter;
+    } else {
+        // Already inside: the way out is through the nearest face
+        float depth = FLT_MAX;
+        for (int a = 0; a < 3; a++) {
+            if (c[a] - lo[a] < depth) { depth = c[a] - lo[a]; axis = a; n[0] = n[1] = n[2] = 0.0f; n[a] = -1.0f; }
+            if (hi[a] - c[a] < depth) { depth = hi[a] - c[a]; axis = a; n[0] = n[1] = n[2] = 0.0f; n[a] = 1.0f; }
+        }
+        if (m[axis]*n[axis] >= 0.0f) return false;
+        *t = 0.0f;
+    }
+    *normal = (Vector3){ n[0], n[1], n[2] };
+    return true;
+}
+
+static int GatherCandidates(const Bvh *bvh, Vector3 center, Vector3 half, Vector3 motion, int *out) {
+    Vector3 grow = { half.x + COLLIDE_SKIN, half.y + COLLIDE_SKIN, half.z + COLLIDE_SKIN };
+    Vector3 end = Vector3Add(center, motion);
+    BoundingBox swept = {
+        Vector3Subtract(Vector3Min(center, end), grow),
+        Vector3Add(Vector3Max(center, end), grow)
+    };
+    int found = BvhQueryBox(bvh, swept, out, COLLIDE_MAX_CANDIDATES);
+    return found < COLLIDE_MAX_CANDIDATES ? found : COLLIDE_MAX_CANDIDATES;
+}
+
+static bool SweepCandidates(const Wall *walls, const int *candidates, int count, Vector3 center, Vector3 half, Vector3 motion, float *t, Vector3 *normal) {
+    float best = FLT_MAX;
+    for (int i = 0; i < count; i++) {
+        float hitT;
+        Vector3 hitNormal;
+        if (SweepOne(WallBox(&walls[candidates[i]]), center, half, motion, &hitT, &hitNormal) && hitT < best) {
+            best = hitT;
+            *normal = hitNormal;
+        }
+    }
+    if (best == FLT_MAX) return false;
+    *t = best;
+    return true;
+}
+
+bool SweepBox(const Bvh *bvh, const Wall *walls, Vector3 center, Vector3 half, Vector3 motion, float *t, Vector3 *normal) {
+    int candidates[COLLIDE_MAX_CANDIDATES];
+    int count = GatherCandidates(bvh, center, half, motion, candidates);
+    return SweepCandidates(walls, candidates, count, center, half, motion, t, normal);
+}
+
+bool SweepBoxLinear(const Wall *walls, int wallCount, Vector3 center, Vector3 half, Vector3 motion, float *t, Vector3 *normal) {
+    float best = FLT_MAX;
+    for (int i = 0; i < wallCount; i++) {
+        float hitT;
+        Vector3 hitNormal;
+        if (SweepOne(WallBox(&walls[i]), center, half, motion, &hitT, &hitNormal) && hitT < best) {
+            best = hitT;
+            *normal = hitNormal;
+        }
+    }
+    if (best == FLT_MAX) return false;
+    *t = best;
+    return true;
+}
+
+MoveResult MoveAndSlide(const Bvh *bvh, const Wall *walls, Vector3 center, Vector3 half, Vector3 motion) {
+    MoveResult result = { center, false, false, false };
+
+    // Sliding only ever removes part of the motion, so every slide stays
+    // inside the box swept by the original move and one query covers them all
+    int candidates[COLLIDE_MAX_CANDIDATES];
+    int count = GatherCandidates(bvh, center, half, motion, candidates);
+
+    for (int slide = 0; slide < COLLIDE_MAX_SLIDES; slide++) {
+        if (Vector3LengthSqr(motion) == 0.0f) break;
+
+        float t;
+        Vector3 normal;
+        if (!SweepCandidates(walls, candidates, count, result.position, half, motion, &t, &normal)) {
+            result.position = Vector3Add(result.position, motion);
+            return result;
+        }
+
+        result.position = Vector3Add(result.position, Vector3Scale(motion, t));
+        result.position = Vector3Add(result.position, Vector3Scale(normal, COLLIDE_SKIN));
+        if (normal.y > 0.7f) result.hitFloor = true;
+        else if (normal.y < -0.7f) result.hitCeiling = true;
+        else result.hitWall = true;
+
+        // What is left of the move, minus the part going into the wall
+        motion = Vector3Scale(motion, 1.0f - t);
+        motion = Vector3Subtract(motion, Vector3Scale(normal, Vector3DotProduct(motion, normal)));
+    }
+    return result;
+}
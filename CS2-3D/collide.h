@@ -0,0 +1,33 @@
+#ifndef CS2_COLLIDE_H
+#define CS2_COLLIDE_H
+
+#include "game.h"
+#include "bvh.h"
+
+// Swept axis-aligned boxes against the map walls. The walls near the whole
+// move come from one BVH box query, so a move costs about the same on a
+// map of any size. Boxes are stopped a hair short of the wall they hit and
+// never end a move inside one.
+
+#define COLLIDE_MAX_CANDIDATES 256
+#define COLLIDE_MAX_SLIDES 4
+#define COLLIDE_SKIN 1e-3f       // gap left between a stopped box and the wall
+
+typedef struct {
+    Vector3 position;       // box centre after the move
+    bool hitFloor;          // stopped by something below (normal.y > 0.7)
+    bool hitCeiling;
+    bool hitWall;
+} MoveResult;
+
+// Earliest contact of a box of half extents half moving from center by motion.
+// t is the fraction of motion travelled (0..1) and normal the face that was hit.
+bool SweepBox(const Bvh *bvh, const Wall *walls, Vector3 center, Vector3 half, Vector3 motion, float *t, Vector3 *normal);
+
+// Moves the box, sliding along whatever it hits for up to COLLIDE_MAX_SLIDES contacts
+MoveResult MoveAndSlide(const Bvh *bvh, const Wall *walls, Vector3 center, Vector3 half, Vector3 motion);
+
+// Reference SweepBox that tests every wall, for checking the BVH version
+bool SweepBoxLinear(const Wall *walls, int wallCount, Vector3 center, Vector3 half, Vector3 motion, float *t, Vector3 *normal);
+
+#endif
@@ -0,0 +1,245 @@
+#include "cull.h"
+#include "raymath.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+// Up to 4 corners plus one from clipping against the near plane
+#define CULL_MAX_POLYGON 8
+
+typedef struct {
+    float x, y, w;
+} ClipVertex;
+
+typedef struct {
+    float x, y, invW;
+} ScreenVertex;
+
+// Corners of a box face in order around it (bit 0 is x, bit 1 y, bit 2 z)
+static const unsigned char faceCorners[6][4] = {
+    { 0, 2, 6, 4 }, { 1, 3, 7, 5 },     // -x, +x
+    { 0, 1, 5, 4 }, { 2, 3, 7, 6 },     // -y, +y
+    { 0, 1, 3, 2 }, { 4, 5, 7, 6 }      // -z, +z
+};
+
+static ClipVertex ToClip(const Matrix *m, Vector3 p) {
+    return (ClipVertex){ m->m0*p.x + m->m4*p.y + m->m8*p.z + m->m12,
+                         m->m1*p.x + m->m5*p.y + m->m9*p.z + m->m13,
+                         m->m3*p.x + m->m7*p.y + m->m11*p.z + m->m15 };
+}
+
+static ScreenVertex ToScreen(ClipVertex v) {
+    float invW = 1.0f/v.w;
+    return (ScreenVertex){ (v.x*invW*0.5f + 0.5f)*CULL_DEPTH_WIDTH, (0.5f - v.y*invW*0.5f)*CULL_DEPTH_HEIGHT, invW };
+}
+
+static Vector3 BoxCorner(BoundingBox box, int corner) {
+    return (Vector3){ (corner & 1) ? box.max.x : box.min.x, (corner & 2) ? box.max.y : box.min.y, (corner & 4) ? box.max.z : box.min.z };
+}
+
+static bool InFrustum(const Culler *cull, BoundingBox box) {
+    for (int i = 0; i < 6; i++) {
+        Vector4 p = cull->planes[i];
+        float x = (p.x >= 0.0f) ? box.max.x : box.min.x;
+        float y = (p.y >= 0.0f) ? box.max.y : box.min.y;
+        float z = (p.z >= 0.0f) ? box.max.z : box.min.z;
+        if (p.x*x + p.y*y + p.z*z + p.w < 0.0f) return false;
+    }
+    return true;
+}
+
+// Fills the pixels a convex polygon covers completely with the smallest 1/w
+// it has inside each of them, where that is nearer than what is there
+static void RasterizePolygon(Culler *cull, const ScreenVertex *v, int count) {
+    float area = 0.0f;
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < count; i++) {
+        int j = (i + 1) % count;
+        area += v[i].x*v[j].y - v[j].x*v[i].y;
+        minX = fminf(minX, v[i].x);
+        minY = fminf(minY, v[i].y);
+        maxX = fmaxf(maxX, v[i].x);
+        maxY = fmaxf(maxY, v[i].y);
+    }
+    if (fabsf(area) < 1e-3f) return;
+    float winding = (area > 0.0f) ? 1.0f : -1.0f;
+
+    // 1/w is a plane over the screen; take it from the best shaped fan triangle
+    float bestDet = 0.0f, a = 0.0f, b = 0.0f;
+    for (int i = 1; i + 1 < count; i++) {
+        float x1 = v[i].x - v[0].x, y1 = v[i].y - v[0].y, w1 = v[i].invW - v[0].invW;
+        float x2 = v[i + 1].x - v[0].x, y2 = v[i + 1].y - v[0].y, w2 = v[i + 1].invW - v[0].invW;
+        float det = x1*y2 - x2*y1;
+        if (fabsf(det) > fabsf(bestDet)) {
+            bestDet = det;
+            a = (w1*y2 - w2*y1)/det;
+            b = (x1*w2 - x2*w1)/det;
+        }
+    }
+    if (bestDet == 0.0f) return;
+    float c = v[0].invW - a*v[0].x - b*v[0].y - 0.5f*(fabsf(a) + fabsf(b));
+
+    // A pixel is covered when its centre is half a pixel inside every edge
+    float edgeX[CULL_MAX_POLYGON], edgeY[CULL_MAX_POLYGON], margin[CULL_MAX_POLYGON];
+    for (int i = 0; i < count; i++) {
+        int j = (i + 1) % count;
+        edgeX[i] = (v[j].x - v[i].x)*winding;
+        edgeY[i] = (v[j].y - v[i].y)*winding;
+        margin[i] = 0.5f*(fabsf(edgeX[i]) + fabsf(edgeY[i]));
+    }
+
+    int x0 = (int)fmaxf(minX, 0.0f), x1 = (int)fminf(maxX, (float)CULL_DEPTH_WIDTH - 1.0f);
+    int y0 = (int)fmaxf(minY, 0.0f), y1 = (int)fminf(maxY, (float)CULL_DEPTH_HEIGHT - 1.0f);
+    // Along a row each edge value falls by edgeY per pixel, so the covered
+    // pixels are one span found from the edges rather than pixel by pixel
+    for (int y = y0; y <= y1; y++) {
+        float cy = (float)y + 0.5f, cx = (float)x0 + 0.5f;
+        float first = 0.0f, last = (float)(x1 - x0);
+        for (int i = 0; i < count && first <= last; i++) {
+            float value = edgeX[i]*(cy - v[i].y) - edgeY[i]*(cx - v[i].x) - margin[i];
+            if (edgeY[i] > 0.0f) last = fminf(last, floorf(value/edgeY[i]));
+            else if (edgeY[i] < 0.0f) first = fmaxf(first, ceilf(value/edgeY[i]));
+            else if (value < 0.0f) first = last + 1.0f;
+        }
+        if (first > last) continue;
+        float *row = &cull->depth[y*CULL_DEPTH_WIDTH];
+        int from = x0 + (int)first, to = x0 + (int)last;
+        float invW = a*((float)from + 0.5f) + b*cy + c;
+        for (int x = from; x <= to; x++, invW += a) {
+            if (invW > row[x]) row[x] = invW;
+        }
+    }
+}
+
+// Draws the faces of the box that look at the eye, clipped to the near plane
+static void RasterizeBox(Culler *cull, BoundingBox box) {
+    ClipVertex corners[8];
+    for (int i = 0; i < 8; i++) corners[i] = ToClip(&cull->viewProjection, BoxCorner(box, i));
+
+    bool facing[6] = {
+        cull->eye.x < box.min.x, cull->eye.x > box.max.x,
+        cull->eye.y < box.min.y, cull->eye.y > box.max.y,
+        cull->eye.z < box.min.z, cull->eye.z > box.max.z
+    };
+    for (int f = 0; f < 6; f++) {
+        if (!facing[f]) continue;
+        ScreenVertex polygon[CULL_MAX_POLYGON];
+        int count = 0;
+        for (int i = 0; i < 4; i++) {
+            ClipVertex p = corners[faceCorners[f][i]], q = corners[faceCorners[f][(i + 1) % 4]];
+            if (p.w >= CULL_NEAR) polygon[count++] = ToScreen(p);
+            if ((p.w >= CULL_NEAR) != (q.w >= CULL_NEAR)) {
+                float t = (CULL_NEAR - p.w)/(q.w - p.w);
+                polygon[count++] = ToScreen((ClipVertex){ p.x + (q.x - p.x)*t, p.y + (q.y - p.y)*t, CULL_NEAR });
+            }
+        }
+        if (count >= 3) RasterizePolygon(cull, polygon, count);
+    }
+}
+
+// Big walls near the eye and in view, the ones that should hide the most first
+static void DrawOccluders(Culler *cull, const Bvh *wallBvh, const Wall *walls) {
+    Vector3 reach = { CULL_OCCLUDER_RANGE, CULL_OCCLUDER_RANGE, CULL_OCCLUDER_RANGE };
+    BoundingBox around = { Vector3Subtract(cull->eye, reach), Vector3Add(cull->eye, reach) };
+    int found = BvhQueryBox(wallBvh, around, cull->candidates, CULL_MAX_CANDIDATES);
+    if (found > CULL_MAX_CANDIDATES) found = CULL_MAX_CANDIDATES;
+
+    int best[CULL_MAX_OCCLUDERS];
+    float bestScore[CULL_MAX_OCCLUDERS];
+    int count = 0;
+    for (int i = 0; i < found; i++) {
+        const Wall *w = &walls[cull->candidates[i]];
+        if (w->size.y < CULL_MIN_OCCLUDER_HEIGHT) continue;
+        BoundingBox box = { Vector3Subtract(w->position, Vector3Scale(w->size, 0.5f)), Vector3Add(w->position, Vector3Scale(w->size, 0.5f)) };
+        if (!InFrustum(cull, box)) continue;
+
+        // Roughly the screen area it could cover
+        float distance = Vector3Distance(cull->eye, w->position);
+        float score = (w->size.x*w->size.y + w->size.z*w->size.y + w->size.x*w->size.z)/(distance*distance + 1.0f);
+        if (count == CULL_MAX_OCCLUDERS && score <= bestScore[count - 1]) continue;
+        int slot = (count < CULL_MAX_OCCLUDERS) ? count++ : count - 1;
+        while (slot > 0 && bestScore[slot - 1] < score) {
+            best[slot] = best[slot - 1];
+            bestScore[slot] = bestScore[slot - 1];
+            slot--;
+        }
+        best[slot] = cull->candidates[i];
+        bestScore[slot] = score;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const Wall *w = &walls[best[i]];
+        RasterizeBox(cull, (BoundingBox){ Vector3Subtract(w->position, Vector3Scale(w->size, 0.5f)), Vector3Add(w->position, Vector3Scale(w->size, 0.5f)) });
+    }
+    cull->occluders = count;
+}
+
+void CullBegin(Culler *cull, Camera3D camera, float aspect, const Bvh *wallBvh, const Wall *walls) {
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection = MatrixPerspective(camera.fovy*DEG2RAD, aspect, CULL_NEAR, CULL_FAR);
+    Matrix m = MatrixMultiply(view, projection);
+    cull->viewProjection = m;
+    cull->eye = camera.position;
+
+    // Gribb and Hartmann: each plane is the w row plus or minus another row
+    Vector4 rowX = { m.m0, m.m4, m.m8, m.m12 }, rowY = { m.m1, m.m5, m.m9, m.m13 };
+    Vector4 rowZ = { m.m2, m.m6, m.m10, m.m14 }, rowW = { m.m3, m.m7, m.m11, m.m15 };
+    Vector4 rows[3] = { rowX, rowY, rowZ };
+    for (int i = 0; i < 3; i++) {
+        for (int s = 0; s < 2; s++) {
+            float sign = s ? -1.0f : 1.0f;
+            Vector4 p = { rowW.x + sign*rows[i].x, rowW.y + sign*rows[i].y, rowW.z + sign*rows[i].z, rowW.w + sign*rows[i].w };
+            float length = sqrtf(p.x*p.x + p.y*p.y + p.z*p.z);
+            cull->planes[2*i + s] = (Vector4){ p.x/length, p.y/length, p.z/length, p.w/length };
+        }
+    }
+
+    memset(cull->counters, 0, sizeof(cull->counters));
+    memset(cull->depth, 0, sizeof(cull->depth));
+    cull->occluders = 0;
+    if (wallBvh && wallBvh->nodeCount > 0) DrawOccluders(cull, wallBvh, walls);
+    cull->occlusion = cull->occluders > 0;
+}
+
+// Hidden when no pixel under the box's screen rectangle is open further back
+// than its nearest corner. Boxes reaching behind the near plane never are.
+static bool Occluded(const Culler *cull, BoundingBox box) {
+    float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, nearest = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        ClipVertex v = ToClip(&cull->viewProjection, BoxCorner(box, i));
+        if (v.w < CULL_NEAR) return false;
+        ScreenVertex s = ToScreen(v);
+        minX = fminf(minX, s.x);
+        minY = fminf(minY, s.y);
+        maxX = fmaxf(maxX, s.x);
+        maxY = fmaxf(maxY, s.y);
+        nearest = fmaxf(nearest, s.invW);
+    }
+
+    int x0 = (int)fmaxf(floorf(minX), 0.0f), x1 = (int)fminf(ceilf(maxX) - 1.0f, (float)CULL_DEPTH_WIDTH - 1.0f);
+    int y0 = (int)fmaxf(floorf(minY), 0.0f), y1 = (int)fminf(ceilf(maxY) - 1.0f, (float)CULL_DEPTH_HEIGHT - 1.0f);
+    if (x1 < x0) x1 = x0;
+    if (y1 < y0) y1 = y0;
+    if (x0 >= CULL_DEPTH_WIDTH || y0 >= CULL_DEPTH_HEIGHT) return false;
+    for (int y = y0; y <= y1; y++) {
+        const float *row = &cull->depth[y*CULL_DEPTH_WIDTH];
+        for (int x = x0; x <= x1; x++) {
+            if (row[x] <= nearest) return false;
+        }
+    }
+    return true;
+}
+
+bool CullBox(Culler *cull, BoundingBox box, CullKind kind) {
+    CullCounters *counters = &cull->counters[kind];
+    if (!InFrustum(cull, box)) {
+        counters->frustumCulled++;
+        return false;
+    }
+    if (cull->occlusion && Occluded(cull, box)) {
+        counters->occluded++;
+        return false;
+    }
+    counters->submitted++;
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef CS2_CULL_H
+#define CS2_CULL_H
+
+#include "raylib.h"
+#include "game.h"
+#include "bvh.h"
+
+// Decides what is worth drawing this frame. A box is dropped when it is
+// outside the camera frustum, or when it is hidden behind the walls drawn
+// into a small software depth buffer at the start of the frame: the nearest
+// big walls in front of the camera, rasterised on the CPU. A box is hidden
+// when every depth pixel its screen rectangle touches holds a wall closer
+// than the box's nearest corner. Walls only claim pixels they cover
+// completely, at the far end of their depth inside the pixel, so both tests
+// can only err towards drawing.
+
+#define CULL_DEPTH_WIDTH 256
+#define CULL_DEPTH_HEIGHT 144
+#define CULL_NEAR 0.01f                 // raylib's clip planes
+#define CULL_FAR 1000.0f
+#define CULL_OCCLUDER_RANGE 60.0f       // walls further away are not rasterised
+#define CULL_MAX_CANDIDATES 4096
+#define CULL_MAX_OCCLUDERS 48
+#define CULL_MIN_OCCLUDER_HEIGHT 1.5f   // lower walls hide too little to be worth it
+
+typedef enum {
+    CULL_WALLS,
+    CULL_TARGETS,
+    CULL_PARTICLES,
+    CULL_GRENADES,
+    CULL_KIND_COUNT
+} CullKind;
+
+typedef struct {
+    int submitted;
+    int frustumCulled;
+    int occluded;
+} CullCounters;
+
+typedef struct {
+    Vector4 planes[6];                  // inside where dot(p.xyz, point) + p.w >= 0
+    Matrix viewProjection;
+    Vector3 eye;
+    bool occlusion;                     // CullBegin turns it on when there are occluders
+    int occluders;                      // rasterised this frame
+    CullCounters counters[CULL_KIND_COUNT];
+    float depth[CULL_DEPTH_WIDTH*CULL_DEPTH_HEIGHT];   // nearest wall's 1/w, 0 for none
+    int candidates[CULL_MAX_CANDIDATES];
+} Culler;
+
+// Sets up the frustum for the camera, clears the counters and rasterises the
+// occluders, picked from walls near the camera through wallBvh
+void CullBegin(Culler *cull, Camera3D camera, float aspect, const Bvh *wallBvh, const Wall *walls);
+
+// Whether anything inside box can be seen; counts the answer under kind
+bool CullBox(Culler *cull, BoundingBox box, CullKind kind);
+
+#endif
@@ -0,0 +1,487 @@
+#include "demo.h"
+#include "hitscan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// What changed in a player's input since the tick before
+#define DEMO_MOVE 0x01
+#define DEMO_LOOK 0x02
+#define DEMO_BUTTONS 0x04
+#define DEMO_SELECT 0x08
+#define DEMO_VIEW 0x10
+
+// Before the players' inputs of a tick
+#define DEMO_TICK_WEAPONS 0x01      // a WeaponTable follows
+
+typedef struct {
+    uint8_t **data;
+    size_t *capacity;
+    uint64_t *used;
+    bool failed;
+} Writer;
+
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool failed;
+} Reader;
+
+static void Put(Writer *w, const void *bytes, size_t size) {
+    if (w->failed || size == 0) return;
+    if (*w->used + size > *w->capacity) {
+        size_t capacity = *w->capacity ? *w->capacity : 4096;
+        while (capacity < *w->used + size) capacity *= 2;
+        uint8_t *data = realloc(*w->data, capacity);
+        if (!data) {
+            w->failed = true;
+            return;
+        }
+        *w->data = data;
+        *w->capacity = capacity;
+    }
+    memcpy(*w->data + *w->used, bytes, size);
+    *w->used += size;
+}
+
+static void PutInt(Writer *w, int32_t value) {
+    Put(w, &value, sizeof(value));
+}
+
+static void Get(Reader *r, void *bytes, size_t size) {
+    if (r->failed || size > r->size - r->pos) {
+        r->failed = true;
+        memset(bytes, 0, size);
+        return;
+    }
+    memcpy(bytes, r->data + r->pos, size);
+    r->pos += size;
+}
+
+// Steps over size bytes, returning where they start (NULL past the end)
+static const uint8_t *Skip(Reader *r, size_t size) {
+    if (r->failed || size > r->size - r->pos) {
+        r->failed = true;
+        return NULL;
+    }
+    r->pos += size;
+    return r->data + r->pos - size;
+}
+
+static int32_t GetInt(Reader *r) {
+    int32_t value;
+    Get(r, &value, sizeof(value));
+    return value;
+}
+
+static PlayerInput BaseInput(void) {
+    return (PlayerInput){ .selectWeapon = -1 };
+}
+
+static uint8_t Buttons(const PlayerInput *in) {
+    return (uint8_t)(in->fireHeld | in->firePressed << 1 | in->jump << 2 | in->reload << 3 | in->inspect << 4 | in->reset << 5);
+}
+
+static bool SameFloats(const void *a, const void *b, size_t size) {
+    return memcmp(a, b, size) == 0;
+}
+
+static void EncodeInput(Writer *w, const PlayerInput *last, const PlayerInput *in) {
+    static const Vector2 still = { 0 };
+    uint8_t buttons = Buttons(in);
+    uint8_t mask = 0;
+    if (!SameFloats(&in->forward, &last->forward, sizeof(float)) || !SameFloats(&in->right, &last->right, sizeof(float))) mask |= DEMO_MOVE;
+    if (!SameFloats(&in->look, &still, sizeof(Vector2))) mask |= DEMO_LOOK;
+    if (buttons != Buttons(last)) mask |= DEMO_BUTTONS;
+    if (in->selectWeapon != -1) mask |= DEMO_SELECT;
+    if (in->viewTick != last->viewTick || !SameFloats(&in->viewFraction, &last->viewFraction, sizeof(float))) mask |= DEMO_VIEW;
+
+    Put(w, &mask, 1);
+    if (mask & DEMO_MOVE) {
+        Put(w, &in->forward, sizeof(float));
+        Put(w, &in->right, sizeof(float));
+    }
+    if (mask & DEMO_LOOK) Put(w, &in->look, sizeof(Vector2));
+    if (mask & DEMO_BUTTONS) Put(w, &buttons, 1);
+    if (mask & DEMO_SELECT) {
+        uint8_t weapon = (uint8_t)in->selectWeapon;
+        Put(w, &weapon, 1);
+    }
+    if (mask & DEMO_VIEW) {
+        Put(w, &in->viewTick, sizeof(uint32_t));
+        Put(w, &in->viewFraction, sizeof(float));
+    }
+}
+
+static PlayerInput DecodeInput(Reader *r, const PlayerInput *last) {
+    PlayerInput in = *last;
+    in.look = (Vector2){ 0 };
+    in.firePressed = in.jump = in.reload = in.inspect = in.reset = false;
+    in.selectWeapon = -1;
+
+    uint8_t mask;
+    Get(r, &mask, 1);
+    if (mask & DEMO_MOVE) {
+        Get(r, &in.forward, sizeof(float));
+        Get(r, &in.right, sizeof(float));
+    }
+    if (mask & DEMO_LOOK) Get(r, &in.look, sizeof(Vector2));
+    uint8_t buttons = Buttons(last);
+    if (mask & DEMO_BUTTONS) Get(r, &buttons, 1);
+    in.fireHeld = buttons & 1;
+    in.firePressed = buttons & 2;
+    in.jump = buttons & 4;
+    in.reload = buttons & 8;
+    in.inspect = buttons & 16;
+    in.reset = buttons & 32;
+    if (mask & DEMO_SELECT) {
+        uint8_t weapon;
+        Get(r, &weapon, 1);
+        in.selectWeapon = weapon;
+    }
+    if (mask & DEMO_VIEW) {
+        Get(r, &in.viewTick, sizeof(uint32_t));
+        Get(r, &in.viewFraction, sizeof(float));
+    }
+    return in;
+}
+
+// Everything WorldStep reads that a reset does not put back by itself. The
+// walls, BVH and nav grid come from the map and are left alone.
+static void WriteState(Writer *w, const World *world) {
+    Put(w, &world->tick, sizeof(world->tick));
+    Put(w, &world->rng, sizeof(world->rng));
+    Put(w, &world->weapons, sizeof(world->weapons));
+
+    PutInt(w, world->playerCount);
+    Put(w, world->players, world->playerCount*sizeof(Player));
+    Put(w, world->prevEye, world->playerCount*sizeof(Vector3));
+    Put(w, world->playerNames, world->playerCount*sizeof(uint16_t));
+    PutInt(w, world->names.count);
+    Put(w, world->names.names, world->names.count*sizeof(world->names.names[0]));
+    Put(w, &world->killFeed, sizeof(world->killFeed));
+
+    PutInt(w, world->botCount);
+    Put(w, world->targets, world->botCount*sizeof(Target));
+    Put(w, world->bots, world->botCount*sizeof(BotBrain));
+    NavFlowState flows;
+    NavFlowSave(&world->nav, &flows);
+    Put(w, &flows, sizeof(flows));
+
+    PutInt(w, world->projectiles.count);
+    Put(w, world->projectiles.items, world->projectiles.count*sizeof(Projectile));
+
+    for (int t = 0; t < PARTICLE_TYPE_COUNT; t++) {
+        const ParticleBucket *b = &world->particles.buckets[t];
+        PutInt(w, b->count);
+        const float *fields[] = { b->x, b->y, b->z, b->vx, b->vy, b->vz, b->size, b->life };
+        for (int f = 0; f < 8; f++) Put(w, fields[f], b->count*sizeof(float));
+        Put(w, b->color, b->count*sizeof(Color));
+    }
+
+    // Lag frames oldest first, only the bots' boxes; the rest are never hittable
+    const LagHistory *lag = &world->lagHistory;
+    PutInt(w, lag->count);
+    Put(w, &lag->newest, sizeof(lag->newest));
+    for (int k = lag->count - 1; k >= 0; k--) {
+        const LagFrame *frame = &lag->frames[(lag->newest - (uint32_t)k) % LAG_HISTORY_TICKS];
+        Put(w, &frame->tick, sizeof(frame->tick));
+        Put(w, frame->head, world->botCount*sizeof(BoundingBox));
+        Put(w, frame->body, world->botCount*sizeof(BoundingBox));
+        Put(w, frame->hittable, world->botCount);
+    }
+}
+
+static bool ValidWeapons(const WeaponTable *weapons) {
+    return weapons->count > 0 && weapons->count <= MAX_WEAPONS;
+}
+
+// Counts and indices read back are checked before anything indexes with them
+static bool ReadState(Reader *r, World *world) {
+    Get(r, &world->tick, sizeof(world->tick));
+    Get(r, &world->rng, sizeof(world->rng));
+    Get(r, &world->weapons, sizeof(world->weapons));
+    if (!ValidWeapons(&world->weapons)) return false;
+
+    if (GetInt(r) != world->playerCount) return false;
+    Get(r, world->players, world->playerCount*sizeof(Player));
+    for (int i = 0; i < world->playerCount; i++) {
+        const Player *p = &world->players[i];
+        if ((int)p->weapon < 0 || (int)p->weapon >= world->weapons.count ||
+            (int)p->lastWeapon < 0 || (int)p->lastWeapon >= world->weapons.count) return false;
+    }
+    Get(r, world->prevEye, world->playerCount*sizeof(Vector3));
+    Get(r, world->playerNames, world->playerCount*sizeof(uint16_t));
+    int names = GetInt(r);
+    if (names < 0 || names > EVENT_MAX_NAMES) return false;
+    world->names.count = names;
+    Get(r, world->names.names, names*sizeof(world->names.names[0]));
+    Get(r, &world->killFeed, sizeof(world->killFeed));
+
+    if (GetInt(r) != world->botCount) return false;
+    Get(r, world->targets, world->botCount*sizeof(Target));
+    Get(r, world->bots, world->botCount*sizeof(BotBrain));
+    for (int i = 0; i < world->botCount; i++) {
+        const BotBrain *brain = &world->bots[i];
+        if (brain->pathLength < 0 || brain->pathLength > BOT_PATH_POINTS ||
+            brain->pathNext < 0 || brain->pathNext > BOT_PATH_POINTS) return false;
+    }
+    // A seek is a jump; nothing to draw between
+    for (int i = 0; i < world->botCount; i++) world->prevTarget[i] = world->targets[i].position;
+    world->targetGridDirty = true;
+    NavFlowState flows;
+    Get(r, &flows, sizeof(flows));
+    if (r->failed) return false;
+    NavFlowRestore(&world->nav, &flows);
+
+    int projectiles = GetInt(r);
+    if (projectiles < 0 || projectiles > world->projectiles.capacity) return false;
+    world->projectiles.count = projectiles;
+    Get(r, world->projectiles.items, projectiles*sizeof(Projectile));
+
+    // Spawned back in bucket order, so each bucket ends up as it was
+    ParticlePoolClear(&world->particles);
+    for (int t = 0; t < PARTICLE_TYPE_COUNT; t++) {
+        int count = GetInt(r);
+        if (count < 0) return false;
+        const uint8_t *fields[8];
+        for (int f = 0; f < 8; f++) fields[f] = Skip(r, count*sizeof(float));
+        const uint8_t *colors = Skip(r, count*sizeof(Color));
+        if (r->failed) return false;
+        for (int i = 0; i < count; i++) {
+            float v[8];
+            for (int f = 0; f < 8; f++) memcpy(&v[f], fields[f] + i*sizeof(float), sizeof(float));
+            Color color;
+            memcpy(&color, colors + i*sizeof(Color), sizeof(Color));
+            ParticlePoolSpawn(&world->particles, (Vector3){ v[0], v[1], v[2] }, (Vector3){ v[3], v[4], v[5] }, color, v[6], v[7], (ParticleType)t);
+        }
+    }
+
+    LagHistory *lag = &world->lagHistory;
+    LagHistoryClear(lag);
+    int frames = GetInt(r);
+    if (frames < 0 || frames > LAG_HISTORY_TICKS) return false;
+    Get(r, &lag->newest, sizeof(lag->newest));
+    lag->count = frames;
+    for (int k = frames - 1; k >= 0; k--) {
+        LagFrame *frame = &lag->frames[(lag->newest - (uint32_t)k) % LAG_HISTORY_TICKS];
+        Get(r, &frame->tick, sizeof(frame->tick));
+        Get(r, frame->head, world->botCount*sizeof(BoundingBox));
+        Get(r, frame->body, world->botCount*sizeof(BoundingBox));
+        Get(r, frame->hittable, world->botCount);
+        for (int i = world->botCount; i < MAX_TARGETS; i++) {
+            frame->head[i] = TargetHeadBox(world->targets[i].position);
+            frame->body[i] = TargetBodyBox(world->targets[i].position);
+            frame->hittable[i] = 0;
+        }
+    }
+    return !r->failed && r->pos == r->size;
+}
+
+void DemoBegin(Demo *demo, const World *world, uint64_t seed, const char *map) {
+    DemoFree(demo);
+    DemoHeader *h = &demo->header;
+    h->magic = DEMO_MAGIC;
+    h->version = DEMO_VERSION;
+    h->playerSize = sizeof(Player);
+    h->targetSize = sizeof(Target);
+    h->brainSize = sizeof(BotBrain);
+    h->projectileSize = sizeof(Projectile);
+    h->weaponsSize = sizeof(WeaponTable);
+    h->playerCount = (uint32_t)world->playerCount;
+    h->botCount = (uint32_t)world->botCount;
+    h->seed = seed;
+    if (map) strncpy(h->map, map, DEMO_MAP_PATH - 1);
+}
+
+void DemoRecordTick(Demo *demo, const World *world, const PlayerInput *inputs) {
+    DemoHeader *h = &demo->header;
+    if (demo->failed) return;
+    if (h->tickCount % DEMO_KEYFRAME_TICKS == 0) {
+        if (h->keyframeCount == (uint32_t)demo->keyframeCapacity) {
+            int capacity = demo->keyframeCapacity ? demo->keyframeCapacity*2 : 64;
+            DemoKeyframe *keyframes = realloc(demo->keyframes, capacity*sizeof(DemoKeyframe));
+            if (!keyframes) {
+                demo->failed = true;
+                return;
+            }
+            demo->keyframes = keyframes;
+            demo->keyframeCapacity = capacity;
+        }
+        DemoKeyframe *key = &demo->keyframes[h->keyframeCount++];
+        key->tick = h->tickCount;
+        key->reserved = 0;
+        key->streamOffset = h->streamBytes;
+        key->stateOffset = h->stateBytes;
+        key->hash = WorldHash(world);
+        Writer states = { &demo->states, &demo->stateCapacity, &h->stateBytes, false };
+        WriteState(&states, world);
+        key->stateSize = h->stateBytes - key->stateOffset;
+        for (int p = 0; p < world->playerCount; p++) demo->last[p] = BaseInput();
+        if (states.failed) demo->failed = true;
+    }
+
+    Writer w = { &demo->stream, &demo->streamCapacity, &h->streamBytes, false };
+    uint8_t flags = demo->weaponsChanged ? DEMO_TICK_WEAPONS : 0;
+    Put(&w, &flags, 1);
+    if (flags & DEMO_TICK_WEAPONS) Put(&w, &demo->weapons, sizeof(WeaponTable));
+    demo->weaponsChanged = false;
+    for (uint32_t p = 0; p < h->playerCount; p++) {
+        EncodeInput(&w, &demo->last[p], &inputs[p]);
+        demo->last[p] = inputs[p];
+    }
+    if (w.failed) demo->failed = true;
+    h->tickCount++;
+}
+
+void DemoRecordWeapons(Demo *demo, const WeaponTable *weapons) {
+    demo->weapons = *weapons;
+    demo->weaponsChanged = true;
+}
+
+void DemoFinish(Demo *demo, const World *world) {
+    demo->header.endHash = WorldHash(world);
+}
+
+void DemoFree(Demo *demo) {
+    free(demo->stream);
+    free(demo->states);
+    free(demo->keyframes);
+    memset(demo, 0, sizeof(*demo));
+}
+
+bool DemoSave(const Demo *demo, const char *path) {
+    if (demo->failed) return false;
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    const DemoHeader *h = &demo->header;
+    bool ok = fwrite(h, sizeof(*h), 1, file) == 1 &&
+              fwrite(demo->keyframes, sizeof(DemoKeyframe), h->keyframeCount, file) == h->keyframeCount &&
+              fwrite(demo->stream, 1, h->streamBytes, file) == h->streamBytes &&
+              fwrite(demo->states, 1, h->stateBytes, file) == h->stateBytes;
+    return fclose(file) == 0 && ok;
+}
+
+bool DemoLoad(Demo *demo, const char *path, char *error, int errorSize) {
+    memset(demo, 0, sizeof(*demo));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        snprintf(error, errorSize, "%s: cannot open", path);
+        return false;
+    }
+    DemoHeader *h = &demo->header;
+    const char *reason = NULL;
+    if (fread(h, sizeof(*h), 1, file) != 1) reason = "too short";
+    else if (h->magic != DEMO_MAGIC) reason = "not a demo, or written with the other byte order";
+    else if (h->version != DEMO_VERSION) reason = "unsupported version";
+    else if (h->playerSize != sizeof(Player) || h->targetSize != sizeof(Target) || h->brainSize != sizeof(BotBrain) ||
+             h->projectileSize != sizeof(Projectile) || h->weaponsSize != sizeof(WeaponTable)) {
+        reason = "written by a build with a different struct layout";
+    } else if (h->playerCount > MAX_PLAYERS || h->botCount > MAX_TARGETS || h->keyframeCount == 0 ||
+               h->keyframeCount != h->tickCount/DEMO_KEYFRAME_TICKS + (h->tickCount % DEMO_KEYFRAME_TICKS != 0)) {
+        // One keyframe per DEMO_KEYFRAME_TICKS ticks started, which playback relies on
+        reason = "bad header";
+    }
+    if (!reason) {
+        h->map[DEMO_MAP_PATH - 1] = '\0';
+        demo->keyframes = malloc(h->keyframeCount*sizeof(DemoKeyframe));
+        demo->stream = malloc(h->streamBytes ? h->streamBytes : 1);
+        demo->states = malloc(h->stateBytes ? h->stateBytes : 1);
+        if (!demo->keyframes || !demo->stream || !demo->states) reason = "out of memory";
+        else if (fread(demo->keyframes, sizeof(DemoKeyframe), h->keyframeCount, file) != h->keyframeCount ||
+                 fread(demo->stream, 1, h->streamBytes, file) != h->streamBytes ||
+                 fread(demo->states, 1, h->stateBytes, file) != h->stateBytes) {
+            reason = "truncated";
+        }
+    }
+    for (uint32_t k = 0; !reason && k < h->keyframeCount; k++) {
+        const DemoKeyframe *key = &demo->keyframes[k];
+        if (key->tick != k*DEMO_KEYFRAME_TICKS || key->streamOffset > h->streamBytes ||
+            key->stateOffset > h->stateBytes || key->stateSize > h->stateBytes - key->stateOffset) {
+            reason = "bad keyframe";
+        }
+    }
+    fclose(file);
+    if (reason) {
+        snprintf(error, errorSize, "%s: %s", path, reason);
+        DemoFree(demo);
+        return false;
+    }
+    demo->keyframeCapacity = (int)h->keyframeCount;
+    demo->streamCapacity = h->streamBytes;
+    demo->stateCapacity = h->stateBytes;
+    return true;
+}
+
+static bool RestoreKeyframe(DemoPlayback *playback, World *world, int index) {
+    const Demo *demo = playback->demo;
+    const DemoKeyframe *key = &demo->keyframes[index];
+    Reader r = { demo->states + key->stateOffset, key->stateSize, 0, false };
+    if (!ReadState(&r, world)) return false;
+    playback->tick = key->tick;
+    playback->cursor = key->streamOffset;
+    for (uint32_t p = 0; p < demo->header.playerCount; p++) playback->last[p] = BaseInput();
+    return true;
+}
+
+bool DemoPlaybackStart(DemoPlayback *playback, const Demo *demo, World *world) {
+    const DemoHeader *h = &demo->header;
+    memset(playback, 0, sizeof(*playback));
+    playback->demo = demo;
+    playback->mismatchTick = -1;
+    if (world->botCount != (int)h->botCount) WorldSetBots(world, (int)h->botCount);
+    while (world->playerCount < (int)h->playerCount) {
+        if (WorldAddPlayer(world, "Player") < 0) return false;
+    }
+    if (world->playerCount != (int)h->playerCount) return false;
+    return RestoreKeyframe(playback, world, 0);
+}
+
+bool DemoPlaybackStep(DemoPlayback *playback, World *world) {
+    const Demo *demo = playback->demo;
+    const DemoHeader *h = &demo->header;
+    if (playback->tick >= h->tickCount) return false;
+
+    if (playback->tick % DEMO_KEYFRAME_TICKS == 0) {
+        uint32_t index = playback->tick/DEMO_KEYFRAME_TICKS;
+        if (index >= h->keyframeCount) return false;
+        const DemoKeyframe *key = &demo->keyframes[index];
+        if (playback->mismatchTick < 0 && WorldHash(world) != key->hash) playback->mismatchTick = playback->tick;
+        for (uint32_t p = 0; p < h->playerCount; p++) playback->last[p] = BaseInput();
+    }
+
+    Reader r = { demo->stream, h->streamBytes, playback->cursor, false };
+    uint8_t flags;
+    Get(&r, &flags, 1);
+    if (flags & DEMO_TICK_WEAPONS) {
+        Get(&r, &playback->weapons, sizeof(playback->weapons));
+        if (r.failed || !ValidWeapons(&playback->weapons)) return false;
+        WorldSetWeapons(world, &playback->weapons);
+    }
+    for (uint32_t p = 0; p < h->playerCount; p++) {
+        playback->inputs[p] = DecodeInput(&r, &playback->last[p]);
+        playback->last[p] = playback->inputs[p];
+    }
+    if (r.failed) return false;
+    playback->cursor = r.pos;
+
+    WorldStep(world, playback->inputs, WORLD_DT);
+    playback->tick++;
+    if (playback->tick == h->tickCount && playback->mismatchTick < 0 && WorldHash(world) != h->endHash) {
+        playback->mismatchTick = playback->tick;
+    }
+    return true;
+}
+
+bool DemoPlaybackSeek(DemoPlayback *playback, World *world, uint32_t tick) {
+    const DemoHeader *h = &playback->demo->header;
+    if (tick > h->tickCount) tick = h->tickCount;
+    uint32_t index = tick/DEMO_KEYFRAME_TICKS;
+    if (index >= h->keyframeCount) index = h->keyframeCount - 1;
+    if (!RestoreKeyframe(playback, world, (int)index)) return false;
+    while (playback->tick < tick) {
+        if (!DemoPlaybackStep(playback, world)) return false;
+    }
+    return true;
+}
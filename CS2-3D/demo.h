@@ -0,0 +1,108 @@
+#ifndef CS2_DEMO_H
+#define CS2_DEMO_H
+
+#include "world.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Recorded matches. A demo holds every tick's PlayerInput for each player,
+// replayed through WorldStep, plus a keyframe of the world every
+// DEMO_KEYFRAME_TICKS ticks: players, targets and bot brains, grenades,
+// particles, the lag history and whatever else the next ticks depend on.
+// Playback starts from the first keyframe, so the world it plays into only
+// needs the same map; seeking restores the nearest keyframe before the tick
+// and plays up to it.
+//
+// Each keyframe also records a hash of the world, which playback checks as
+// it passes, so a build that simulates differently is caught within a
+// keyframe of where it went wrong.
+//
+// Inputs are stored per player as a byte saying what changed since the tick
+// before, followed by only those fields; a player standing still costs one
+// byte a tick. The base is reset at every keyframe so decoding can start
+// there. Like compiled maps, files are only read back by builds with the
+// same struct layout and byte order.
+
+#define DEMO_MAGIC 0x324D4544u      // "DEM2" in a little-endian file
+#define DEMO_VERSION 2
+#define DEMO_KEYFRAME_TICKS 640     // one every 10 s
+#define DEMO_MAP_PATH 128
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t playerSize;    // struct sizes of the writer
+    uint32_t targetSize;
+    uint32_t brainSize;
+    uint32_t projectileSize;
+    uint32_t weaponsSize;
+    uint32_t playerCount;
+    uint32_t botCount;
+    uint32_t tickCount;
+    uint32_t keyframeCount;
+    uint32_t reserved;
+    uint64_t seed;
+    uint64_t streamBytes;
+    uint64_t stateBytes;
+    uint64_t endHash;       // WorldHash after the last tick
+    char map[DEMO_MAP_PATH];    // compiled map played on, empty for the built-in one
+} DemoHeader;
+
+typedef struct {
+    uint32_t tick;          // ticks into the demo, before that tick runs
+    uint32_t reserved;
+    uint64_t streamOffset;  // inputs from this tick on
+    uint64_t stateOffset;
+    uint64_t stateSize;
+    uint64_t hash;
+} DemoKeyframe;
+
+typedef struct {
+    DemoHeader header;
+    uint8_t *stream;
+    size_t streamCapacity;
+    uint8_t *states;
+    size_t stateCapacity;
+    DemoKeyframe *keyframes;
+    int keyframeCapacity;
+
+    // Recording only
+    PlayerInput last[MAX_PLAYERS];
+    bool weaponsChanged;
+    WeaponTable weapons;
+    bool failed;            // out of memory; the recording is incomplete
+} Demo;
+
+typedef struct {
+    const Demo *demo;
+    uint32_t tick;          // the next to play
+    size_t cursor;          // into the stream
+    PlayerInput last[MAX_PLAYERS];
+    PlayerInput inputs[MAX_PLAYERS];    // of the tick just played
+    WeaponTable weapons;    // decoded from the stream when the table changes
+    int64_t mismatchTick;   // first keyframe whose hash differed, or -1
+} DemoPlayback;
+
+// Starts recording a match between the world's current players and bots.
+// map is the compiled map's path, NULL for the built-in one.
+void DemoBegin(Demo *demo, const World *world, uint64_t seed, const char *map);
+// Call with the inputs right before every WorldStep
+void DemoRecordTick(Demo *demo, const World *world, const PlayerInput *inputs);
+// The world switched to this table; it takes effect before the next tick
+void DemoRecordWeapons(Demo *demo, const WeaponTable *weapons);
+void DemoFinish(Demo *demo, const World *world);
+void DemoFree(Demo *demo);
+
+// Fails if recording ran out of memory
+bool DemoSave(const Demo *demo, const char *path);
+bool DemoLoad(Demo *demo, const char *path, char *error, int errorSize);
+
+// Puts world, set up on the demo's map, at the start of the demo: the bot
+// count and players are matched and the first keyframe is restored
+bool DemoPlaybackStart(DemoPlayback *playback, const Demo *demo, World *world);
+// Plays one tick; false once the demo is over
+bool DemoPlaybackStep(DemoPlayback *playback, World *world);
+// Jumps to just before tick (clamped to the demo's length)
+bool DemoPlaybackSeek(DemoPlayback *playback, World *world, uint32_t tick);
+
+#endif
@@ -0,0 +1,226 @@
+#include "demo.h"
+#include "../common/jobs.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// cs2_demo record <out.dem> <seed> <ticks> [players] [bots] [compiled map]
+//     Records the autopilot playing every player.
+// cs2_demo verify [-n repeat] <file.dem>...
+//     Plays every demo headlessly and checks the keyframe and end hashes.
+// cs2_demo seek <file.dem>
+//     Seeks to every keyframe and to ticks in between, playing each to the
+//     end, to check that keyframes restore everything the simulation reads.
+
+// A world on the demo's map with no more players than it needs. Worlds are
+// only rebuilt when that changes, which is what makes short demos cheap.
+typedef struct {
+    World world;
+    MapFile map;
+    bool hasMap;
+    char mapPath[DEMO_MAP_PATH];
+    bool ready;
+} Stage;
+
+static bool StageFor(Stage *stage, const Demo *demo, JobSystem *jobs) {
+    const DemoHeader *h = &demo->header;
+    if (stage->ready && strcmp(stage->mapPath, h->map) == 0 && stage->world.playerCount <= (int)h->playerCount) {
+        return true;
+    }
+    if (stage->ready) WorldFree(&stage->world);
+    if (stage->hasMap) MapFileClose(&stage->map);
+    stage->ready = stage->hasMap = false;
+
+    WorldInit(&stage->world, h->seed);
+    stage->world.jobs = jobs;
+    if (h->map[0]) {
+        char error[160];
+        if (!MapFileOpen(&stage->map, h->map, error, sizeof(error))) {
+            printf("%s\n", error);
+            WorldFree(&stage->world);
+            return false;
+        }
+        stage->hasMap = true;
+        WorldSetMap(&stage->world, &stage->map);
+    }
+    strcpy(stage->mapPath, h->map);
+    stage->ready = true;
+    return true;
+}
+
+static int Record(const char *path, uint64_t seed, long long ticks, int players, int bots, const char *mapPath) {
+    static World world;
+    static PlayerInput inputs[MAX_PLAYERS];
+    static MapFile map;
+    static Demo demo;
+
+    WorldInit(&world, seed);
+    if (mapPath) {
+        char error[160];
+        if (!MapFileOpen(&map, mapPath, error, sizeof(error))) {
+            fprintf(stderr, "%s\n", error);
+            return 1;
+        }
+        WorldSetMap(&world, &map);
+    }
+    if (bots >= 0) WorldSetBots(&world, bots);
+    JobSystem *jobs = JobSystemCreate(0);
+    world.jobs = jobs;
+    for (int i = 0; i < players && i < MAX_PLAYERS; i++) WorldAddPlayer(&world, i == 0 ? "Player" : "Bot");
+
+    DemoBegin(&demo, &world, seed, mapPath);
+    for (long long t = 0; t < ticks; t++) {
+        for (int i = 0; i < world.playerCount; i++) inputs[i] = WorldAutopilot(&world, i);
+        DemoRecordTick(&demo, &world, inputs);
+        WorldStep(&world, inputs, WORLD_DT);
+    }
+    DemoFinish(&demo, &world);
+
+    bool ok = DemoSave(&demo, path);
+    const DemoHeader *h = &demo.header;
+    printf("%s: %u ticks, %llu input bytes (%.2f per player tick), %u keyframes, %llu state bytes\n", path, h->tickCount,
+           (unsigned long long)h->streamBytes, (double)h->streamBytes/((double)h->tickCount*(h->playerCount ? h->playerCount : 1)),
+           h->keyframeCount, (unsigned long long)h->stateBytes);
+    DemoFree(&demo);
+    JobSystemDestroy(jobs);
+    WorldFree(&world);
+    if (mapPath) MapFileClose(&map);
+    return ok ? 0 : 1;
+}
+
+static int Verify(int count, char **paths, int repeat) {
+    Demo *demos = calloc(count, sizeof(Demo));
+    bool *loaded = calloc(count, sizeof(bool));
+    static Stage stage;
+    static DemoPlayback playback;
+    JobSystem *jobs = JobSystemCreate(0);
+    int failures = 0;
+    long long ticks = 0;
+    long long kills = 0;
+
+    for (int i = 0; i < count; i++) {
+        char error[200];
+        loaded[i] = DemoLoad(&demos[i], paths[i], error, sizeof(error));
+        if (!loaded[i]) {
+            printf("%s\n", error);
+            failures++;
+        }
+    }
+
+    double start = BenchNowSeconds();
+    for (int r = 0; r < repeat; r++) {
+        for (int i = 0; i < count; i++) {
+            if (!loaded[i]) continue;
+            if (!StageFor(&stage, &demos[i], jobs) || !DemoPlaybackStart(&playback, &demos[i], &stage.world)) {
+                if (r == 0) {
+                    printf("%s: cannot set up the world\n", paths[i]);
+                    failures++;
+                }
+                continue;
+            }
+            World *world = &stage.world;
+            for (;;) {
+                bool wasDead[MAX_TARGETS];
+                for (int t = 0; t < world->botCount; t++) wasDead[t] = world->targets[t].health <= 0;
+                if (!DemoPlaybackStep(&playback, world)) break;
+                for (int t = 0; t < world->botCount; t++) kills += !wasDead[t] && world->targets[t].health <= 0;
+            }
+            ticks += playback.tick;
+
+            if (r > 0) continue;
+            if (playback.tick != demos[i].header.tickCount) {
+                printf("%s: stream ends early, at tick %u\n", paths[i], playback.tick);
+                failures++;
+            } else if (playback.mismatchTick >= 0) {
+                printf("%s: MISMATCH at tick %lld\n", paths[i], (long long)playback.mismatchTick);
+                failures++;
+            }
+        }
+    }
+    double elapsed = BenchNowSeconds() - start;
+
+    printf("demos: %d x %d, failures: %d, kills: %lld\n", count, repeat, failures, kills);
+    printf("ticks/sec: %.0f  realtime x: %.0f\n", ticks/elapsed, (ticks/(double)WORLD_TICK_RATE)/elapsed);
+
+    for (int i = 0; i < count; i++) DemoFree(&demos[i]);
+    free(demos);
+    free(loaded);
+    if (stage.ready) WorldFree(&stage.world);
+    if (stage.hasMap) MapFileClose(&stage.map);
+    JobSystemDestroy(jobs);
+    return failures ? 1 : 0;
+}
+
+static int Seek(const char *path) {
+    static Demo demo;
+    static Stage stage;
+    static DemoPlayback playback;
+    char error[200];
+    if (!DemoLoad(&demo, path, error, sizeof(error))) {
+        fprintf(stderr, "%s\n", error);
+        return 1;
+    }
+    JobSystem *jobs = JobSystemCreate(0);
+    int failures = 0;
+    int seeks = 0;
+    if (!StageFor(&stage, &demo, jobs) || !DemoPlaybackStart(&playback, &demo, &stage.world)) {
+        printf("%s: cannot set up the world\n", path);
+        failures++;
+    }
+
+    // Backwards, so every seek lands in a world the previous one left in
+    // a later state
+    const uint32_t offsets[] = { 0, 1, DEMO_KEYFRAME_TICKS/2, DEMO_KEYFRAME_TICKS - 1 };
+    double start = BenchNowSeconds();
+    for (int k = (int)demo.header.keyframeCount - 1; failures == 0 && k >= 0; k--) {
+        for (int o = 3; o >= 0; o--) {
+            uint32_t tick = (uint32_t)k*DEMO_KEYFRAME_TICKS + offsets[o];
+            if (tick > demo.header.tickCount) continue;
+            playback.mismatchTick = -1;
+            if (!DemoPlaybackSeek(&playback, &stage.world, tick)) {
+                printf("%s: cannot seek to tick %u\n", path, tick);
+                failures++;
+                break;
+            }
+            while (DemoPlaybackStep(&playback, &stage.world)) {}
+            seeks++;
+            if (playback.mismatchTick >= 0) {
+                printf("%s: MISMATCH at tick %lld after seeking to %u\n", path, (long long)playback.mismatchTick, tick);
+                failures++;
+                break;
+            }
+        }
+    }
+    printf("%s: %d seeks played to the end in %.2f s, failures: %d\n", path, seeks, BenchNowSeconds() - start, failures);
+
+    DemoFree(&demo);
+    if (stage.ready) WorldFree(&stage.world);
+    if (stage.hasMap) MapFileClose(&stage.map);
+    JobSystemDestroy(jobs);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 5 && strcmp(argv[1], "record") == 0) {
+        return Record(argv[2], strtoull(argv[3], NULL, 10), atoll(argv[4]), (argc > 5) ? atoi(argv[5]) : 1,
+                      (argc > 6) ? atoi(argv[6]) : -1, (argc > 7 && argv[7][0] != '-') ? argv[7] : NULL);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "verify") == 0) {
+        int first = 2;
+        int repeat = 1;
+        if (argc >= 5 && strcmp(argv[2], "-n") == 0) {
+            repeat = atoi(argv[3]);
+            first = 4;
+        }
+        return Verify(argc - first, argv + first, repeat < 1 ? 1 : repeat);
+    }
+
+    if (argc == 3 && strcmp(argv[1], "seek") == 0) return Seek(argv[2]);
+
+    fprintf(stderr, "usage: %s record <out.dem> <seed> <ticks> [players] [bots] [compiled map]\n"
+                    "       %s verify [-n repeat] <file.dem>...\n"
+                    "       %s seek <file.dem>\n", argv[0], argv[0], argv[0]);
+    return 2;
+}
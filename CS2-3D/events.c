@@ -0,0 +1,60 @@
+#include "events.h"
+#include <string.h>
+
+uint16_t NameIntern(NameTable *table, const char *name) {
+    if (table->count == 0) {
+        strcpy(table->names[0], "?");
+        table->count = 1;
+    }
+    // Names arrive when players join, not per event, so a scan is enough
+    for (int i = 1; i < table->count; i++) {
+        if (strncmp(table->names[i], name, EVENT_NAME_LENGTH - 1) == 0) return (uint16_t)i;
+    }
+    if (table->count == EVENT_MAX_NAMES) return 0;
+    strncpy(table->names[table->count], name, EVENT_NAME_LENGTH - 1);
+    table->names[table->count][EVENT_NAME_LENGTH - 1] = '\0';
+    return (uint16_t)table->count++;
+}
+
+const char *NameLookup(const NameTable *table, uint16_t id) {
+    return (id < table->count) ? table->names[id] : "?";
+}
+
+void KillFeedObserve(KillFeed *feed, const GameEvent *event) {
+    if (event->type != EVENT_KILL) return;
+    feed->newest = (feed->newest + 1) % MAX_KILLFEED;
+    feed->kills[feed->newest] = *event;
+    if (feed->count < MAX_KILLFEED) feed->count++;
+}
+
+const GameEvent *KillFeedGet(const KillFeed *feed, int i) {
+    if (i < 0 || i >= feed->count) return NULL;
+    return &feed->kills[(feed->newest - i + MAX_KILLFEED) % MAX_KILLFEED];
+}
+
+void EventRingInit(EventRing *ring) {
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->dropped = 0;
+}
+
+bool EventRingPush(EventRing *ring, const GameEvent *event) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == EVENT_RING_SIZE) {
+        ring->dropped++;
+        return false;
+    }
+    ring->items[head & (EVENT_RING_SIZE - 1)] = *event;
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+int EventRingPop(EventRing *ring, GameEvent *out, int maxOut) {
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    int count = (head - tail < (uint64_t)maxOut) ? (int)(head - tail) : maxOut;
+    for (int i = 0; i < count; i++) out[i] = ring->items[(tail + i) & (EVENT_RING_SIZE - 1)];
+    atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+    return count;
+}
@@ -0,0 +1,78 @@
+#ifndef CS2_EVENTS_H
+#define CS2_EVENTS_H
+
+#include "game.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// What happens in a match as a stream of small fixed-size events. Names are
+// interned once into a NameTable and events carry their ids, so nothing is
+// copied per event but 16 bytes.
+//
+// The kill feed is a view over the stream: it keeps the last few kill events
+// it was shown, in a ring instead of shifting them down.
+//
+// An EventRing hands the stream from the thread running WorldStep to one
+// other thread without locks. The producer never waits: when the consumer is
+// a whole ring behind, new events are dropped and counted instead.
+
+#define EVENT_RING_SIZE 8192        // a power of two
+#define EVENT_MAX_NAMES 256
+#define EVENT_NAME_LENGTH 32
+
+typedef enum {
+    EVENT_SHOT,             // a hitscan or melee attack, hit or not
+    EVENT_HIT,              // a shot that drew blood
+    EVENT_KILL,
+    EVENT_GRENADE_DAMAGE,   // one victim of a blast
+    EVENT_TYPE_COUNT
+} GameEventType;
+
+typedef struct {
+    uint32_t tick;
+    uint8_t type;           // GameEventType
+    uint8_t weapon;         // WeaponType
+    uint8_t headshot;
+    uint8_t unused;
+    uint16_t actor;         // name id of who shot or killed
+    uint16_t subject;       // name id of who was hit or killed
+    int32_t damage;
+} GameEvent;
+
+typedef struct {
+    char names[EVENT_MAX_NAMES][EVENT_NAME_LENGTH];
+    int count;
+} NameTable;
+
+typedef struct {
+    _Alignas(64) atomic_uint_least64_t head;    // next event to write
+    _Alignas(64) atomic_uint_least64_t tail;    // next event to read
+    _Alignas(64) long long dropped;             // producer only
+    GameEvent items[EVENT_RING_SIZE];
+} EventRing;
+
+// Newest at kills[newest]
+typedef struct {
+    GameEvent kills[MAX_KILLFEED];
+    int newest;
+    int count;
+} KillFeed;
+
+// The id of name, added if new. Id 0 is "?" and stands in once the table is
+// full; names longer than EVENT_NAME_LENGTH - 1 are cut.
+uint16_t NameIntern(NameTable *table, const char *name);
+const char *NameLookup(const NameTable *table, uint16_t id);
+
+// Keeps event if it is a kill
+void KillFeedObserve(KillFeed *feed, const GameEvent *event);
+// The i-th newest kill kept (0 is the newest), or NULL
+const GameEvent *KillFeedGet(const KillFeed *feed, int i);
+
+void EventRingInit(EventRing *ring);
+// Producer side; false when the ring is full and the event was dropped
+bool EventRingPush(EventRing *ring, const GameEvent *event);
+// Consumer side; copies up to maxOut of the oldest events and returns how many
+int EventRingPop(EventRing *ring, GameEvent *out, int maxOut);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef CS2_GAME_H
+#define CS2_GAME_H
+
+#include "raylib.h"
+
+#define MAX_TARGETS 256
+#define MAX_PLAYERS 128
+#define MAX_PARTICLES 131072
+#define MAX_KILLFEED 5
+#define MAX_WEAPONS 32
+#define GRAVITY 18.0f
+#define JUMP_FORCE 8.0f
+#define WALK_SPEED 6.0f
+#define SENSITIVITY 0.25f
+
+
+
+// The built-in weapons; weapons.txt can add more after these (weapons.h)
+typedef enum { 
+    WPN_RIFLE, 
+    WPN_PISTOL, 
+    WPN_KNIFE, 
+    WPN_GRENADE 
+} WeaponType;
+
+typedef enum {
+    PARTICLE_BLOOD,
+    PARTICLE_SPARK,
+    PARTICLE_EXPLOSION,
+    PARTICLE_SMOKE,
+    PARTICLE_TYPE_COUNT
+} ParticleType;
+
+typedef struct {
+    Vector3 position;
+    Vector3 size;
+    Color color;
+    Color outlineColor;
+} Wall;
+
+typedef struct {
+    Vector3 position;
+    bool active;
+    int health;
+    float hitTimer; 
+    float deathTimer; 
+    int id; 
+} Target;
+
+typedef struct {
+    char name[32];
+    bool connected;
+    Vector3 position;       // eye position
+    float yaw;              // radians, 0 looks down +Z, positive turns right
+    float pitch;            // radians, positive looks up
+    WeaponType weapon;
+    WeaponType lastWeapon;
+    
+    
+    Vector3 velocity;
+    bool isGrounded;
+    
+    
+    int ammo[MAX_WEAPONS];      // magazine, or grenades carried
+    int reserve[MAX_WEAPONS];
+    int health;
+    
+    
+    float shootCooldown;
+    float recoilOffset;     
+    float recoilPitch;      
+    float equipTimer;       
+    float walkTimer;        
+    Vector2 weaponSway;     
+    float muzzleFlashTimer; 
+    
+    
+    float reloadTimer;
+    bool isReloading;
+    float inspectTimer;
+    bool isInspecting;
+} Player;
+
+#endif
@@ -0,0 +1,188 @@
+#include "grid.h"
+#include "bvh.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void CellRange(const TargetGrid *grid, BoundingBox box, int *x0, int *z0, int *x1, int *z1) {
+    *x0 = (int)((box.min.x - grid->bounds.min.x)/grid->cellSize);
+    *z0 = (int)((box.min.z - grid->bounds.min.z)/grid->cellSize);
+    *x1 = (int)((box.max.x - grid->bounds.min.x)/grid->cellSize);
+    *z1 = (int)((box.max.z - grid->bounds.min.z)/grid->cellSize);
+    if (*x0 < 0) *x0 = 0;
+    if (*z0 < 0) *z0 = 0;
+    if (*x1 >= grid->cellsX) *x1 = grid->cellsX - 1;
+    if (*z1 >= grid->cellsZ) *z1 = grid->cellsZ - 1;
+}
+
+static bool IsPresent(BoundingBox box) {
+    return box.min.x <= box.max.x;
+}
+
+// Grows one of the grid's arrays, keeping the old one and its capacity if
+// realloc fails
+static bool Reserve(int **items, int *capacity, int needed) {
+    if (needed <= *capacity) return true;
+    int *grown = realloc(*items, needed*sizeof(int));
+    if (!grown) return false;
+    *items = grown;
+    *capacity = needed;
+    return true;
+}
+
+bool TargetGridBuild(TargetGrid *grid, const BoundingBox *itemBounds, int count) {
+    grid->itemCount = count;
+    grid->bounds = (BoundingBox){ (Vector3){ FLT_MAX, FLT_MAX, FLT_MAX }, (Vector3){ -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+
+    int present = 0;
+    for (int i = 0; i < count; i++) {
+        if (!IsPresent(itemBounds[i])) continue;
+        grid->bounds.min = (Vector3){ fminf(grid->bounds.min.x, itemBounds[i].min.x), fminf(grid->bounds.min.y, itemBounds[i].min.y), fminf(grid->bounds.min.z, itemBounds[i].min.z) };
+        grid->bounds.max = (Vector3){ fmaxf(grid->bounds.max.x, itemBounds[i].max.x), fmaxf(grid->bounds.max.y, itemBounds[i].max.y), fmaxf(grid->bounds.max.z, itemBounds[i].max.z) };
+        present++;
+    }
+
+    if (present == 0) {
+        grid->cellsX = grid->cellsZ = 0;
+        return true;
+    }
+
+    float extent = fmaxf(grid->bounds.max.x - grid->bounds.min.x, grid->bounds.max.z - grid->bounds.min.z);
+    grid->cellSize = fmaxf(GRID_MIN_CELL_SIZE, extent/GRID_MAX_CELLS_PER_AXIS);
+    grid->cellsX = (int)((grid->bounds.max.x - grid->bounds.min.x)/grid->cellSize) + 1;
+    grid->cellsZ = (int)((grid->bounds.max.z - grid->bounds.min.z)/grid->cellSize) + 1;
+
+    int cells = grid->cellsX*grid->cellsZ;
+    if (!Reserve(&grid->cellStart, &grid->cellCapacity, cells + 1)) {
+        grid->cellsX = grid->cellsZ = 0;
+        return false;
+    }
+    memset(grid->cellStart, 0, (cells + 1)*sizeof(int));
+
+    // Count, prefix-sum, then scatter each item into every cell it overlaps
+    int refs = 0;
+    for (int i = 0; i < count; i++) {
+        if (!IsPresent(itemBounds[i])) continue;
+        int x0, z0, x1, z1;
+        CellRange(grid, itemBounds[i], &x0, &z0, &x1, &z1);
+        for (int z = z0; z <= z1; z++)
+            for (int x = x0; x <= x1; x++) grid->cellStart[z*grid->cellsX + x + 1]++;
+        refs += (x1 - x0 + 1)*(z1 - z0 + 1);
+    }
+    for (int c = 0; c < cells; c++) grid->cellStart[c + 1] += grid->cellStart[c];
+
+    int *cursor = malloc(cells*sizeof(int));
+    if (!cursor || !Reserve(&grid->cellItems, &grid->refCapacity, refs) ||
+        !Reserve(&grid->itemFirstCell, &grid->itemCapacity, count)) {
+        free(cursor);
+        grid->cellsX = grid->cellsZ = 0;
+        return false;
+    }
+    memcpy(cursor, grid->cellStart, cells*sizeof(int));
+    for (int i = 0; i < count; i++) {
+        if (!IsPresent(itemBounds[i])) continue;
+        int x0, z0, x1, z1;
+        CellRange(grid, itemBounds[i], &x0, &z0, &x1, &z1);
+        grid->itemFirstCell[i] = x0 | (z0 << 16);
+        for (int z = z0; z <= z1; z++)
+            for (int x = x0; x <= x1; x++) grid->cellItems[cursor[z*grid->cellsX + x]++] = i;
+    }
+    free(cursor);
+    return true;
+}
+
+void TargetGridFree(TargetGrid *grid) {
+    free(grid->cellStart);
+    free(grid->cellItems);
+    free(grid->itemFirstCell);
+    memset(grid, 0, sizeof(*grid));
+}
+
+int TargetGridQueryBox(const TargetGrid *grid, BoundingBox box, int *out, int maxOut) {
+    if (grid->cellsX == 0) return 0;
+    if (box.max.x < grid->bounds.min.x || box.min.x > grid->bounds.max.x ||
+        box.max.z < grid->bounds.min.z || box.min.z > grid->bounds.max.z) return 0;
+
+    int x0, z0, x1, z1;
+    CellRange(grid, box, &x0, &z0, &x1, &z1);
+
+    int found = 0;
+    for (int z = z0; z <= z1; z++) {
+        for (int x = x0; x <= x1; x++) {
+            int cell = z*grid->cellsX + x;
+            for (int r = grid->cellStart[cell]; r < grid->cellStart[cell + 1]; r++) {
+                // An item spanning several cells is reported by the first of
+                // them inside the query
+                int item = grid->cellItems[r];
+                int itemX = grid->itemFirstCell[item] & 0xFFFF;
+                int itemZ = grid->itemFirstCell[item] >> 16;
+                if ((itemX > x0 ? itemX : x0) != x || (itemZ > z0 ? itemZ : z0) != z) continue;
+                if (found < maxOut) out[found] = item;
+                found++;
+            }
+        }
+    }
+    return found;
+}
+
+bool TargetGridRaycast(const TargetGrid *grid, Ray ray, float maxDistance, GridItemRaycast test, void *ctx, int *item, float *distance) {
+    if (grid->cellsX == 0) return false;
+
+    Vector3 inv = { 1.0f/ray.direction.x, 1.0f/ray.direction.y, 1.0f/ray.direction.z };
+    float tEnter;
+    if (!RayBoxSlab(ray.position, inv, grid->bounds, maxDistance, &tEnter)) return false;
+
+    float px = ray.position.x + ray.direction.x*tEnter - grid->bounds.min.x;
+    float pz = ray.position.z + ray.direction.z*tEnter - grid->bounds.min.z;
+    int cx = (int)(px/grid->cellSize);
+    int cz = (int)(pz/grid->cellSize);
+    if (cx < 0) cx = 0;
+    if (cz < 0) cz = 0;
+    if (cx >= grid->cellsX) cx = grid->cellsX - 1;
+    if (cz >= grid->cellsZ) cz = grid->cellsZ - 1;
+
+    int stepX = (ray.direction.x > 0) ? 1 : -1;
+    int stepZ = (ray.direction.z > 0) ? 1 : -1;
+    float tDeltaX = fabsf(grid->cellSize*inv.x);
+    float tDeltaZ = fabsf(grid->cellSize*inv.z);
+    float nextX = grid->bounds.min.x + (cx + (stepX > 0 ? 1 : 0))*grid->cellSize;
+    float nextZ = grid->bounds.min.z + (cz + (stepZ > 0 ? 1 : 0))*grid->cellSize;
+    float tMaxX = (ray.direction.x != 0.0f) ? (nextX - ray.position.x)*inv.x : FLT_MAX;
+    float tMaxZ = (ray.direction.z != 0.0f) ? (nextZ - ray.position.z)*inv.z : FLT_MAX;
+
+    float best = maxDistance;
+    int bestItem = -1;
+
+    for (;;) {
+        int cell = cz*grid->cellsX + cx;
+        for (int r = grid->cellStart[cell]; r < grid->cellStart[cell + 1]; r++) {
+            float t;
+            int candidate = grid->cellItems[r];
+            if (test(ctx, candidate, ray, best, &t) && (t < best || bestItem < 0)) {
+                best = t;
+                bestItem = candidate;
+            }
+        }
+
+        // A hit inside this cell cannot be beaten by anything further along
+        float cellExit = fminf(tMaxX, tMaxZ);
+        if (bestItem >= 0 && best <= cellExit) break;
+        if (cellExit > maxDistance || cellExit > best) break;
+
+        if (tMaxX < tMaxZ) {
+            cx += stepX;
+            tMaxX += tDeltaX;
+            if (cx < 0 || cx >= grid->cellsX) break;
+        } else {
+            cz += stepZ;
+            tMaxZ += tDeltaZ;
+            if (cz < 0 || cz >= grid->cellsZ) break;
+        }
+    }
+
+    if (bestItem < 0) return false;
+    if (item) *item = bestItem;
+    if (distance) *distance = best;
+    return true;
+}
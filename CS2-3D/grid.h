@@ -0,0 +1,43 @@
+#ifndef CS2_GRID_H
+#define CS2_GRID_H
+
+#include "raylib.h"
+
+// Uniform grid on the XZ plane for moving objects, rebuilt from scratch every
+// tick with a counting sort (cell ranges into one flat item list). It only
+// covers the bounds of what was inserted, so rays are clipped to those bounds
+// before being walked cell by cell.
+
+#define GRID_MIN_CELL_SIZE 2.0f
+#define GRID_MAX_CELLS_PER_AXIS 256
+
+typedef struct {
+    BoundingBox bounds;
+    float cellSize;
+    int cellsX;
+    int cellsZ;
+    int *cellStart;
+    int *cellItems;
+    int *itemFirstCell;     // x | z << 16 of the first cell each item is in
+    int cellCapacity;
+    int refCapacity;
+    int itemCapacity;
+    int itemCount;
+} TargetGrid;
+
+// Exact test against one item; returns the hit distance through *distance
+typedef bool (*GridItemRaycast)(void *ctx, int item, Ray ray, float maxDistance, float *distance);
+
+// Boxes with min.x > max.x are treated as absent. Returns false if out of
+// memory, leaving the grid empty.
+bool TargetGridBuild(TargetGrid *grid, const BoundingBox *itemBounds, int count);
+void TargetGridFree(TargetGrid *grid);
+
+// Items in the cells box touches, each reported once. The test is per cell,
+// so callers still check the items themselves. Writes up to maxOut items and
+// returns how many there are.
+int TargetGridQueryBox(const TargetGrid *grid, BoundingBox box, int *out, int maxOut);
+
+bool TargetGridRaycast(const TargetGrid *grid, Ray ray, float maxDistance, GridItemRaycast test, void *ctx, int *item, float *distance);
+
+#endif
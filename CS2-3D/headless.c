@@ -0,0 +1,119 @@
+#include "world.h"
+#include "stats.h"
+#include "../common/profile.h"
+#include "../common/jobs.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Runs the world tick loop without a window as fast as the CPU allows, with
+// the autopilot playing every player and the bots thinking on a job system.
+// Built with -DPROFILE it also prints zone timings per tick and saves the
+// last events to profile.json. With a stats file the players' accuracy is
+// added up on the stats thread and appended to it.
+// Usage: cs2_headless [ticks] [seed] [players] [weapons file or -] [compiled map or -] [bots] [threads] [stats file]
+
+int main(int argc, char **argv) {
+    long long ticks = (argc > 1) ? atoll(argv[1]) : 1000000;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1;
+    int players = (argc > 3) ? atoi(argv[3]) : 1;
+
+    static World world;
+    static PlayerInput inputs[MAX_PLAYERS];
+    WorldInit(&world, seed);
+    if (argc > 4 && argv[4][0] != '-') {
+        WeaponTable weapons;
+        char error[160];
+        if (!WeaponTableLoad(&weapons, argv[4], error, sizeof(error))) {
+            fprintf(stderr, "%s\n", error);
+            return 1;
+        }
+        WorldSetWeapons(&world, &weapons);
+    }
+    static MapFile map;
+    if (argc > 5 && argv[5][0] != '-') {
+        char error[160];
+        if (!MapFileOpen(&map, argv[5], error, sizeof(error))) {
+            fprintf(stderr, "%s\n", error);
+            return 1;
+        }
+        WorldSetMap(&world, &map);
+    }
+    if (argc > 6) WorldSetBots(&world, atoi(argv[6]));
+    // The result is the same with any number of threads
+    JobSystem *jobs = JobSystemCreate((argc > 7) ? atoi(argv[7]) : 0);
+    world.jobs = jobs;
+    StatsPipeline *stats = NULL;
+    if (argc > 8) {
+        stats = StatsStart(argv[8]);
+        if (!stats) {
+            fprintf(stderr, "could not open %s\n", argv[8]);
+            return 1;
+        }
+        world.events = StatsEvents(stats);
+    }
+    for (int i = 0; i < players && i < MAX_PLAYERS; i++) WorldAddPlayer(&world, i == 0 ? "Player" : "Bot");
+
+    long long kills = 0;
+    long long resets = 0;
+    int peakParticles = 0;
+
+    double start = BenchNowSeconds();
+    for (long long t = 0; t < ticks; t++) {
+        bool reset = false;
+        for (int i = 0; i < world.playerCount; i++) {
+            inputs[i] = WorldAutopilot(&world, i);
+            reset |= inputs[i].reset;
+        }
+        resets += reset;
+
+        bool wasDead[MAX_TARGETS];
+        for (int i = 0; i < MAX_TARGETS; i++) wasDead[i] = world.targets[i].health <= 0;
+        WorldStep(&world, inputs, WORLD_DT);
+        for (int i = 0; i < MAX_TARGETS; i++) kills += !wasDead[i] && world.targets[i].health <= 0;
+
+        if (world.particles.count > peakParticles) peakParticles = world.particles.count;
+        ProfileFrameEnd();
+    }
+    double elapsed = BenchNowSeconds() - start;
+
+    printf("ticks:          %lld\n", ticks);
+    printf("seconds:        %.3f\n", elapsed);
+    printf("ticks/sec:      %.0f\n", ticks/elapsed);
+    printf("realtime x:     %.0f\n", (ticks/(double)WORLD_TICK_RATE)/elapsed);
+    printf("kills:          %lld\n", kills);
+    printf("map resets:     %lld\n", resets);
+    printf("peak particles: %d\n", peakParticles);
+    printf("checksum:       %016llx\n", (unsigned long long)WorldHash(&world));
+
+    if (stats) {
+        WeaponStats totals[MAX_WEAPONS];
+        long long dropped = world.events->dropped;
+        world.events = NULL;
+        StatsStop(stats);
+        long long records;
+        if (!StatsFileLoad(argv[8], totals, &records)) {
+            fprintf(stderr, "%s is not a stats file\n", argv[8]);
+            return 1;
+        }
+        printf("stats file:     %lld records, %lld events dropped\n", records, dropped);
+        for (int w = 0; w < world.weapons.count; w++) {
+            const WeaponStats *s = &totals[w];
+            if (s->shots == 0 && s->blastHits == 0) continue;
+            printf("  %-12s  %7lld shots  %5.1f%% hit  %5.1f%% headshots  %6lld kills  %6lld blast hits\n",
+                   world.weapons.defs[w].name, s->shots, s->shots ? 100.0*s->hits/s->shots : 0.0,
+                   s->hits ? 100.0*s->headshots/s->hits : 0.0, s->kills, s->blastHits);
+        }
+    }
+
+    ProfileZoneStats zones[PROFILE_MAX_ZONES + 1];
+    int zoneCount = ProfileGetStats(zones, PROFILE_MAX_ZONES + 1);
+    for (int i = 0; i < zoneCount; i++) printf("%-15s p50 %.4f ms  p99 %.4f ms\n", zones[i].name, zones[i].p50Ms, zones[i].p99Ms);
+    if (zoneCount > 0 && !ProfileWriteChromeTrace("profile.json")) fprintf(stderr, "could not write profile.json\n");
+
+    WorldFree(&world);
+    JobSystemDestroy(jobs);
+    MapFileClose(&map);
+    ProfileShutdown();
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "hitscan.h"
+#include "raymath.h"
+#include <float.h>
+#include <stdlib.h>
+
+BoundingBox TargetHeadBox(Vector3 position) {
+    return (BoundingBox){ (Vector3){ position.x - 0.3f, 1.4f, position.z - 0.3f }, (Vector3){ position.x + 0.3f, 1.9f, position.z + 0.3f } };
+}
+
+BoundingBox TargetBodyBox(Vector3 position) {
+    return (BoundingBox){ (Vector3){ position.x - 0.4f, 0.0f, position.z - 0.4f }, (Vector3){ position.x + 0.4f, 1.4f, position.z + 0.4f } };
+}
+
+BoundingBox TargetBounds(const Target *target) {
+    if (!target->active || target->health <= 0) {
+        return (BoundingBox){ (Vector3){ FLT_MAX, FLT_MAX, FLT_MAX }, (Vector3){ -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+    }
+    BoundingBox head = TargetHeadBox(target->position);
+    BoundingBox body = TargetBodyBox(target->position);
+    return (BoundingBox){ Vector3Min(head.min, body.min), Vector3Max(head.max, body.max) };
+}
+
+bool BuildTargetGrid(TargetGrid *grid, const Target *targets, int count) {
+    BoundingBox *bounds = malloc((count > 0 ? count : 1)*sizeof(BoundingBox));
+    if (!bounds) return false;
+    for (int i = 0; i < count; i++) bounds[i] = TargetBounds(&targets[i]);
+    bool built = TargetGridBuild(grid, bounds, count);
+    free(bounds);
+    return built;
+}
+
+// Nearest of head and body; on a tie the head wins, as it always has
+static bool TargetPartHit(const Target *target, Ray ray, float maxDistance, float *distance, bool *headshot) {
+    Vector3 inv = { 1.0f/ray.direction.x, 1.0f/ray.direction.y, 1.0f/ray.direction.z };
+    float tHead, tBody;
+    bool head = RayBoxSlab(ray.position, inv, TargetHeadBox(target->position), maxDistance, &tHead);
+    bool body = RayBoxSlab(ray.position, inv, TargetBodyBox(target->position), maxDistance, &tBody);
+
+    if (head && (!body || tHead <= tBody)) { *distance = tHead; *headshot = true; return true; }
+    if (body) { *distance = tBody; *headshot = false; return true; }
+    return false;
+}
+
+static bool GridTargetTest(void *ctx, int item, Ray ray, float maxDistance, float *distance) {
+    const Target *targets = ctx;
+    bool headshot;
+    // The grid may be older than the last kill
+    if (!targets[item].active || targets[item].health <= 0) return false;
+    return TargetPartHit(&targets[item], ray, maxDistance, distance, &headshot);
+}
+
+static ShotHit TargetShotHit(const Target *targets, int index, Ray ray, float range) {
+    ShotHit shot = { SHOT_MISS, -1, { 0 } };
+    float distance;
+    bool headshot;
+    if (TargetPartHit(&targets[index], ray, range, &distance, &headshot)) {
+        BoundingBox box = headshot ? TargetHeadBox(targets[index].position) : TargetBodyBox(targets[index].position);
+        shot.kind = headshot ? SHOT_HEAD : SHOT_BODY;
+        shot.index = index;
+        shot.collision = RayBoxCollision(ray, box, distance);
+    }
+    return shot;
+}
+
+ShotHit CastShot(const Bvh *walls, const TargetGrid *grid, const Target *targets, Ray ray, float range) {
+    ShotHit shot = { SHOT_MISS, -1, { 0 } };
+
+    RayCollision wallHit;
+    int wall;
+    if (BvhRaycast(walls, ray, range, &wallHit, &wall)) {
+        shot.kind = SHOT_WALL;
+        shot.index = wall;
+        shot.collision = wallHit;
+        range = wallHit.distance;
+    }
+
+    // Targets only need searching up to the first wall
+    int target;
+    float distance;
+    if (TargetGridRaycast(grid, ray, range, GridTargetTest, (void *)targets, &target, &distance) &&
+        (shot.kind == SHOT_MISS || distance < shot.collision.distance)) {
+        shot = TargetShotHit(targets, target, ray, range);
+    }
+    return shot;
+}
+
+ShotHit CastShotLinear(const Wall *walls, int wallCount, const Target *targets, int targetCount, Ray ray, float range) {
+    ShotHit shot = { SHOT_MISS, -1, { 0 } };
+    Vector3 inv = { 1.0f/ray.direction.x, 1.0f/ray.direction.y, 1.0f/ray.direction.z };
+    float best = range;
+
+    for (int i = 0; i < wallCount; i++) {
+        BoundingBox box = {
+            Vector3Subtract(walls[i].position, Vector3Scale(walls[i].size, 0.5f)),
+            Vector3Add(walls[i].position, Vector3Scale(walls[i].size, 0.5f))
+        };
+        float t;
+        if (RayBoxSlab(ray.position, inv, box, best, &t) && (t < best || shot.kind == SHOT_MISS)) {
+            best = t;
+            shot.kind = SHOT_WALL;
+            shot.index = i;
+            shot.collision = RayBoxCollision(ray, box, t);
+        }
+    }
+
+    int bestTarget = -1;
+    float bestTargetDistance = best;
+    for (int i = 0; i < targetCount; i++) {
+        if (!targets[i].active || targets[i].health <= 0) continue;
+        float t;
+        bool headshot;
+        if (TargetPartHit(&targets[i], ray, bestTargetDistance, &t, &headshot) && (t < bestTargetDistance || bestTarget < 0)) {
+            bestTargetDistance = t;
+            bestTarget = i;
+        }
+    }
+
+    if (bestTarget >= 0 && (shot.kind == SHOT_MISS || bestTargetDistance < best)) {
+        shot = TargetShotHit(targets, bestTarget, ray, best);
+    }
+    return shot;
+}
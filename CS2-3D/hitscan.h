@@ -0,0 +1,39 @@
+#ifndef CS2_HITSCAN_H
+#define CS2_HITSCAN_H
+
+#include "game.h"
+#include "bvh.h"
+#include "grid.h"
+
+typedef enum {
+    SHOT_MISS,
+    SHOT_WALL,
+    SHOT_HEAD,
+    SHOT_BODY
+} ShotHitKind;
+
+typedef struct {
+    ShotHitKind kind;
+    int index;
+    RayCollision collision;
+} ShotHit;
+
+BoundingBox TargetHeadBox(Vector3 position);
+BoundingBox TargetBodyBox(Vector3 position);
+
+// Union of head and body, or an empty box for targets that cannot be hit
+BoundingBox TargetBounds(const Target *target);
+
+// Dead and inactive targets are left out; CastShot also skips targets that
+// died after the grid was built, so it only has to be rebuilt when they move.
+// Returns false if out of memory.
+bool BuildTargetGrid(TargetGrid *grid, const Target *targets, int count);
+
+// Nearest hit along the ray among walls (BVH) and live targets (grid), so a
+// wall in front of a target stops the shot. index is the wall or target index.
+ShotHit CastShot(const Bvh *walls, const TargetGrid *grid, const Target *targets, Ray ray, float range);
+
+// Brute-force version of CastShot over plain arrays, kept as a reference
+ShotHit CastShotLinear(const Wall *walls, int wallCount, const Target *targets, int targetCount, Ray ray, float range);
+
+#endif
@@ -0,0 +1,125 @@
+#include "instancing.h"
+#include <rlgl.h>
+#include <stdlib.h>
+
+static const char *cubeVertexShader =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in mat4 instanceTransform;\n"
+    "in vec4 instanceColor;\n"
+    "uniform mat4 mvp;\n"
+    "out vec4 fragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    fragColor = instanceColor;\n"
+    "    gl_Position = mvp*instanceTransform*vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+static const char *cubeFragmentShader =
+    "#version 330\n"
+    "in vec4 fragColor;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    finalColor = fragColor;\n"
+    "}\n";
+
+// (Re)creates the colour buffer and points the cube VAO's colour attribute at it
+static void AttachColorBuffer(CubeBatch *batch, int capacity) {
+    if (batch->colorVbo) rlUnloadVertexBuffer(batch->colorVbo);
+
+    rlEnableVertexArray(batch->mesh.vaoId);
+    batch->colorVbo = rlLoadVertexBuffer(NULL, capacity*sizeof(Color), true);
+    rlSetVertexAttribute(batch->colorLoc, 4, RL_UNSIGNED_BYTE, true, 0, 0);
+    rlEnableVertexAttribute(batch->colorLoc);
+    rlSetVertexAttributeDivisor(batch->colorLoc, 1);
+    rlDisableVertexBuffer();
+    rlDisableVertexArray();
+
+    batch->colorVboCapacity = capacity;
+}
+
+void CubeBatchInit(CubeBatch *batch) {
+    *batch = (CubeBatch){ 0 };
+
+    int version = rlGetVersion();
+    if (version != RL_OPENGL_33 && version != RL_OPENGL_43) return;
+
+    Shader shader = LoadShaderFromMemory(cubeVertexShader, cubeFragmentShader);
+    if (shader.id == 0 || shader.id == rlGetShaderIdDefault()) return;
+
+    shader.locs[SHADER_LOC_MATRIX_MVP] = GetShaderLocation(shader, "mvp");
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "instanceTransform");
+    batch->colorLoc = GetShaderLocationAttrib(shader, "instanceColor");
+    if (batch->colorLoc < 0) {
+        UnloadShader(shader);
+        return;
+    }
+
+    batch->mesh = GenMeshCube(1.0f, 1.0f, 1.0f);
+    batch->material = LoadMaterialDefault();
+    batch->material.shader = shader;
+    AttachColorBuffer(batch, 1024);
+    batch->instanced = true;
+}
+
+void CubeBatchUnload(CubeBatch *batch) {
+    if (batch->instanced) {
+        rlUnloadVertexBuffer(batch->colorVbo);
+        UnloadMaterial(batch->material);
+        UnloadMesh(batch->mesh);
+    }
+    free(batch->transforms);
+    free(batch->colors);
+    *batch = (CubeBatch){ 0 };
+}
+
+void CubeBatchClear(CubeBatch *batch) {
+    batch->count = 0;
+}
+
+void CubeBatchAdd(CubeBatch *batch, Vector3 position, Vector3 size, Color color) {
+    if (batch->count == batch->capacity) {
+        int capacity = batch->capacity ? batch->capacity*2 : 1024;
+        Matrix *transforms = realloc(batch->transforms, capacity*sizeof(Matrix));
+        if (!transforms) return;
+        batch->transforms = transforms;
+        Color *colors = realloc(batch->colors, capacity*sizeof(Color));
+        if (!colors) return;
+        batch->colors = colors;
+        batch->capacity = capacity;
+    }
+
+    // Scale then translate, written out instead of MatrixMultiply
+    batch->transforms[batch->count] = (Matrix){
+        size.x, 0.0f, 0.0f, position.x,
+        0.0f, size.y, 0.0f, position.y,
+        0.0f, 0.0f, size.z, position.z,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    batch->colors[batch->count] = color;
+    batch->count++;
+}
+
+void CubeBatchDraw(CubeBatch *batch) {
+    if (batch->count == 0) return;
+
+    if (!batch->instanced) {
+        for (int i = 0; i < batch->count; i++) {
+            const Matrix *m = &batch->transforms[i];
+            DrawCube((Vector3){ m->m12, m->m13, m->m14 }, m->m0, m->m5, m->m10, batch->colors[i]);
+        }
+        return;
+    }
+
+    if (batch->count > batch->colorVboCapacity) {
+        int capacity = batch->colorVboCapacity;
+        while (capacity < batch->count) capacity *= 2;
+        AttachColorBuffer(batch, capacity);
+    }
+    rlUpdateVertexBuffer(batch->colorVbo, batch->colors, batch->count*sizeof(Color), 0);
+
+    // Flush pending immediate-mode geometry first so draw order is kept
+    rlDrawRenderBatchActive();
+    DrawMeshInstanced(batch->mesh, batch->material, batch->transforms, batch->count);
+}
@@ -0,0 +1,34 @@
+#ifndef CS2_INSTANCING_H
+#define CS2_INSTANCING_H
+
+#include "raylib.h"
+
+// Collects coloured boxes for a frame and draws them as instances of one unit
+// cube with DrawMeshInstanced. Colours go to a per-instance vertex buffer on
+// the cube's VAO that is refreshed once per draw. Without OpenGL 3.3 (or if
+// the shader fails to build) the same boxes are drawn with DrawCube.
+
+typedef struct {
+    Mesh mesh;
+    Material material;
+    Matrix *transforms;
+    Color *colors;
+    int count;
+    int capacity;
+    unsigned int colorVbo;
+    int colorVboCapacity;
+    int colorLoc;
+    bool instanced;
+} CubeBatch;
+
+// Needs a GL context, so call it after InitWindow
+void CubeBatchInit(CubeBatch *batch);
+void CubeBatchUnload(CubeBatch *batch);
+
+void CubeBatchClear(CubeBatch *batch);
+void CubeBatchAdd(CubeBatch *batch, Vector3 position, Vector3 size, Color color);
+
+// Draws everything added since the last clear; call inside BeginMode3D
+void CubeBatchDraw(CubeBatch *batch);
+
+#endif
@@ -0,0 +1,98 @@
+#include "lagcomp.h"
+#include "raymath.h"
+#include <string.h>
+
+void LagHistoryClear(LagHistory *history) {
+    history->newest = 0;
+    history->count = 0;
+}
+
+void LagHistoryRecord(LagHistory *history, uint32_t tick, const Target *targets) {
+    LagFrame *frame = &history->frames[tick % LAG_HISTORY_TICKS];
+    frame->tick = tick;
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        frame->hittable[i] = targets[i].active && targets[i].health > 0;
+        frame->head[i] = TargetHeadBox(targets[i].position);
+        frame->body[i] = TargetBodyBox(targets[i].position);
+    }
+
+    // A gap (or a tick going backwards after a reset) invalidates older frames
+    if (history->count == 0 || tick != history->newest + 1) history->count = 0;
+    history->newest = tick;
+    if (history->count < LAG_HISTORY_TICKS) history->count++;
+}
+
+static BoundingBox LerpBox(BoundingBox a, BoundingBox b, float t) {
+    return (BoundingBox){ Vector3Lerp(a.min, b.min, t), Vector3Lerp(a.max, b.max, t) };
+}
+
+bool LagHistoryRewind(const LagHistory *history, uint32_t viewTick, float fraction, LagFrame *out) {
+    if (history->count == 0) return false;
+
+    uint32_t oldest = history->newest - (uint32_t)(history->count - 1);
+    if ((int32_t)(viewTick - oldest) < 0) { viewTick = oldest; fraction = 0.0f; }
+    if ((int32_t)(viewTick - history->newest) >= 0) { viewTick = history->newest; fraction = 0.0f; }
+
+    const LagFrame *a = &history->frames[viewTick % LAG_HISTORY_TICKS];
+    if (fraction <= 0.0f) {
+        memcpy(out, a, sizeof(*out));
+        return true;
+    }
+
+    const LagFrame *b = &history->frames[(viewTick + 1) % LAG_HISTORY_TICKS];
+    out->tick = viewTick;
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        // A target that appears or dies in between uses the nearer tick
+        if (a->hittable[i] && b->hittable[i]) {
+            out->hittable[i] = 1;
+            out->head[i] = LerpBox(a->head[i], b->head[i], fraction);
+            out->body[i] = LerpBox(a->body[i], b->body[i], fraction);
+        } else {
+            const LagFrame *nearer = (fraction < 0.5f) ? a : b;
+            out->hittable[i] = nearer->hittable[i];
+            out->head[i] = nearer->head[i];
+            out->body[i] = nearer->body[i];
+        }
+    }
+    return true;
+}
+
+ShotHit CastShotRewound(const Bvh *walls, const LagFrame *frame, Ray ray, float range) {
+    ShotHit shot = { SHOT_MISS, -1, { 0 } };
+
+    RayCollision wallHit;
+    int wall;
+    if (BvhRaycast(walls, ray, range, &wallHit, &wall)) {
+        shot.kind = SHOT_WALL;
+        shot.index = wall;
+        shot.collision = wallHit;
+        range = wallHit.distance;
+    }
+
+    Vector3 inv = { 1.0f/ray.direction.x, 1.0f/ray.direction.y, 1.0f/ray.direction.z };
+    int best = -1;
+    bool bestHead = false;
+    float bestDistance = range;
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        if (!frame->hittable[i]) continue;
+        // Same rule as CastShot: nearest part, head on a tie
+        float tHead, tBody;
+        bool head = RayBoxSlab(ray.position, inv, frame->head[i], bestDistance, &tHead);
+        bool body = RayBoxSlab(ray.position, inv, frame->body[i], bestDistance, &tBody);
+        if (!head && !body) continue;
+        bool isHead = head && (!body || tHead <= tBody);
+        float t = isHead ? tHead : tBody;
+        if (best < 0 || t < bestDistance) {
+            best = i;
+            bestHead = isHead;
+            bestDistance = t;
+        }
+    }
+
+    if (best >= 0 && (shot.kind == SHOT_MISS || bestDistance < shot.collision.distance)) {
+        shot.kind = bestHead ? SHOT_HEAD : SHOT_BODY;
+        shot.index = best;
+        shot.collision = RayBoxCollision(ray, bestHead ? frame->head[best] : frame->body[best], bestDistance);
+    }
+    return shot;
+}
@@ -0,0 +1,39 @@
+#ifndef CS2_LAGCOMP_H
+#define CS2_LAGCOMP_H
+
+#include "game.h"
+#include "bvh.h"
+#include "hitscan.h"
+#include <stdint.h>
+
+// Target hitboxes for the last LAG_HISTORY_TICKS ticks in a fixed ring, so a
+// shot can be tested against the world as the shooter saw it. Memory is
+// LAG_HISTORY_TICKS*MAX_TARGETS boxes no matter how long the game runs.
+
+#define LAG_HISTORY_TICKS 32
+
+typedef struct {
+    uint32_t tick;
+    BoundingBox head[MAX_TARGETS];
+    BoundingBox body[MAX_TARGETS];
+    uint8_t hittable[MAX_TARGETS];
+} LagFrame;
+
+typedef struct {
+    LagFrame frames[LAG_HISTORY_TICKS];
+    uint32_t newest;
+    int count;
+} LagHistory;
+
+void LagHistoryClear(LagHistory *history);
+void LagHistoryRecord(LagHistory *history, uint32_t tick, const Target *targets);
+
+// Hitboxes at viewTick + fraction, interpolated between the two stored ticks
+// around it. Times outside the stored range are clamped to it. Returns false
+// while the history is empty.
+bool LagHistoryRewind(const LagHistory *history, uint32_t viewTick, float fraction, LagFrame *out);
+
+// CastShot against rewound hitboxes; walls come from the BVH as usual
+ShotHit CastShotRewound(const Bvh *walls, const LagFrame *frame, Ray ray, float range);
+
+#endif
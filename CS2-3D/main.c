@@ -4,218 +4,45 @@
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <rlgl.h>
-
-
-#define MAX_WALLS 100
-#define MAX_TARGETS 10
-#define MAX_PARTICLES 200
-#define MAX_KILLFEED 5
-#define GRAVITY 18.0f
-#define JUMP_FORCE 8.0f
-#define WALK_SPEED 6.0f
-#define SENSITIVITY 0.25f
-
-
-
-typedef enum { 
-    WPN_RIFLE, 
-    WPN_PISTOL, 
-    WPN_KNIFE, 
-    WPN_GRENADE 
-} WeaponType;
-
-typedef enum {
-    PARTICLE_BLOOD,
-    PARTICLE_SPARK,
-    PARTICLE_EXPLOSION,
-    PARTICLE_SMOKE
-} ParticleType;
-
-typedef struct {
-    Vector3 position;
-    Vector3 velocity;
-    Color color;
-    float size;
-    float life; 
-    ParticleType type;
-    bool active;
-} Particle;
-
-typedef struct {
-    Vector3 position;
-    Vector3 size;
-    Color color;
-    Color outlineColor;
-} Wall;
-
-typedef struct {
-    Vector3 position;
-    bool active;
-    int health;
-    float hitTimer; 
-    float deathTimer; 
-    int id; 
-} Target;
-
-typedef struct {
-    Vector3 position;
-    Vector3 velocity;
-    float timer;
-    bool active;
-    bool exploding;
-} Grenade;
-
-typedef struct {
-    char killer[32];
-    char victim[32];
-    WeaponType weapon;
-    bool headshot;
-    float timer;
-    bool active;
-} KillMessage;
-
-typedef struct {
-    Camera3D camera;
-    WeaponType weapon;
-    WeaponType lastWeapon;
-    
-    
-    Vector3 velocity;
-    bool isGrounded;
-    
-    
-    int ammoRifle;
-    int reserveRifle;
-    int ammoPistol;
-    int reservePistol;
-    int grenades;
-    int health;
-    
-    
-    float shootCooldown;
-    float recoilOffset;     
-    float recoilPitch;      
-    float equipTimer;       
-    float walkTimer;        
-    Vector2 weaponSway;     
-    float muzzleFlashTimer; 
-    
-    
-    float reloadTimer;
-    bool isReloading;
-    float inspectTimer;
-    bool isInspecting;
-} Player;
-
-
-Wall mapWalls[MAX_WALLS];
-Target targets[MAX_TARGETS];
-Particle particles[MAX_PARTICLES];
-KillMessage killFeed[MAX_KILLFEED];
-int wallCount = 0;
-Grenade activeNade = { 0 };
-
-
-void AddKillMsg(const char* killer, const char* victim, WeaponType wpn, bool hs) {
-    
-    for (int i = MAX_KILLFEED - 1; i > 0; i--) {
-        killFeed[i] = killFeed[i-1];
-    }
-    
-    strncpy(killFeed[0].killer, killer, 31);
-    strncpy(killFeed[0].victim, victim, 31);
-    killFeed[0].weapon = wpn;
-    killFeed[0].headshot = hs;
-    killFeed[0].timer = 5.0f; 
-    killFeed[0].active = true;
-}
-
-
-void SpawnParticle(Vector3 pos, Vector3 vel, Color col, float size, float life, ParticleType type) {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (!particles[i].active) {
-            particles[i].position = pos;
-            particles[i].velocity = vel;
-            particles[i].color = col;
-            particles[i].size = size;
-            particles[i].life = life;
-            particles[i].type = type;
-            particles[i].active = true;
-            return;
-        }
-    }
-}
-
-void UpdateParticles(float dt) {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (!particles[i].active) continue;
-
-        particles[i].life -= dt;
-        particles[i].position = Vector3Add(particles[i].position, Vector3Scale(particles[i].velocity, dt));
-
-        if (particles[i].type == PARTICLE_BLOOD) {
-            particles[i].velocity.y -= GRAVITY * dt; 
-        } else if (particles[i].type == PARTICLE_EXPLOSION) {
-            particles[i].size += dt * 10.0f; 
-            particles[i].color.a = (unsigned char)(particles[i].life * 255.0f * 5.0f);
-        } else if (particles[i].type == PARTICLE_SMOKE) {
-            particles[i].velocity.y += 2.0f * dt;
-            particles[i].size += dt * 2.0f;
+#include "game.h"
+#include "world.h"
+#include "instancing.h"
+#include "staticmesh.h"
+#include "cull.h"
+#include "stats.h"
+#include "demo.h"
+#include "../common/profile.h"
+#include "../common/hudtext.h"
+
+
+World world;
+MapFile map;
+CubeBatch cubes = { 0 };
+StaticMesh staticMesh = { 0 };
+Culler culler;
+// All HUD text, drawn in one batch at the end of the frame
+HudText hudText;
+Demo demo;
+DemoPlayback playback;
+
+
+// Particles are drawn where they will be after the fraction alpha of the next tick
+void DrawParticles3D(float alpha) {
+    float ahead = alpha * WORLD_DT;
+    for (int t = 0; t < PARTICLE_TYPE_COUNT; t++) {
+        const ParticleBucket *b = &world.particles.buckets[t];
+        for (int i = 0; i < b->count; i++) {
+            Vector3 pos = { b->x[i] + b->vx[i]*ahead, b->y[i] + b->vy[i]*ahead, b->z[i] + b->vz[i]*ahead };
+            Vector3 half = { b->size[i]*0.5f, b->size[i]*0.5f, b->size[i]*0.5f };
+            if (!CullBox(&culler, (BoundingBox){ Vector3Subtract(pos, half), Vector3Add(pos, half) }, CULL_PARTICLES)) continue;
+            CubeBatchAdd(&cubes, pos, (Vector3){ b->size[i], b->size[i], b->size[i] }, b->color[i]);
         }
-
-        if (particles[i].life <= 0) particles[i].active = false;
-    }
-}
-
-void DrawParticles3D() {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (!particles[i].active) continue;
-        DrawCube(particles[i].position, particles[i].size, particles[i].size, particles[i].size, particles[i].color);
     }
 }
 
 
-void AddWall(Vector3 pos, Vector3 size, Color col) {
-    if (wallCount < MAX_WALLS) {
-        mapWalls[wallCount].position = pos;
-        mapWalls[wallCount].size = size;
-        mapWalls[wallCount].color = col;
-        mapWalls[wallCount].outlineColor = ColorBrightness(col, -0.3f);
-        wallCount++;
-    }
-}
-
-void ResetGame() {
-    wallCount = 0;
-    
-    AddWall((Vector3){0, -0.5f, 0}, (Vector3){60, 1, 60}, (Color){80, 80, 80, 255});
-    
-    
-    AddWall((Vector3){-15, 2.5f, 15}, (Vector3){10, 6, 1}, DARKGRAY); 
-    AddWall((Vector3){15, 2.5f, -15}, (Vector3){10, 6, 1}, DARKGRAY); 
-    
-    
-    AddWall((Vector3){-5, 1, 5}, (Vector3){2, 2, 2}, ORANGE);
-    AddWall((Vector3){5, 1.5f, -5}, (Vector3){3, 3, 3}, BEIGE);
-    AddWall((Vector3){0, 1, 10}, (Vector3){2, 2, 6}, BROWN);
-
-    
-    for (int i = 0; i < MAX_TARGETS; i++) {
-        targets[i].position = (Vector3){ (float)GetRandomValue(-20, 20), 0.0f, (float)GetRandomValue(-20, 20) };
-        targets[i].active = true;
-        targets[i].health = 100;
-        targets[i].hitTimer = 0;
-        targets[i].deathTimer = 0;
-        targets[i].id = i + 1;
-    }
-    
-    
-    for(int i=0; i<MAX_PARTICLES; i++) particles[i].active = false;
-    for(int i=0; i<MAX_KILLFEED; i++) killFeed[i].active = false;
-}
-
-
 void DrawWeaponRect(float x, float y, float w, float h, Color c) {
     DrawRectangle((int)x, (int)y, (int)w, (int)h, c);
     DrawRectangleLines((int)x, (int)y, (int)w, (int)h, ColorBrightness(c, -0.3f));
@@ -228,343 +55,205 @@ Vector2 RotatePoint(Vector2 point, float angle) {
     return (Vector2){ point.x * c - point.y * s, point.x * s + point.y * c };
 }
 
-int main() {
-    InitWindow(1280, 720, "CS2 Engine - Enhanced 2.0");
-    SetTargetFPS(60);
-    DisableCursor();
 
-    Player p = { 0 };
-    p.camera.position = (Vector3){ 0.0f, 2.0f, -10.0f };
-    p.camera.target = (Vector3){ 0.0f, 2.0f, 0.0f };
-    p.camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
-    p.camera.fovy = 75.0f;
-    p.camera.projection = CAMERA_PERSPECTIVE;
-    
-    
-    p.ammoRifle = 30;
-    p.reserveRifle = 90;
-    p.ammoPistol = 20;
-    p.reservePistol = 120;
-    p.grenades = 3;
-    p.health = 100;
-    p.weapon = WPN_RIFLE;
-    p.lastWeapon = WPN_RIFLE;
-    p.equipTimer = 1.0f;
-
-    ResetGame();
+// Presses and mouse movement pile up until a tick consumes them
+void SampleInput(PlayerInput *in) {
+    in->forward = (float)(IsKeyDown(KEY_W) - IsKeyDown(KEY_S));
+    in->right = (float)(IsKeyDown(KEY_D) - IsKeyDown(KEY_A));
+    in->look = Vector2Add(in->look, GetMouseDelta());
+    in->fireHeld = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    in->firePressed |= IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+    in->jump |= IsKeyPressed(KEY_SPACE);
+    in->reload |= IsKeyPressed(KEY_R);
+    in->inspect |= IsKeyPressed(KEY_F);
+    in->reset |= IsKeyPressed(KEY_T);
+    // Keys 1-9 pick weapons in the order of the weapon table
+    for (int i = 0; i < 9 && i < world.weapons.count; i++) {
+        if (IsKeyPressed(KEY_ONE + i)) in->selectWeapon = i;
+    }
+}
 
-    while (!WindowShouldClose()) {
-        float dt = GetFrameTime();
-        
-        
-        WeaponType targetWeapon = p.weapon;
-        if (IsKeyPressed(KEY_ONE)) targetWeapon = WPN_RIFLE;
-        if (IsKeyPressed(KEY_TWO)) targetWeapon = WPN_PISTOL;
-        if (IsKeyPressed(KEY_THREE)) targetWeapon = WPN_KNIFE;
-        if (IsKeyPressed(KEY_FOUR)) targetWeapon = WPN_GRENADE;
-        
-        if (targetWeapon != p.weapon) {
-            p.lastWeapon = p.weapon;
-            p.weapon = targetWeapon;
-            p.equipTimer = 0.0f; 
-            p.shootCooldown = 0.5f;
-            p.isReloading = false; 
-            p.isInspecting = false; 
-            p.reloadTimer = 0;
-        }
-        
-        
-        if (IsKeyPressed(KEY_F) && !p.isReloading && p.weapon != WPN_GRENADE) {
-            p.isInspecting = true;
-            p.inspectTimer = 0.0f;
-        }
-        
-        
-        if (IsKeyPressed(KEY_R) && !p.isReloading && !p.isInspecting && p.weapon != WPN_KNIFE && p.weapon != WPN_GRENADE) {
-            bool canReload = false;
-            if (p.weapon == WPN_RIFLE && p.ammoRifle < 30 && p.reserveRifle > 0) canReload = true;
-            if (p.weapon == WPN_PISTOL && p.ammoPistol < 20 && p.reservePistol > 0) canReload = true;
-            
-            if (canReload) {
-                p.isReloading = true;
-                p.reloadTimer = 0.0f;
-            }
-        }
-        
-        if (IsKeyPressed(KEY_T)) ResetGame();
-
-        
-        Vector2 mouseDelta = GetMouseDelta();
-        UpdateCameraPro(&p.camera, 
-            (Vector3){
-                (IsKeyDown(KEY_W) - IsKeyDown(KEY_S)) * WALK_SPEED * dt,
-                (IsKeyDown(KEY_D) - IsKeyDown(KEY_A)) * WALK_SPEED * dt,
-                0
-            },
-            (Vector3){
-                mouseDelta.x * SENSITIVITY,
-                mouseDelta.y * SENSITIVITY + (p.recoilPitch * 0.1f), 
-                0
-            },
-            0.0f
-        );
-        p.recoilPitch = Lerp(p.recoilPitch, 0, dt * 5.0f); 
-
-        
-        p.velocity.y -= GRAVITY * dt;
-        p.camera.position.y += p.velocity.y * dt;
-
-        if (p.camera.position.y <= 2.0f) {
-            p.camera.position.y = 2.0f;
-            p.velocity.y = 0;
-            p.isGrounded = true;
-        } else {
-            p.isGrounded = false;
-        }
+void ClearPressedInput(PlayerInput *in) {
+    in->look = (Vector2){ 0 };
+    in->firePressed = in->jump = in->reload = in->inspect = in->reset = false;
+    in->selectWeapon = -1;
+}
 
-        if (IsKeyPressed(KEY_SPACE) && p.isGrounded) {
-            p.velocity.y = JUMP_FORCE;
+// Usage: cs2 [-record file.dem] [compiled map]
+//        cs2 -play file.dem
+int main(int argc, char **argv) {
+    const char *recordPath = NULL;
+    const char *playPath = NULL;
+    int arg = 1;
+    if (argc > 2 && strcmp(argv[1], "-record") == 0) {
+        recordPath = argv[2];
+        arg = 3;
+    } else if (argc > 2 && strcmp(argv[1], "-play") == 0) {
+        playPath = argv[2];
+        arg = 3;
+    }
+    const char *mapPath = (argc > arg) ? argv[arg] : NULL;
+
+    uint64_t seed = (uint64_t)time(NULL);
+    if (playPath) {
+        char demoError[200];
+        if (!DemoLoad(&demo, playPath, demoError, sizeof(demoError))) {
+            fprintf(stderr, "%s\n", demoError);
+            return 1;
         }
+        // The demo knows its map
+        seed = demo.header.seed;
+        mapPath = demo.header.map[0] ? demo.header.map : NULL;
+    }
 
-        
-        bool isMoving = (IsKeyDown(KEY_W) || IsKeyDown(KEY_S) || IsKeyDown(KEY_A) || IsKeyDown(KEY_D)) && p.isGrounded;
-        if (isMoving) p.walkTimer += dt * 10.0f;
-        else p.walkTimer = 0.0f;
-
-        
-        p.weaponSway.x = Lerp(p.weaponSway.x, -mouseDelta.x * 2.0f, dt * 5.0f);
-        p.weaponSway.y = Lerp(p.weaponSway.y, -mouseDelta.y * 2.0f, dt * 5.0f);
-
-        
-        p.equipTimer = fminf(p.equipTimer + dt * 3.0f, 1.0f);
-
-        
-        if (p.isInspecting) {
-            p.inspectTimer += dt;
-            if (p.inspectTimer > 3.14f * 2) { 
-                 p.isInspecting = false; 
-            }
-        }
-        
-        
-        if (p.isReloading) {
-            p.reloadTimer += dt;
-            float reloadTime = (p.weapon == WPN_RIFLE) ? 2.0f : 1.5f;
-            
-            if (p.reloadTimer >= reloadTime) {
-                
-                if (p.weapon == WPN_RIFLE) {
-                    int needed = 30 - p.ammoRifle;
-                    int take = (needed > p.reserveRifle) ? p.reserveRifle : needed;
-                    p.ammoRifle += take;
-                    p.reserveRifle -= take;
-                } else if (p.weapon == WPN_PISTOL) {
-                    int needed = 20 - p.ammoPistol;
-                    int take = (needed > p.reservePistol) ? p.reservePistol : needed;
-                    p.ammoPistol += take;
-                    p.reservePistol -= take;
-                }
-                p.isReloading = false;
-                p.reloadTimer = 0;
-            }
-        }
+    InitWindow(1280, 720, "CS2 Engine - Enhanced 2.0");
+    SetTargetFPS(60);
+    DisableCursor();
 
-        if (p.shootCooldown > 0) p.shootCooldown -= dt;
-        if (p.recoilOffset > 0) p.recoilOffset -= dt * 5.0f;
-        if (p.muzzleFlashTimer > 0) p.muzzleFlashTimer -= dt;
-
-        
-        bool isFiring = (p.weapon == WPN_RIFLE) ? IsMouseButtonDown(MOUSE_LEFT_BUTTON) : IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
-        
-        
-        if (isFiring && (p.isInspecting || p.isReloading) && p.weapon != WPN_GRENADE) {
-            p.isInspecting = false;
-            p.isReloading = false; 
+    WorldInit(&world, seed);
+    // Accuracy per weapon is kept across sessions in stats.bin; demos being
+    // watched do not add to it
+    StatsPipeline *stats = playPath ? NULL : StatsStart("stats.bin");
+    if (stats) world.events = StatsEvents(stats);
+    else if (!playPath) TraceLog(LOG_WARNING, "could not open stats.bin, accuracy is not kept");
+    WeaponStats weaponStats[MAX_WEAPONS] = { 0 };
+    if (mapPath) {
+        char mapError[160];
+        if (MapFileOpen(&map, mapPath, mapError, sizeof(mapError))) {
+            WorldSetMap(&world, &map);
+        } else {
+            TraceLog(LOG_WARNING, "%s, using the built-in map", mapError);
+            mapPath = NULL;
         }
+    }
 
-        if (isFiring && p.shootCooldown <= 0 && p.equipTimer >= 0.8f && !p.isReloading) {
-            bool shotFired = false;
-            int dmg = 0;
-            float spread = 0.0f;
-            float range = 1000.0f; 
-
-            if (p.weapon == WPN_RIFLE && p.ammoRifle > 0) { 
-                p.ammoRifle--; p.shootCooldown = 0.1f; p.recoilOffset = 0.2f; p.recoilPitch = 2.0f; dmg = 35; shotFired = true; spread = 0.05f; p.muzzleFlashTimer = 0.05f;
-            }
-            else if (p.weapon == WPN_PISTOL && p.ammoPistol > 0) { 
-                p.ammoPistol--; p.shootCooldown = 0.15f; p.recoilOffset = 0.15f; p.recoilPitch = 1.5f; dmg = 25; shotFired = true; spread = 0.02f; p.muzzleFlashTimer = 0.05f;
-            }
-            else if (p.weapon == WPN_KNIFE) { 
-                p.shootCooldown = 0.5f; p.recoilOffset = -0.5f; dmg = 55; shotFired = true; range = 3.5f; 
-            }
-            else if (p.weapon == WPN_GRENADE && p.grenades > 0 && !activeNade.active) {
-                p.grenades--;
-                activeNade.active = true;
-                activeNade.timer = 2.0f;
-                activeNade.position = p.camera.position;
-                Vector3 dir = Vector3Normalize(Vector3Subtract(p.camera.target, p.camera.position));
-                dir.y += 0.2f; 
-                activeNade.velocity = Vector3Scale(dir, 20.0f);
-                p.shootCooldown = 1.0f;
-                p.equipTimer = 0.0f; 
-            }
-
-            
-            if (shotFired && p.weapon != WPN_GRENADE) {
-                Ray ray = GetMouseRay((Vector2){1280/2, 720/2}, p.camera);
-                
-                
-                if (p.weapon != WPN_KNIFE) {
-                    ray.direction.x += ((float)GetRandomValue(-100, 100)/10000.0f) * spread;
-                    ray.direction.y += ((float)GetRandomValue(-100, 100)/10000.0f) * spread;
-                }
-
-                bool hitAnything = false;
-                
-                
-                for (int i=0; i<MAX_TARGETS; i++) {
-                    if (!targets[i].active || targets[i].health <= 0) continue;
-                    
-                    BoundingBox hBox = {(Vector3){targets[i].position.x-0.3f, 1.4f, targets[i].position.z-0.3f}, (Vector3){targets[i].position.x+0.3f, 1.9f, targets[i].position.z+0.3f}};
-                    BoundingBox bBox = {(Vector3){targets[i].position.x-0.4f, 0.0f, targets[i].position.z-0.4f}, (Vector3){targets[i].position.x+0.4f, 1.4f, targets[i].position.z+0.4f}};
-                    
-                    RayCollision headHit = GetRayCollisionBox(ray, hBox);
-                    RayCollision bodyHit = GetRayCollisionBox(ray, bBox);
-
-                    
-                    bool validHit = false;
-                    bool isHeadshot = false;
-
-                    if (headHit.hit && headHit.distance < range) { validHit = true; isHeadshot = true; }
-                    else if (bodyHit.hit && bodyHit.distance < range) { validHit = true; isHeadshot = false; }
-
-                    if (validHit) {
-                        hitAnything = true;
-                        float hitDmg = isHeadshot ? dmg * 4 : dmg; 
-                        targets[i].health -= hitDmg;
-                        targets[i].hitTimer = 0.2f;
-                        
-                        
-                        for(int p=0; p<5; p++) {
-                            Vector3 hitPos = isHeadshot ? headHit.point : bodyHit.point;
-                            SpawnParticle(hitPos, 
-                                (Vector3){(float)GetRandomValue(-10,10)*0.1f, (float)GetRandomValue(0,10)*0.1f, (float)GetRandomValue(-10,10)*0.1f}, 
-                                RED, 0.1f, 0.5f, PARTICLE_BLOOD);
-                        }
+    // weapons.txt is optional; without it the built-in table is used. A demo
+    // brings its own.
+    WeaponTable weapons = world.weapons;
+    char weaponError[160] = "";
+    if (!playPath && WeaponTableReload(&weapons, "weapons.txt", weaponError, sizeof(weaponError))) WorldSetWeapons(&world, &weapons);
+    float weaponCheckTimer = 0.0f;
+
+    int me = WorldAddPlayer(&world, "Player");
+    if (recordPath) DemoBegin(&demo, &world, seed, mapPath);
+    if (playPath && !DemoPlaybackStart(&playback, &demo, &world)) {
+        TraceLog(LOG_WARNING, "%s does not fit this world, not playing it", playPath);
+        playPath = NULL;
+    }
+    int playSpeed = 1;
+    CubeBatchInit(&cubes);
+    StaticMeshInit(&staticMesh);
+    HudTextInit(&hudText, GetFontDefault());
 
-                        if (targets[i].health <= 0 && targets[i].deathTimer == 0) {
-                            targets[i].deathTimer = 1.5f;
-                            
-                            AddKillMsg("Player", "Enemy", p.weapon, isHeadshot);
-                        }
-                        break; 
-                    }
-                }
+    PlayerInput input = { 0 };
+    input.selectWeapon = -1;
+    float accumulator = 0.0f;
+    bool showProfile = false;
+    bool showCulling = false;
 
-                
-                if (!hitAnything) {
-                    for(int i=0; i<wallCount; i++) {
-                         RayCollision col = GetRayCollisionBox(ray, (BoundingBox){
-                             Vector3Subtract(mapWalls[i].position, Vector3Scale(mapWalls[i].size, 0.5f)),
-                             Vector3Add(mapWalls[i].position, Vector3Scale(mapWalls[i].size, 0.5f))
-                         });
-                         if(col.hit && col.distance < range) {
-                             SpawnParticle(col.point, (Vector3){col.normal.x*2, col.normal.y*2, col.normal.z*2}, YELLOW, 0.05f, 0.2f, PARTICLE_SPARK);
-                             break;
-                         }
-                    }
-                }
+    while (!WindowShouldClose()) {
+        float dt = GetFrameTime();
+        PROFILE_BEGIN(input, "input");
+
+        // F3 shows what culling let through, F4 zone timings and F5 saves a
+        // trace (builds with -DPROFILE)
+        if (IsKeyPressed(KEY_F4)) showProfile = !showProfile;
+        if (IsKeyPressed(KEY_F3)) showCulling = !showCulling;
+        if (IsKeyPressed(KEY_F5) && !ProfileWriteChromeTrace("profile.json")) TraceLog(LOG_WARNING, "Could not write profile.json");
+
+        // Pick up edits to weapons.txt while the game runs
+        weaponCheckTimer -= dt;
+        if (!playPath && weaponCheckTimer <= 0.0f) {
+            weaponCheckTimer = 0.5f;
+            if (WeaponTableReload(&weapons, "weapons.txt", weaponError, sizeof(weaponError))) {
+                WorldSetWeapons(&world, &weapons);
+                if (recordPath) DemoRecordWeapons(&demo, &weapons);
+                weaponError[0] = '\0';
             }
         }
 
-        
-        if (activeNade.active) {
-            if (!activeNade.exploding) {
-                activeNade.velocity.y -= GRAVITY * dt;
-                activeNade.position = Vector3Add(activeNade.position, Vector3Scale(activeNade.velocity, dt));
-                
-                if (activeNade.position.y < 0.2f) { 
-                    activeNade.position.y = 0.2f; 
-                    activeNade.velocity.y *= -0.5f; 
-                    activeNade.velocity.x *= 0.7f; 
-                    activeNade.velocity.z *= 0.7f;
-                }
-
-                activeNade.timer -= dt;
-                if (activeNade.timer <= 0) {
-                    activeNade.exploding = true;
-                    activeNade.timer = 0.5f; 
-                    for(int i=0; i<30; i++) {
-                        SpawnParticle(activeNade.position, 
-                            (Vector3){(float)GetRandomValue(-50,50)*0.1f, (float)GetRandomValue(-50,50)*0.1f, (float)GetRandomValue(-50,50)*0.1f}, 
-                            ORANGE, 0.5f, 0.6f, PARTICLE_EXPLOSION);
-                    }
-                    
-                    for(int i=0; i<MAX_TARGETS; i++) {
-                        if(targets[i].active && Vector3Distance(targets[i].position, activeNade.position) < 8.0f) {
-                            targets[i].health -= 80;
-                            targets[i].hitTimer = 0.2f;
-                             if (targets[i].health <= 0 && targets[i].deathTimer == 0) {
-                                 targets[i].deathTimer = 1.5f;
-                                 AddKillMsg("Player", "Enemy", WPN_GRENADE, false);
-                             }
-                        }
-                    }
-                }
-            } else {
-                activeNade.timer -= dt;
-                if (activeNade.timer <= 0) activeNade.active = false;
+        if (playPath) {
+            // Left/Right jump 10 s, Up/Down change the speed
+            int seekTicks = (IsKeyPressed(KEY_RIGHT) - IsKeyPressed(KEY_LEFT))*10*WORLD_TICK_RATE;
+            if (seekTicks != 0) {
+                int64_t target = (int64_t)playback.tick + seekTicks;
+                DemoPlaybackSeek(&playback, &world, target < 0 ? 0 : (uint32_t)target);
+                accumulator = 0.0f;
             }
+            if (IsKeyPressed(KEY_UP) && playSpeed < 8) playSpeed *= 2;
+            if (IsKeyPressed(KEY_DOWN) && playSpeed > 1) playSpeed /= 2;
+        } else {
+            SampleInput(&input);
         }
-        
-        UpdateParticles(dt);
-        
-        
-        for (int i=0; i<MAX_KILLFEED; i++) {
-            if (killFeed[i].active) {
-                killFeed[i].timer -= dt;
-                if (killFeed[i].timer <= 0) killFeed[i].active = false;
+        PROFILE_END(input);
+        accumulator += dt*playSpeed;
+        if (accumulator > 0.25f*playSpeed) accumulator = 0.25f*playSpeed;
+        while (accumulator >= WORLD_DT) {
+            if (playPath) {
+                if (!DemoPlaybackStep(&playback, &world)) accumulator = 0.0f;
+            } else {
+                if (recordPath) DemoRecordTick(&demo, &world, &input);
+                WorldStep(&world, &input, WORLD_DT);
+                ClearPressedInput(&input);
             }
+            accumulator = fmaxf(accumulator - WORLD_DT, 0.0f);
         }
 
-        
+        float alpha = accumulator / WORLD_DT;
+        Player p = world.players[me];
+        const WeaponDef *weapon = &world.weapons.defs[p.weapon];
+        Camera3D camera = WorldCamera(&world, me, alpha, playPath ? (Vector2){ 0 } : input.look);
+
         BeginDrawing();
             ClearBackground(SKYBLUE);
-            BeginMode3D(p.camera);
-                
-                DrawGrid(60, 1.0f);
+            PROFILE_BEGIN(draw3d, "draw 3d");
+            BeginMode3D(camera);
 
-                for (int i=0; i<wallCount; i++) {
-                    DrawCube(mapWalls[i].position, mapWalls[i].size.x, mapWalls[i].size.y, mapWalls[i].size.z, mapWalls[i].color);
-                    DrawCubeWires(mapWalls[i].position, mapWalls[i].size.x, mapWalls[i].size.y, mapWalls[i].size.z, mapWalls[i].outlineColor);
-                }
+                // Only what is in view and not behind the nearest big walls is drawn
+                CullBegin(&culler, camera, (float)GetScreenWidth()/(float)GetScreenHeight(), &world.wallBvh, world.walls);
+
+                // The grid, walls and outlines are baked when the map changes
+                StaticMeshUpdate(&staticMesh, world.walls, world.wallCount, world.wallVersion);
+                StaticMeshDraw(&staticMesh, &culler);
+
+                // Targets and particles all go out in one instanced draw
+                CubeBatchClear(&cubes);
 
                 for (int i=0; i<MAX_TARGETS; i++) {
-                    if (targets[i].active) {
-                        Vector3 pos = targets[i].position;
-                        if (targets[i].health <= 0) {
-                            targets[i].deathTimer -= dt;
-                            if (targets[i].deathTimer <= 0) targets[i].active = false;
-                            DrawCube((Vector3){pos.x, 0.2f, pos.z}, 1.5f, 0.4f, 2.5f, DARKGRAY);
+                    if (world.targets[i].active) {
+                        Vector3 pos = Vector3Lerp(world.prevTarget[i], world.targets[i].position, alpha);
+                        BoundingBox bounds = (world.targets[i].health <= 0)
+                            ? (BoundingBox){ { pos.x - 0.75f, 0.0f, pos.z - 1.25f }, { pos.x + 0.75f, 0.4f, pos.z + 1.25f } }
+                            : (BoundingBox){ { pos.x - 0.7f, 0.0f, pos.z - 0.25f }, { pos.x + 0.7f, 2.75f, pos.z + 0.25f } };
+                        if (!CullBox(&culler, bounds, CULL_TARGETS)) continue;
+                        if (world.targets[i].health <= 0) {
+                            CubeBatchAdd(&cubes, (Vector3){pos.x, 0.2f, pos.z}, (Vector3){1.5f, 0.4f, 2.5f}, DARKGRAY);
                         } else {
-                            Color skin = targets[i].hitTimer > 0 ? RED : BEIGE;
-                            Color shirt = targets[i].hitTimer > 0 ? RED : BLUE;
+                            Color skin = world.targets[i].hitTimer > 0 ? RED : BEIGE;
+                            Color shirt = world.targets[i].hitTimer > 0 ? RED : BLUE;
                             
-                            DrawCube((Vector3){pos.x-0.2f, 0.7f, pos.z}, 0.25f, 1.4f, 0.3f, DARKBLUE);
-                            DrawCube((Vector3){pos.x+0.2f, 0.7f, pos.z}, 0.25f, 1.4f, 0.3f, DARKBLUE);
-                            DrawCube((Vector3){pos.x, 1.8f, pos.z}, 0.9f, 0.9f, 0.5f, shirt);
-                            DrawCube((Vector3){pos.x, 2.5f, pos.z}, 0.5f, 0.5f, 0.5f, skin);
-                            DrawCube((Vector3){pos.x-0.6f, 1.8f, pos.z}, 0.2f, 0.8f, 0.2f, skin);
-                            DrawCube((Vector3){pos.x+0.6f, 1.8f, pos.z}, 0.2f, 0.8f, 0.2f, skin);
+                            CubeBatchAdd(&cubes, (Vector3){pos.x-0.2f, 0.7f, pos.z}, (Vector3){0.25f, 1.4f, 0.3f}, DARKBLUE);
+                            CubeBatchAdd(&cubes, (Vector3){pos.x+0.2f, 0.7f, pos.z}, (Vector3){0.25f, 1.4f, 0.3f}, DARKBLUE);
+                            CubeBatchAdd(&cubes, (Vector3){pos.x, 1.8f, pos.z}, (Vector3){0.9f, 0.9f, 0.5f}, shirt);
+                            CubeBatchAdd(&cubes, (Vector3){pos.x, 2.5f, pos.z}, (Vector3){0.5f, 0.5f, 0.5f}, skin);
+                            CubeBatchAdd(&cubes, (Vector3){pos.x-0.6f, 1.8f, pos.z}, (Vector3){0.2f, 0.8f, 0.2f}, skin);
+                            CubeBatchAdd(&cubes, (Vector3){pos.x+0.6f, 1.8f, pos.z}, (Vector3){0.2f, 0.8f, 0.2f}, skin);
                         }
-                        targets[i].hitTimer -= dt;
                     }
                 }
 
-                if (activeNade.active && !activeNade.exploding) DrawSphere(activeNade.position, 0.3f, DARKGREEN);
-                DrawParticles3D();
+                for (int i = 0; i < world.projectiles.count; i++) {
+                    const Projectile *nade = &world.projectiles.items[i];
+                    Vector3 pos = Vector3Lerp(nade->previous, nade->position, alpha);
+                    BoundingBox bounds = { Vector3Subtract(pos, (Vector3){ 0.3f, 0.3f, 0.3f }), Vector3Add(pos, (Vector3){ 0.3f, 0.3f, 0.3f }) };
+                    if (!nade->exploding && CullBox(&culler, bounds, CULL_GRENADES)) DrawSphere(pos, 0.3f, DARKGREEN);
+                }
+                DrawParticles3D(alpha);
+                CubeBatchDraw(&cubes);
 
             EndMode3D();
+            PROFILE_END(draw3d);
+            PROFILE_BEGIN(hud, "hud");
 
             
             
@@ -601,7 +290,7 @@ int main() {
             float wx = 1280 - 300 + p.weaponSway.x + bobX + inspectX;
             float wy = 720 - 300 + p.weaponSway.y + bobY + equipY + recoilKick + reloadY + inspectY;
 
-            if (p.weapon == WPN_RIFLE) {
+            if (weapon->model == WPN_RIFLE) {
                 
                 rlPushMatrix();
                 rlTranslatef(wx, wy, 0);
@@ -616,7 +305,7 @@ int main() {
 
                 rlPopMatrix();
             } 
-            else if (p.weapon == WPN_PISTOL) {
+            else if (weapon->model == WPN_PISTOL) {
                 rlPushMatrix();
                 rlTranslatef(wx, wy, 0);
                 rlRotatef(inspectRot, 0, 0, 1);
@@ -628,7 +317,7 @@ int main() {
 
                 rlPopMatrix();
             }
-            else if (p.weapon == WPN_KNIFE) {
+            else if (weapon->model == WPN_KNIFE) {
                 float stabY = (p.recoilOffset < 0) ? p.recoilOffset * 200.0f : 0;
                 
                 rlPushMatrix();
@@ -641,84 +330,152 @@ int main() {
                 
                 rlPopMatrix();
             }
-            else if (p.weapon == WPN_GRENADE) {
+            else if (weapon->model == WPN_GRENADE) {
                 DrawCircle((int)wx + 100, (int)wy + 100, 40, DARKGREEN);
                 DrawCircleLines((int)wx + 100, (int)wy + 100, 40, BLACK);
                 DrawRectangle((int)wx + 90, (int)wy + 50, 20, 30, GRAY);
             }
 
             
-            DrawText(TextFormat("HP: %03d", p.health), 20, 670, 40, RED);
+            char hpText[16];
+            snprintf(hpText, sizeof(hpText), "HP: %03d", p.health);
+            HudTextDraw(&hudText, hpText, 20, 670, 40, RED);
             
-            char* ammoText = "---";
-            if (p.weapon == WPN_RIFLE) ammoText = TextFormat("%d / %d", p.ammoRifle, p.reserveRifle);
-            if (p.weapon == WPN_PISTOL) ammoText = TextFormat("%d / %d", p.ammoPistol, p.reservePistol);
-            if (p.weapon == WPN_GRENADE) ammoText = TextFormat("%d", p.grenades);
+            char ammoText[32] = "---";
+            if (weapon->mode == FIRE_THROWN) snprintf(ammoText, sizeof(ammoText), "%d", p.ammo[p.weapon]);
+            else if (weapon->magazine > 0) snprintf(ammoText, sizeof(ammoText), "%d / %d", p.ammo[p.weapon], p.reserve[p.weapon]);
             
             
-            if (p.isReloading) DrawText("RELOADING...", 1000, 620, 30, RED);
-            else if ((p.weapon == WPN_RIFLE && p.ammoRifle == 0) || (p.weapon == WPN_PISTOL && p.ammoPistol == 0)) DrawText("PRESS 'R'", 1100, 620, 30, RED);
+            if (p.isReloading) HudTextDraw(&hudText, "RELOADING...", 1000, 620, 30, RED);
+            else if (weapon->mode != FIRE_THROWN && weapon->magazine > 0 && p.ammo[p.weapon] == 0) HudTextDraw(&hudText, "PRESS 'R'", 1100, 620, 30, RED);
+
+            HudTextDraw(&hudText, ammoText, 1100, 670, 40, YELLOW);
+
+            // Left as it was when the stats thread is busy with a batch
+            if (stats) StatsRead(stats, weaponStats, NULL);
+            const WeaponStats *ws = &weaponStats[p.weapon];
+            if (ws->shots > 0) {
+                char accuracyText[48];
+                snprintf(accuracyText, sizeof(accuracyText), "HIT %.0f%%  HS %.0f%%", 100.0*ws->hits/ws->shots,
+                         ws->hits ? 100.0*ws->headshots/ws->hits : 0.0);
+                HudTextDraw(&hudText, accuracyText, 20, 640, 20, LIGHTGRAY);
+            }
 
-            DrawText(ammoText, 1100, 670, 40, YELLOW);
-            DrawText("1:AK 2:GLOCK 3:KNIFE 4:NADE | F:INSPECT R:RELOAD T:RESET", 20, 20, 20, WHITE);
+            char help[256] = "";
+            int helpLength = 0;
+            for (int i = 0; i < 9 && i < world.weapons.count; i++) {
+                helpLength += snprintf(help + helpLength, sizeof(help) - helpLength, "%d:%s ", i + 1, world.weapons.defs[i].shortName);
+            }
+            snprintf(help + helpLength, sizeof(help) - helpLength, "| F:INSPECT R:RELOAD T:RESET");
+            HudTextDraw(&hudText, help, 20, 20, 20, WHITE);
+            if (weaponError[0]) HudTextDraw(&hudText, weaponError, 20, 45, 20, RED);
+            // The demo warning, cull counters and profile table stack down the
+            // left side from here
+            int panelY = 75;
+            if (playPath) {
+                int at = (int)(playback.tick/WORLD_TICK_RATE);
+                int length = (int)(demo.header.tickCount/WORLD_TICK_RATE);
+                char demoText[96];
+                snprintf(demoText, sizeof(demoText), "DEMO %d:%02d / %d:%02d  x%d  <-/-> SEEK  UP/DOWN SPEED",
+                         at/60, at%60, length/60, length%60, playSpeed);
+                HudTextDraw(&hudText, demoText, 20, 45, 20, WHITE);
+                if (playback.mismatchTick >= 0) {
+                    snprintf(demoText, sizeof(demoText), "OUT OF SYNC SINCE TICK %lld", (long long)playback.mismatchTick);
+                    HudTextDraw(&hudText, demoText, 20, panelY, 20, RED);
+                    panelY += 25;
+                }
+            }
 
-            
+            if (showCulling) {
+                static const char *kinds[CULL_KIND_COUNT] = { "wall chunks", "targets", "particles", "grenades" };
+                char line[96];
+                for (int k = 0; k < CULL_KIND_COUNT; k++) {
+                    const CullCounters *c = &culler.counters[k];
+                    snprintf(line, sizeof(line), "%s: %d drawn, %d off screen, %d hidden", kinds[k], c->submitted, c->frustumCulled, c->occluded);
+                    HudTextDraw(&hudText, line, 20, panelY + 22*k, 20, WHITE);
+                }
+                snprintf(line, sizeof(line), "occluders: %d", culler.occluders);
+                HudTextDraw(&hudText, line, 20, panelY + 22*CULL_KIND_COUNT, 20, WHITE);
+                panelY += 22*(CULL_KIND_COUNT + 1) + 5;
+            }
+
+            PROFILE_END(hud);
+
+            PROFILE_BEGIN(killFeed, "kill feed");
             int kfY = 20;
             for (int i=0; i<MAX_KILLFEED; i++) {
-                if (killFeed[i].active) {
-                    
+                float killTimer;
+                const GameEvent *kill = WorldKillFeed(&world, i, &killTimer);
+                if (kill) {
+                    const char *victim = NameLookup(&world.names, kill->subject);
+                    const char *killer = NameLookup(&world.names, kill->actor);
                     int startX = 1260;
                     
                     
-                    int enemyW = MeasureText(killFeed[i].victim, 20);
-                    int playerW = MeasureText(killFeed[i].killer, 20);
+                    int enemyW = HudTextMeasure(&hudText, victim, 20);
+                    int playerW = HudTextMeasure(&hudText, killer, 20);
                     int iconW = 30; 
                     int gap = 10;
                     
                     
-                    Color bg = (Color){0, 0, 0, (unsigned char)(killFeed[i].timer > 1.0f ? 150 : killFeed[i].timer * 150.0f)};
-                    Color txt = (Color){255, 255, 255, (unsigned char)(killFeed[i].timer > 1.0f ? 255 : killFeed[i].timer * 255.0f)};
-                    Color red = (Color){230, 41, 55, (unsigned char)(killFeed[i].timer > 1.0f ? 255 : killFeed[i].timer * 255.0f)};
+                    Color bg = (Color){0, 0, 0, (unsigned char)(killTimer > 1.0f ? 150 : killTimer * 150.0f)};
+                    Color txt = (Color){255, 255, 255, (unsigned char)(killTimer > 1.0f ? 255 : killTimer * 255.0f)};
+                    Color red = (Color){230, 41, 55, (unsigned char)(killTimer > 1.0f ? 255 : killTimer * 255.0f)};
 
                     
-                    int totalW = enemyW + playerW + iconW + (killFeed[i].headshot ? 30 : 0) + (gap * 4);
+                    int totalW = enemyW + playerW + iconW + (kill->headshot ? 30 : 0) + (gap * 4);
                     DrawRectangle(startX - totalW, kfY, totalW, 30, bg);
                     
                     
                     int curX = startX - 10;
                     
                     
-                    DrawText(killFeed[i].victim, curX - enemyW, kfY + 5, 20, txt);
+                    HudTextDraw(&hudText, victim, curX - enemyW, kfY + 5, 20, txt);
                     curX -= (enemyW + gap);
                     
                     
-                    if (killFeed[i].headshot) {
+                    if (kill->headshot) {
                         DrawCircle(curX - 10, kfY + 15, 8, red);
                         DrawCircle(curX - 10, kfY + 15, 4, bg); 
                         curX -= (20 + gap);
                     }
                     
                     
-                    Color wpnCol = GRAY;
-                    const char* wpnShort = "?";
-                    if (killFeed[i].weapon == WPN_RIFLE) { wpnCol = DARKBROWN; wpnShort = "AK"; }
-                    if (killFeed[i].weapon == WPN_PISTOL) { wpnCol = GRAY; wpnShort = "GL"; }
-                    if (killFeed[i].weapon == WPN_KNIFE) { wpnCol = MAROON; wpnShort = "KN"; }
-                    if (killFeed[i].weapon == WPN_GRENADE) { wpnCol = DARKGREEN; wpnShort = "HE"; }
+                    const WeaponDef *killWeapon = &world.weapons.defs[kill->weapon];
+                    Color wpnCol = killWeapon->color;
+                    const char* wpnShort = killWeapon->shortName;
                     
                     DrawRectangle(curX - 30, kfY + 5, 30, 20, wpnCol);
-                    DrawText(wpnShort, curX - 25, kfY + 8, 10, WHITE);
+                    HudTextDraw(&hudText, wpnShort, curX - 25, kfY + 8, 10, WHITE);
                     curX -= (30 + gap);
                     
                     
-                    DrawText(killFeed[i].killer, curX - playerW, kfY + 5, 20, txt);
+                    HudTextDraw(&hudText, killer, curX - playerW, kfY + 5, 20, txt);
                     
                     kfY += 35;
                 }
             }
+            HudTextFlush(&hudText);
+            PROFILE_END(killFeed);
+
+            if (showProfile) ProfileDrawOverlay(20, panelY);
 
         EndDrawing();
+        ProfileFrameEnd();
+    }
+    CubeBatchUnload(&cubes);
+    StaticMeshUnload(&staticMesh);
+    HudTextFree(&hudText);
+    world.events = NULL;
+    StatsStop(stats);
+    if (recordPath) {
+        DemoFinish(&demo, &world);
+        if (!DemoSave(&demo, recordPath)) TraceLog(LOG_WARNING, "Could not write demo %s", recordPath);
     }
+    DemoFree(&demo);
+    WorldFree(&world);
+    MapFileClose(&map);
+    ProfileShutdown();
     CloseWindow();
     return 0;
 }
@@ -0,0 +1,62 @@
+#include "mapfile.h"
+#include "../common/bench.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Compiles a text map into the binary format the game maps into memory,
+// or generates a random text map of any size for testing.
+// Usage: mapc input.txt output.map
+//        mapc --generate walls output.txt [seed]
+
+static unsigned int genSeed = 12345;
+
+// A floor plus random boxes at roughly one per 16 square metres
+static int Generate(int count, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "%s: cannot write\n", path);
+        return 1;
+    }
+    float half = sqrtf((float)count*16.0f)*0.5f;
+    fprintf(file, "# %d generated walls\n", count);
+    fprintf(file, "wall 0 -0.5 0 %.1f 1 %.1f 505050\n", half*2, half*2);
+    for (int i = 1; i < count; i++) {
+        float sx = BenchRandomFloat(&genSeed, 0.5f, 4), sy = BenchRandomFloat(&genSeed, 0.5f, 6), sz = BenchRandomFloat(&genSeed, 0.5f, 4);
+        unsigned int shade = 0x40 + (unsigned int)BenchRandomFloat(&genSeed, 0, 0x80);
+        fprintf(file, "wall %.2f %.2f %.2f %.2f %.2f %.2f %02X%02X%02X\n",
+                BenchRandomFloat(&genSeed, -half, half), sy*0.5f, BenchRandomFloat(&genSeed, -half, half), sx, sy, sz, shade, shade, shade);
+    }
+    for (int i = 0; i < 16; i++) {
+        float angle = (float)i*2.0f*PI/16.0f;
+        fprintf(file, "spawn %.2f 0 %.2f %.1f\n", half*0.9f*sinf(angle), half*0.9f*cosf(angle), 180.0f - angle*RAD2DEG);
+    }
+    return fclose(file) == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && strcmp(argv[1], "--generate") == 0) {
+        if (argc > 4) genSeed = (unsigned int)strtoul(argv[4], NULL, 10);
+        return Generate(atoi(argv[2]), argv[3]);
+    }
+    if (argc != 3) {
+        fprintf(stderr, "usage: mapc input.txt output.map\n       mapc --generate walls output.txt [seed]\n");
+        return 1;
+    }
+
+    Wall *walls;
+    MapSpawn *spawns;
+    int wallCount, spawnCount;
+    char error[160];
+    if (!MapLoadText(argv[1], &walls, &wallCount, &spawns, &spawnCount, error, sizeof(error))) {
+        fprintf(stderr, "%s\n", error);
+        return 1;
+    }
+    bool ok = MapFileWrite(argv[2], walls, wallCount, spawns, spawnCount);
+    if (ok) printf("%s: %d walls, %d spawns\n", argv[2], wallCount, spawnCount);
+    else fprintf(stderr, "%s: cannot write\n", argv[2]);
+    free(walls);
+    free(spawns);
+    return ok ? 0 : 1;
+}
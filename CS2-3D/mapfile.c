@@ -0,0 +1,248 @@
+#include "mapfile.h"
+#include "raymath.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define MAP_ALIGN 16
+
+static uint64_t AlignUp(uint64_t offset) {
+    return (offset + MAP_ALIGN - 1) & ~(uint64_t)(MAP_ALIGN - 1);
+}
+
+static bool Fail(char *error, int errorSize, const char *path, const char *reason) {
+    if (error) snprintf(error, errorSize, "%s: %s", path, reason);
+    return false;
+}
+
+// Whole file mapped read-only; returns NULL on failure
+static void *MapWholeFile(const char *path, size_t *size) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER length;
+    void *data = NULL;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)length.QuadPart;
+    }
+    CloseHandle(file);
+    return data;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    void *data = NULL;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) data = NULL;
+        *size = (size_t)info.st_size;
+    }
+    close(fd);
+    return data;
+#endif
+}
+
+static void UnmapWholeFile(void *data, size_t size) {
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+static bool SectionFits(const MapHeader *h, uint64_t offset, uint64_t count, uint64_t itemSize) {
+    return offset % MAP_ALIGN == 0 && offset <= h->fileSize && count <= (h->fileSize - offset)/itemSize;
+}
+
+static bool ValidBvh(const MapFile *map) {
+    const Bvh *bvh = &map->bvh;
+    for (int i = 0; i < bvh->nodeCount; i++) {
+        const BvhNode *node = &bvh->nodes[i];
+        if (node->count > 0) {
+            if (node->first < 0 || node->first > bvh->itemCount - node->count) return false;
+        } else if (node->first <= i || node->first + 1 >= bvh->nodeCount) {
+            // Children always come after their parent, which rules out cycles
+            return false;
+        }
+    }
+    for (int i = 0; i < bvh->itemCount; i++) {
+        if (bvh->items[i] < 0 || bvh->items[i] >= map->wallCount) return false;
+    }
+    return true;
+}
+
+bool MapFileOpen(MapFile *map, const char *path, char *error, int errorSize) {
+    memset(map, 0, sizeof(*map));
+
+    size_t size = 0;
+    uint8_t *data = MapWholeFile(path, &size);
+    if (!data) return Fail(error, errorSize, path, "cannot open or map");
+
+    const MapHeader *h = (const MapHeader *)data;
+    const char *reason = NULL;
+    if (size < sizeof(MapHeader) || h->magic != MAP_MAGIC) reason = "not a compiled map";
+    else if (h->version != MAP_VERSION) reason = "unsupported map version";
+    else if (h->wallSize != sizeof(Wall) || h->nodeSize != sizeof(BvhNode)) reason = "written by a build with a different struct layout";
+    else if (h->fileSize != size) reason = "truncated";
+    else if (h->wallCount > INT32_MAX/2 || h->spawnCount > INT32_MAX || h->nodeCount > INT32_MAX) reason = "bad counts";
+    else if (!SectionFits(h, h->wallsOffset, h->wallCount, sizeof(Wall)) ||
+             !SectionFits(h, h->spawnsOffset, h->spawnCount, sizeof(MapSpawn)) ||
+             !SectionFits(h, h->nodesOffset, h->nodeCount, sizeof(BvhNode)) ||
+             !SectionFits(h, h->boxesOffset, h->wallCount, sizeof(BoundingBox)) ||
+             !SectionFits(h, h->itemsOffset, h->wallCount, sizeof(int))) reason = "section outside the file";
+    if (reason) {
+        UnmapWholeFile(data, size);
+        return Fail(error, errorSize, path, reason);
+    }
+
+    map->data = data;
+    map->size = size;
+    map->walls = (const Wall *)(data + h->wallsOffset);
+    map->wallCount = (int)h->wallCount;
+    map->spawns = (const MapSpawn *)(data + h->spawnsOffset);
+    map->spawnCount = (int)h->spawnCount;
+
+    // The BVH is only read, so it can point straight at the read-only pages
+    map->bvh.nodes = (BvhNode *)(data + h->nodesOffset);
+    map->bvh.boxes = (BoundingBox *)(data + h->boxesOffset);
+    map->bvh.items = (int *)(data + h->itemsOffset);
+    map->bvh.nodeCount = (int)h->nodeCount;
+    map->bvh.itemCount = (int)h->wallCount;
+    map->bvh.owned = false;
+
+    if (!ValidBvh(map)) {
+        MapFileClose(map);
+        return Fail(error, errorSize, path, "corrupt BVH");
+    }
+    return true;
+}
+
+void MapFileClose(MapFile *map) {
+    if (map->data) UnmapWholeFile(map->data, map->size);
+    memset(map, 0, sizeof(*map));
+}
+
+static bool WriteSection(FILE *file, uint64_t offset, const void *data, size_t bytes) {
+    if (fseek(file, (long)offset, SEEK_SET) != 0) return false;
+    return bytes == 0 || fwrite(data, 1, bytes, file) == bytes;
+}
+
+bool MapFileWrite(const char *path, const Wall *walls, int wallCount, const MapSpawn *spawns, int spawnCount) {
+    BoundingBox *boxes = malloc((wallCount > 0 ? wallCount : 1)*sizeof(BoundingBox));
+    if (!boxes) return false;
+    for (int i = 0; i < wallCount; i++) {
+        Vector3 half = Vector3Scale(walls[i].size, 0.5f);
+        boxes[i] = (BoundingBox){ Vector3Subtract(walls[i].position, half), Vector3Add(walls[i].position, half) };
+    }
+    Bvh bvh = { 0 };
+    bool built = BvhBuild(&bvh, boxes, wallCount);
+    free(boxes);
+    if (!built) return false;
+
+    MapHeader h = { 0 };
+    h.magic = MAP_MAGIC;
+    h.version = MAP_VERSION;
+    h.wallSize = sizeof(Wall);
+    h.nodeSize = sizeof(BvhNode);
+    h.wallCount = (uint32_t)wallCount;
+    h.spawnCount = (uint32_t)spawnCount;
+    h.nodeCount = (uint32_t)bvh.nodeCount;
+    h.wallsOffset = AlignUp(sizeof(MapHeader));
+    h.spawnsOffset = AlignUp(h.wallsOffset + (uint64_t)wallCount*sizeof(Wall));
+    h.nodesOffset = AlignUp(h.spawnsOffset + (uint64_t)spawnCount*sizeof(MapSpawn));
+    h.boxesOffset = AlignUp(h.nodesOffset + (uint64_t)bvh.nodeCount*sizeof(BvhNode));
+    h.itemsOffset = AlignUp(h.boxesOffset + (uint64_t)wallCount*sizeof(BoundingBox));
+    h.fileSize = h.itemsOffset + (uint64_t)wallCount*sizeof(int);
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file != NULL;
+    if (ok) {
+        // Sections are written at their offsets; the gaps read back as zeros
+        ok = WriteSection(file, 0, &h, sizeof(h)) &&
+             WriteSection(file, h.wallsOffset, walls, (size_t)wallCount*sizeof(Wall)) &&
+             WriteSection(file, h.spawnsOffset, spawns, (size_t)spawnCount*sizeof(MapSpawn)) &&
+             WriteSection(file, h.nodesOffset, bvh.nodes, (size_t)bvh.nodeCount*sizeof(BvhNode)) &&
+             WriteSection(file, h.boxesOffset, bvh.boxes, (size_t)wallCount*sizeof(BoundingBox)) &&
+             WriteSection(file, h.itemsOffset, bvh.items, (size_t)wallCount*sizeof(int));
+        ok = (fclose(file) == 0) && ok;
+    }
+    BvhFree(&bvh);
+    return ok;
+}
+
+// Same shade WorldAddWall gives its outlines
+static Color Outline(Color col) {
+    return (Color){ (unsigned char)(col.r*0.7f), (unsigned char)(col.g*0.7f), (unsigned char)(col.b*0.7f), col.a };
+}
+
+bool MapLoadText(const char *path, Wall **walls, int *wallCount, MapSpawn **spawns, int *spawnCount, char *error, int errorSize) {
+    *walls = NULL;
+    *spawns = NULL;
+    *wallCount = *spawnCount = 0;
+
+    FILE *file = fopen(path, "r");
+    if (!file) return Fail(error, errorSize, path, "cannot open");
+
+    int wallCapacity = 0, spawnCapacity = 0;
+    char line[256];
+    char reason[96] = "";
+    int lineNumber = 0;
+    while (!reason[0] && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char *start = line + strspn(line, " \t\r\n");
+        if (*start == '\0' || *start == '#') continue;
+
+        Wall wall = { 0 };
+        MapSpawn spawn = { 0 };
+        unsigned int rgb;
+        if (sscanf(start, "wall %f %f %f %f %f %f %x", &wall.position.x, &wall.position.y, &wall.position.z,
+                   &wall.size.x, &wall.size.y, &wall.size.z, &rgb) == 7) {
+            if (*wallCount == wallCapacity) {
+                wallCapacity = wallCapacity ? wallCapacity*2 : 64;
+                Wall *grown = realloc(*walls, wallCapacity*sizeof(Wall));
+                if (!grown) { snprintf(reason, sizeof(reason), "out of memory"); break; }
+                *walls = grown;
+            }
+            wall.color = (Color){ (unsigned char)(rgb >> 16), (unsigned char)(rgb >> 8), (unsigned char)rgb, 255 };
+            wall.outlineColor = Outline(wall.color);
+            (*walls)[(*wallCount)++] = wall;
+        } else if (sscanf(start, "spawn %f %f %f %f", &spawn.position.x, &spawn.position.y, &spawn.position.z, &spawn.yaw) == 4) {
+            if (*spawnCount == spawnCapacity) {
+                spawnCapacity = spawnCapacity ? spawnCapacity*2 : 16;
+                MapSpawn *grown = realloc(*spawns, spawnCapacity*sizeof(MapSpawn));
+                if (!grown) { snprintf(reason, sizeof(reason), "out of memory"); break; }
+                *spawns = grown;
+            }
+            spawn.yaw *= DEG2RAD;
+            (*spawns)[(*spawnCount)++] = spawn;
+        } else {
+            snprintf(reason, sizeof(reason), "line %d: expected 'wall x y z sx sy sz RRGGBB' or 'spawn x y z yaw'", lineNumber);
+        }
+    }
+    fclose(file);
+
+    if (reason[0]) {
+        free(*walls);
+        free(*spawns);
+        *walls = NULL;
+        *spawns = NULL;
+        *wallCount = *spawnCount = 0;
+        return Fail(error, errorSize, path, reason);
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef CS2_MAPFILE_H
+#define CS2_MAPFILE_H
+
+#include "game.h"
+#include "bvh.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Compiled maps: a header followed by the walls, spawn points and the wall
+// BVH exactly as they sit in memory, each section 16-byte aligned. Opening a
+// map maps the file read-only and points into it, so there is no parsing
+// and no allocation however many walls it has. Files are only portable
+// between builds with the same struct layout and byte order; the header
+// records both so a mismatch is rejected instead of misread.
+
+#define MAP_MAGIC 0x3250414Du   // "MAP2" in a little-endian file
+#define MAP_VERSION 1
+
+typedef struct {
+    Vector3 position;       // feet
+    float yaw;              // radians, same convention as Player
+} MapSpawn;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t wallSize;      // sizeof(Wall) of the writer
+    uint32_t nodeSize;      // sizeof(BvhNode) of the writer
+    uint32_t wallCount;
+    uint32_t spawnCount;
+    uint32_t nodeCount;
+    uint32_t reserved;
+    uint64_t wallsOffset;
+    uint64_t spawnsOffset;
+    uint64_t nodesOffset;
+    uint64_t boxesOffset;   // BVH boxes, in leaf order
+    uint64_t itemsOffset;   // wall index of each BVH box
+    uint64_t fileSize;
+} MapHeader;
+
+typedef struct {
+    const Wall *walls;
+    int wallCount;
+    const MapSpawn *spawns;
+    int spawnCount;
+    Bvh bvh;                // points into the mapping, not owned
+    void *data;
+    size_t size;
+} MapFile;
+
+// Checks the header and that every BVH index stays inside the file, so a
+// bad file fails here instead of crashing a raycast later.
+bool MapFileOpen(MapFile *map, const char *path, char *error, int errorSize);
+void MapFileClose(MapFile *map);
+
+// Builds the BVH over walls and writes a compiled map
+bool MapFileWrite(const char *path, const Wall *walls, int wallCount, const MapSpawn *spawns, int spawnCount);
+
+// Reads the text form, one entry per line ('#' starts a comment):
+//   wall  x y z  sx sy sz  RRGGBB      centre, size, color
+//   spawn x y z  yaw                   feet position, yaw in degrees
+// walls and spawns are allocated with malloc and owned by the caller.
+bool MapLoadText(const char *path, Wall **walls, int *wallCount, MapSpawn **spawns, int *spawnCount, char *error, int errorSize);
+
+#endif
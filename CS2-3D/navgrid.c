@@ -0,0 +1,749 @@
+#include "navgrid.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NAV_SQRT2 1.41421356f
+#define NAV_WIDE_ENTRANCE 8         // runs this long get an entrance at each end too
+#define NAV_CACHE_BUCKETS (2*NAV_PATH_CACHE_SIZE)
+
+// The four straight steps first, then the diagonals
+static const int stepX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int stepZ[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+typedef struct {
+    int from, to;
+    float cost;
+} BuildEdge;
+
+typedef struct {
+    int *cellNode;
+    BuildEdge *edges;
+    int edgeCount, edgeCapacity;
+    int nodeCapacity;
+    bool failed;            // out of memory; the graph is incomplete
+} BuildContext;
+
+// False when the heap is full and cannot grow; it is left as it was
+static bool HeapPush(NavHeap *heap, float priority, float cost, int id) {
+    if (heap->count == heap->capacity) {
+        int capacity = heap->capacity ? heap->capacity*2 : 256;
+        NavHeapItem *grown = realloc(heap->items, capacity*sizeof(NavHeapItem));
+        if (!grown) return false;
+        heap->items = grown;
+        heap->capacity = capacity;
+    }
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1)/2;
+        if (heap->items[parent].priority <= priority) break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = (NavHeapItem){ priority, cost, id };
+    return true;
+}
+
+static NavHeapItem HeapPop(NavHeap *heap) {
+    NavHeapItem top = heap->items[0];
+    NavHeapItem last = heap->items[--heap->count];
+    int i = 0;
+    for (;;) {
+        int child = 2*i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap->items[child + 1].priority < heap->items[child].priority) child++;
+        if (last.priority <= heap->items[child].priority) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    heap->items[i] = last;
+    return top;
+}
+
+// Lower bound of the cost between two cells on an 8-connected grid
+static float Octile(int dx, int dz) {
+    dx = abs(dx);
+    dz = abs(dz);
+    return (float)(dx + dz) + (NAV_SQRT2 - 2.0f)*(float)((dx < dz) ? dx : dz);
+}
+
+// Diagonal steps need both cells beside them open, so paths never cut a corner
+static bool CanStep(const NavGrid *nav, int x, int z, int direction) {
+    int nx = x + stepX[direction], nz = z + stepZ[direction];
+    if (nx < 0 || nz < 0 || nx >= nav->cellsX || nz >= nav->cellsZ) return false;
+    if (nav->blocked[nz*nav->cellsX + nx]) return false;
+    return direction < 4 || (!nav->blocked[z*nav->cellsX + nx] && !nav->blocked[nz*nav->cellsX + x]);
+}
+
+static int ClusterOf(const NavGrid *nav, int cell) {
+    int x = cell % nav->cellsX, z = cell/nav->cellsX;
+    return (z/NAV_CLUSTER_SIZE)*nav->clustersX + x/NAV_CLUSTER_SIZE;
+}
+
+static void ClusterRect(const NavGrid *nav, int cluster, int *x0, int *z0, int *x1, int *z1) {
+    *x0 = (cluster % nav->clustersX)*NAV_CLUSTER_SIZE;
+    *z0 = (cluster/nav->clustersX)*NAV_CLUSTER_SIZE;
+    *x1 = (*x0 + NAV_CLUSTER_SIZE < nav->cellsX) ? *x0 + NAV_CLUSTER_SIZE - 1 : nav->cellsX - 1;
+    *z1 = (*z0 + NAV_CLUSTER_SIZE < nav->cellsZ) ? *z0 + NAV_CLUSTER_SIZE - 1 : nav->cellsZ - 1;
+}
+
+// A* from start to goal over the cells in [x0, x1] x [z0, z1], or Dijkstra to
+// all of them when goal is -1. Leaves cost and parent set on the cells visited.
+// False if the goal was not reached, or for goal -1 if the heap ran out of
+// memory and not every cell was visited.
+static bool GridSearch(NavGrid *nav, int start, int goal, int x0, int z0, int x1, int z1) {
+    if (++nav->stamp == 0) {
+        memset(nav->visit, 0, (size_t)nav->cellsX*nav->cellsZ*sizeof(uint32_t));
+        nav->stamp = 1;
+    }
+    int goalX = (goal >= 0) ? goal % nav->cellsX : 0;
+    int goalZ = (goal >= 0) ? goal/nav->cellsX : 0;
+
+    nav->heap.count = 0;
+    nav->cost[start] = 0.0f;
+    nav->parent[start] = -1;
+    nav->visit[start] = nav->stamp;
+    if (!HeapPush(&nav->heap, 0.0f, 0.0f, start)) return false;
+
+    while (nav->heap.count > 0) {
+        NavHeapItem item = HeapPop(&nav->heap);
+        if (item.cost > nav->cost[item.id]) continue;
+        if (item.id == goal) return true;
+
+        int x = item.id % nav->cellsX, z = item.id/nav->cellsX;
+        for (int d = 0; d < 8; d++) {
+            int nx = x + stepX[d], nz = z + stepZ[d];
+            if (nx < x0 || nz < z0 || nx > x1 || nz > z1 || !CanStep(nav, x, z, d)) continue;
+            int next = nz*nav->cellsX + nx;
+            float cost = item.cost + ((d < 4) ? 1.0f : NAV_SQRT2);
+            if (nav->visit[next] == nav->stamp && cost >= nav->cost[next]) continue;
+            nav->visit[next] = nav->stamp;
+            nav->cost[next] = cost;
+            nav->parent[next] = item.id;
+            float estimate = (goal >= 0) ? Octile(nx - goalX, nz - goalZ) : 0.0f;
+            if (!HeapPush(&nav->heap, cost + estimate, cost, next)) return false;
+        }
+    }
+    return goal < 0;
+}
+
+// Appends the cells after start on the path the last search found to goal
+static void AppendSegment(NavGrid *nav, int start, int goal, int *routeCount) {
+    int cells = nav->cellsX*nav->cellsZ;
+    int count = 0;
+    for (int cell = goal; cell != start; cell = nav->parent[cell]) nav->segment[count++] = cell;
+    while (count > 0 && *routeCount < cells) nav->route[(*routeCount)++] = nav->segment[--count];
+}
+
+// Keeps the route's ends and every cell where it turns
+static int RouteToPoints(const NavGrid *nav, int routeCount, Vector3 *out, int maxOut) {
+    int count = 0;
+    for (int i = 0; i < routeCount && count < maxOut; i++) {
+        if (i > 0 && i < routeCount - 1 && nav->route[i] - nav->route[i - 1] == nav->route[i + 1] - nav->route[i]) continue;
+        out[count++] = NavCellCenter(nav, nav->route[i]);
+    }
+    return count;
+}
+
+// The cell of position, or the nearest open one around it when that is
+// blocked: the grown walls cover the cells an agent standing against them is in
+static int OpenCellNear(const NavGrid *nav, Vector3 position) {
+    int cell = NavCellAt(nav, position);
+    if (cell < 0 || !nav->blocked[cell]) return cell;
+
+    int x = cell % nav->cellsX, z = cell/nav->cellsX;
+    int best = -1;
+    float bestDistance = FLT_MAX;
+    for (int d = 0; d < 8; d++) {
+        int nx = x + stepX[d], nz = z + stepZ[d];
+        if (nx < 0 || nz < 0 || nx >= nav->cellsX || nz >= nav->cellsZ || nav->blocked[nz*nav->cellsX + nx]) continue;
+        Vector3 center = NavCellCenter(nav, nz*nav->cellsX + nx);
+        float dx = center.x - position.x, dz = center.z - position.z;
+        if (dx*dx + dz*dz < bestDistance) {
+            bestDistance = dx*dx + dz*dz;
+            best = nz*nav->cellsX + nx;
+        }
+    }
+    return best;
+}
+
+// The entrance node on cell, made on first use; -1 when out of memory
+static int NodeAt(NavGrid *nav, BuildContext *ctx, int cell) {
+    if (ctx->cellNode[cell] >= 0) return ctx->cellNode[cell];
+    if (nav->nodeCount == ctx->nodeCapacity) {
+        int capacity = ctx->nodeCapacity ? ctx->nodeCapacity*2 : 256;
+        NavNode *grown = realloc(nav->nodes, capacity*sizeof(NavNode));
+        if (!grown) {
+            ctx->failed = true;
+            return -1;
+        }
+        nav->nodes = grown;
+        ctx->nodeCapacity = capacity;
+    }
+    nav->nodes[nav->nodeCount] = (NavNode){ cell, ClusterOf(nav, cell) };
+    ctx->cellNode[cell] = nav->nodeCount;
+    return nav->nodeCount++;
+}
+
+static void AddEdge(BuildContext *ctx, int from, int to, float cost) {
+    if (ctx->edgeCount == ctx->edgeCapacity) {
+        int capacity = ctx->edgeCapacity ? ctx->edgeCapacity*2 : 1024;
+        BuildEdge *grown = realloc(ctx->edges, capacity*sizeof(BuildEdge));
+        if (!grown) {
+            ctx->failed = true;
+            return;
+        }
+        ctx->edges = grown;
+        ctx->edgeCapacity = capacity;
+    }
+    ctx->edges[ctx->edgeCount++] = (BuildEdge){ from, to, cost };
+}
+
+static void AddEntrance(NavGrid *nav, BuildContext *ctx, int near, int far) {
+    int a = NodeAt(nav, ctx, near), b = NodeAt(nav, ctx, far);
+    if (a < 0 || b < 0) return;
+    AddEdge(ctx, a, b, 1.0f);
+    AddEdge(ctx, b, a, 1.0f);
+}
+
+// Walks length cells from (x, z) by (alongX, alongZ) on a cluster border;
+// (acrossX, acrossZ) leads to the neighbour cluster. Every run of cells open
+// on both sides becomes an entrance in its middle, wide ones at the ends too.
+static void AddBorder(NavGrid *nav, BuildContext *ctx, int x, int z, int alongX, int alongZ, int acrossX, int acrossZ, int length) {
+    int across = acrossZ*nav->cellsX + acrossX;
+    int runStart = -1;
+    for (int i = 0; i <= length; i++) {
+        int near = (z + i*alongZ)*nav->cellsX + x + i*alongX;
+        bool open = i < length && !nav->blocked[near] && !nav->blocked[near + across];
+        if (open && runStart < 0) runStart = i;
+        if (open || runStart < 0) continue;
+
+        int first = (z + runStart*alongZ)*nav->cellsX + x + runStart*alongX;
+        int step = alongZ*nav->cellsX + alongX;
+        int runLength = i - runStart;
+        int middle = first + (runLength - 1)/2*step;
+        AddEntrance(nav, ctx, middle, middle + across);
+        if (runLength >= NAV_WIDE_ENTRANCE) {
+            AddEntrance(nav, ctx, first, first + across);
+            AddEntrance(nav, ctx, first + (runLength - 1)*step, first + (runLength - 1)*step + across);
+        }
+        runStart = -1;
+    }
+}
+
+static void Rasterize(NavGrid *nav, const Wall *walls, int count) {
+    for (int i = 0; i < count; i++) {
+        const Wall *w = &walls[i];
+        float bottom = w->position.y - w->size.y*0.5f, top = w->position.y + w->size.y*0.5f;
+        if (top <= NAV_STEP_HEIGHT || bottom >= NAV_AGENT_HEIGHT) continue;
+
+        // Cells whose centre an agent could not stand on; at least the one
+        // under the wall's centre, so thin walls on coarse grids still count
+        float minX = (w->position.x - w->size.x*0.5f - NAV_AGENT_RADIUS - nav->minX)/nav->cellSize;
+        float maxX = (w->position.x + w->size.x*0.5f + NAV_AGENT_RADIUS - nav->minX)/nav->cellSize;
+        float minZ = (w->position.z - w->size.z*0.5f - NAV_AGENT_RADIUS - nav->minZ)/nav->cellSize;
+        float maxZ = (w->position.z + w->size.z*0.5f + NAV_AGENT_RADIUS - nav->minZ)/nav->cellSize;
+        int x0 = (int)ceilf(minX - 0.5f), x1 = (int)floorf(maxX - 0.5f);
+        int z0 = (int)ceilf(minZ - 0.5f), z1 = (int)floorf(maxZ - 0.5f);
+        if (x0 > x1) x0 = x1 = (int)((w->position.x - nav->minX)/nav->cellSize);
+        if (z0 > z1) z0 = z1 = (int)((w->position.z - nav->minZ)/nav->cellSize);
+        if (x0 < 0) x0 = 0;
+        if (z0 < 0) z0 = 0;
+        if (x1 >= nav->cellsX) x1 = nav->cellsX - 1;
+        if (z1 >= nav->cellsZ) z1 = nav->cellsZ - 1;
+        for (int z = z0; z <= z1; z++) memset(&nav->blocked[z*nav->cellsX + x0], 1, (x1 >= x0) ? x1 - x0 + 1 : 0);
+    }
+}
+
+// Flood fills the open cells with the steps paths take; route is free here
+static void LabelRegions(NavGrid *nav) {
+    int cells = nav->cellsX*nav->cellsZ;
+    memset(nav->region, 0xFF, cells*sizeof(int));
+    int regions = 0;
+    for (int seed = 0; seed < cells; seed++) {
+        if (nav->blocked[seed] || nav->region[seed] >= 0) continue;
+        int count = 0;
+        nav->route[count++] = seed;
+        nav->region[seed] = regions;
+        while (count > 0) {
+            int cell = nav->route[--count];
+            int x = cell % nav->cellsX, z = cell/nav->cellsX;
+            for (int d = 0; d < 8; d++) {
+                if (!CanStep(nav, x, z, d)) continue;
+                int next = (z + stepZ[d])*nav->cellsX + x + stepX[d];
+                if (nav->region[next] >= 0) continue;
+                nav->region[next] = regions;
+                nav->route[count++] = next;
+            }
+        }
+        regions++;
+    }
+}
+
+// Entrances grouped by cluster
+static bool GroupEntrances(NavGrid *nav, int clusters) {
+    nav->clusterStart = calloc(clusters + 1, sizeof(int));
+    nav->clusterNodes = malloc((nav->nodeCount + 1)*sizeof(int));
+    int *cursor = malloc((clusters + 1)*sizeof(int));
+    if (!nav->clusterStart || !nav->clusterNodes || !cursor) {
+        free(cursor);
+        return false;
+    }
+    for (int i = 0; i < nav->nodeCount; i++) nav->clusterStart[nav->nodes[i].cluster + 1]++;
+    for (int c = 0; c < clusters; c++) {
+        int size = nav->clusterStart[c + 1];
+        if (size > nav->maxClusterNodes) nav->maxClusterNodes = size;
+        nav->clusterStart[c + 1] += nav->clusterStart[c];
+    }
+    memcpy(cursor, nav->clusterStart, (clusters + 1)*sizeof(int));
+    for (int i = 0; i < nav->nodeCount; i++) nav->clusterNodes[cursor[nav->nodes[i].cluster]++] = i;
+    free(cursor);
+    return true;
+}
+
+// The cost between every two entrances of a cluster, through it
+static bool LinkEntrances(NavGrid *nav, BuildContext *ctx, int clusters) {
+    for (int cluster = 0; cluster < clusters && !ctx->failed; cluster++) {
+        int x0, z0, x1, z1;
+        ClusterRect(nav, cluster, &x0, &z0, &x1, &z1);
+        for (int i = nav->clusterStart[cluster]; i < nav->clusterStart[cluster + 1]; i++) {
+            int from = nav->clusterNodes[i];
+            if (!GridSearch(nav, nav->nodes[from].cell, -1, x0, z0, x1, z1)) return false;
+            for (int j = nav->clusterStart[cluster]; j < nav->clusterStart[cluster + 1]; j++) {
+                int to = nav->clusterNodes[j];
+                int cell = nav->nodes[to].cell;
+                if (to != from && nav->visit[cell] == nav->stamp) AddEdge(ctx, from, to, nav->cost[cell]);
+            }
+        }
+    }
+    return !ctx->failed;
+}
+
+// The edges sorted by the node they leave
+static bool PackEdges(NavGrid *nav, const BuildContext *ctx) {
+    nav->edgeCount = ctx->edgeCount;
+    nav->edgeStart = calloc(nav->nodeCount + 1, sizeof(int));
+    nav->edges = malloc((ctx->edgeCount + 1)*sizeof(NavEdge));
+    int *cursor = malloc((nav->nodeCount + 1)*sizeof(int));
+    if (!nav->edgeStart || !nav->edges || !cursor) {
+        free(cursor);
+        return false;
+    }
+    for (int i = 0; i < ctx->edgeCount; i++) nav->edgeStart[ctx->edges[i].from + 1]++;
+    for (int i = 0; i < nav->nodeCount; i++) nav->edgeStart[i + 1] += nav->edgeStart[i];
+    memcpy(cursor, nav->edgeStart, (nav->nodeCount + 1)*sizeof(int));
+    for (int i = 0; i < ctx->edgeCount; i++) {
+        nav->edges[cursor[ctx->edges[i].from]++] = (NavEdge){ ctx->edges[i].to, ctx->edges[i].cost };
+    }
+    free(cursor);
+    return true;
+}
+
+// False when out of memory, leaving what it allocated for NavGridFree
+static bool BuildGraph(NavGrid *nav) {
+    int cells = nav->cellsX*nav->cellsZ;
+    int clusters = nav->clustersX*nav->clustersZ;
+    BuildContext ctx = { malloc(cells*sizeof(int)), NULL, 0, 0, 0, false };
+    if (!ctx.cellNode) return false;
+    memset(ctx.cellNode, 0xFF, cells*sizeof(int));
+
+    for (int cluster = 0; cluster < clusters && !ctx.failed; cluster++) {
+        int x0, z0, x1, z1;
+        ClusterRect(nav, cluster, &x0, &z0, &x1, &z1);
+        if (x1 + 1 < nav->cellsX) AddBorder(nav, &ctx, x1, z0, 0, 1, 1, 0, z1 - z0 + 1);
+        if (z1 + 1 < nav->cellsZ) AddBorder(nav, &ctx, x0, z1, 1, 0, 0, 1, x1 - x0 + 1);
+    }
+    bool built = !ctx.failed && GroupEntrances(nav, clusters) && LinkEntrances(nav, &ctx, clusters) && PackEdges(nav, &ctx);
+    free(ctx.edges);
+    free(ctx.cellNode);
+    return built;
+}
+
+bool NavGridBuild(NavGrid *nav, const Wall *walls, int count) {
+    NavGridFree(nav);
+
+    float minX = -NAV_MARGIN, minZ = -NAV_MARGIN, maxX = NAV_MARGIN, maxZ = NAV_MARGIN;
+    if (count > 0) {
+        minX = minZ = FLT_MAX;
+        maxX = maxZ = -FLT_MAX;
+        for (int i = 0; i < count; i++) {
+            minX = fminf(minX, walls[i].position.x - walls[i].size.x*0.5f - NAV_MARGIN);
+            minZ = fminf(minZ, walls[i].position.z - walls[i].size.z*0.5f - NAV_MARGIN);
+            maxX = fmaxf(maxX, walls[i].position.x + walls[i].size.x*0.5f + NAV_MARGIN);
+            maxZ = fmaxf(maxZ, walls[i].position.z + walls[i].size.z*0.5f + NAV_MARGIN);
+        }
+    }
+
+    nav->minX = minX;
+    nav->minZ = minZ;
+    nav->cellSize = fmaxf(NAV_CELL_SIZE, fmaxf(maxX - minX, maxZ - minZ)/NAV_MAX_CELLS_PER_AXIS);
+    nav->cellsX = (int)ceilf((maxX - minX)/nav->cellSize);
+    nav->cellsZ = (int)ceilf((maxZ - minZ)/nav->cellSize);
+    if (nav->cellsX > NAV_MAX_CELLS_PER_AXIS) nav->cellsX = NAV_MAX_CELLS_PER_AXIS;
+    if (nav->cellsZ > NAV_MAX_CELLS_PER_AXIS) nav->cellsZ = NAV_MAX_CELLS_PER_AXIS;
+    nav->clustersX = (nav->cellsX + NAV_CLUSTER_SIZE - 1)/NAV_CLUSTER_SIZE;
+    nav->clustersZ = (nav->cellsZ + NAV_CLUSTER_SIZE - 1)/NAV_CLUSTER_SIZE;
+
+    int cells = nav->cellsX*nav->cellsZ;
+    nav->blocked = calloc(cells, 1);
+    nav->cost = malloc(cells*sizeof(float));
+    nav->parent = malloc(cells*sizeof(int));
+    nav->visit = calloc(cells, sizeof(uint32_t));
+    nav->route = malloc(cells*sizeof(int));
+    nav->segment = malloc(cells*sizeof(int));
+    nav->region = malloc(cells*sizeof(int));
+    if (!nav->blocked || !nav->cost || !nav->parent || !nav->visit || !nav->route || !nav->segment || !nav->region) {
+        NavGridFree(nav);
+        return false;
+    }
+    Rasterize(nav, walls, count);
+    LabelRegions(nav);
+    if (!BuildGraph(nav)) {
+        NavGridFree(nav);
+        return false;
+    }
+
+    nav->nodeCost = malloc((nav->nodeCount + 1)*sizeof(float));
+    nav->nodeParent = malloc((nav->nodeCount + 1)*sizeof(int));
+    nav->nodeVisit = calloc(nav->nodeCount + 1, sizeof(uint32_t));
+    nav->chain = malloc((nav->nodeCount + 1)*sizeof(int));
+    nav->startLinks = malloc((nav->maxClusterNodes + 1)*sizeof(NavEdge));
+    nav->goalLinks = malloc((nav->maxClusterNodes + 1)*sizeof(NavEdge));
+
+    for (int i = 0; i < NAV_FLOW_FIELDS; i++) nav->flows[i].goal = -1;
+    nav->cache = malloc(NAV_PATH_CACHE_SIZE*sizeof(NavCacheEntry));
+    nav->buckets = malloc(NAV_CACHE_BUCKETS*sizeof(int));
+    if (!nav->nodeCost || !nav->nodeParent || !nav->nodeVisit || !nav->chain || !nav->startLinks || !nav->goalLinks ||
+        !nav->cache || !nav->buckets) {
+        NavGridFree(nav);
+        return false;
+    }
+    NavClearCache(nav);
+    return true;
+}
+
+void NavClearCache(NavGrid *nav) {
+    memset(nav->buckets, 0xFF, NAV_CACHE_BUCKETS*sizeof(int));
+    nav->cacheCount = 0;
+    nav->newest = nav->oldest = -1;
+}
+
+void NavGridFree(NavGrid *nav) {
+    free(nav->blocked);
+    free(nav->region);
+    free(nav->nodes);
+    free(nav->edgeStart);
+    free(nav->edges);
+    free(nav->clusterStart);
+    free(nav->clusterNodes);
+    free(nav->cost);
+    free(nav->parent);
+    free(nav->visit);
+    free(nav->route);
+    free(nav->segment);
+    free(nav->chain);
+    free(nav->heap.items);
+    free(nav->nodeCost);
+    free(nav->nodeParent);
+    free(nav->nodeVisit);
+    free(nav->startLinks);
+    free(nav->goalLinks);
+    for (int i = 0; i < NAV_FLOW_FIELDS; i++) free(nav->flows[i].next);
+    free(nav->cache);
+    free(nav->buckets);
+    memset(nav, 0, sizeof(*nav));
+}
+
+int NavCellAt(const NavGrid *nav, Vector3 position) {
+    if (!nav->blocked) return -1;
+    float x = (position.x - nav->minX)/nav->cellSize, z = (position.z - nav->minZ)/nav->cellSize;
+    if (x < 0.0f || z < 0.0f || x >= (float)nav->cellsX || z >= (float)nav->cellsZ) return -1;
+    return (int)z*nav->cellsX + (int)x;
+}
+
+Vector3 NavCellCenter(const NavGrid *nav, int cell) {
+    return (Vector3){ nav->minX + ((float)(cell % nav->cellsX) + 0.5f)*nav->cellSize, 0.0f,
+                      nav->minZ + ((float)(cell/nav->cellsX) + 0.5f)*nav->cellSize };
+}
+
+bool NavWalkable(const NavGrid *nav, int cell) {
+    return cell >= 0 && cell < nav->cellsX*nav->cellsZ && !nav->blocked[cell];
+}
+
+// Runs the search from cell through its cluster and notes the cost to each
+// of the cluster's entrances it reached
+static int LinkCluster(NavGrid *nav, int cell, NavEdge *links) {
+    int cluster = ClusterOf(nav, cell);
+    int x0, z0, x1, z1;
+    ClusterRect(nav, cluster, &x0, &z0, &x1, &z1);
+    if (!GridSearch(nav, cell, -1, x0, z0, x1, z1)) return 0;
+
+    int count = 0;
+    for (int i = nav->clusterStart[cluster]; i < nav->clusterStart[cluster + 1]; i++) {
+        int node = nav->clusterNodes[i];
+        int nodeCell = nav->nodes[node].cell;
+        if (nav->visit[nodeCell] == nav->stamp) links[count++] = (NavEdge){ node, nav->cost[nodeCell] };
+    }
+    return count;
+}
+
+// False only when the heap is out of memory
+static bool Relax(NavGrid *nav, int node, float cost, int parent, float estimate) {
+    if (nav->nodeVisit[node] == nav->nodeStamp && cost >= nav->nodeCost[node]) return true;
+    nav->nodeVisit[node] = nav->nodeStamp;
+    nav->nodeCost[node] = cost;
+    nav->nodeParent[node] = parent;
+    return HeapPush(&nav->heap, cost + estimate, cost, node);
+}
+
+// A* over the entrances, starting from the start's links. The goal is the
+// extra node nodeCount, reached through the goal's links.
+static bool AbstractSearch(NavGrid *nav, int goal, int startLinkCount, int goalLinkCount) {
+    if (++nav->nodeStamp == 0) {
+        memset(nav->nodeVisit, 0, (nav->nodeCount + 1)*sizeof(uint32_t));
+        nav->nodeStamp = 1;
+    }
+    int goalX = goal % nav->cellsX, goalZ = goal/nav->cellsX, goalCluster = ClusterOf(nav, goal);
+    int target = nav->nodeCount;
+
+    nav->heap.count = 0;
+    for (int i = 0; i < startLinkCount; i++) {
+        int cell = nav->nodes[nav->startLinks[i].to].cell;
+        if (!Relax(nav, nav->startLinks[i].to, nav->startLinks[i].cost, -1, Octile(cell % nav->cellsX - goalX, cell/nav->cellsX - goalZ))) return false;
+    }
+
+    while (nav->heap.count > 0) {
+        NavHeapItem item = HeapPop(&nav->heap);
+        if (item.cost > nav->nodeCost[item.id]) continue;
+        if (item.id == target) return true;
+
+        for (int e = nav->edgeStart[item.id]; e < nav->edgeStart[item.id + 1]; e++) {
+            int cell = nav->nodes[nav->edges[e].to].cell;
+            float estimate = Octile(cell % nav->cellsX - goalX, cell/nav->cellsX - goalZ);
+            if (!Relax(nav, nav->edges[e].to, item.cost + nav->edges[e].cost, item.id, estimate)) return false;
+        }
+        if (nav->nodes[item.id].cluster != goalCluster) continue;
+        for (int i = 0; i < goalLinkCount; i++) {
+            if (nav->goalLinks[i].to == item.id && !Relax(nav, target, item.cost + nav->goalLinks[i].cost, item.id, 0.0f)) return false;
+        }
+    }
+    return false;
+}
+
+// Walks one step of the abstract path: across a border, or through the
+// cluster both cells are in
+static bool Refine(NavGrid *nav, int from, int to, int *routeCount) {
+    if (from == to) return true;
+    int x = from % nav->cellsX, z = from/nav->cellsX;
+    int dx = to % nav->cellsX - x, dz = to/nav->cellsX - z;
+    for (int d = 0; d < 8; d++) {
+        if (stepX[d] == dx && stepZ[d] == dz && CanStep(nav, x, z, d)) {
+            if (*routeCount < nav->cellsX*nav->cellsZ) nav->route[(*routeCount)++] = to;
+            return true;
+        }
+    }
+
+    int x0, z0, x1, z1;
+    ClusterRect(nav, ClusterOf(nav, from), &x0, &z0, &x1, &z1);
+    if (!GridSearch(nav, from, to, x0, z0, x1, z1)) return false;
+    AppendSegment(nav, from, to, routeCount);
+    return true;
+}
+
+int NavFindPath(NavGrid *nav, Vector3 from, Vector3 to, Vector3 *out, int maxOut) {
+    int start = OpenCellNear(nav, from), goal = OpenCellNear(nav, to);
+    if (start < 0 || goal < 0 || nav->region[start] != nav->region[goal]) return 0;
+
+    int routeCount = 0;
+    nav->route[routeCount++] = start;
+    if (start == goal) return RouteToPoints(nav, routeCount, out, maxOut);
+
+    // Close enough to stay inside one cluster, unless that way is walled off
+    int startCluster = ClusterOf(nav, start);
+    if (startCluster == ClusterOf(nav, goal)) {
+        int x0, z0, x1, z1;
+        ClusterRect(nav, startCluster, &x0, &z0, &x1, &z1);
+        if (GridSearch(nav, start, goal, x0, z0, x1, z1)) {
+            AppendSegment(nav, start, goal, &routeCount);
+            return RouteToPoints(nav, routeCount, out, maxOut);
+        }
+    }
+
+    int startLinks = LinkCluster(nav, start, nav->startLinks);
+    int goalLinks = LinkCluster(nav, goal, nav->goalLinks);
+    if (!AbstractSearch(nav, goal, startLinks, goalLinks)) return 0;
+
+    int chainCount = 0;
+    for (int node = nav->nodeParent[nav->nodeCount]; node >= 0; node = nav->nodeParent[node]) nav->chain[chainCount++] = node;
+
+    int cell = start;
+    while (chainCount > 0) {
+        int next = nav->nodes[nav->chain[--chainCount]].cell;
+        if (!Refine(nav, cell, next, &routeCount)) return 0;
+        cell = next;
+    }
+    if (!Refine(nav, cell, goal, &routeCount)) return 0;
+    return RouteToPoints(nav, routeCount, out, maxOut);
+}
+
+int NavFindPathFlat(NavGrid *nav, Vector3 from, Vector3 to, Vector3 *out, int maxOut) {
+    int start = OpenCellNear(nav, from), goal = OpenCellNear(nav, to);
+    if (start < 0 || goal < 0 || nav->region[start] != nav->region[goal]) return 0;
+
+    int routeCount = 0;
+    nav->route[routeCount++] = start;
+    if (start != goal) {
+        if (!GridSearch(nav, start, goal, 0, 0, nav->cellsX - 1, nav->cellsZ - 1)) return 0;
+        AppendSegment(nav, start, goal, &routeCount);
+    }
+    return RouteToPoints(nav, routeCount, out, maxOut);
+}
+
+static uint32_t HashKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    return (uint32_t)key;
+}
+
+static void CacheUnlink(NavGrid *nav, int e) {
+    NavCacheEntry *entry = &nav->cache[e];
+    if (entry->newer >= 0) nav->cache[entry->newer].older = entry->older;
+    else nav->newest = entry->older;
+    if (entry->older >= 0) nav->cache[entry->older].newer = entry->newer;
+    else nav->oldest = entry->newer;
+}
+
+static void CachePushNewest(NavGrid *nav, int e) {
+    nav->cache[e].newer = -1;
+    nav->cache[e].older = nav->newest;
+    if (nav->newest >= 0) nav->cache[nav->newest].newer = e;
+    nav->newest = e;
+    if (nav->oldest < 0) nav->oldest = e;
+}
+
+int NavCachedPath(NavGrid *nav, Vector3 from, Vector3 to, Vector3 *out, int maxOut) {
+    int start = OpenCellNear(nav, from), goal = OpenCellNear(nav, to);
+    if (start < 0 || goal < 0) return 0;
+
+    uint64_t key = (uint64_t)(uint32_t)start | (uint64_t)(uint32_t)goal << 32;
+    int *bucket = &nav->buckets[HashKey(key) & (NAV_CACHE_BUCKETS - 1)];
+    int e = *bucket;
+    while (e >= 0 && nav->cache[e].key != key) e = nav->cache[e].chain;
+
+    if (e >= 0) {
+        nav->cacheHits++;
+        CacheUnlink(nav, e);
+    } else {
+        nav->cacheMisses++;
+        if (nav->cacheCount < NAV_PATH_CACHE_SIZE) {
+            e = nav->cacheCount++;
+        } else {
+            e = nav->oldest;
+            CacheUnlink(nav, e);
+            int *link = &nav->buckets[HashKey(nav->cache[e].key) & (NAV_CACHE_BUCKETS - 1)];
+            while (*link != e) link = &nav->cache[*link].chain;
+            *link = nav->cache[e].chain;
+        }
+        nav->cache[e].key = key;
+        nav->cache[e].count = NavFindPath(nav, NavCellCenter(nav, start), NavCellCenter(nav, goal), nav->cache[e].points, NAV_CACHED_POINTS);
+        nav->cache[e].chain = *bucket;
+        *bucket = e;
+    }
+    CachePushNewest(nav, e);
+
+    int count = (nav->cache[e].count < maxOut) ? nav->cache[e].count : maxOut;
+    memcpy(out, nav->cache[e].points, count*sizeof(Vector3));
+    return count;
+}
+
+// The directions of every cell around goal towards it
+// False when out of memory, with the field left empty
+static bool FillFlowField(NavGrid *nav, NavFlowField *field, int goal) {
+    int goalX = goal % nav->cellsX, goalZ = goal/nav->cellsX;
+    field->goal = goal;
+    field->x0 = (goalX > NAV_FLOW_RADIUS) ? goalX - NAV_FLOW_RADIUS : 0;
+    field->z0 = (goalZ > NAV_FLOW_RADIUS) ? goalZ - NAV_FLOW_RADIUS : 0;
+    field->x1 = (goalX + NAV_FLOW_RADIUS < nav->cellsX) ? goalX + NAV_FLOW_RADIUS : nav->cellsX - 1;
+    field->z1 = (goalZ + NAV_FLOW_RADIUS < nav->cellsZ) ? goalZ + NAV_FLOW_RADIUS : nav->cellsZ - 1;
+    if (!field->next) field->next = malloc((2*NAV_FLOW_RADIUS + 1)*(2*NAV_FLOW_RADIUS + 1));
+
+    // Steps are symmetric, so the tree Dijkstra grows out of the goal has
+    // every cell's parent one step closer to it
+    if (!field->next || !GridSearch(nav, goal, -1, field->x0, field->z0, field->x1, field->z1)) {
+        field->goal = -1;
+        return false;
+    }
+    int width = field->x1 - field->x0 + 1;
+    for (int z = field->z0; z <= field->z1; z++) {
+        for (int x = field->x0; x <= field->x1; x++) {
+            int cell = z*nav->cellsX + x;
+            uint8_t direction = NAV_NO_DIRECTION;
+            if (nav->visit[cell] == nav->stamp && cell != goal) {
+                int parent = nav->parent[cell];
+                int dx = parent % nav->cellsX - x, dz = parent/nav->cellsX - z;
+                for (int d = 0; d < 8; d++) {
+                    if (stepX[d] == dx && stepZ[d] == dz) direction = (uint8_t)d;
+                }
+            }
+            field->next[(z - field->z0)*width + x - field->x0] = direction;
+        }
+    }
+    return true;
+}
+
+const NavFlowField *NavFlowTo(NavGrid *nav, int goal, int slack) {
+    if (!NavWalkable(nav, goal)) return NULL;
+
+    // Reuse a field for a goal this close, or recompute the least recently used
+    int goalX = goal % nav->cellsX, goalZ = goal/nav->cellsX;
+    nav->flowClock++;
+    NavFlowField *field = &nav->flows[0];
+    for (int i = 0; i < NAV_FLOW_FIELDS; i++) {
+        int cached = nav->flows[i].goal;
+        if (cached >= 0 && abs(cached % nav->cellsX - goalX) <= slack && abs(cached/nav->cellsX - goalZ) <= slack) {
+            nav->flows[i].lastUsed = nav->flowClock;
+            return &nav->flows[i];
+        }
+        if (nav->flows[i].lastUsed < field->lastUsed) field = &nav->flows[i];
+    }
+
+    field->lastUsed = nav->flowClock;
+    return FillFlowField(nav, field, goal) ? field : NULL;
+}
+
+void NavFlowSave(const NavGrid *nav, NavFlowState *state) {
+    state->clock = nav->flowClock;
+    for (int i = 0; i < NAV_FLOW_FIELDS; i++) {
+        state->goal[i] = nav->flows[i].goal;
+        state->lastUsed[i] = nav->flows[i].lastUsed;
+    }
+}
+
+void NavFlowRestore(NavGrid *nav, const NavFlowState *state) {
+    nav->flowClock = state->clock;
+    for (int i = 0; i < NAV_FLOW_FIELDS; i++) {
+        nav->flows[i].goal = -1;
+        nav->flows[i].lastUsed = state->lastUsed[i];
+        if (NavWalkable(nav, state->goal[i])) FillFlowField(nav, &nav->flows[i], state->goal[i]);
+    }
+}
+
+Vector3 NavFlowDirection(const NavGrid *nav, const NavFlowField *field, Vector3 position) {
+    Vector3 none = { 0.0f, 0.0f, 0.0f };
+    int cell = OpenCellNear(nav, position);
+    if (!field || cell < 0) return none;
+
+    int x = cell % nav->cellsX, z = cell/nav->cellsX;
+    if (x < field->x0 || z < field->z0 || x > field->x1 || z > field->z1) return none;
+    uint8_t direction = field->next[(z - field->z0)*(field->x1 - field->x0 + 1) + x - field->x0];
+    if (direction == NAV_NO_DIRECTION) return none;
+
+    // Steer for the next cell's centre so agents stay off the walls
+    Vector3 target = NavCellCenter(nav, cell + stepZ[direction]*nav->cellsX + stepX[direction]);
+    float dx = target.x - position.x, dz = target.z - position.z;
+    float length = sqrtf(dx*dx + dz*dz);
+    if (length < 1e-4f) return none;
+    return (Vector3){ dx/length, 0.0f, dz/length };
+}
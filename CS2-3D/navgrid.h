@@ -0,0 +1,160 @@
+#ifndef CS2_NAVGRID_H
+#define CS2_NAVGRID_H
+
+#include "game.h"
+#include <stdint.h>
+
+// Walkable grid on the XZ plane baked from the map walls, for bots. A cell is
+// blocked when a wall between step and head height covers its centre, grown
+// by the agent's radius; floors and overhangs do not block.
+//
+// Paths are found with hierarchical A*: the grid is cut into clusters, and
+// the walkable runs along each cluster border become entrance nodes, linked
+// across the border and to the other entrances of their cluster by the cost
+// of the path inside it. A query links start and goal into that small graph,
+// searches it and then walks each step through its cluster. Open cells are
+// labelled by connected region, so a goal that cannot be reached costs
+// nothing to turn down. NavCachedPath keeps recent results in an LRU cache
+// keyed by start and goal cell.
+//
+// Flow fields serve many agents heading for the same cell: one Dijkstra
+// around the goal gives every cell the direction to take. The last few are
+// kept, so agents chasing the same player share one.
+//
+// Queries share scratch space inside the grid, so only one thread may use a
+// grid at a time, except NavFlowDirection and the read-only helpers.
+
+#define NAV_CELL_SIZE 1.0f
+#define NAV_MAX_CELLS_PER_AXIS 2048
+#define NAV_CLUSTER_SIZE 16
+#define NAV_AGENT_RADIUS 0.45f
+#define NAV_AGENT_HEIGHT 2.8f
+#define NAV_STEP_HEIGHT 0.3f        // walls with a lower top are walked over
+#define NAV_MARGIN 2.0f             // walkable border around the walls
+#define NAV_FLOW_FIELDS 8
+#define NAV_FLOW_RADIUS 32          // cells around the goal a field covers
+#define NAV_PATH_CACHE_SIZE 1024
+#define NAV_CACHED_POINTS 32
+#define NAV_NO_DIRECTION 255
+
+typedef struct {
+    int cell;
+    int cluster;
+} NavNode;
+
+typedef struct {
+    int to;
+    float cost;
+} NavEdge;
+
+typedef struct {
+    float priority;
+    float cost;
+    int id;
+} NavHeapItem;
+
+typedef struct {
+    NavHeapItem *items;
+    int count;
+    int capacity;
+} NavHeap;
+
+typedef struct {
+    int goal;               // cell, or -1 for an unused slot
+    int x0, z0, x1, z1;     // cells covered, inclusive
+    uint64_t lastUsed;
+    uint8_t *next;          // per covered cell, 0-7 or NAV_NO_DIRECTION
+} NavFlowField;
+
+// Which fields are kept and how recently each was used, so a restored world
+// reuses or replaces the same ones
+typedef struct {
+    int goal[NAV_FLOW_FIELDS];
+    uint64_t lastUsed[NAV_FLOW_FIELDS];
+    uint64_t clock;
+} NavFlowState;
+
+typedef struct {
+    uint64_t key;           // start cell | goal cell << 32
+    int count;              // points, 0 when there is no path
+    int newer, older;       // LRU list
+    int chain;              // next entry in the same bucket
+    Vector3 points[NAV_CACHED_POINTS];
+} NavCacheEntry;
+
+typedef struct {
+    float minX, minZ;
+    float cellSize;
+    int cellsX, cellsZ;
+    uint8_t *blocked;
+    int *region;            // cells with the same region reach each other
+
+    int clustersX, clustersZ;
+    NavNode *nodes;
+    int nodeCount;
+    int *edgeStart;         // nodeCount + 1 offsets into edges
+    NavEdge *edges;
+    int edgeCount;
+    int *clusterStart;      // cluster count + 1 offsets into clusterNodes
+    int *clusterNodes;
+
+    // Search scratch; visit[i] == stamp marks cost and parent as current
+    float *cost;
+    int *parent;
+    uint32_t *visit;
+    uint32_t stamp;
+    int *route;             // cells of the path being built
+    int *segment;
+    int *chain;             // entrances on the abstract path
+    NavHeap heap;
+    float *nodeCost;
+    int *nodeParent;
+    uint32_t *nodeVisit;
+    uint32_t nodeStamp;
+    NavEdge *startLinks;
+    NavEdge *goalLinks;
+    int maxClusterNodes;
+
+    NavFlowField flows[NAV_FLOW_FIELDS];
+    uint64_t flowClock;
+
+    NavCacheEntry *cache;
+    int *buckets;
+    int cacheCount;
+    int newest, oldest;
+    long long cacheHits;
+    long long cacheMisses;
+} NavGrid;
+
+// False when out of memory, with the grid left empty (no cell is walkable)
+bool NavGridBuild(NavGrid *nav, const Wall *walls, int count);
+void NavGridFree(NavGrid *nav);
+
+// Cell index of a point, or -1 outside the grid
+int NavCellAt(const NavGrid *nav, Vector3 position);
+Vector3 NavCellCenter(const NavGrid *nav, int cell);
+bool NavWalkable(const NavGrid *nav, int cell);
+
+// Waypoints from the cell of from to the cell of to, at cell centres with
+// y = 0 and only where the direction changes; the first is the start cell.
+// Returns how many were written (cut at maxOut), 0 when there is no path.
+int NavFindPath(NavGrid *nav, Vector3 from, Vector3 to, Vector3 *out, int maxOut);
+// Plain A* over the whole grid, as a reference for NavFindPath
+int NavFindPathFlat(NavGrid *nav, Vector3 from, Vector3 to, Vector3 *out, int maxOut);
+// NavFindPath through the LRU cache; paths are kept up to NAV_CACHED_POINTS
+int NavCachedPath(NavGrid *nav, Vector3 from, Vector3 to, Vector3 *out, int maxOut);
+void NavClearCache(NavGrid *nav);
+
+// A field towards goal: one of the last NAV_FLOW_FIELDS if its goal is within
+// slack cells of this one, else computed. NULL if the goal cell is blocked or
+// outside the grid, or there is no memory for the field.
+const NavFlowField *NavFlowTo(NavGrid *nav, int goal, int slack);
+// Unit XZ direction to walk from position, or zero at the goal, outside the
+// field or where the goal cannot be reached
+Vector3 NavFlowDirection(const NavGrid *nav, const NavFlowField *field, Vector3 position);
+
+// For demo keyframes: the kept fields are recomputed from their goals
+void NavFlowSave(const NavGrid *nav, NavFlowState *state);
+void NavFlowRestore(NavGrid *nav, const NavFlowState *state);
+
+#endif
@@ -0,0 +1,163 @@
+#include "net.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef int socklen_t;
+#define SOCKET_OF(sock) ((SOCKET)(sock)->handle)
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define SOCKET_OF(sock) ((int)(sock)->handle)
+#endif
+
+bool NetStartup(void) {
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    return true;
+#endif
+}
+
+void NetShutdown(void) {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool NetOpen(NetSocket *sock, uint16_t port) {
+#ifdef _WIN32
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) return false;
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) return false;
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    // A server with many clients gets bursts of input between ticks
+    int bufferSize = 1 << 20;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char *)&bufferSize, sizeof(bufferSize));
+    setsockopt(s, SOL_SOCKET, SO_SNDBUF, (const char *)&bufferSize, sizeof(bufferSize));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        sock->handle = (intptr_t)s;
+        NetClose(sock);
+        return false;
+    }
+    sock->handle = (intptr_t)s;
+    return true;
+}
+
+void NetClose(NetSocket *sock) {
+#ifdef _WIN32
+    closesocket(SOCKET_OF(sock));
+#else
+    close(SOCKET_OF(sock));
+#endif
+    sock->handle = -1;
+}
+
+NetAddress NetLoopback(uint16_t port) {
+    return (NetAddress){ htonl(INADDR_LOOPBACK), htons(port) };
+}
+
+bool NetAddressEqual(NetAddress a, NetAddress b) {
+    return a.host == b.host && a.port == b.port;
+}
+
+bool NetSend(NetSocket *sock, NetAddress to, const void *data, int size) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = to.host;
+    addr.sin_port = to.port;
+    return sendto(SOCKET_OF(sock), (const char *)data, size, 0, (struct sockaddr *)&addr, sizeof(addr)) == size;
+}
+
+int NetReceive(NetSocket *sock, NetAddress *from, void *data, int capacity) {
+    struct sockaddr_in addr;
+    socklen_t length = sizeof(addr);
+    int size = (int)recvfrom(SOCKET_OF(sock), (char *)data, capacity, 0, (struct sockaddr *)&addr, &length);
+    if (size <= 0) return 0;
+    from->host = addr.sin_addr.s_addr;
+    from->port = addr.sin_port;
+    return size;
+}
+
+// Mouse movement goes over the wire in quarter pixels
+#define LOOK_SCALE 4.0f
+
+static uint32_t PackLook(float pixels) {
+    float q = pixels*LOOK_SCALE;
+    if (q < -32768.0f) q = -32768.0f;
+    if (q > 32767.0f) q = 32767.0f;
+    return (uint16_t)(int16_t)lrintf(q);
+}
+
+static float UnpackLook(uint32_t bits) {
+    return (float)(int16_t)(uint16_t)bits/LOOK_SCALE;
+}
+
+void NetWriteInput(BitWriter *w, const PlayerInput *in) {
+    BitWrite(w, (uint32_t)(in->forward + 1.0f + 0.5f), 2);
+    BitWrite(w, (uint32_t)(in->right + 1.0f + 0.5f), 2);
+    BitWrite(w, PackLook(in->look.x), 16);
+    BitWrite(w, PackLook(in->look.y), 16);
+    BitWriteBool(w, in->fireHeld);
+    BitWriteBool(w, in->firePressed);
+    BitWriteBool(w, in->jump);
+    BitWriteBool(w, in->reload);
+    BitWriteBool(w, in->inspect);
+    BitWriteBool(w, in->reset);
+    BitWrite(w, (uint32_t)(in->selectWeapon + 1), 6);
+    BitWrite(w, in->viewTick, 32);
+    BitWrite(w, (uint32_t)(in->viewFraction*255.0f + 0.5f), 8);
+}
+
+void NetReadInput(BitReader *r, PlayerInput *in) {
+    in->forward = (float)BitRead(r, 2) - 1.0f;
+    in->right = (float)BitRead(r, 2) - 1.0f;
+    in->look.x = UnpackLook(BitRead(r, 16));
+    in->look.y = UnpackLook(BitRead(r, 16));
+    in->fireHeld = BitReadBool(r);
+    in->firePressed = BitReadBool(r);
+    in->jump = BitReadBool(r);
+    in->reload = BitReadBool(r);
+    in->inspect = BitReadBool(r);
+    in->reset = BitReadBool(r);
+    in->selectWeapon = (int)BitRead(r, 6) - 1;
+    in->viewTick = BitRead(r, 32);
+    in->viewFraction = (float)BitRead(r, 8)/255.0f;
+    if (in->forward > 1.0f) in->forward = 1.0f;
+    if (in->right > 1.0f) in->right = 1.0f;
+    if (in->selectWeapon >= MAX_WEAPONS) in->selectWeapon = -1;
+}
+
+void NetMergeInput(PlayerInput *into, const PlayerInput *in) {
+    into->forward = in->forward;
+    into->right = in->right;
+    into->look.x += in->look.x;
+    into->look.y += in->look.y;
+    into->fireHeld = in->fireHeld;
+    into->firePressed |= in->firePressed;
+    into->jump |= in->jump;
+    into->reload |= in->reload;
+    into->inspect |= in->inspect;
+    into->reset |= in->reset;
+    if (in->selectWeapon >= 0) into->selectWeapon = in->selectWeapon;
+    into->viewTick = in->viewTick;
+    into->viewFraction = in->viewFraction;
+}
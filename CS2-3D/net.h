@@ -0,0 +1,59 @@
+#ifndef CS2_NET_H
+#define CS2_NET_H
+
+#include "world.h"
+#include "bitstream.h"
+
+// Non-blocking UDP sockets and the packets the server and clients exchange.
+// Every packet starts with an 8-bit PacketType and is bit-packed after that.
+//
+//   CONNECT     protocol:32
+//   ACCEPT      player:8
+//   INPUT       sequence:32 ack:32 input   (ack = newest snapshot tick received)
+//   SNAPSHOT    tick:32 base:32 hash:32 tickMicros:16 player:8 delta
+//   DISCONNECT
+
+#define NET_DEFAULT_PORT 27015
+#define NET_PROTOCOL 0x43533204u
+#define NET_MAX_PACKET 8192
+
+typedef enum {
+    PACKET_CONNECT = 1,
+    PACKET_ACCEPT,
+    PACKET_INPUT,
+    PACKET_SNAPSHOT,
+    PACKET_DISCONNECT
+} PacketType;
+
+typedef struct {
+    uint32_t host;  // network byte order
+    uint16_t port;  // network byte order
+} NetAddress;
+
+typedef struct {
+    intptr_t handle;
+} NetSocket;
+
+bool NetStartup(void);
+void NetShutdown(void);
+
+// Binds to 127.0.0.1; port 0 picks any free port
+bool NetOpen(NetSocket *sock, uint16_t port);
+void NetClose(NetSocket *sock);
+
+NetAddress NetLoopback(uint16_t port);
+bool NetAddressEqual(NetAddress a, NetAddress b);
+
+bool NetSend(NetSocket *sock, NetAddress to, const void *data, int size);
+
+// Returns the packet size, or 0 when nothing is waiting
+int NetReceive(NetSocket *sock, NetAddress *from, void *data, int capacity);
+
+void NetWriteInput(BitWriter *w, const PlayerInput *in);
+void NetReadInput(BitReader *r, PlayerInput *in);
+
+// Folds a newer input into one not yet used by a tick: presses and mouse
+// movement add up, held state is replaced
+void NetMergeInput(PlayerInput *into, const PlayerInput *in);
+
+#endif
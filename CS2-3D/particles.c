@@ -0,0 +1,257 @@
+#include "particles.h"
+#include "../common/profile.h"
+#include <stdlib.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PARTICLES_X86 1
+#include <immintrin.h>
+#endif
+
+// The SIMD kernels do the same float operations in the same order as the
+// scalar one, so with FP contraction off (the default for -std=c99/c11) all
+// levels produce identical particles; bench_particles checks this.
+
+typedef struct {
+    float accel;   // added to velocity.y per second
+    float growth;  // added to size per second
+    float fade;    // alpha = life*fade, clamped; 0 keeps the spawn alpha
+} ParticleKind;
+
+static const ParticleKind particleKinds[PARTICLE_TYPE_COUNT] = {
+    [PARTICLE_BLOOD] = { -GRAVITY, 0.0f, 0.0f },
+    [PARTICLE_SPARK] = { 0.0f, 0.0f, 0.0f },
+    [PARTICLE_EXPLOSION] = { 0.0f, 10.0f, 255.0f*5.0f },
+    [PARTICLE_SMOKE] = { 2.0f, 2.0f, 0.0f },
+};
+
+static void IntegrateScalarFrom(ParticleBucket *b, int i, float dt, float accel, float grow) {
+    for (; i < b->count; i++) {
+        b->life[i] -= dt;
+        b->x[i] += b->vx[i]*dt;
+        b->y[i] += b->vy[i]*dt;
+        b->z[i] += b->vz[i]*dt;
+        b->vy[i] += accel;
+        b->size[i] += grow;
+    }
+}
+
+static void FadeScalarFrom(ParticleBucket *b, int i, float fade) {
+    for (; i < b->count; i++) {
+        float a = b->life[i]*fade;
+        a = a < 0.0f ? 0.0f : (a > 255.0f ? 255.0f : a);
+        b->color[i].a = (unsigned char)a;
+    }
+}
+
+static void IntegrateScalar(ParticleBucket *b, float dt, float accel, float grow) {
+    IntegrateScalarFrom(b, 0, dt, accel, grow);
+}
+
+static void FadeScalar(ParticleBucket *b, float fade) {
+    FadeScalarFrom(b, 0, fade);
+}
+
+#ifdef PARTICLES_X86
+
+__attribute__((target("sse2")))
+static void IntegrateSse2(ParticleBucket *b, float dt, float accel, float grow) {
+    __m128 step = _mm_set1_ps(dt);
+    __m128 accelStep = _mm_set1_ps(accel);
+    __m128 growStep = _mm_set1_ps(grow);
+    int i = 0;
+    for (; i + 4 <= b->count; i += 4) {
+        __m128 vy = _mm_loadu_ps(b->vy + i);
+        _mm_storeu_ps(b->life + i, _mm_sub_ps(_mm_loadu_ps(b->life + i), step));
+        _mm_storeu_ps(b->x + i, _mm_add_ps(_mm_loadu_ps(b->x + i), _mm_mul_ps(_mm_loadu_ps(b->vx + i), step)));
+        _mm_storeu_ps(b->y + i, _mm_add_ps(_mm_loadu_ps(b->y + i), _mm_mul_ps(vy, step)));
+        _mm_storeu_ps(b->z + i, _mm_add_ps(_mm_loadu_ps(b->z + i), _mm_mul_ps(_mm_loadu_ps(b->vz + i), step)));
+        _mm_storeu_ps(b->vy + i, _mm_add_ps(vy, accelStep));
+        _mm_storeu_ps(b->size + i, _mm_add_ps(_mm_loadu_ps(b->size + i), growStep));
+    }
+    IntegrateScalarFrom(b, i, dt, accel, grow);
+}
+
+__attribute__((target("sse2")))
+static void FadeSse2(ParticleBucket *b, float fade) {
+    __m128 scale = _mm_set1_ps(fade);
+    __m128 lo = _mm_setzero_ps();
+    __m128 hi = _mm_set1_ps(255.0f);
+    int i = 0;
+    for (; i + 4 <= b->count; i += 4) {
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(b->life + i), scale), lo), hi);
+        int alpha[4];
+        _mm_storeu_si128((__m128i *)alpha, _mm_cvttps_epi32(a));
+        for (int k = 0; k < 4; k++) b->color[i + k].a = (unsigned char)alpha[k];
+    }
+    FadeScalarFrom(b, i, fade);
+}
+
+__attribute__((target("avx2")))
+static void IntegrateAvx2(ParticleBucket *b, float dt, float accel, float grow) {
+    __m256 step = _mm256_set1_ps(dt);
+    __m256 accelStep = _mm256_set1_ps(accel);
+    __m256 growStep = _mm256_set1_ps(grow);
+    int i = 0;
+    for (; i + 8 <= b->count; i += 8) {
+        __m256 vy = _mm256_loadu_ps(b->vy + i);
+        _mm256_storeu_ps(b->life + i, _mm256_sub_ps(_mm256_loadu_ps(b->life + i), step));
+        _mm256_storeu_ps(b->x + i, _mm256_add_ps(_mm256_loadu_ps(b->x + i), _mm256_mul_ps(_mm256_loadu_ps(b->vx + i), step)));
+        _mm256_storeu_ps(b->y + i, _mm256_add_ps(_mm256_loadu_ps(b->y + i), _mm256_mul_ps(vy, step)));
+        _mm256_storeu_ps(b->z + i, _mm256_add_ps(_mm256_loadu_ps(b->z + i), _mm256_mul_ps(_mm256_loadu_ps(b->vz + i), step)));
+        _mm256_storeu_ps(b->vy + i, _mm256_add_ps(vy, accelStep));
+        _mm256_storeu_ps(b->size + i, _mm256_add_ps(_mm256_loadu_ps(b->size + i), growStep));
+    }
+    IntegrateScalarFrom(b, i, dt, accel, grow);
+}
+
+__attribute__((target("avx2")))
+static void FadeAvx2(ParticleBucket *b, float fade) {
+    __m256 scale = _mm256_set1_ps(fade);
+    __m256 lo = _mm256_setzero_ps();
+    __m256 hi = _mm256_set1_ps(255.0f);
+    int i = 0;
+    for (; i + 8 <= b->count; i += 8) {
+        __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(b->life + i), scale), lo), hi);
+        int alpha[8];
+        _mm256_storeu_si256((__m256i *)alpha, _mm256_cvttps_epi32(a));
+        for (int k = 0; k < 8; k++) b->color[i + k].a = (unsigned char)alpha[k];
+    }
+    FadeScalarFrom(b, i, fade);
+}
+
+#endif
+
+typedef void (*IntegrateFn)(ParticleBucket *b, float dt, float accel, float grow);
+typedef void (*FadeFn)(ParticleBucket *b, float fade);
+
+static IntegrateFn integrate = NULL;
+static FadeFn fadeAlpha = NULL;
+static ParticleSimd activeSimd = PARTICLE_SIMD_SCALAR;
+
+static bool SimdSupported(ParticleSimd simd) {
+    if (simd == PARTICLE_SIMD_SCALAR) return true;
+#ifdef PARTICLES_X86
+    __builtin_cpu_init();
+    if (simd == PARTICLE_SIMD_SSE2) return __builtin_cpu_supports("sse2");
+    if (simd == PARTICLE_SIMD_AVX2) return __builtin_cpu_supports("avx2");
+#endif
+    return false;
+}
+
+bool ParticleSimdSet(ParticleSimd simd) {
+    if (!SimdSupported(simd)) return false;
+    switch (simd) {
+#ifdef PARTICLES_X86
+        case PARTICLE_SIMD_AVX2: integrate = IntegrateAvx2; fadeAlpha = FadeAvx2; break;
+        case PARTICLE_SIMD_SSE2: integrate = IntegrateSse2; fadeAlpha = FadeSse2; break;
+#endif
+        default: integrate = IntegrateScalar; fadeAlpha = FadeScalar; break;
+    }
+    activeSimd = simd;
+    return true;
+}
+
+ParticleSimd ParticleSimdActive(void) {
+    if (!integrate) {
+        if (!ParticleSimdSet(PARTICLE_SIMD_AVX2) && !ParticleSimdSet(PARTICLE_SIMD_SSE2)) ParticleSimdSet(PARTICLE_SIMD_SCALAR);
+    }
+    return activeSimd;
+}
+
+const char *ParticleSimdName(ParticleSimd simd) {
+    switch (simd) {
+        case PARTICLE_SIMD_SSE2: return "sse2";
+        case PARTICLE_SIMD_AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+static bool BucketReserve(ParticleBucket *b, int capacity) {
+    float **fields[] = { &b->x, &b->y, &b->z, &b->vx, &b->vy, &b->vz, &b->size, &b->life };
+    for (int f = 0; f < (int)(sizeof(fields)/sizeof(fields[0])); f++) {
+        float *grown = realloc(*fields[f], capacity*sizeof(float));
+        if (!grown) return false;
+        *fields[f] = grown;
+    }
+    Color *color = realloc(b->color, capacity*sizeof(Color));
+    if (!color) return false;
+    b->color = color;
+    b->capacity = capacity;
+    return true;
+}
+
+static void BucketFree(ParticleBucket *b) {
+    free(b->x); free(b->y); free(b->z);
+    free(b->vx); free(b->vy); free(b->vz);
+    free(b->size); free(b->life); free(b->color);
+    *b = (ParticleBucket){ 0 };
+}
+
+bool ParticlePoolInit(ParticlePool *pool, int capacity) {
+    *pool = (ParticlePool){ 0 };
+    pool->capacity = capacity;
+    ParticleSimdActive();
+    return capacity > 0;
+}
+
+void ParticlePoolFree(ParticlePool *pool) {
+    for (int t = 0; t < PARTICLE_TYPE_COUNT; t++) BucketFree(&pool->buckets[t]);
+    pool->count = pool->capacity = 0;
+}
+
+void ParticlePoolClear(ParticlePool *pool) {
+    for (int t = 0; t < PARTICLE_TYPE_COUNT; t++) pool->buckets[t].count = 0;
+    pool->count = 0;
+}
+
+bool ParticlePoolSpawn(ParticlePool *pool, Vector3 pos, Vector3 vel, Color col, float size, float life, ParticleType type) {
+    if (pool->count == pool->capacity) return false;
+
+    ParticleBucket *b = &pool->buckets[type];
+    if (b->count == b->capacity) {
+        int capacity = b->capacity ? b->capacity*2 : 256;
+        if (capacity > pool->capacity) capacity = pool->capacity;
+        if (!BucketReserve(b, capacity)) return false;
+    }
+
+    int i = b->count++;
+    b->x[i] = pos.x; b->y[i] = pos.y; b->z[i] = pos.z;
+    b->vx[i] = vel.x; b->vy[i] = vel.y; b->vz[i] = vel.z;
+    b->size[i] = size;
+    b->life[i] = life;
+    b->color[i] = col;
+    pool->count++;
+    return true;
+}
+
+void ParticlePoolKill(ParticlePool *pool, ParticleType type, int index) {
+    ParticleBucket *b = &pool->buckets[type];
+    int last = --b->count;
+    b->x[index] = b->x[last]; b->y[index] = b->y[last]; b->z[index] = b->z[last];
+    b->vx[index] = b->vx[last]; b->vy[index] = b->vy[last]; b->vz[index] = b->vz[last];
+    b->size[index] = b->size[last];
+    b->life[index] = b->life[last];
+    b->color[index] = b->color[last];
+    pool->count--;
+}
+
+void ParticlePoolUpdate(ParticlePool *pool, float dt) {
+    PROFILE_ZONE("particles");
+    ParticleSimdActive();
+    for (int t = 0; t < PARTICLE_TYPE_COUNT; t++) {
+        ParticleBucket *b = &pool->buckets[t];
+        const ParticleKind *kind = &particleKinds[t];
+        if (b->count == 0) continue;
+
+        integrate(b, dt, kind->accel*dt, kind->growth*dt);
+        if (kind->fade > 0.0f) fadeAlpha(b, kind->fade);
+
+        // Compact afterwards; a particle swapped in from the end has already
+        // been integrated, it only needs its own life checked
+        int i = 0;
+        while (i < b->count) {
+            if (b->life[i] <= 0) ParticlePoolKill(pool, (ParticleType)t, i);
+            else i++;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef CS2_PARTICLES_H
+#define CS2_PARTICLES_H
+
+#include "game.h"
+
+// Particles are split into one bucket per ParticleType, each in
+// structure-of-arrays layout with its live particles packed at the front.
+// Spawning appends and a dead particle is replaced by the last one in its
+// bucket, so both are O(1), and each bucket is integrated by one branch-free
+// loop with the type's constants. Order within a bucket is not stable.
+
+typedef struct {
+    float *x, *y, *z;
+    float *vx, *vy, *vz;
+    float *size;
+    float *life;
+    Color *color;
+    int count;
+    int capacity;
+} ParticleBucket;
+
+typedef struct {
+    ParticleBucket buckets[PARTICLE_TYPE_COUNT];
+    int count;
+    int capacity;
+} ParticlePool;
+
+typedef enum {
+    PARTICLE_SIMD_SCALAR,
+    PARTICLE_SIMD_SSE2,
+    PARTICLE_SIMD_AVX2
+} ParticleSimd;
+
+// capacity caps the total over all buckets; buckets grow on demand
+bool ParticlePoolInit(ParticlePool *pool, int capacity);
+void ParticlePoolFree(ParticlePool *pool);
+void ParticlePoolClear(ParticlePool *pool);
+
+// Returns false (and drops the particle) when the pool is full
+bool ParticlePoolSpawn(ParticlePool *pool, Vector3 pos, Vector3 vel, Color col, float size, float life, ParticleType type);
+void ParticlePoolKill(ParticlePool *pool, ParticleType type, int index);
+
+void ParticlePoolUpdate(ParticlePool *pool, float dt);
+
+// The kernels are picked once from what the CPU supports; the setter is for
+// benchmarks and returns false if the level is not available
+ParticleSimd ParticleSimdActive(void);
+bool ParticleSimdSet(ParticleSimd simd);
+const char *ParticleSimdName(ParticleSimd simd);
+
+#endif
@@ -0,0 +1,98 @@
+#include "projectiles.h"
+#include "collide.h"
+#include "raymath.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool ProjectilePoolInit(ProjectilePool *pool, int capacity) {
+    pool->items = calloc(capacity, sizeof(Projectile));
+    pool->detonated = malloc(capacity*sizeof(int));
+    pool->count = 0;
+    if (!pool->items || !pool->detonated) {
+        ProjectilePoolFree(pool);
+        return false;
+    }
+    pool->capacity = capacity;
+    return true;
+}
+
+void ProjectilePoolFree(ProjectilePool *pool) {
+    free(pool->items);
+    free(pool->detonated);
+    memset(pool, 0, sizeof(*pool));
+}
+
+void ProjectilePoolClear(ProjectilePool *pool) {
+    pool->count = 0;
+}
+
+Projectile *ProjectilePoolSpawn(ProjectilePool *pool) {
+    if (pool->count == pool->capacity) return NULL;
+    Projectile *p = &pool->items[pool->count++];
+    memset(p, 0, sizeof(*p));
+    return p;
+}
+
+// Each wall hit sends back part of the speed into it and keeps part of the
+// speed along it; the rest of the tick's motion is treated the same way
+static void Bounce(Projectile *p, const Bvh *bvh, const Wall *walls, Vector3 motion) {
+    Vector3 half = { p->halfSize, p->halfSize, p->halfSize };
+    for (int hit = 0; hit < COLLIDE_MAX_SLIDES; hit++) {
+        float t;
+        Vector3 normal;
+        if (!SweepBox(bvh, walls, p->position, half, motion, &t, &normal)) {
+            p->position = Vector3Add(p->position, motion);
+            return;
+        }
+        p->position = Vector3Add(p->position, Vector3Scale(motion, t));
+        p->position = Vector3Add(p->position, Vector3Scale(normal, COLLIDE_SKIN));
+
+        float speedIn = Vector3DotProduct(p->velocity, normal);
+        Vector3 along = Vector3Subtract(p->velocity, Vector3Scale(normal, speedIn));
+        p->velocity = Vector3Subtract(Vector3Scale(along, p->friction), Vector3Scale(normal, speedIn*p->bounce));
+
+        float leftIn = Vector3DotProduct(motion, normal)*(1.0f - t);
+        Vector3 leftAlong = Vector3Subtract(Vector3Scale(motion, 1.0f - t), Vector3Scale(normal, leftIn));
+        motion = Vector3Subtract(Vector3Scale(leftAlong, p->friction), Vector3Scale(normal, leftIn*p->bounce));
+    }
+}
+
+int ProjectilePoolUpdate(ProjectilePool *pool, const Bvh *bvh, const Wall *walls, float dt) {
+    int count = 0;
+    int i = 0;
+    while (i < pool->count) {
+        Projectile *p = &pool->items[i];
+        p->previous = p->position;
+
+        if (p->exploding) {
+            p->timer -= dt;
+            if (p->timer <= 0.0f) {
+                // Only entries not visited yet move, so earlier indices stay put
+                *p = pool->items[--pool->count];
+                continue;
+            }
+            i++;
+            continue;
+        }
+
+        p->velocity.y -= GRAVITY*dt;
+        Bounce(p, bvh, walls, Vector3Scale(p->velocity, dt));
+
+        // Ground level still holds on maps without a floor
+        if (p->position.y < p->halfSize) {
+            p->position.y = p->halfSize;
+            p->velocity.y *= -p->bounce;
+            p->velocity.x *= p->friction;
+            p->velocity.z *= p->friction;
+        }
+
+        p->timer -= dt;
+        if (p->timer <= 0.0f) {
+            p->exploding = true;
+            p->timer = PROJECTILE_EXPLOSION_TIME;
+            pool->detonated[count++] = i;
+        }
+        i++;
+    }
+    return count;
+}
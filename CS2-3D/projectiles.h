@@ -0,0 +1,50 @@
+#ifndef CS2_PROJECTILES_H
+#define CS2_PROJECTILES_H
+
+#include "game.h"
+#include "bvh.h"
+
+// Thrown and fired objects that fly under gravity, bounce off walls and go
+// off when their fuse runs out. Live projectiles are packed at the front of
+// one array; spawning appends and a finished one is replaced by the last, so
+// both are O(1) and an update is one pass over count entries.
+
+#define MAX_PROJECTILES 4096
+#define PROJECTILE_EXPLOSION_TIME 0.5f
+
+typedef struct {
+    Vector3 position;
+    Vector3 previous;       // before the last update, for drawing between ticks
+    Vector3 velocity;
+    float halfSize;         // collision box half extent
+    float bounce;           // share of the speed into a wall that comes back
+    float friction;         // share of the speed along a wall that is kept
+    float timer;            // fuse, then time left showing the explosion
+    float radius;           // blast radius
+    int damage;
+    int owner;              // player index
+    int weapon;
+    bool exploding;
+} Projectile;
+
+typedef struct {
+    Projectile *items;
+    int count;
+    int capacity;
+    int *detonated;         // capacity entries, see ProjectilePoolUpdate
+} ProjectilePool;
+
+bool ProjectilePoolInit(ProjectilePool *pool, int capacity);
+void ProjectilePoolFree(ProjectilePool *pool);
+void ProjectilePoolClear(ProjectilePool *pool);
+
+// A zeroed slot to fill in, or NULL when the pool is full
+Projectile *ProjectilePoolSpawn(ProjectilePool *pool);
+
+// Moves every projectile by dt against the walls, counts down fuses and drops
+// finished explosions. The indices of projectiles that went off during this
+// update are left in pool->detonated until the next update; returns how many
+// there are.
+int ProjectilePoolUpdate(ProjectilePool *pool, const Bvh *bvh, const Wall *walls, float dt);
+
+#endif
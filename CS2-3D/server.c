@@ -0,0 +1,270 @@
+#include "net.h"
+#include "snapshot.h"
+#include "../common/jobs.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Headless dedicated server: runs the world at WORLD_TICK_RATE, takes player
+// input over UDP on localhost and sends every client a delta snapshot against
+// the newest one it has acknowledged. Bots think on one thread per core.
+// Usage: cs2_server [port] [seconds, 0 = forever] [ticks per snapshot] [weapons file] [compiled map or -] [bots]
+
+#define SNAPSHOT_HISTORY 64
+#define CLIENT_TIMEOUT 5.0
+#define STATS_INTERVAL 5.0
+
+typedef struct {
+    bool active;
+    NetAddress address;
+    int player;
+    PlayerInput pending;
+    uint32_t lastSequence;
+    uint32_t ackTick;
+    double lastHeard;
+} Client;
+
+static World world;
+static Client clients[MAX_PLAYERS];
+static PlayerInput inputs[MAX_PLAYERS];
+static NetSnapshot history[SNAPSHOT_HISTORY];
+static const NetSnapshot emptySnapshot;
+
+static void SleepUntil(double when) {
+    double wait = when - BenchNowSeconds();
+    if (wait <= 0) return;
+    struct timespec ts = { (time_t)wait, (long)((wait - (double)(time_t)wait)*1e9) };
+    nanosleep(&ts, NULL);
+}
+
+static Client *FindClient(NetAddress address) {
+    for (int i = 0; i < MAX_PLAYERS; i++) {
+        if (clients[i].active && NetAddressEqual(clients[i].address, address)) return &clients[i];
+    }
+    return NULL;
+}
+
+static void SendAccept(NetSocket *sock, const Client *client) {
+    uint8_t packet[8];
+    BitWriter w;
+    BitWriterInit(&w, packet, sizeof(packet));
+    BitWrite(&w, PACKET_ACCEPT, 8);
+    BitWrite(&w, (uint32_t)client->player, 8);
+    NetSend(sock, client->address, packet, BitWriterBytes(&w));
+}
+
+static void DropClient(Client *client) {
+    WorldRemovePlayer(&world, client->player);
+    printf("player %d left\n", client->player);
+    client->active = false;
+}
+
+static void HandlePacket(NetSocket *sock, NetAddress from, const uint8_t *data, int size, double now) {
+    BitReader r;
+    BitReaderInit(&r, data, size);
+    PacketType type = (PacketType)BitRead(&r, 8);
+    Client *client = FindClient(from);
+
+    if (type == PACKET_CONNECT) {
+        if (BitRead(&r, 32) != NET_PROTOCOL) return;
+        if (!client) {
+            int slot = 0;
+            while (slot < MAX_PLAYERS && clients[slot].active) slot++;
+            if (slot == MAX_PLAYERS) return;
+
+            char name[32];
+            snprintf(name, sizeof(name), "Player %d", slot + 1);
+            int player = WorldAddPlayer(&world, name);
+            if (player < 0) return;
+
+            client = &clients[slot];
+            memset(client, 0, sizeof(*client));
+            client->active = true;
+            client->address = from;
+            client->player = player;
+            client->pending.selectWeapon = -1;
+            printf("player %d joined\n", player);
+        }
+        client->lastHeard = now;
+        // Sent again for every CONNECT in case the first ACCEPT was lost
+        SendAccept(sock, client);
+        return;
+    }
+    if (!client) return;
+
+    if (type == PACKET_INPUT) {
+        uint32_t sequence = BitRead(&r, 32);
+        uint32_t ack = BitRead(&r, 32);
+        PlayerInput in;
+        NetReadInput(&r, &in);
+        if (r.overflow || (int32_t)(sequence - client->lastSequence) <= 0) return;
+
+        // Map resets are up to the server
+        in.reset = false;
+        client->lastSequence = sequence;
+        if ((int32_t)(ack - client->ackTick) > 0) client->ackTick = ack;
+        NetMergeInput(&client->pending, &in);
+        client->lastHeard = now;
+    } else if (type == PACKET_DISCONNECT) {
+        DropClient(client);
+    }
+}
+
+int main(int argc, char **argv) {
+    int port = (argc > 1) ? atoi(argv[1]) : NET_DEFAULT_PORT;
+    double duration = (argc > 2) ? atof(argv[2]) : 0.0;
+    int snapshotInterval = (argc > 3) ? atoi(argv[3]) : 1;
+    if (snapshotInterval < 1) snapshotInterval = 1;
+    const char *weaponsPath = (argc > 4) ? argv[4] : "weapons.txt";
+
+    NetSocket sock;
+    if (!NetStartup() || !NetOpen(&sock, (uint16_t)port)) {
+        fprintf(stderr, "cannot open UDP port %d\n", port);
+        return 1;
+    }
+    WorldInit(&world, (uint64_t)time(NULL));
+    WeaponTable weapons = world.weapons;
+    char weaponError[160];
+    static MapFile map;
+    if (argc > 5 && argv[5][0] != '-') {
+        char mapError[160];
+        if (!MapFileOpen(&map, argv[5], mapError, sizeof(mapError))) {
+            fprintf(stderr, "%s\n", mapError);
+            return 1;
+        }
+        WorldSetMap(&world, &map);
+        printf("map %s: %d walls, %d spawns\n", argv[5], map.wallCount, map.spawnCount);
+    }
+    if (argc > 6) WorldSetBots(&world, atoi(argv[6]));
+    JobSystem *jobs = JobSystemCreate(0);
+    world.jobs = jobs;
+    printf("listening on 127.0.0.1:%d, %d Hz, %d bots on %d threads\n", port, WORLD_TICK_RATE, world.botCount, JobSystemSize(jobs));
+
+    static uint8_t packet[NET_MAX_PACKET];
+    double start = BenchNowSeconds();
+    double nextTick = start;
+    double statsStart = start;
+    double tickTime = 0.0, tickMax = 0.0;
+    long long statTicks = 0, bytesOut = 0, bytesIn = 0, clientTicks = 0, snapshotsOut = 0;
+    uint32_t lastTickMicros = 0;
+
+    while (duration <= 0.0 || BenchNowSeconds() - start < duration) {
+        // The weapon file is optional and picked up again whenever it changes
+        if (world.tick % WORLD_TICK_RATE == 0) {
+            weaponError[0] = '\0';
+            if (WeaponTableReload(&weapons, weaponsPath, weaponError, sizeof(weaponError))) {
+                WorldSetWeapons(&world, &weapons);
+                printf("loaded %d weapons from %s\n", weapons.count, weaponsPath);
+            } else if (weaponError[0]) {
+                printf("%s\n", weaponError);
+            }
+        }
+
+        SleepUntil(nextTick);
+        nextTick += WORLD_DT;
+        double now = BenchNowSeconds();
+        // Fell badly behind: skip ahead instead of running a burst of ticks
+        if (now - nextTick > 0.25) nextTick = now;
+
+        NetAddress from;
+        int size;
+        while ((size = NetReceive(&sock, &from, packet, sizeof(packet))) > 0) {
+            bytesIn += size;
+            HandlePacket(&sock, from, packet, size, now);
+        }
+
+        double tickStart = BenchNowSeconds();
+        for (int i = 0; i < MAX_PLAYERS; i++) {
+            Client *client = &clients[i];
+            if (!client->active) continue;
+            if (now - client->lastHeard > CLIENT_TIMEOUT) {
+                DropClient(client);
+                continue;
+            }
+            inputs[client->player] = client->pending;
+            client->pending.look = (Vector2){ 0 };
+            client->pending.firePressed = client->pending.jump = client->pending.reload = client->pending.inspect = false;
+            client->pending.selectWeapon = -1;
+        }
+
+        bool anyTarget = false;
+        for (int i = 0; i < MAX_TARGETS; i++) anyTarget |= world.targets[i].active;
+        if (!anyTarget && world.botCount > 0) WorldReset(&world);
+
+        WorldStep(&world, inputs, WORLD_DT);
+
+        if (world.tick % snapshotInterval == 0) {
+            NetSnapshot *snap = &history[world.tick % SNAPSHOT_HISTORY];
+            SnapshotCapture(snap, &world);
+            uint32_t hash = SnapshotHash(snap);
+
+            for (int i = 0; i < MAX_PLAYERS; i++) {
+                Client *client = &clients[i];
+                if (!client->active) continue;
+
+                const NetSnapshot *base = &emptySnapshot;
+                uint32_t baseTick = 0;
+                const NetSnapshot *acked = &history[client->ackTick % SNAPSHOT_HISTORY];
+                if (client->ackTick != 0 && acked->tick == client->ackTick && snap->tick - client->ackTick < SNAPSHOT_HISTORY) {
+                    base = acked;
+                    baseTick = client->ackTick;
+                }
+
+                BitWriter w;
+                BitWriterInit(&w, packet, sizeof(packet));
+                BitWrite(&w, PACKET_SNAPSHOT, 8);
+                BitWrite(&w, snap->tick, 32);
+                BitWrite(&w, baseTick, 32);
+                BitWrite(&w, hash, 32);
+                BitWrite(&w, lastTickMicros, 16);
+                BitWrite(&w, (uint32_t)client->player, 8);
+                SnapshotWriteDelta(&w, snap, base);
+                if (w.overflow) continue;
+
+                NetSend(&sock, client->address, packet, BitWriterBytes(&w));
+                bytesOut += BitWriterBytes(&w);
+                snapshotsOut++;
+            }
+        }
+
+        double elapsed = BenchNowSeconds() - tickStart;
+        tickTime += elapsed;
+        if (elapsed > tickMax) tickMax = elapsed;
+        lastTickMicros = (uint32_t)(elapsed*1e6 < 65535.0 ? elapsed*1e6 : 65535.0);
+        statTicks++;
+
+        int connected = 0;
+        for (int i = 0; i < MAX_PLAYERS; i++) connected += clients[i].active;
+        clientTicks += connected;
+
+        if (now - statsStart >= STATS_INTERVAL) {
+            double clientSeconds = (double)clientTicks/WORLD_TICK_RATE;
+            // What the same state costs without a base, for comparison
+            NetSnapshot full;
+            SnapshotCapture(&full, &world);
+            BitWriter w;
+            BitWriterInit(&w, packet, sizeof(packet));
+            SnapshotWriteDelta(&w, &full, &emptySnapshot);
+
+            printf("clients %3d  tick avg %.3f ms  max %.3f ms  out %.1f KB/s per client  in %.1f KB/s per client  "
+                   "snapshot %lld B avg, %d B full\n",
+                   connected, tickTime*1e3/statTicks, tickMax*1e3,
+                   clientSeconds > 0 ? bytesOut/clientSeconds/1024.0 : 0.0,
+                   clientSeconds > 0 ? bytesIn/clientSeconds/1024.0 : 0.0,
+                   snapshotsOut ? bytesOut/snapshotsOut : 0, BitWriterBytes(&w) + 15);
+            fflush(stdout);
+            statsStart = now;
+            tickTime = tickMax = 0.0;
+            statTicks = bytesOut = bytesIn = clientTicks = snapshotsOut = 0;
+        }
+    }
+
+    NetClose(&sock);
+    NetShutdown();
+    WorldFree(&world);
+    JobSystemDestroy(jobs);
+    MapFileClose(&map);
+    return 0;
+}
@@ -0,0 +1,254 @@
+#include "snapshot.h"
+#include <math.h>
+#include <string.h>
+
+#define POS_SCALE 64.0f
+#define POS_OFFSET 512.0f
+
+static uint16_t QuantizePosition(float value) {
+    float q = (value + POS_OFFSET)*POS_SCALE + 0.5f;
+    if (q < 0.0f) q = 0.0f;
+    if (q > 65535.0f) q = 65535.0f;
+    return (uint16_t)q;
+}
+
+float SnapshotPosition(uint16_t value) {
+    return (float)value/POS_SCALE - POS_OFFSET;
+}
+
+static uint16_t QuantizeAngle(float radians, float min, float max, int bits) {
+    float t = (radians - min)/(max - min);
+    float steps = (float)((1 << bits) - 1);
+    float q = t*steps + 0.5f;
+    if (q < 0.0f) q = 0.0f;
+    if (q > steps) q = steps;
+    return (uint16_t)q;
+}
+
+static uint8_t ClampByte(int value, int max) {
+    return (uint8_t)(value < 0 ? 0 : (value > max ? max : value));
+}
+
+void SnapshotCapture(NetSnapshot *snap, const World *world) {
+    memset(snap, 0, sizeof(*snap));
+    snap->tick = (uint32_t)world->tick;
+    snap->playerCount = (uint8_t)world->playerCount;
+
+    for (int i = 0; i < world->playerCount; i++) {
+        const Player *p = &world->players[i];
+        NetPlayer *n = &snap->players[i];
+        if (!p->connected) continue;
+        n->connected = 1;
+        n->health = ClampByte(p->health, 127);
+        n->weapon = (uint8_t)p->weapon;
+        n->flags = (p->isGrounded ? NET_PLAYER_GROUNDED : 0) | (p->isReloading ? NET_PLAYER_RELOADING : 0) |
+                   (p->isInspecting ? NET_PLAYER_INSPECTING : 0) | (p->muzzleFlashTimer > 0 ? NET_PLAYER_MUZZLE_FLASH : 0);
+        n->ammo = ClampByte(p->ammo[p->weapon], 255);
+        n->reserve = ClampByte(p->reserve[p->weapon], 255);
+        n->x = QuantizePosition(p->position.x);
+        n->y = QuantizePosition(p->position.y);
+        n->z = QuantizePosition(p->position.z);
+        n->yaw = QuantizeAngle(p->yaw - 2.0f*PI*floorf(p->yaw/(2.0f*PI)), 0.0f, 2.0f*PI, SNAPSHOT_YAW_BITS);
+        n->pitch = QuantizeAngle(p->pitch, -PI/2, PI/2, SNAPSHOT_PITCH_BITS);
+    }
+
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        const Target *t = &world->targets[i];
+        NetTarget *n = &snap->targets[i];
+        if (!t->active) continue;
+        n->active = 1;
+        n->health = ClampByte(t->health, 127);
+        n->hit = t->hitTimer > 0;
+        n->x = QuantizePosition(t->position.x);
+        n->z = QuantizePosition(t->position.z);
+    }
+
+    const ProjectilePool *pool = &world->projectiles;
+    snap->grenadeCount = (uint8_t)(pool->count < SNAPSHOT_MAX_GRENADES ? pool->count : SNAPSHOT_MAX_GRENADES);
+    for (int i = 0; i < snap->grenadeCount; i++) {
+        const Projectile *p = &pool->items[i];
+        NetGrenade *n = &snap->grenades[i];
+        n->exploding = p->exploding;
+        n->owner = (uint8_t)(p->owner < 0 ? 0 : p->owner);
+        n->x = QuantizePosition(p->position.x);
+        n->y = QuantizePosition(p->position.y);
+        n->z = QuantizePosition(p->position.z);
+    }
+
+    const GameEvent *k;
+    float timeLeft;
+    for (int i = 0; (k = WorldKillFeed(world, i, &timeLeft)) != NULL; i++) {
+        NetKill *n = &snap->kills[i];
+        n->active = 1;
+        n->weapon = k->weapon;
+        n->headshot = k->headshot;
+        n->timer = ClampByte((int)ceilf(timeLeft*4.0f), 31);
+        strncpy(n->killer, NameLookup(&world->names, k->actor), SNAPSHOT_NAME_LENGTH);
+        strncpy(n->victim, NameLookup(&world->names, k->subject), SNAPSHOT_NAME_LENGTH);
+    }
+}
+
+// Field helpers: a changed bit, then the value only if it changed
+#define WRITE_FIELD(field, bits) do { \
+        bool changed = cur->field != base->field; \
+        BitWriteBool(w, changed); \
+        if (changed) BitWrite(w, cur->field, bits); \
+    } while (0)
+
+#define READ_FIELD(field, bits) do { \
+        if (BitReadBool(r)) out->field = BitRead(r, bits); \
+    } while (0)
+
+static void WriteString(BitWriter *w, const char *cur, const char *base) {
+    bool changed = strcmp(cur, base) != 0;
+    BitWriteBool(w, changed);
+    if (!changed) return;
+    int length = (int)strlen(cur);
+    BitWrite(w, length, 5);
+    for (int i = 0; i < length; i++) BitWrite(w, (uint8_t)cur[i] & 0x7F, 7);
+}
+
+static void ReadString(BitReader *r, char *out) {
+    if (!BitReadBool(r)) return;
+    int length = (int)BitRead(r, 5);
+    for (int i = 0; i < length; i++) out[i] = (char)BitRead(r, 7);
+    memset(out + length, 0, SNAPSHOT_NAME_LENGTH + 1 - length);
+}
+
+static void WritePlayer(BitWriter *w, const NetPlayer *cur, const NetPlayer *base) {
+    WRITE_FIELD(connected, 1);
+    WRITE_FIELD(health, 7);
+    WRITE_FIELD(weapon, SNAPSHOT_WEAPON_BITS);
+    WRITE_FIELD(flags, 4);
+    WRITE_FIELD(ammo, 8);
+    WRITE_FIELD(reserve, 8);
+    WRITE_FIELD(x, SNAPSHOT_POS_BITS);
+    WRITE_FIELD(y, SNAPSHOT_POS_BITS);
+    WRITE_FIELD(z, SNAPSHOT_POS_BITS);
+    WRITE_FIELD(yaw, SNAPSHOT_YAW_BITS);
+    WRITE_FIELD(pitch, SNAPSHOT_PITCH_BITS);
+}
+
+static void ReadPlayer(BitReader *r, NetPlayer *out) {
+    READ_FIELD(connected, 1);
+    READ_FIELD(health, 7);
+    READ_FIELD(weapon, SNAPSHOT_WEAPON_BITS);
+    READ_FIELD(flags, 4);
+    READ_FIELD(ammo, 8);
+    READ_FIELD(reserve, 8);
+    READ_FIELD(x, SNAPSHOT_POS_BITS);
+    READ_FIELD(y, SNAPSHOT_POS_BITS);
+    READ_FIELD(z, SNAPSHOT_POS_BITS);
+    READ_FIELD(yaw, SNAPSHOT_YAW_BITS);
+    READ_FIELD(pitch, SNAPSHOT_PITCH_BITS);
+}
+
+static void WriteTarget(BitWriter *w, const NetTarget *cur, const NetTarget *base) {
+    WRITE_FIELD(active, 1);
+    WRITE_FIELD(health, 7);
+    WRITE_FIELD(hit, 1);
+    WRITE_FIELD(x, SNAPSHOT_POS_BITS);
+    WRITE_FIELD(z, SNAPSHOT_POS_BITS);
+}
+
+static void ReadTarget(BitReader *r, NetTarget *out) {
+    READ_FIELD(active, 1);
+    READ_FIELD(health, 7);
+    READ_FIELD(hit, 1);
+    READ_FIELD(x, SNAPSHOT_POS_BITS);
+    READ_FIELD(z, SNAPSHOT_POS_BITS);
+}
+
+static void WriteGrenade(BitWriter *w, const NetGrenade *cur, const NetGrenade *base) {
+    WRITE_FIELD(exploding, 1);
+    WRITE_FIELD(owner, 7);
+    WRITE_FIELD(x, SNAPSHOT_POS_BITS);
+    WRITE_FIELD(y, SNAPSHOT_POS_BITS);
+    WRITE_FIELD(z, SNAPSHOT_POS_BITS);
+}
+
+static void ReadGrenade(BitReader *r, NetGrenade *out) {
+    READ_FIELD(exploding, 1);
+    READ_FIELD(owner, 7);
+    READ_FIELD(x, SNAPSHOT_POS_BITS);
+    READ_FIELD(y, SNAPSHOT_POS_BITS);
+    READ_FIELD(z, SNAPSHOT_POS_BITS);
+}
+
+static void WriteKill(BitWriter *w, const NetKill *cur, const NetKill *base) {
+    WRITE_FIELD(active, 1);
+    WRITE_FIELD(weapon, SNAPSHOT_WEAPON_BITS);
+    WRITE_FIELD(headshot, 1);
+    WRITE_FIELD(timer, 5);
+    WriteString(w, cur->killer, base->killer);
+    WriteString(w, cur->victim, base->victim);
+}
+
+static void ReadKill(BitReader *r, NetKill *out) {
+    READ_FIELD(active, 1);
+    READ_FIELD(weapon, SNAPSHOT_WEAPON_BITS);
+    READ_FIELD(headshot, 1);
+    READ_FIELD(timer, 5);
+    ReadString(r, out->killer);
+    ReadString(r, out->victim);
+}
+
+// Entities are whole structs that were zeroed before being filled, so memcmp
+// is a safe "anything changed" test
+#define WRITE_ENTITY(fn, cur, base) do { \
+        bool changed = memcmp((cur), (base), sizeof(*(cur))) != 0; \
+        BitWriteBool(w, changed); \
+        if (changed) fn(w, (cur), (base)); \
+    } while (0)
+
+#define READ_ENTITY(fn, out) do { \
+        if (BitReadBool(r)) fn(r, (out)); \
+    } while (0)
+
+void SnapshotWriteDelta(BitWriter *w, const NetSnapshot *snap, const NetSnapshot *base) {
+    BitWrite(w, snap->playerCount, 8);
+    for (int i = 0; i < snap->playerCount; i++) WRITE_ENTITY(WritePlayer, &snap->players[i], &base->players[i]);
+    for (int i = 0; i < MAX_TARGETS; i++) WRITE_ENTITY(WriteTarget, &snap->targets[i], &base->targets[i]);
+    // Grenades are sent per slot like players. The pool reorders when one
+    // goes away, which only costs a few more changed fields.
+    BitWrite(w, snap->grenadeCount, SNAPSHOT_GRENADE_COUNT_BITS);
+    for (int i = 0; i < snap->grenadeCount; i++) WRITE_ENTITY(WriteGrenade, &snap->grenades[i], &base->grenades[i]);
+    for (int i = 0; i < MAX_KILLFEED; i++) WRITE_ENTITY(WriteKill, &snap->kills[i], &base->kills[i]);
+}
+
+bool SnapshotReadDelta(BitReader *r, const NetSnapshot *base, NetSnapshot *out) {
+    if (out != base) memcpy(out, base, sizeof(*out));
+
+    int playerCount = (int)BitRead(r, 8);
+    if (playerCount > MAX_PLAYERS) return false;
+    // Slots past the base's count were not in the base, so start them empty
+    for (int i = base->playerCount; i < playerCount; i++) memset(&out->players[i], 0, sizeof(NetPlayer));
+    for (int i = playerCount; i < MAX_PLAYERS; i++) memset(&out->players[i], 0, sizeof(NetPlayer));
+    out->playerCount = (uint8_t)playerCount;
+
+    for (int i = 0; i < playerCount; i++) READ_ENTITY(ReadPlayer, &out->players[i]);
+    for (int i = 0; i < MAX_TARGETS; i++) READ_ENTITY(ReadTarget, &out->targets[i]);
+    int grenadeCount = (int)BitRead(r, SNAPSHOT_GRENADE_COUNT_BITS);
+    if (grenadeCount > SNAPSHOT_MAX_GRENADES) return false;
+    for (int i = base->grenadeCount; i < grenadeCount; i++) memset(&out->grenades[i], 0, sizeof(NetGrenade));
+    for (int i = grenadeCount; i < SNAPSHOT_MAX_GRENADES; i++) memset(&out->grenades[i], 0, sizeof(NetGrenade));
+    out->grenadeCount = (uint8_t)grenadeCount;
+    for (int i = 0; i < grenadeCount; i++) READ_ENTITY(ReadGrenade, &out->grenades[i]);
+    for (int i = 0; i < MAX_KILLFEED; i++) READ_ENTITY(ReadKill, &out->kills[i]);
+    return !r->overflow;
+}
+
+uint32_t SnapshotHash(const NetSnapshot *snap) {
+    uint32_t hash = 2166136261u;
+    const uint8_t *bytes = (const uint8_t *)snap->players;
+    size_t size = snap->playerCount*sizeof(NetPlayer);
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i])*16777619u;
+
+    const void *parts[] = { snap->targets, snap->grenades, snap->kills };
+    size_t sizes[] = { sizeof(snap->targets), snap->grenadeCount*sizeof(NetGrenade), sizeof(snap->kills) };
+    for (int p = 0; p < 3; p++) {
+        bytes = parts[p];
+        for (size_t i = 0; i < sizes[p]; i++) hash = (hash ^ bytes[i])*16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,82 @@
+#ifndef CS2_SNAPSHOT_H
+#define CS2_SNAPSHOT_H
+
+#include "world.h"
+#include "bitstream.h"
+
+// Quantised copy of the networked part of a World. Snapshots are sent as a
+// delta against one the client has acknowledged: every entity costs one bit
+// when unchanged, otherwise one bit per field plus the new value of each
+// field that changed. Positions are kept to 1/64 m inside +-512 m.
+
+#define SNAPSHOT_POS_BITS 16
+#define SNAPSHOT_YAW_BITS 12
+#define SNAPSHOT_PITCH_BITS 10
+#define SNAPSHOT_NAME_LENGTH 31
+#define SNAPSHOT_WEAPON_BITS 5     // enough for MAX_WEAPONS
+#define SNAPSHOT_MAX_GRENADES 64   // the rest of a busy pool is not sent
+#define SNAPSHOT_GRENADE_COUNT_BITS 7
+
+enum {
+    NET_PLAYER_GROUNDED = 1,
+    NET_PLAYER_RELOADING = 2,
+    NET_PLAYER_INSPECTING = 4,
+    NET_PLAYER_MUZZLE_FLASH = 8
+};
+
+typedef struct {
+    uint8_t connected;
+    uint8_t health;     // 0..127
+    uint8_t weapon;     // SNAPSHOT_WEAPON_BITS
+    uint8_t flags;      // NET_PLAYER_*
+    uint8_t ammo;       // magazine or grenades, 0..255
+    uint8_t reserve;    // 0..255
+    uint16_t x, y, z;
+    uint16_t yaw;
+    uint16_t pitch;
+} NetPlayer;
+
+typedef struct {
+    uint8_t active;
+    uint8_t health;     // 0..127, 0 while dying
+    uint8_t hit;
+    uint16_t x, z;
+} NetTarget;
+
+typedef struct {
+    uint8_t exploding;
+    uint8_t owner;      // player index
+    uint16_t x, y, z;
+} NetGrenade;
+
+typedef struct {
+    uint8_t active;
+    uint8_t weapon;
+    uint8_t headshot;
+    uint8_t timer;      // quarter seconds left
+    char killer[SNAPSHOT_NAME_LENGTH + 1];
+    char victim[SNAPSHOT_NAME_LENGTH + 1];
+} NetKill;
+
+typedef struct {
+    uint32_t tick;
+    uint8_t playerCount;
+    NetPlayer players[MAX_PLAYERS];
+    NetTarget targets[MAX_TARGETS];
+    uint8_t grenadeCount;
+    NetGrenade grenades[SNAPSHOT_MAX_GRENADES];
+    NetKill kills[MAX_KILLFEED];
+} NetSnapshot;
+
+void SnapshotCapture(NetSnapshot *snap, const World *world);
+
+// base may be an all-zero snapshot for a full update
+void SnapshotWriteDelta(BitWriter *w, const NetSnapshot *snap, const NetSnapshot *base);
+bool SnapshotReadDelta(BitReader *r, const NetSnapshot *base, NetSnapshot *out);
+
+// Hash of the quantised state, for checking a decoded snapshot end to end
+uint32_t SnapshotHash(const NetSnapshot *snap);
+
+float SnapshotPosition(uint16_t value);
+
+#endif
@@ -0,0 +1,168 @@
+#include "staticmesh.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Outward faces over corners 0-7 (bit 0 is x, bit 1 y, bit 2 z), wound
+// counter-clockwise so back-face culling keeps working
+static const unsigned char boxIndices[36] = {
+    4, 6, 2, 4, 2, 0,   1, 3, 7, 1, 7, 5,
+    0, 1, 5, 0, 5, 4,   6, 7, 3, 6, 3, 2,
+    2, 3, 1, 2, 1, 0,   4, 5, 7, 4, 7, 6
+};
+
+// Reuses the chunk's arrays from earlier bakes when there are any
+static StaticChunk *NextChunk(StaticMesh *mesh) {
+    if (mesh->chunkCount == mesh->chunkCapacity) {
+        int capacity = mesh->chunkCapacity ? mesh->chunkCapacity*2 : 4;
+        StaticChunk *chunks = realloc(mesh->chunks, capacity*sizeof(StaticChunk));
+        if (!chunks) return NULL;
+        memset(chunks + mesh->chunkCapacity, 0, (capacity - mesh->chunkCapacity)*sizeof(StaticChunk));
+        mesh->chunks = chunks;
+        mesh->chunkCapacity = capacity;
+    }
+
+    StaticChunk *chunk = &mesh->chunks[mesh->chunkCount];
+    if (!chunk->vertices) {
+        chunk->vertices = malloc((STATIC_CHUNK_BOXES*8 + 4)*sizeof(StaticVertex));
+        chunk->indices = malloc((STATIC_CHUNK_BOXES*36 + 6)*sizeof(unsigned short));
+        if (!chunk->vertices || !chunk->indices) {
+            free(chunk->vertices);
+            free(chunk->indices);
+            chunk->vertices = NULL;
+            chunk->indices = NULL;
+            return NULL;
+        }
+    }
+    chunk->vertexCount = 0;
+    chunk->indexCount = 0;
+    chunk->bounds = (BoundingBox){ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+    mesh->chunkCount++;
+    return chunk;
+}
+
+// What DrawGrid(60, 1.0f) draws, as one quad the shader puts the lines on.
+// It sits a hair above y = 0 so it shows on the floor instead of fighting it.
+static void AddGrid(StaticChunk *chunk) {
+    float half = STATIC_GRID_SLICES*0.5f;
+    float corners[4][2] = { { -half, -half }, { -half, half }, { half, half }, { half, -half } };
+    for (int i = 0; i < 4; i++) {
+        chunk->vertices[i] = (StaticVertex){ corners[i][0], 0.01f, corners[i][1],
+                                             (Color){ 191, 191, 191, 255 }, (Color){ 127, 127, 127, 255 }, { 0, 0, 0, 1 } };
+    }
+    static const unsigned short quad[6] = { 0, 1, 2, 0, 2, 3 };
+    memcpy(chunk->indices, quad, sizeof(quad));
+    chunk->vertexCount = 4;
+    chunk->indexCount = 6;
+    chunk->bounds = (BoundingBox){ { -half, 0.0f, -half }, { half, 0.01f, half } };
+}
+
+static void AddBox(StaticChunk *chunk, const Wall *wall) {
+    Vector3 min = { wall->position.x - wall->size.x*0.5f, wall->position.y - wall->size.y*0.5f, wall->position.z - wall->size.z*0.5f };
+    StaticVertex *v = &chunk->vertices[chunk->vertexCount];
+    for (int c = 0; c < 8; c++) {
+        unsigned char x = c & 1, y = (c >> 1) & 1, z = (c >> 2) & 1;
+        v[c] = (StaticVertex){ min.x + wall->size.x*x, min.y + wall->size.y*y, min.z + wall->size.z*z,
+                               wall->color, wall->outlineColor, { x, y, z, 0 } };
+    }
+    unsigned short *out = &chunk->indices[chunk->indexCount];
+    for (int i = 0; i < 36; i++) out[i] = (unsigned short)(chunk->vertexCount + boxIndices[i]);
+    chunk->vertexCount += 8;
+    chunk->indexCount += 36;
+
+    Vector3 max = { min.x + wall->size.x, min.y + wall->size.y, min.z + wall->size.z };
+    chunk->bounds.min = (Vector3){ fminf(chunk->bounds.min.x, min.x), fminf(chunk->bounds.min.y, min.y), fminf(chunk->bounds.min.z, min.z) };
+    chunk->bounds.max = (Vector3){ fmaxf(chunk->bounds.max.x, max.x), fmaxf(chunk->bounds.max.y, max.y), fmaxf(chunk->bounds.max.z, max.z) };
+}
+
+// Spreads the low 16 bits of v over the even bits
+static uint32_t SpreadBits(uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+// Walls by the Morton code of their tile, key 0 for walls wider than a
+// tile. Four counting passes over a byte of the key each; they are stable,
+// so walls in one tile keep their map order, and the last one leaves the
+// result in the first half of the buffer.
+static bool SortWalls(StaticMesh *mesh, const Wall *walls, int count) {
+    if (count > mesh->orderCapacity) {
+        StaticSortItem *order = realloc(mesh->order, 2*(size_t)count*sizeof(StaticSortItem));
+        if (!order) return false;
+        mesh->order = order;
+        mesh->orderCapacity = count;
+    }
+
+    float minX = FLT_MAX, minZ = FLT_MAX;
+    for (int i = 0; i < count; i++) {
+        minX = fminf(minX, walls[i].position.x);
+        minZ = fminf(minZ, walls[i].position.z);
+    }
+    for (int i = 0; i < count; i++) {
+        const Wall *w = &walls[i];
+        uint32_t key = 0;
+        if (w->size.x <= STATIC_TILE_SIZE && w->size.z <= STATIC_TILE_SIZE) {
+            uint32_t x = (uint32_t)fminf((w->position.x - minX)/STATIC_TILE_SIZE, 65535.0f);
+            uint32_t z = (uint32_t)fminf((w->position.z - minZ)/STATIC_TILE_SIZE, 65535.0f);
+            key = (SpreadBits(x) | (SpreadBits(z) << 1)) + 1;
+        }
+        mesh->order[i] = (StaticSortItem){ key, i };
+    }
+
+    StaticSortItem *from = mesh->order, *to = mesh->order + count;
+    for (int shift = 0; shift < 32; shift += 8) {
+        int offsets[256] = { 0 };
+        for (int i = 0; i < count; i++) offsets[(from[i].key >> shift) & 0xFF]++;
+        for (int d = 0, total = 0; d < 256; d++) {
+            int n = offsets[d];
+            offsets[d] = total;
+            total += n;
+        }
+        for (int i = 0; i < count; i++) to[offsets[(from[i].key >> shift) & 0xFF]++] = from[i];
+        StaticSortItem *swap = from;
+        from = to;
+        to = swap;
+    }
+    return true;
+}
+
+void StaticMeshUpdate(StaticMesh *mesh, const Wall *walls, int count, uint32_t version) {
+    mesh->walls = walls;
+    mesh->wallCount = count;
+    if (mesh->version == version) return;
+    mesh->version = version;
+    mesh->uploaded = false;
+
+    mesh->chunkCount = 0;
+    if (!SortWalls(mesh, walls, count)) return;
+    StaticChunk *chunk = NextChunk(mesh);
+    if (!chunk) return;
+    AddGrid(chunk);
+    for (int i = 0; i < count; i++) {
+        if (chunk->vertexCount + 8 > STATIC_CHUNK_BOXES*8 + 4) {
+            chunk = NextChunk(mesh);
+            if (!chunk) return;
+        }
+        AddBox(chunk, &walls[mesh->order[i].wall]);
+    }
+}
+
+void StaticMeshFree(StaticMesh *mesh) {
+    for (int i = 0; i < mesh->chunkCapacity; i++) {
+        free(mesh->chunks[i].vertices);
+        free(mesh->chunks[i].indices);
+    }
+    free(mesh->chunks);
+    free(mesh->order);
+    mesh->chunks = NULL;
+    mesh->order = NULL;
+    mesh->orderCapacity = 0;
+    mesh->chunkCount = 0;
+    mesh->chunkCapacity = 0;
+    mesh->version = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef CS2_STATICMESH_H
+#define CS2_STATICMESH_H
+
+#include "raylib.h"
+#include "game.h"
+#include "cull.h"
+#include <stdint.h>
+
+// The map's walls, their outlines and the floor grid baked into a few merged
+// meshes, uploaded once and redrawn every frame without streaming anything.
+// Outlines are not lines: every vertex carries its box corner, and the
+// fragment shader colours pixels near two faces' edges with fwidth. Baking
+// (staticmesh.c) only needs Raylib's types; uploading and drawing is in
+// staticmesh_draw.c. Without OpenGL 3.3 the walls are drawn with DrawCube and
+// DrawCubeWires as before.
+
+// Walls are baked in spatial order (Morton order of STATIC_TILE_SIZE tiles),
+// so each chunk covers a small part of the map and can be culled on its own.
+// Walls wider than a tile go first, with the grid.
+#define STATIC_CHUNK_BOXES 2048
+#define STATIC_TILE_SIZE 16.0f
+#define STATIC_GRID_SLICES 60
+
+typedef struct {
+    float x, y, z;
+    Color color;
+    Color outline;
+    unsigned char corner[4];    // 0 or 1 per axis; w is 1 on the grid
+} StaticVertex;
+
+typedef struct {
+    StaticVertex *vertices;
+    unsigned short *indices;
+    int vertexCount;
+    int indexCount;
+    BoundingBox bounds;
+    unsigned int vao;
+    unsigned int vbo;
+    unsigned int ebo;
+} StaticChunk;
+
+typedef struct {
+    uint32_t key;
+    int wall;
+} StaticSortItem;
+
+typedef struct {
+    StaticChunk *chunks;
+    int chunkCount;
+    int chunkCapacity;
+    uint32_t version;           // of the walls last baked, 0 before the first
+    bool uploaded;              // false after a bake until the next draw
+    StaticSortItem *order;      // bake order, then sort scratch; twice the walls
+    int orderCapacity;
+
+    // Kept for the fallback path
+    const Wall *walls;
+    int wallCount;
+
+    Shader shader;
+    int mvpLoc;
+    int attribLocs[4];          // position, colour, outline, corner
+    bool gpu;
+} StaticMesh;
+
+// Rebakes only if version differs from the last bake (see World.wallVersion)
+void StaticMeshUpdate(StaticMesh *mesh, const Wall *walls, int count, uint32_t version);
+// Frees what baking allocated; StaticMeshUnload also frees the GL side
+void StaticMeshFree(StaticMesh *mesh);
+
+// Needs a GL context, so call it after InitWindow
+void StaticMeshInit(StaticMesh *mesh);
+void StaticMeshUnload(StaticMesh *mesh);
+// Call inside BeginMode3D; one draw per chunk that cull lets through (all of
+// them when cull is NULL)
+void StaticMeshDraw(StaticMesh *mesh, Culler *cull);
+
+#endif
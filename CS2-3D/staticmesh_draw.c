@@ -0,0 +1,138 @@
+#include "staticmesh.h"
+#include "raymath.h"
+#include <rlgl.h>
+#include <stddef.h>
+
+static const char *staticVertexShader =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec4 vertexColor;\n"
+    "in vec4 vertexOutline;\n"
+    "in vec4 vertexCorner;\n"
+    "uniform mat4 mvp;\n"
+    "out vec3 fragPosition;\n"
+    "out vec4 fragColor;\n"
+    "out vec4 fragOutline;\n"
+    "out vec4 fragCorner;\n"
+    "void main()\n"
+    "{\n"
+    "    fragPosition = vertexPosition;\n"
+    "    fragColor = vertexColor;\n"
+    "    fragOutline = vertexOutline;\n"
+    "    fragCorner = vertexCorner;\n"
+    "    gl_Position = mvp*vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+// Distances are in pixels. On a box face one corner coordinate is constant
+// (distance 0), so the pixel is on an edge when the second smallest is under
+// one pixel. On the grid, x and z close to a whole number are lines, and the
+// two through the origin take the outline colour.
+static const char *staticFragmentShader =
+    "#version 330\n"
+    "in vec3 fragPosition;\n"
+    "in vec4 fragColor;\n"
+    "in vec4 fragOutline;\n"
+    "in vec4 fragCorner;\n"
+    "out vec4 finalColor;\n"
+    "void main()\n"
+    "{\n"
+    "    if (fragCorner.w > 0.5) {\n"
+    "        vec2 p = fragPosition.xz;\n"
+    "        vec2 d = abs(fract(p + 0.5) - 0.5)/max(fwidth(p), vec2(1e-6));\n"
+    "        if (min(d.x, d.y) > 0.5) discard;\n"
+    "        bool axis = (d.x <= 0.5 && abs(p.x) < 0.5) || (d.y <= 0.5 && abs(p.y) < 0.5);\n"
+    "        finalColor = axis ? fragOutline : fragColor;\n"
+    "        return;\n"
+    "    }\n"
+    "    vec3 c = fragCorner.xyz;\n"
+    "    vec3 d = min(c, 1.0 - c)/max(fwidth(c), vec3(1e-6));\n"
+    "    float edge = d.x + d.y + d.z - min(d.x, min(d.y, d.z)) - max(d.x, max(d.y, d.z));\n"
+    "    finalColor = edge < 1.0 ? fragOutline : fragColor;\n"
+    "}\n";
+
+void StaticMeshInit(StaticMesh *mesh) {
+    *mesh = (StaticMesh){ 0 };
+
+    int version = rlGetVersion();
+    if (version != RL_OPENGL_33 && version != RL_OPENGL_43) return;
+
+    Shader shader = LoadShaderFromMemory(staticVertexShader, staticFragmentShader);
+    if (shader.id == 0 || shader.id == rlGetShaderIdDefault()) return;
+
+    static const char *attribs[4] = { "vertexPosition", "vertexColor", "vertexOutline", "vertexCorner" };
+    for (int i = 0; i < 4; i++) {
+        mesh->attribLocs[i] = GetShaderLocationAttrib(shader, attribs[i]);
+        if (mesh->attribLocs[i] < 0) {
+            UnloadShader(shader);
+            return;
+        }
+    }
+    mesh->mvpLoc = GetShaderLocation(shader, "mvp");
+    mesh->shader = shader;
+    mesh->gpu = true;
+}
+
+static void UnloadChunk(StaticChunk *chunk) {
+    if (!chunk->vao) return;
+    rlUnloadVertexArray(chunk->vao);
+    rlUnloadVertexBuffer(chunk->vbo);
+    rlUnloadVertexBuffer(chunk->ebo);
+    chunk->vao = chunk->vbo = chunk->ebo = 0;
+}
+
+static void UploadChunk(const StaticMesh *mesh, StaticChunk *chunk) {
+    static const int components[4] = { 3, 4, 4, 4 };
+    static const int types[4] = { RL_FLOAT, RL_UNSIGNED_BYTE, RL_UNSIGNED_BYTE, RL_UNSIGNED_BYTE };
+    static const bool normalized[4] = { false, true, true, false };
+    static const size_t offsets[4] = { offsetof(StaticVertex, x), offsetof(StaticVertex, color),
+                                       offsetof(StaticVertex, outline), offsetof(StaticVertex, corner) };
+
+    chunk->vao = rlLoadVertexArray();
+    rlEnableVertexArray(chunk->vao);
+    chunk->vbo = rlLoadVertexBuffer(chunk->vertices, chunk->vertexCount*sizeof(StaticVertex), false);
+    for (int i = 0; i < 4; i++) {
+        rlSetVertexAttribute(mesh->attribLocs[i], components[i], types[i], normalized[i], sizeof(StaticVertex), (const void *)offsets[i]);
+        rlEnableVertexAttribute(mesh->attribLocs[i]);
+    }
+    chunk->ebo = rlLoadVertexBufferElement(chunk->indices, chunk->indexCount*sizeof(unsigned short), false);
+    rlDisableVertexArray();
+}
+
+void StaticMeshUnload(StaticMesh *mesh) {
+    for (int i = 0; i < mesh->chunkCapacity; i++) UnloadChunk(&mesh->chunks[i]);
+    if (mesh->gpu) UnloadShader(mesh->shader);
+    StaticMeshFree(mesh);
+    *mesh = (StaticMesh){ 0 };
+}
+
+void StaticMeshDraw(StaticMesh *mesh, Culler *cull) {
+    if (!mesh->gpu) {
+        DrawGrid(STATIC_GRID_SLICES, 1.0f);
+        for (int i = 0; i < mesh->wallCount; i++) {
+            const Wall *wall = &mesh->walls[i];
+            BoundingBox box = { Vector3Subtract(wall->position, Vector3Scale(wall->size, 0.5f)), Vector3Add(wall->position, Vector3Scale(wall->size, 0.5f)) };
+            if (cull && !CullBox(cull, box, CULL_WALLS)) continue;
+            DrawCube(wall->position, wall->size.x, wall->size.y, wall->size.z, wall->color);
+            DrawCubeWires(wall->position, wall->size.x, wall->size.y, wall->size.z, wall->outlineColor);
+        }
+        return;
+    }
+
+    if (!mesh->uploaded) {
+        for (int i = 0; i < mesh->chunkCapacity; i++) UnloadChunk(&mesh->chunks[i]);
+        for (int i = 0; i < mesh->chunkCount; i++) UploadChunk(mesh, &mesh->chunks[i]);
+        mesh->uploaded = true;
+    }
+
+    // Flush pending immediate-mode geometry first so draw order is kept
+    rlDrawRenderBatchActive();
+    rlEnableShader(mesh->shader.id);
+    rlSetUniformMatrix(mesh->mvpLoc, MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+    for (int i = 0; i < mesh->chunkCount; i++) {
+        if (cull && !CullBox(cull, mesh->chunks[i].bounds, CULL_WALLS)) continue;
+        rlEnableVertexArray(mesh->chunks[i].vao);
+        rlDrawVertexArrayElements(0, mesh->chunks[i].indexCount, 0);
+    }
+    rlDisableVertexArray();
+    rlDisableShader();
+}
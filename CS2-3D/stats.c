@@ -0,0 +1,198 @@
+#include "stats.h"
+#include "world.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+struct StatsPipeline {
+    EventRing ring;
+    pthread_t thread;
+    atomic_bool stopping;
+    FILE *file;
+
+    // Only the thread touches pending; totals are shared under lock
+    WeaponStats pending[MAX_WEAPONS];
+    uint32_t pendingTick;   // of the newest event in pending
+    uint32_t flushTick;     // of the oldest
+    pthread_mutex_t lock;
+    WeaponStats totals[MAX_WEAPONS];
+    WeaponStats botTotals[MAX_WEAPONS];
+    atomic_uint_least64_t counted;  // events taken from the ring and folded in
+};
+
+static void Nap(void) {
+#ifdef _WIN32
+    Sleep(1);
+#else
+    struct timespec pause = { 0, 1000000 };
+    nanosleep(&pause, NULL);
+#endif
+}
+
+static void Count(WeaponStats *stats, const GameEvent *event) {
+    switch (event->type) {
+    case EVENT_SHOT: stats->shots++; break;
+    case EVENT_HIT:
+        stats->hits++;
+        stats->headshots += event->headshot;
+        stats->damage += event->damage;
+        break;
+    case EVENT_KILL: stats->kills++; break;
+    case EVENT_GRENADE_DAMAGE:
+        stats->blastHits++;
+        stats->damage += event->damage;
+        break;
+    }
+}
+
+static void AddStats(WeaponStats *to, const WeaponStats *from) {
+    to->shots += from->shots;
+    to->hits += from->hits;
+    to->headshots += from->headshots;
+    to->kills += from->kills;
+    to->blastHits += from->blastHits;
+    to->damage += from->damage;
+}
+
+static void Flush(StatsPipeline *stats) {
+    StatsRecord records[MAX_WEAPONS];
+    int count = 0;
+    for (int w = 0; w < MAX_WEAPONS; w++) {
+        const WeaponStats *s = &stats->pending[w];
+        if (s->shots + s->hits + s->kills + s->blastHits == 0) continue;
+        records[count++] = (StatsRecord){ stats->pendingTick, (uint32_t)w, (uint32_t)s->shots, (uint32_t)s->hits,
+                                          (uint32_t)s->headshots, (uint32_t)s->kills, (uint32_t)s->blastHits, (uint32_t)s->damage };
+    }
+    memset(stats->pending, 0, sizeof(stats->pending));
+    if (count == 0 || !stats->file) return;
+    fwrite(records, sizeof(StatsRecord), count, stats->file);
+    fflush(stats->file);
+}
+
+// Takes events a batch at a time; the lock is only held to fold a batch in
+static void *StatsThread(void *arg) {
+    StatsPipeline *stats = arg;
+    GameEvent batch[STATS_BATCH];
+    WeaponStats added[MAX_WEAPONS], botAdded[MAX_WEAPONS];
+    for (;;) {
+        bool stopping = atomic_load(&stats->stopping);
+        int count = EventRingPop(&stats->ring, batch, STATS_BATCH);
+        if (count == 0) {
+            if (stopping) break;
+            Nap();
+            continue;
+        }
+
+        memset(added, 0, sizeof(added));
+        memset(botAdded, 0, sizeof(botAdded));
+        for (int i = 0; i < count; i++) {
+            const GameEvent *event = &batch[i];
+            if (event->weapon >= MAX_WEAPONS) continue;
+            if (event->actor == WORLD_NAME_ENEMY) {
+                Count(&botAdded[event->weapon], event);
+                continue;
+            }
+            if (event->tick - stats->flushTick >= STATS_FLUSH_TICKS) {
+                Flush(stats);
+                stats->flushTick = event->tick;
+            }
+            Count(&added[event->weapon], event);
+            Count(&stats->pending[event->weapon], event);
+            stats->pendingTick = event->tick;
+        }
+        pthread_mutex_lock(&stats->lock);
+        for (int w = 0; w < MAX_WEAPONS; w++) {
+            AddStats(&stats->totals[w], &added[w]);
+            AddStats(&stats->botTotals[w], &botAdded[w]);
+        }
+        pthread_mutex_unlock(&stats->lock);
+        atomic_fetch_add(&stats->counted, (uint64_t)count);
+    }
+    Flush(stats);
+    return NULL;
+}
+
+StatsPipeline *StatsStart(const char *path) {
+    StatsPipeline *stats = calloc(1, sizeof(StatsPipeline));
+    if (!stats) return NULL;
+    EventRingInit(&stats->ring);
+    atomic_init(&stats->stopping, false);
+    atomic_init(&stats->counted, 0);
+
+    if (path) {
+        stats->file = fopen(path, "ab");
+        if (!stats->file) {
+            free(stats);
+            return NULL;
+        }
+        fseek(stats->file, 0, SEEK_END);
+        if (ftell(stats->file) == 0) {
+            StatsFileHeader header = { STATS_FILE_MAGIC, STATS_FILE_VERSION, (uint16_t)sizeof(StatsRecord) };
+            fwrite(&header, sizeof(header), 1, stats->file);
+        }
+    }
+    pthread_mutex_init(&stats->lock, NULL);
+    if (pthread_create(&stats->thread, NULL, StatsThread, stats) != 0) {
+        pthread_mutex_destroy(&stats->lock);
+        if (stats->file) fclose(stats->file);
+        free(stats);
+        return NULL;
+    }
+    return stats;
+}
+
+void StatsStop(StatsPipeline *stats) {
+    if (!stats) return;
+    atomic_store(&stats->stopping, true);
+    pthread_join(stats->thread, NULL);
+    pthread_mutex_destroy(&stats->lock);
+    if (stats->file) fclose(stats->file);
+    free(stats);
+}
+
+EventRing *StatsEvents(StatsPipeline *stats) {
+    return &stats->ring;
+}
+
+void StatsWait(StatsPipeline *stats) {
+    uint64_t pushed = atomic_load(&stats->ring.head);
+    while (atomic_load(&stats->counted) < pushed) Nap();
+}
+
+bool StatsRead(StatsPipeline *stats, WeaponStats out[MAX_WEAPONS], WeaponStats bots[MAX_WEAPONS]) {
+    if (pthread_mutex_trylock(&stats->lock) != 0) return false;
+    memcpy(out, stats->totals, sizeof(stats->totals));
+    if (bots) memcpy(bots, stats->botTotals, sizeof(stats->botTotals));
+    pthread_mutex_unlock(&stats->lock);
+    return true;
+}
+
+bool StatsFileLoad(const char *path, WeaponStats out[MAX_WEAPONS], long long *records) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    StatsFileHeader header;
+    bool valid = fread(&header, sizeof(header), 1, file) == 1 && header.magic == STATS_FILE_MAGIC &&
+                 header.version == STATS_FILE_VERSION && header.recordSize == sizeof(StatsRecord);
+    memset(out, 0, MAX_WEAPONS*sizeof(WeaponStats));
+    *records = 0;
+    StatsRecord record;
+    while (valid && fread(&record, sizeof(record), 1, file) == 1) {
+        if (record.weapon >= MAX_WEAPONS) continue;
+        WeaponStats *s = &out[record.weapon];
+        s->shots += record.shots;
+        s->hits += record.hits;
+        s->headshots += record.headshots;
+        s->kills += record.kills;
+        s->blastHits += record.blastHits;
+        s->damage += record.damage;
+        (*records)++;
+    }
+    fclose(file);
+    return valid;
+}
@@ -0,0 +1,68 @@
+#ifndef CS2_STATS_H
+#define CS2_STATS_H
+
+#include "events.h"
+
+// Per-weapon accuracy of the players, added up from the event stream on a
+// thread of its own. Bots' events (actor WORLD_NAME_ENEMY) are added up
+// apart, so they do not drown the players' numbers, and are not written.
+// The game hands it events through an EventRing (World.events) and never
+// waits for it. Every STATS_FLUSH_TICKS game ticks the thread appends one
+// record per weapon used since the last flush to the stats file, so the
+// file only grows and can be summed at any time.
+//
+// The file is a StatsFileHeader and then StatsRecords, in the byte order of
+// the machine that wrote them.
+
+#define STATS_FLUSH_TICKS 64
+#define STATS_BATCH 512
+#define STATS_FILE_MAGIC 0x53545343u   // "CSTS" in little-endian
+#define STATS_FILE_VERSION 1
+
+typedef struct {
+    long long shots;
+    long long hits;
+    long long headshots;
+    long long kills;
+    long long blastHits;    // targets caught by grenades
+    long long damage;
+} WeaponStats;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+} StatsFileHeader;
+
+// What a weapon did since its previous record
+typedef struct {
+    uint32_t tick;          // of the newest event counted
+    uint32_t weapon;
+    uint32_t shots;
+    uint32_t hits;
+    uint32_t headshots;
+    uint32_t kills;
+    uint32_t blastHits;
+    uint32_t damage;
+} StatsRecord;
+
+typedef struct StatsPipeline StatsPipeline;
+
+// Starts the thread, appending to path (NULL keeps the totals only). NULL if
+// the file cannot be opened or the thread started.
+StatsPipeline *StatsStart(const char *path);
+// Takes the events still in the ring, writes the last records and joins
+void StatsStop(StatsPipeline *stats);
+EventRing *StatsEvents(StatsPipeline *stats);
+
+// Returns once every event pushed so far is in the totals
+void StatsWait(StatsPipeline *stats);
+// Copies the players' totals so far, and the bots' unless bots is NULL,
+// unless the thread is adding to them right now: then it returns false at
+// once and both are left alone
+bool StatsRead(StatsPipeline *stats, WeaponStats out[MAX_WEAPONS], WeaponStats bots[MAX_WEAPONS]);
+
+// Sums every record in a stats file; false if it is not one
+bool StatsFileLoad(const char *path, WeaponStats out[MAX_WEAPONS], long long *records);
+
+#endif
@@ -0,0 +1,150 @@
+#include "weapons.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const WeaponDef builtinWeapons[] = {
+    { FIRE_HITSCAN, true,  WPN_RIFLE,   35, 4.0f, 0.10f, 0.05f, 1000.0f, 30,  90, 2.0f,  0.20f, 2.0f, 0.05f,  0.0f, 0.0f, { 76, 63, 47, 255 },   "AK", "rifle" },
+    { FIRE_HITSCAN, false, WPN_PISTOL,  25, 4.0f, 0.15f, 0.02f, 1000.0f, 20, 120, 1.5f,  0.15f, 1.5f, 0.05f,  0.0f, 0.0f, { 130, 130, 130, 255 }, "GL", "pistol" },
+    { FIRE_MELEE,   false, WPN_KNIFE,   55, 4.0f, 0.50f, 0.00f,    3.5f,  0,   0, 0.0f, -0.50f, 0.0f, 0.00f,  0.0f, 0.0f, { 190, 33, 55, 255 },   "KN", "knife" },
+    { FIRE_THROWN,  false, WPN_GRENADE, 80, 1.0f, 1.00f, 0.00f,    8.0f,  3,   0, 0.0f,  0.00f, 0.0f, 0.00f, 20.0f, 2.0f, { 0, 117, 44, 255 },    "HE", "grenade" },
+};
+
+void WeaponTableDefaults(WeaponTable *table) {
+    memset(table, 0, sizeof(*table));
+    table->count = (int)(sizeof(builtinWeapons)/sizeof(builtinWeapons[0]));
+    memcpy(table->defs, builtinWeapons, sizeof(builtinWeapons));
+}
+
+static int Lookup(const char *word, const char *const *names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(word, names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+static bool ParseLine(const char *line, WeaponDef *def, char *error, int errorSize) {
+    static const char *const modes[] = { "hitscan", "melee", "thrown" };
+    static const char *const models[] = { "rifle", "pistol", "knife", "grenade" };
+
+    char name[64], shortName[64], model[64], mode[64], color[64];
+    int automatic;
+    int fields = sscanf(line, "%63s %63s %63s %63s %d %d %f %f %f %f %d %d %f %f %f %f %f %f %63s",
+                        name, shortName, model, mode, &automatic, &def->damage, &def->headshot, &def->cooldown,
+                        &def->spread, &def->range, &def->magazine, &def->reserve, &def->reloadTime,
+                        &def->recoil, &def->kick, &def->flash, &def->speed, &def->fuse, color);
+    if (fields != 19) {
+        snprintf(error, errorSize, "expected 19 columns, found %d", fields);
+        return false;
+    }
+
+    int modeIndex = Lookup(mode, modes, 3);
+    int modelIndex = Lookup(model, models, 4);
+    if (modeIndex < 0) {
+        snprintf(error, errorSize, "unknown fire mode '%s'", mode);
+        return false;
+    }
+    if (modelIndex < 0) {
+        snprintf(error, errorSize, "unknown model '%s'", model);
+        return false;
+    }
+    if (def->magazine < 0 || def->reserve < 0 || def->cooldown <= 0.0f || def->range <= 0.0f) {
+        snprintf(error, errorSize, "negative ammo or non-positive cooldown/range");
+        return false;
+    }
+
+    if (strlen(name) >= sizeof(def->name) || strlen(shortName) >= sizeof(def->shortName)) {
+        snprintf(error, errorSize, "name longer than %d or short name longer than %d characters",
+                 (int)sizeof(def->name) - 1, (int)sizeof(def->shortName) - 1);
+        return false;
+    }
+
+    char *end;
+    unsigned long rgb = strtoul(color[0] == '#' ? color + 1 : color, &end, 16);
+    if (*end != '\0') {
+        snprintf(error, errorSize, "bad color '%s'", color);
+        return false;
+    }
+
+    def->mode = (unsigned char)modeIndex;
+    def->model = (unsigned char)modelIndex;
+    def->automatic = automatic != 0;
+    def->color = (Color){ (unsigned char)(rgb >> 16), (unsigned char)(rgb >> 8), (unsigned char)rgb, 255 };
+    memcpy(def->shortName, shortName, strlen(shortName) + 1);
+    memcpy(def->name, name, strlen(name) + 1);
+    return true;
+}
+
+// Changes whenever the file is saved. Whole seconds alone miss a second save
+// within the same second, so the size and, where stat has them (st_mtime is
+// then a macro for st_mtim.tv_sec), the nanoseconds go in too.
+static uint64_t FileStamp(const char *path) {
+    struct stat info;
+    if (stat(path, &info) != 0) return 0;
+    uint64_t stamp = (uint64_t)info.st_mtime*1000003u ^ (uint64_t)info.st_size;
+#ifdef st_mtime
+    stamp = stamp*1000003u ^ (uint64_t)info.st_mtim.tv_nsec;
+#endif
+    return stamp ? stamp : 1;
+}
+
+bool WeaponTableLoad(WeaponTable *table, const char *path, char *error, int errorSize) {
+    char scratch[128];
+    if (!error) {
+        error = scratch;
+        errorSize = (int)sizeof(scratch);
+    }
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        snprintf(error, errorSize, "%s: cannot open", path);
+        return false;
+    }
+
+    // Parsed into a copy so a half-edited file never reaches the game
+    WeaponTable loaded = { 0 };
+
+    char line[512];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        lineNumber++;
+        char *start = line + strspn(line, " \t\r\n");
+        if (*start == '\0' || *start == '#') continue;
+
+        if (loaded.count == MAX_WEAPONS) {
+            snprintf(error, errorSize, "%s:%d: more than %d weapons", path, lineNumber, MAX_WEAPONS);
+            ok = false;
+            break;
+        }
+        char reason[96];
+        if (!ParseLine(start, &loaded.defs[loaded.count], reason, sizeof(reason))) {
+            snprintf(error, errorSize, "%s:%d: %s", path, lineNumber, reason);
+            ok = false;
+            break;
+        }
+        loaded.count++;
+    }
+    fclose(file);
+
+    if (ok && loaded.count == 0) {
+        snprintf(error, errorSize, "%s: no weapons", path);
+        ok = false;
+    }
+    if (!ok) return false;
+
+    loaded.stamp = FileStamp(path);
+    *table = loaded;
+    return true;
+}
+
+bool WeaponTableReload(WeaponTable *table, const char *path, char *error, int errorSize) {
+    uint64_t stamp = FileStamp(path);
+    if (stamp == 0 || stamp == table->stamp) return false;
+    if (WeaponTableLoad(table, path, error, errorSize)) return true;
+
+    // Remember the broken version so it is not parsed again every frame
+    table->stamp = stamp;
+    return false;
+}
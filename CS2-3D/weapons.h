@@ -0,0 +1,57 @@
+#ifndef CS2_WEAPONS_H
+#define CS2_WEAPONS_H
+
+#include "game.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Weapon stats as one flat array indexed by weapon number, so firing and
+// reloading read a row instead of branching on the weapon. The built-in rows
+// are the original four weapons (in WeaponType order); weapons.txt can change
+// them or add more, one weapon per line, and is reloaded when it changes.
+
+typedef enum {
+    FIRE_HITSCAN,
+    FIRE_MELEE,
+    FIRE_THROWN
+} FireMode;
+
+typedef struct {
+    unsigned char mode;     // FireMode
+    bool automatic;         // fires while held instead of once per press
+    unsigned char model;    // WeaponType whose view model is drawn
+    int damage;
+    float headshot;         // damage multiplier
+    float cooldown;         // seconds between shots
+    float spread;
+    float range;            // blast radius for thrown weapons
+    int magazine;           // 0 for weapons that never run out
+    int reserve;            // starting spare rounds
+    float reloadTime;
+    float recoil;           // view model kick
+    float kick;             // view pitch kick
+    float flash;            // muzzle flash time
+    float speed;            // throw speed
+    float fuse;             // seconds until a thrown weapon goes off
+    Color color;            // kill feed icon
+    char shortName[4];
+    char name[16];
+} WeaponDef;
+
+typedef struct {
+    WeaponDef defs[MAX_WEAPONS];
+    int count;
+    uint64_t stamp;         // FileStamp of the last load, 0 for built-ins
+} WeaponTable;
+
+void WeaponTableDefaults(WeaponTable *table);
+
+// Parses the whole file into table only if every line is valid. On failure
+// table is untouched and error (if given) says what was wrong.
+bool WeaponTableLoad(WeaponTable *table, const char *path, char *error, int errorSize);
+
+// Loads path if its modification time differs from the last load. Returns
+// true when the table changed.
+bool WeaponTableReload(WeaponTable *table, const char *path, char *error, int errorSize);
+
+#endif
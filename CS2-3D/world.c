@@ -0,0 +1,754 @@
+#include "world.h"
+#include "hitscan.h"
+#include "collide.h"
+#include "projectiles.h"
+#include "../common/profile.h"
+#include "raymath.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PITCH_LIMIT (89.0f*DEG2RAD)
+
+// Collision boxes. The player's runs from the feet to just above the eye.
+#define PLAYER_HALF_WIDTH 0.3f
+#define PLAYER_HALF_HEIGHT ((PLAYER_EYE_HEIGHT + 0.1f)*0.5f)
+#define NADE_HALF_SIZE 0.2f
+
+int WorldRandomValue(World *world, int min, int max) {
+    if (min > max) {
+        int tmp = max;
+        max = min;
+        min = tmp;
+    }
+    // xorshift64*
+    world->rng ^= world->rng >> 12;
+    world->rng ^= world->rng << 25;
+    world->rng ^= world->rng >> 27;
+    uint32_t value = (uint32_t)((world->rng*0x2545F4914F6CDD1Dull) >> 32);
+    return min + (int)(value % (uint32_t)(max - min + 1));
+}
+
+Vector3 ViewDirection(float yaw, float pitch) {
+    return (Vector3){ -sinf(yaw)*cosf(pitch), sinf(pitch), cosf(yaw)*cosf(pitch) };
+}
+
+static void SpawnParticle(World *world, Vector3 pos, Vector3 vel, Color col, float size, float life, ParticleType type) {
+    ParticlePoolSpawn(&world->particles, pos, vel, col, size, life, type);
+}
+
+void WorldEmit(World *world, GameEventType type, uint16_t actor, uint16_t subject, WeaponType weapon, int damage, bool headshot) {
+    GameEvent event = { (uint32_t)world->tick, (uint8_t)type, (uint8_t)weapon, headshot, 0, actor, subject, damage };
+    KillFeedObserve(&world->killFeed, &event);
+    if (world->events) EventRingPush(world->events, &event);
+}
+
+// Whoever is in the slot now, for players who may have left since
+static uint16_t PlayerName(const World *world, int player) {
+    return (player >= 0 && world->players[player].connected) ? world->playerNames[player] : WORLD_NAME_PLAYER;
+}
+
+// Same as ColorBrightness with a negative factor, without needing Raylib
+static Color Darken(Color col, float amount) {
+    float factor = 1.0f - amount;
+    return (Color){ (unsigned char)(col.r*factor), (unsigned char)(col.g*factor), (unsigned char)(col.b*factor), col.a };
+}
+
+void WorldAddWall(World *world, Vector3 pos, Vector3 size, Color col) {
+    if (world->wallCount >= world->wallCapacity) {
+        int capacity = world->wallCapacity ? world->wallCapacity*2 : 64;
+        while (capacity <= world->wallCount) capacity *= 2;
+        Wall *walls = realloc(world->wallStorage, capacity*sizeof(Wall));
+        if (!walls) return;
+        world->wallStorage = walls;
+        world->wallCapacity = capacity;
+    }
+    // Adding to a loaded map copies its walls out of the read-only file first
+    if (world->walls != world->wallStorage) {
+        if (world->wallCount > 0) memcpy(world->wallStorage, world->walls, world->wallCount*sizeof(Wall));
+        world->walls = world->wallStorage;
+    }
+    Wall *wall = &world->wallStorage[world->wallCount++];
+    wall->position = pos;
+    wall->size = size;
+    wall->color = col;
+    wall->outlineColor = Darken(col, 0.3f);
+    world->wallBvhDirty = true;
+    world->wallVersion++;
+}
+
+// Stays dirty if out of memory, so the next shot tries again
+static void RebuildWallBvh(World *world) {
+    BoundingBox *boxes = malloc((world->wallCount > 0 ? world->wallCount : 1)*sizeof(BoundingBox));
+    if (!boxes) return;
+    for (int i = 0; i < world->wallCount; i++) {
+        const Wall *wall = &world->walls[i];
+        boxes[i] = (BoundingBox){
+            Vector3Subtract(wall->position, Vector3Scale(wall->size, 0.5f)),
+            Vector3Add(wall->position, Vector3Scale(wall->size, 0.5f))
+        };
+    }
+    bool built = BvhBuild(&world->wallBvh, boxes, world->wallCount);
+    free(boxes);
+    if (built) world->wallBvhDirty = false;
+}
+
+// The map the game has always had
+static void AddDefaultWalls(World *world) {
+    WorldAddWall(world, (Vector3){0, -0.5f, 0}, (Vector3){60, 1, 60}, (Color){80, 80, 80, 255});
+
+    WorldAddWall(world, (Vector3){-15, 2.5f, 15}, (Vector3){10, 6, 1}, DARKGRAY);
+    WorldAddWall(world, (Vector3){15, 2.5f, -15}, (Vector3){10, 6, 1}, DARKGRAY);
+
+    WorldAddWall(world, (Vector3){-5, 1, 5}, (Vector3){2, 2, 2}, ORANGE);
+    WorldAddWall(world, (Vector3){5, 1.5f, -5}, (Vector3){3, 3, 3}, BEIGE);
+    WorldAddWall(world, (Vector3){0, 1, 10}, (Vector3){2, 2, 6}, BROWN);
+}
+
+// Bakes the nav grid again once the walls have changed; nothing walks it
+// without bots. Out of memory the grid stays empty and the bots stand
+// still until the next reset tries again.
+static void UpdateNav(World *world) {
+    if (world->botCount == 0 || (world->nav.blocked && world->navVersion == world->wallVersion)) return;
+    if (NavGridBuild(&world->nav, world->walls, world->wallCount)) world->navVersion = world->wallVersion;
+}
+
+void WorldReset(World *world) {
+    const Wall *oldWalls = world->walls;
+    int oldCount = world->wallCount;
+    world->walls = world->wallStorage;
+    world->wallCount = 0;
+
+    if (world->map) {
+        // The map's BVH is used in place; BvhFree leaves a non-owned tree alone
+        BvhFree(&world->wallBvh);
+        world->walls = world->map->walls;
+        world->wallCount = world->map->wallCount;
+        world->wallBvh = world->map->bvh;
+        world->wallBvhDirty = false;
+        // Same map as before: what was baked from it still holds
+        if (world->walls != oldWalls || world->wallCount != oldCount) world->wallVersion++;
+    } else {
+        AddDefaultWalls(world);
+        RebuildWallBvh(world);
+    }
+
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        Target *t = &world->targets[i];
+        *t = (Target){ .id = i + 1 };
+        world->bots[i] = (BotBrain){ .enemy = -1 };
+        if (i >= world->botCount) continue;
+        t->position = (Vector3){ (float)WorldRandomValue(world, -20, 20), 0.0f, (float)WorldRandomValue(world, -20, 20) };
+        t->active = true;
+        t->health = 100;
+        world->bots[i].yaw = (float)WorldRandomValue(world, -180, 180)*DEG2RAD;
+    }
+    for (int i = 0; i < MAX_TARGETS; i++) world->prevTarget[i] = world->targets[i].position;
+    world->targetGridDirty = true;
+    UpdateNav(world);
+
+    LagHistoryClear(&world->lagHistory);
+
+    ParticlePoolClear(&world->particles);
+    ProjectilePoolClear(&world->projectiles);
+    world->killFeed.count = 0;
+}
+
+// A loaded map's spawn points are handed out in turn. Otherwise the first
+// player starts where the single-player game always did and the rest are
+// spread around the edge of the map facing the middle.
+static void PlacePlayer(World *world, int index) {
+    Player *p = &world->players[index];
+    if (world->map && world->map->spawnCount > 0) {
+        const MapSpawn *spawn = &world->map->spawns[index % world->map->spawnCount];
+        p->position = (Vector3){ spawn->position.x, spawn->position.y + PLAYER_EYE_HEIGHT, spawn->position.z };
+        p->yaw = spawn->yaw;
+    } else if (index == 0) {
+        p->position = (Vector3){ 0.0f, PLAYER_EYE_HEIGHT, -10.0f };
+    } else {
+        float angle = (float)index * 2.39996f;
+        p->position = (Vector3){ 25.0f*sinf(angle), PLAYER_EYE_HEIGHT, 25.0f*cosf(angle) };
+        p->yaw = atan2f(p->position.x, -p->position.z);
+    }
+    p->pitch = 0.0f;
+    p->velocity = (Vector3){ 0 };
+    world->prevEye[index] = p->position;
+}
+
+int WorldAddPlayer(World *world, const char *name) {
+    int index = 0;
+    while (index < MAX_PLAYERS && world->players[index].connected) index++;
+    if (index == MAX_PLAYERS) return -1;
+
+    Player *p = &world->players[index];
+    memset(p, 0, sizeof(*p));
+    strncpy(p->name, name, sizeof(p->name) - 1);
+    p->connected = true;
+    world->playerNames[index] = NameIntern(&world->names, p->name);
+    PlacePlayer(world, index);
+    for (int w = 0; w < world->weapons.count; w++) {
+        p->ammo[w] = world->weapons.defs[w].magazine;
+        p->reserve[w] = world->weapons.defs[w].reserve;
+    }
+    p->health = 100;
+    p->weapon = WPN_RIFLE;
+    p->lastWeapon = WPN_RIFLE;
+    p->equipTimer = 1.0f;
+
+    if (index >= world->playerCount) world->playerCount = index + 1;
+    return index;
+}
+
+void WorldRemovePlayer(World *world, int index) {
+    world->players[index].connected = false;
+    while (world->playerCount > 0 && !world->players[world->playerCount - 1].connected) world->playerCount--;
+}
+
+void WorldInit(World *world, uint64_t seed) {
+    memset(world, 0, sizeof(*world));
+    world->rng = seed*0x9E3779B97F4A7C15ull + 1;
+    ParticlePoolInit(&world->particles, MAX_PARTICLES);
+    ProjectilePoolInit(&world->projectiles, MAX_PROJECTILES);
+    WeaponTableDefaults(&world->weapons);
+    NameIntern(&world->names, "Enemy");
+    NameIntern(&world->names, "Player");
+    world->botCount = WORLD_DEFAULT_BOTS;
+    WorldReset(world);
+}
+
+void WorldSetBots(World *world, int count) {
+    world->botCount = (count < 0) ? 0 : (count > MAX_TARGETS) ? MAX_TARGETS : count;
+    WorldReset(world);
+}
+
+void WorldSetMap(World *world, const MapFile *map) {
+    world->map = map;
+    WorldReset(world);
+}
+
+void WorldSetWeapons(World *world, const WeaponTable *weapons) {
+    int oldCount = world->weapons.count;
+    world->weapons = *weapons;
+
+    for (int i = 0; i < world->playerCount; i++) {
+        Player *p = &world->players[i];
+        for (int w = oldCount; w < weapons->count; w++) {
+            p->ammo[w] = weapons->defs[w].magazine;
+            p->reserve[w] = weapons->defs[w].reserve;
+        }
+        // A shorter table can drop the weapon in hand
+        if ((int)p->weapon >= weapons->count) p->weapon = WPN_RIFLE;
+        if ((int)p->lastWeapon >= weapons->count) p->lastWeapon = WPN_RIFLE;
+    }
+}
+
+void WorldFree(World *world) {
+    free(world->wallStorage);
+    BvhFree(&world->wallBvh);
+    NavGridFree(&world->nav);
+    TargetGridFree(&world->targetGrid);
+    ParticlePoolFree(&world->particles);
+    ProjectilePoolFree(&world->projectiles);
+    memset(world, 0, sizeof(*world));
+}
+
+static void DamageTarget(World *world, int index, int attacker, int damage, WeaponType weapon, bool headshot) {
+    Target *t = &world->targets[index];
+    t->health -= damage;
+    t->hitTimer = 0.2f;
+    if (t->health <= 0 && t->deathTimer == 0) {
+        t->deathTimer = 1.5f;
+        WorldEmit(world, EVENT_KILL, PlayerName(world, attacker), WORLD_NAME_ENEMY, weapon, 0, headshot);
+    }
+}
+
+// Deaths do not dirty the grid: the ray test skips dead targets itself
+static void UpdateTargetGrid(World *world) {
+    if (!world->targetGridDirty) return;
+    if (BuildTargetGrid(&world->targetGrid, world->targets, MAX_TARGETS)) world->targetGridDirty = false;
+}
+
+static void FireShot(World *world, int player, const PlayerInput *in, const WeaponDef *weapon) {
+    PROFILE_ZONE("hitscan");
+    Player *p = &world->players[player];
+    Ray ray = { p->position, ViewDirection(p->yaw, p->pitch) };
+
+    if (weapon->spread > 0.0f) {
+        ray.direction.x += ((float)WorldRandomValue(world, -100, 100)/10000.0f) * weapon->spread;
+        ray.direction.y += ((float)WorldRandomValue(world, -100, 100)/10000.0f) * weapon->spread;
+    }
+    ray.direction = Vector3Normalize(ray.direction);
+
+    if (world->wallBvhDirty) RebuildWallBvh(world);
+
+    ShotHit shot;
+    LagFrame seen;
+    if (in->viewTick != 0 && LagHistoryRewind(&world->lagHistory, in->viewTick, in->viewFraction, &seen)) {
+        shot = CastShotRewound(&world->wallBvh, &seen, ray, weapon->range);
+    } else {
+        UpdateTargetGrid(world);
+        shot = CastShot(&world->wallBvh, &world->targetGrid, world->targets, ray, weapon->range);
+    }
+
+    WorldEmit(world, EVENT_SHOT, world->playerNames[player], 0, p->weapon, 0, false);
+    if (shot.kind == SHOT_HEAD || shot.kind == SHOT_BODY) {
+        bool isHeadshot = (shot.kind == SHOT_HEAD);
+        for (int i = 0; i < 5; i++) {
+            SpawnParticle(world, shot.collision.point,
+                (Vector3){(float)WorldRandomValue(world, -10,10)*0.1f, (float)WorldRandomValue(world, 0,10)*0.1f, (float)WorldRandomValue(world, -10,10)*0.1f},
+                RED, 0.1f, 0.5f, PARTICLE_BLOOD);
+        }
+        // A rewound shot can land on a target that has died since
+        if (world->targets[shot.index].health > 0) {
+            int damage = isHeadshot ? (int)((float)weapon->damage*weapon->headshot) : weapon->damage;
+            WorldEmit(world, EVENT_HIT, world->playerNames[player], WORLD_NAME_ENEMY, p->weapon, damage, isHeadshot);
+            DamageTarget(world, shot.index, player, damage, p->weapon, isHeadshot);
+        }
+    } else if (shot.kind == SHOT_WALL) {
+        RayCollision col = shot.collision;
+        SpawnParticle(world, col.point, (Vector3){col.normal.x*2, col.normal.y*2, col.normal.z*2}, YELLOW, 0.05f, 0.2f, PARTICLE_SPARK);
+    }
+}
+
+static void UpdatePlayer(World *world, int player, const PlayerInput *in, float dt) {
+    Player *p = &world->players[player];
+
+    bool validSelect = in->selectWeapon >= 0 && in->selectWeapon < world->weapons.count;
+    WeaponType targetWeapon = validSelect ? (WeaponType)in->selectWeapon : p->weapon;
+    if (targetWeapon != p->weapon) {
+        p->lastWeapon = p->weapon;
+        p->weapon = targetWeapon;
+        p->equipTimer = 0.0f;
+        p->shootCooldown = 0.5f;
+        p->isReloading = false;
+        p->isInspecting = false;
+        p->reloadTimer = 0;
+    }
+
+    const WeaponDef *weapon = &world->weapons.defs[p->weapon];
+    int *ammo = &p->ammo[p->weapon];
+    int *reserve = &p->reserve[p->weapon];
+    bool thrown = weapon->mode == FIRE_THROWN;
+
+    if (in->inspect && !p->isReloading && !thrown) {
+        p->isInspecting = true;
+        p->inspectTimer = 0.0f;
+    }
+
+    // Weapons without spare rounds (knife, grenades) never reload
+    if (in->reload && !p->isReloading && !p->isInspecting && *ammo < weapon->magazine && *reserve > 0) {
+        p->isReloading = true;
+        p->reloadTimer = 0.0f;
+    }
+
+    if (in->reset) WorldReset(world);
+
+    // Mouse look, then movement along the ground plane
+    p->yaw += in->look.x * SENSITIVITY * DEG2RAD;
+    p->pitch -= (in->look.y * SENSITIVITY + p->recoilPitch * 0.1f) * DEG2RAD;
+    p->pitch = Clamp(p->pitch, -PITCH_LIMIT, PITCH_LIMIT);
+
+    Vector3 forward = { -sinf(p->yaw), 0.0f, cosf(p->yaw) };
+    Vector3 right = { -cosf(p->yaw), 0.0f, -sinf(p->yaw) };
+    p->recoilPitch = Lerp(p->recoilPitch, 0, dt * 5.0f);
+    p->velocity.y -= GRAVITY * dt;
+
+    Vector3 motion = Vector3Add(Vector3Scale(forward, in->forward * WALK_SPEED * dt), Vector3Scale(right, in->right * WALK_SPEED * dt));
+    motion.y = p->velocity.y * dt;
+
+    Vector3 half = { PLAYER_HALF_WIDTH, PLAYER_HALF_HEIGHT, PLAYER_HALF_WIDTH };
+    Vector3 center = { p->position.x, p->position.y - PLAYER_EYE_HEIGHT + PLAYER_HALF_HEIGHT, p->position.z };
+    MoveResult move = MoveAndSlide(&world->wallBvh, world->walls, center, half, motion);
+    p->position = (Vector3){ move.position.x, move.position.y + PLAYER_EYE_HEIGHT - PLAYER_HALF_HEIGHT, move.position.z };
+    p->isGrounded = move.hitFloor;
+    if (move.hitFloor || (move.hitCeiling && p->velocity.y > 0)) p->velocity.y = 0;
+
+    // Ground level still holds on maps without a floor
+    if (p->position.y <= PLAYER_EYE_HEIGHT) {
+        p->position.y = PLAYER_EYE_HEIGHT;
+        p->velocity.y = 0;
+        p->isGrounded = true;
+    }
+
+    if (in->jump && p->isGrounded) {
+        p->velocity.y = JUMP_FORCE;
+    }
+
+    bool isMoving = (in->forward != 0 || in->right != 0) && p->isGrounded;
+    if (isMoving) p->walkTimer += dt * 10.0f;
+    else p->walkTimer = 0.0f;
+
+    p->weaponSway.x = Lerp(p->weaponSway.x, -in->look.x * 2.0f, dt * 5.0f);
+    p->weaponSway.y = Lerp(p->weaponSway.y, -in->look.y * 2.0f, dt * 5.0f);
+
+    p->equipTimer = fminf(p->equipTimer + dt * 3.0f, 1.0f);
+
+    if (p->isInspecting) {
+        p->inspectTimer += dt;
+        if (p->inspectTimer > 3.14f * 2) {
+            p->isInspecting = false;
+        }
+    }
+
+    if (p->isReloading) {
+        p->reloadTimer += dt;
+        if (p->reloadTimer >= weapon->reloadTime) {
+            int needed = weapon->magazine - *ammo;
+            int take = (needed > *reserve) ? *reserve : needed;
+            *ammo += take;
+            *reserve -= take;
+            p->isReloading = false;
+            p->reloadTimer = 0;
+        }
+    }
+
+    if (p->shootCooldown > 0) p->shootCooldown -= dt;
+    if (p->recoilOffset > 0) p->recoilOffset -= dt * 5.0f;
+    if (p->muzzleFlashTimer > 0) p->muzzleFlashTimer -= dt;
+
+    bool isFiring = weapon->automatic ? in->fireHeld : in->firePressed;
+
+    if (isFiring && (p->isInspecting || p->isReloading) && !thrown) {
+        p->isInspecting = false;
+        p->isReloading = false;
+    }
+
+    if (isFiring && p->shootCooldown <= 0 && p->equipTimer >= 0.8f && !p->isReloading) {
+        // A magazine of 0 means the weapon never runs out. A throw with the
+        // pool full is lost, like a shot that misses.
+        bool loaded = weapon->magazine == 0 || *ammo > 0;
+        if (loaded) {
+            if (weapon->magazine > 0) (*ammo)--;
+            p->shootCooldown = weapon->cooldown;
+
+            if (thrown) {
+                Projectile *nade = ProjectilePoolSpawn(&world->projectiles);
+                if (nade) {
+                    Vector3 dir = ViewDirection(p->yaw, p->pitch);
+                    dir.y += 0.2f;
+                    nade->position = p->position;
+                    nade->previous = p->position;
+                    nade->velocity = Vector3Scale(dir, weapon->speed);
+                    nade->halfSize = NADE_HALF_SIZE;
+                    nade->bounce = 0.5f;
+                    nade->friction = 0.7f;
+                    nade->timer = weapon->fuse;
+                    nade->radius = weapon->range;
+                    nade->damage = weapon->damage;
+                    nade->owner = player;
+                    nade->weapon = p->weapon;
+                }
+                p->equipTimer = 0.0f;
+            } else {
+                p->recoilOffset = weapon->recoil;
+                p->recoilPitch = fmaxf(p->recoilPitch, weapon->kick);
+                p->muzzleFlashTimer = fmaxf(p->muzzleFlashTimer, weapon->flash);
+                FireShot(world, player, in, weapon);
+            }
+        }
+    }
+}
+
+// Everything inside the blast radius takes the full damage. Targets come from
+// the grid around the blast, so a tick full of explosions stays cheap.
+static void Explode(World *world, const Projectile *nade) {
+    for (int i = 0; i < 30; i++) {
+        SpawnParticle(world, nade->position,
+            (Vector3){(float)WorldRandomValue(world, -50,50)*0.1f, (float)WorldRandomValue(world, -50,50)*0.1f, (float)WorldRandomValue(world, -50,50)*0.1f},
+            ORANGE, 0.5f, 0.6f, PARTICLE_EXPLOSION);
+    }
+
+    Vector3 reach = { nade->radius, nade->radius, nade->radius };
+    BoundingBox blast = { Vector3Subtract(nade->position, reach), Vector3Add(nade->position, reach) };
+    int nearby[MAX_TARGETS];
+    int count = TargetGridQueryBox(&world->targetGrid, blast, nearby, MAX_TARGETS);
+    for (int n = 0; n < count; n++) {
+        int i = nearby[n];
+        if (world->targets[i].health > 0 && Vector3Distance(world->targets[i].position, nade->position) < nade->radius) {
+            WorldEmit(world, EVENT_GRENADE_DAMAGE, PlayerName(world, nade->owner), WORLD_NAME_ENEMY, nade->weapon, nade->damage, false);
+            DamageTarget(world, i, nade->owner, nade->damage, nade->weapon, false);
+        }
+    }
+}
+
+static void UpdateProjectiles(World *world, float dt) {
+    PROFILE_ZONE("projectiles");
+    if (world->projectiles.count == 0) return;
+
+    int count = ProjectilePoolUpdate(&world->projectiles, &world->wallBvh, world->walls, dt);
+    if (count == 0) return;
+
+    UpdateTargetGrid(world);
+    for (int i = 0; i < count; i++) Explode(world, &world->projectiles.items[world->projectiles.detonated[i]]);
+}
+
+static BoundingBox PlayerBounds(const Player *p) {
+    return (BoundingBox){
+        { p->position.x - PLAYER_HALF_WIDTH, p->position.y - PLAYER_EYE_HEIGHT, p->position.z - PLAYER_HALF_WIDTH },
+        { p->position.x + PLAYER_HALF_WIDTH, p->position.y + 0.1f, p->position.z + PLAYER_HALF_WIDTH }
+    };
+}
+
+// A player who dies starts again at their spawn point
+static void DamagePlayer(World *world, int index, int damage) {
+    Player *p = &world->players[index];
+    p->health -= damage;
+    WorldEmit(world, EVENT_HIT, WORLD_NAME_ENEMY, world->playerNames[index], WPN_RIFLE, damage, false);
+    if (p->health > 0) return;
+    WorldEmit(world, EVENT_KILL, WORLD_NAME_ENEMY, world->playerNames[index], WPN_RIFLE, 0, false);
+    p->health = 100;
+    PlacePlayer(world, index);
+}
+
+// Bots only shoot players: the nearest one the shot reaches before its wall
+static void BotShoot(World *world, const BotIntent *intent) {
+    Ray ray = intent->shot;
+    Vector3 invDir = { 1.0f/ray.direction.x, 1.0f/ray.direction.y, 1.0f/ray.direction.z };
+    int victim = -1;
+    float nearest = intent->shotWallDistance;
+    for (int i = 0; i < world->playerCount; i++) {
+        const Player *p = &world->players[i];
+        float t;
+        if (p->connected && p->health > 0 && RayBoxSlab(ray.position, invDir, PlayerBounds(p), nearest, &t) && t < nearest) {
+            victim = i;
+            nearest = t;
+        }
+    }
+
+    WorldEmit(world, EVENT_SHOT, WORLD_NAME_ENEMY, 0, WPN_RIFLE, 0, false);
+    Vector3 point = Vector3Add(ray.position, Vector3Scale(ray.direction, nearest));
+    if (victim >= 0) {
+        SpawnParticle(world, point, (Vector3){ 0.0f, 1.0f, 0.0f }, RED, 0.1f, 0.5f, PARTICLE_BLOOD);
+        DamagePlayer(world, victim, BOT_DAMAGE);
+    } else if (intent->shotWallDistance < BOT_RANGE) {
+        SpawnParticle(world, point, Vector3Scale(ray.direction, -2.0f), YELLOW, 0.05f, 0.2f, PARTICLE_SPARK);
+    }
+}
+
+typedef struct {
+    World *world;
+    BotView view;
+} BotThinkJob;
+
+static void ThinkBot(void *ctx, int index, int thread) {
+    (void)thread;
+    BotThinkJob *job = ctx;
+    World *world = job->world;
+    world->botIntents[index] = BotAiThink(&job->view, &world->bots[index], &world->targets[index], index);
+}
+
+// Every bot thinks against the same start-of-tick world, in parallel when
+// there is a job system; the intents are then applied in bot order
+static void UpdateBots(World *world, float dt) {
+    PROFILE_ZONE("bots");
+    UpdateNav(world);
+    BotThinkJob job = { world, { .wallBvh = &world->wallBvh, .walls = world->walls, .players = world->players, .playerCount = world->playerCount,
+                                 .nav = &world->nav, .seed = world->rng ^ world->tick, .dt = dt } };
+
+    // Flow fields towards the first few live players with a bot near enough
+    // to hunt them; bots chasing the same player share its field
+    int fields = 0;
+    for (int i = 0; i < world->playerCount && fields < NAV_FLOW_FIELDS; i++) {
+        const Player *p = &world->players[i];
+        if (!p->connected || p->health <= 0) continue;
+        for (int b = 0; b < world->botCount; b++) {
+            const Target *t = &world->targets[b];
+            float dx = t->position.x - p->position.x, dz = t->position.z - p->position.z;
+            if (!t->active || t->health <= 0 || dx*dx + dz*dz >= BOT_HUNT_RANGE*BOT_HUNT_RANGE) continue;
+            job.view.flows[i] = NavFlowTo(&world->nav, NavCellAt(&world->nav, p->position), BOT_HUNT_SLACK);
+            fields += job.view.flows[i] != NULL;
+            break;
+        }
+    }
+
+    if (world->jobs) {
+        JobSystemRun(world->jobs, ThinkBot, &job, world->botCount);
+    } else {
+        for (int i = 0; i < world->botCount; i++) ThinkBot(&job, i, 0);
+    }
+
+    for (int i = 0; i < world->botCount; i++) {
+        Target *t = &world->targets[i];
+        if (!t->active || t->health <= 0) continue;
+        const BotIntent *intent = &world->botIntents[i];
+        BotBrain *brain = &world->bots[i];
+        t->position = intent->position;
+        world->targetGridDirty = true;
+        brain->yaw = intent->yaw;
+        brain->wanderTimer = intent->wanderTimer;
+        brain->enemy = intent->enemy;
+        brain->pathNext = intent->pathNext;
+        if (intent->wantPath) {
+            brain->pathLength = NavCachedPath(&world->nav, t->position, intent->pathGoal, brain->path, BOT_PATH_POINTS);
+            brain->pathNext = 0;
+        }
+        brain->fireCooldown = fmaxf(brain->fireCooldown - dt, 0.0f);
+        if (intent->fire) {
+            brain->fireCooldown = BOT_FIRE_INTERVAL;
+            BotShoot(world, intent);
+        }
+    }
+}
+
+void WorldStep(World *world, const PlayerInput *inputs, float dt) {
+    PROFILE_ZONE("physics");
+    if (world->wallBvhDirty) RebuildWallBvh(world);
+    for (int i = 0; i < world->playerCount; i++) world->prevEye[i] = world->players[i].position;
+    for (int i = 0; i < world->botCount; i++) world->prevTarget[i] = world->targets[i].position;
+
+    for (int i = 0; i < world->playerCount; i++) {
+        if (world->players[i].connected) UpdatePlayer(world, i, &inputs[i], dt);
+    }
+    UpdateBots(world, dt);
+    UpdateProjectiles(world, dt);
+    ParticlePoolUpdate(&world->particles, dt);
+
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        Target *t = &world->targets[i];
+        if (!t->active) continue;
+        if (t->health <= 0) {
+            t->deathTimer -= dt;
+            if (t->deathTimer <= 0) t->active = false;
+        }
+        t->hitTimer -= dt;
+    }
+
+    world->tick++;
+    LagHistoryRecord(&world->lagHistory, (uint32_t)world->tick, world->targets);
+}
+
+PlayerInput WorldAutopilot(const World *world, int player) {
+    const Player *p = &world->players[player];
+    PlayerInput in = { 0 };
+    in.selectWeapon = -1;
+
+    int nearest = -1;
+    float nearestDistance = 0.0f;
+    bool anyActive = false;
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        const Target *t = &world->targets[i];
+        anyActive |= t->active;
+        if (!t->active || t->health <= 0) continue;
+        float d = Vector3Distance(t->position, p->position);
+        if (nearest < 0 || d < nearestDistance) {
+            nearest = i;
+            nearestDistance = d;
+        }
+    }
+    if (!anyActive) {
+        in.reset = true;
+        return in;
+    }
+
+    static const WeaponType cycle[] = { WPN_RIFLE, WPN_PISTOL, WPN_GRENADE, WPN_KNIFE };
+    WeaponType wanted = cycle[(world->tick / (10*WORLD_TICK_RATE)) % 4];
+    if (wanted != p->weapon) in.selectWeapon = wanted;
+
+    const WeaponDef *weapon = &world->weapons.defs[p->weapon];
+    if (weapon->magazine > 0 && p->ammo[p->weapon] == 0) in.reload = true;
+    if (nearest < 0) return in;
+
+    Vector3 aim = world->targets[nearest].position;
+    aim.y = 1.0f;
+    Vector3 d = Vector3Subtract(aim, p->position);
+    float yaw = atan2f(-d.x, d.z);
+    float pitch = atan2f(d.y, sqrtf(d.x*d.x + d.z*d.z));
+    float turn = yaw - p->yaw;
+    turn = atan2f(sinf(turn), cosf(turn));
+
+    // Mouse pixels for the turn, limited to a fast human flick
+    float pixels = 1.0f/(SENSITIVITY*DEG2RAD);
+    in.look.x = Clamp(turn*pixels, -150.0f, 150.0f);
+    in.look.y = Clamp(-(pitch - p->pitch)*pixels, -150.0f, 150.0f);
+
+    in.forward = (nearestDistance > ((weapon->mode == FIRE_MELEE) ? 2.0f : 8.0f)) ? 1.0f : 0.0f;
+    // Offset per player so a crowd of bots does not move in lockstep
+    uint64_t tick = world->tick + (uint64_t)player*37;
+    in.right = ((tick / 96) & 1) ? 1.0f : -1.0f;
+    in.jump = (tick % 200) == 0;
+
+    bool onTarget = fabsf(turn) < 2.0f*DEG2RAD;
+    in.fireHeld = onTarget;
+    in.firePressed = onTarget && (tick % 8) == 0;
+    return in;
+}
+
+Camera3D WorldCamera(const World *world, int player, float alpha, Vector2 look) {
+    const Player *p = &world->players[player];
+    float yaw = p->yaw + look.x * SENSITIVITY * DEG2RAD;
+    float pitch = Clamp(p->pitch - look.y * SENSITIVITY * DEG2RAD, -PITCH_LIMIT, PITCH_LIMIT);
+
+    Camera3D camera = { 0 };
+    camera.position = Vector3Lerp(world->prevEye[player], p->position, alpha);
+    camera.target = Vector3Add(camera.position, ViewDirection(yaw, pitch));
+    camera.up = (Vector3){ 0.0f, 1.0f, 0.0f };
+    camera.fovy = 75.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+    return camera;
+}
+
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i])*1099511628211ull;
+    return hash;
+}
+
+#define HASH_FIELD(field) hash = HashBytes(hash, &(field), sizeof(field))
+
+uint64_t WorldHash(const World *world) {
+    uint64_t hash = 1469598103934665603ull;
+    for (int i = 0; i < world->playerCount; i++) {
+        const Player *p = &world->players[i];
+        HASH_FIELD(p->connected);
+        HASH_FIELD(p->position);
+        HASH_FIELD(p->yaw);
+        HASH_FIELD(p->pitch);
+        HASH_FIELD(p->weapon);
+        HASH_FIELD(p->lastWeapon);
+        HASH_FIELD(p->velocity);
+        HASH_FIELD(p->isGrounded);
+        HASH_FIELD(p->ammo);
+        HASH_FIELD(p->reserve);
+        HASH_FIELD(p->health);
+        HASH_FIELD(p->shootCooldown);
+        HASH_FIELD(p->recoilOffset);
+        HASH_FIELD(p->recoilPitch);
+        HASH_FIELD(p->equipTimer);
+        HASH_FIELD(p->walkTimer);
+        HASH_FIELD(p->weaponSway);
+        HASH_FIELD(p->muzzleFlashTimer);
+        HASH_FIELD(p->reloadTimer);
+        HASH_FIELD(p->isReloading);
+        HASH_FIELD(p->inspectTimer);
+        HASH_FIELD(p->isInspecting);
+    }
+    for (int i = 0; i < MAX_TARGETS; i++) {
+        const Target *t = &world->targets[i];
+        HASH_FIELD(t->position);
+        HASH_FIELD(t->active);
+        HASH_FIELD(t->health);
+        HASH_FIELD(t->hitTimer);
+        HASH_FIELD(t->deathTimer);
+        HASH_FIELD(t->id);
+    }
+    for (int i = 0; i < world->projectiles.count; i++) {
+        const Projectile *p = &world->projectiles.items[i];
+        HASH_FIELD(p->position);
+        HASH_FIELD(p->previous);
+        HASH_FIELD(p->velocity);
+        HASH_FIELD(p->halfSize);
+        HASH_FIELD(p->bounce);
+        HASH_FIELD(p->friction);
+        HASH_FIELD(p->timer);
+        HASH_FIELD(p->radius);
+        HASH_FIELD(p->damage);
+        HASH_FIELD(p->owner);
+        HASH_FIELD(p->weapon);
+        HASH_FIELD(p->exploding);
+    }
+    HASH_FIELD(world->rng);
+    HASH_FIELD(world->tick);
+    HASH_FIELD(world->particles.count);
+    return hash;
+}
+
+#undef HASH_FIELD
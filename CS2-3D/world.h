@@ -0,0 +1,149 @@
+#ifndef CS2_WORLD_H
+#define CS2_WORLD_H
+
+#include "game.h"
+#include "bvh.h"
+#include "grid.h"
+#include "particles.h"
+#include "projectiles.h"
+#include "lagcomp.h"
+#include "weapons.h"
+#include "mapfile.h"
+#include "botai.h"
+#include "navgrid.h"
+#include "events.h"
+#include "../common/jobs.h"
+#include <stdint.h>
+
+// Everything the game simulates, advanced only by WorldStep at a fixed tick
+// rate. WorldStep reads nothing but its arguments (no Raylib input, timing or
+// RNG), so a seed plus the same inputs always give the same world, with or
+// without a window.
+
+#define WORLD_TICK_RATE 64
+#define WORLD_DT (1.0f/WORLD_TICK_RATE)
+#define PLAYER_EYE_HEIGHT 2.0f
+#define WORLD_DEFAULT_BOTS 10
+#define KILLFEED_SECONDS 5.0f
+
+// Names every world interns first, in this order
+#define WORLD_NAME_ENEMY 1
+#define WORLD_NAME_PLAYER 2
+
+// One tick of player input. Held buttons are sampled when the tick runs;
+// presses and mouse movement are collected since the previous tick.
+typedef struct {
+    float forward;      // -1..1
+    float right;        // -1..1
+    Vector2 look;       // mouse movement in pixels
+    bool fireHeld;
+    bool firePressed;
+    bool jump;
+    bool reload;
+    bool inspect;
+    bool reset;
+    int selectWeapon;   // WeaponType, or -1 to keep the current one
+
+    // The tick (plus fraction) the player was looking at when firing, so
+    // shots hit targets where the player saw them. 0 means the current tick.
+    uint32_t viewTick;
+    float viewFraction;
+} PlayerInput;
+
+typedef struct {
+    // walls is wallStorage for the built-in map, or points into a loaded
+    // map file together with wallBvh
+    const Wall *walls;
+    int wallCount;
+    Wall *wallStorage;
+    int wallCapacity;
+    const MapFile *map;
+    Bvh wallBvh;
+    bool wallBvhDirty;
+    uint32_t wallVersion;   // bumped whenever walls change, for baked meshes
+    TargetGrid targetGrid;
+    bool targetGridDirty;   // targets moved or respawned since it was built
+
+    // The first botCount targets are bots; the rest stay inactive
+    Target targets[MAX_TARGETS];
+    BotBrain bots[MAX_TARGETS];
+    BotIntent botIntents[MAX_TARGETS];
+    int botCount;
+    JobSystem *jobs;        // optional; bots think on it when set
+    NavGrid nav;            // baked from the walls while there are bots
+    uint32_t navVersion;    // wallVersion the grid was baked from
+    ParticlePool particles;
+    NameTable names;
+    uint16_t playerNames[MAX_PLAYERS];  // name ids of the connected players
+    KillFeed killFeed;
+    EventRing *events;      // optional; every event is also pushed here
+    ProjectilePool projectiles;
+    LagHistory lagHistory;
+    WeaponTable weapons;
+
+    // Slots up to playerCount; a slot is in use while its player is connected
+    Player players[MAX_PLAYERS];
+    int playerCount;
+
+    // Where things were before the last tick, for drawing between ticks
+    Vector3 prevEye[MAX_PLAYERS];
+    Vector3 prevTarget[MAX_TARGETS];
+
+    uint64_t rng;
+    uint64_t tick;
+} World;
+
+void WorldInit(World *world, uint64_t seed);
+void WorldFree(World *world);
+
+// Rebuilds the map and targets and clears effects; players are kept
+void WorldReset(World *world);
+
+// Plays on a compiled map from now on (NULL for the built-in one) and resets.
+// The map must stay open until the world is freed or given another map.
+void WorldSetMap(World *world, const MapFile *map);
+
+// Resets the world with count bots (at most MAX_TARGETS)
+void WorldSetBots(World *world, int count);
+
+// Returns the new player's index, or -1 if every slot is taken
+int WorldAddPlayer(World *world, const char *name);
+void WorldRemovePlayer(World *world, int index);
+
+// Swaps in a new weapon table; weapons it adds start with full ammo
+void WorldSetWeapons(World *world, const WeaponTable *weapons);
+
+void WorldAddWall(World *world, Vector3 pos, Vector3 size, Color col);
+// Puts an event on the stream: into the kill feed and the events ring
+void WorldEmit(World *world, GameEventType type, uint16_t actor, uint16_t subject, WeaponType weapon, int damage, bool headshot);
+// The i-th newest kill still on the feed (0 is the newest) and how many
+// seconds it has left there, or NULL. Inline so snapshot.c can use it
+// without the simulation.
+static inline const GameEvent *WorldKillFeed(const World *world, int i, float *timeLeft) {
+    const GameEvent *kill = KillFeedGet(&world->killFeed, i);
+    if (!kill) return NULL;
+    *timeLeft = KILLFEED_SECONDS - (float)(world->tick - kill->tick)*WORLD_DT;
+    return (*timeLeft > 0.0f) ? kill : NULL;
+}
+// inputs holds one entry per player slot (playerCount entries)
+void WorldStep(World *world, const PlayerInput *inputs, float dt);
+
+// Simple bot for headless runs: walks towards the nearest live target, aims
+// and fires, reloads, cycles weapons and resets the map once it is cleared
+PlayerInput WorldAutopilot(const World *world, int player);
+
+// Inclusive range, like GetRandomValue
+int WorldRandomValue(World *world, int min, int max);
+
+// FNV-1a over what the simulation has to reproduce exactly: players, targets,
+// grenades, the random state and the tick. Hashed field by field, so struct
+// padding never counts.
+uint64_t WorldHash(const World *world);
+
+Vector3 ViewDirection(float yaw, float pitch);
+
+// Camera between the last two ticks (alpha in 0..1). look is mouse movement
+// not yet consumed by a tick, applied right away so aiming does not lag.
+Camera3D WorldCamera(const World *world, int player, float alpha, Vector2 look);
+
+#endif
@@ -0,0 +1,357 @@
+#include "batch.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The SIMD and scalar paths perform the same float operations in the same
+// order, so with FP contraction off (the default for -std=c99/c11) they stay
+// bit-identical; the benchmark checks this.
+
+#define BIRD_X 100.0f
+#define BIRD_RADIUS 18.0f
+#define GAP_MIN 80
+#define GAP_RANGE (SCREEN_HEIGHT - 80 - GAP_SIZE - GAP_MIN + 1)
+#define GAP_SCALE ((float)GAP_RANGE / 16777216.0f)
+
+static const float gravityStep = GRAVITY * SIM_DT;
+static const float pipeStep = PIPE_SPEED * SIM_DT;
+
+static float RandomGap(uint32_t *state)
+{
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (float)GAP_MIN + (float)(int32_t)((float)(int32_t)(x >> 8) * GAP_SCALE);
+}
+
+static void ResetWorld(FlappyBatch *b, int i)
+{
+    b->birdY[i] = SCREEN_HEIGHT / 2.0f;
+    b->birdVelocity[i] = 0.0f;
+    b->birdRotation[i] = 0.0f;
+    b->pipeHeadX[i] = SCREEN_WIDTH + 200;
+    for (int k = 0; k < BATCH_PIPE_WINDOW; k++)
+        b->gapY[k][i] = RandomGap(&b->rng[i]);
+    b->passed[i] = 0;
+    b->score[i] = 0;
+}
+
+static void FinishEpisode(FlappyBatch *b, int i)
+{
+    b->episodes[i]++;
+    b->scoreSum[i] += b->score[i];
+    if (b->score[i] > b->bestScore[i])
+        b->bestScore[i] = b->score[i];
+    ResetWorld(b, i);
+}
+
+static void RecyclePipe(FlappyBatch *b, int i)
+{
+    for (int k = 0; k < BATCH_PIPE_WINDOW - 1; k++)
+        b->gapY[k][i] = b->gapY[k + 1][i];
+    b->gapY[BATCH_PIPE_WINDOW - 1][i] = RandomGap(&b->rng[i]);
+    b->pipeHeadX[i] += PIPE_SPACING;
+    b->passed[i] = 0;
+}
+
+// Circle against the top (0..gapY) and bottom (gapY+GAP_SIZE..SCREEN_HEIGHT)
+// rectangles of the pipe at x, via the closest point on each rectangle
+static bool HitsPipe(float y, float x, float gapY)
+{
+    float cx = fminf(fmaxf(BIRD_X, x), x + PIPE_WIDTH);
+    float dx = BIRD_X - cx;
+    float dyTop = y - fminf(fmaxf(y, 0.0f), gapY);
+    float dyBottom = y - fmaxf(fminf(y, (float)SCREEN_HEIGHT), gapY + GAP_SIZE);
+    float dx2 = dx * dx;
+    float r2 = BIRD_RADIUS * BIRD_RADIUS;
+    return (dx2 + dyTop * dyTop <= r2) || (dx2 + dyBottom * dyBottom <= r2);
+}
+
+static void StepWorld(FlappyBatch *b, int i)
+{
+    float y = b->birdY[i];
+    float velocity = b->birdVelocity[i];
+    float rotation = b->birdRotation[i];
+
+    if (b->flap[i])
+    {
+        velocity = -JUMP_STRENGTH;
+        rotation = -25.0f;
+    }
+
+    velocity += gravityStep;
+    y += velocity * SIM_DT;
+
+    if (velocity > 100.0f)
+        rotation = fminf(rotation + ROTATION_SPEED, 90.0f);
+
+    b->pipeHeadX[i] -= pipeStep;
+    if (b->pipeHeadX[i] + PIPE_WIDTH < 0.0f)
+        RecyclePipe(b, i);
+
+    float headX = b->pipeHeadX[i];
+    bool dead = HitsPipe(y, headX, b->gapY[0][i]) || HitsPipe(y, headX + PIPE_SPACING, b->gapY[1][i]);
+
+    if (!b->passed[i] && headX + PIPE_WIDTH < BIRD_X)
+    {
+        b->score[i]++;
+        b->passed[i] = 1;
+    }
+
+    if (y - BIRD_RADIUS < 0.0f)
+    {
+        y = BIRD_RADIUS;
+        velocity = 0.0f;
+    }
+    if (y + BIRD_RADIUS > SCREEN_HEIGHT)
+        dead = true;
+
+    b->birdY[i] = y;
+    b->birdVelocity[i] = velocity;
+    b->birdRotation[i] = rotation;
+
+    if (dead)
+        FinishEpisode(b, i);
+}
+
+void BatchStepRangeScalar(FlappyBatch *batch, int begin, int end)
+{
+    for (int i = begin; i < end; i++)
+        StepWorld(batch, i);
+}
+
+#if defined(__SSE2__)
+
+static inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 HitsPipe4(__m128 y, __m128 x, __m128 gapY)
+{
+    const __m128 birdX = _mm_set1_ps(BIRD_X);
+    const __m128 zero = _mm_setzero_ps();
+
+    __m128 cx = _mm_min_ps(_mm_max_ps(birdX, x), _mm_add_ps(x, _mm_set1_ps(PIPE_WIDTH)));
+    __m128 dx = _mm_sub_ps(birdX, cx);
+    __m128 dyTop = _mm_sub_ps(y, _mm_min_ps(_mm_max_ps(y, zero), gapY));
+    __m128 dyBottom = _mm_sub_ps(y, _mm_max_ps(_mm_min_ps(y, _mm_set1_ps(SCREEN_HEIGHT)), _mm_add_ps(gapY, _mm_set1_ps(GAP_SIZE))));
+    __m128 dx2 = _mm_mul_ps(dx, dx);
+    __m128 r2 = _mm_set1_ps(BIRD_RADIUS * BIRD_RADIUS);
+
+    __m128 top = _mm_cmple_ps(_mm_add_ps(dx2, _mm_mul_ps(dyTop, dyTop)), r2);
+    __m128 bottom = _mm_cmple_ps(_mm_add_ps(dx2, _mm_mul_ps(dyBottom, dyBottom)), r2);
+    return _mm_or_ps(top, bottom);
+}
+
+static void StepWorlds4(FlappyBatch *b, int i)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i zeroi = _mm_setzero_si128();
+    const __m128 radius = _mm_set1_ps(BIRD_RADIUS);
+
+    __m128 y = _mm_loadu_ps(b->birdY + i);
+    __m128 velocity = _mm_loadu_ps(b->birdVelocity + i);
+    __m128 rotation = _mm_loadu_ps(b->birdRotation + i);
+
+    int32_t flapBytes;
+    memcpy(&flapBytes, b->flap + i, sizeof(flapBytes));
+    __m128i flap = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(flapBytes), zeroi), zeroi);
+    __m128 flapMask = _mm_castsi128_ps(_mm_cmpgt_epi32(flap, zeroi));
+
+    velocity = Select(flapMask, _mm_set1_ps(-JUMP_STRENGTH), velocity);
+    rotation = Select(flapMask, _mm_set1_ps(-25.0f), rotation);
+
+    velocity = _mm_add_ps(velocity, _mm_set1_ps(gravityStep));
+    y = _mm_add_ps(y, _mm_mul_ps(velocity, _mm_set1_ps(SIM_DT)));
+
+    __m128 falling = _mm_cmpgt_ps(velocity, _mm_set1_ps(100.0f));
+    rotation = Select(falling, _mm_min_ps(_mm_add_ps(rotation, _mm_set1_ps(ROTATION_SPEED)), _mm_set1_ps(90.0f)), rotation);
+
+    // Recycling happens once every PIPE_SPACING / pipeStep ticks, so the lanes
+    // that need it are fixed up with the scalar helper
+    __m128 headX = _mm_sub_ps(_mm_loadu_ps(b->pipeHeadX + i), _mm_set1_ps(pipeStep));
+    _mm_storeu_ps(b->pipeHeadX + i, headX);
+    int recycle = _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(headX, _mm_set1_ps(PIPE_WIDTH)), zero));
+    if (recycle)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (recycle & (1 << lane))
+                RecyclePipe(b, i + lane);
+        }
+        headX = _mm_loadu_ps(b->pipeHeadX + i);
+    }
+
+    __m128 gap0 = _mm_loadu_ps(b->gapY[0] + i);
+    __m128 gap1 = _mm_loadu_ps(b->gapY[1] + i);
+    __m128 dead = _mm_or_ps(HitsPipe4(y, headX, gap0), HitsPipe4(y, _mm_add_ps(headX, _mm_set1_ps(PIPE_SPACING)), gap1));
+
+    __m128i passed = _mm_loadu_si128((const __m128i *)(b->passed + i));
+    __m128i crossed = _mm_castps_si128(_mm_cmplt_ps(_mm_add_ps(headX, _mm_set1_ps(PIPE_WIDTH)), _mm_set1_ps(BIRD_X)));
+    __m128i scored = _mm_andnot_si128(_mm_cmpgt_epi32(passed, zeroi), crossed);
+    __m128i score = _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(b->score + i)), scored);
+    passed = _mm_or_si128(passed, _mm_and_si128(scored, _mm_set1_epi32(1)));
+
+    __m128 ceiling = _mm_cmplt_ps(_mm_sub_ps(y, radius), zero);
+    y = Select(ceiling, radius, y);
+    velocity = Select(ceiling, zero, velocity);
+    dead = _mm_or_ps(dead, _mm_cmpgt_ps(_mm_add_ps(y, radius), _mm_set1_ps(SCREEN_HEIGHT)));
+
+    _mm_storeu_ps(b->birdY + i, y);
+    _mm_storeu_ps(b->birdVelocity + i, velocity);
+    _mm_storeu_ps(b->birdRotation + i, rotation);
+    _mm_storeu_si128((__m128i *)(b->score + i), score);
+    _mm_storeu_si128((__m128i *)(b->passed + i), passed);
+
+    int deadBits = _mm_movemask_ps(dead);
+    if (deadBits)
+    {
+        for (int lane = 0; lane < 4; lane++)
+        {
+            if (deadBits & (1 << lane))
+                FinishEpisode(b, i + lane);
+        }
+    }
+}
+
+void BatchStepRange(FlappyBatch *batch, int begin, int end)
+{
+    int i = begin;
+    for (; i + 4 <= end; i += 4)
+        StepWorlds4(batch, i);
+    BatchStepRangeScalar(batch, i, end);
+}
+
+const char *BatchSimdName(void)
+{
+    return "sse2";
+}
+
+#else
+
+void BatchStepRange(FlappyBatch *batch, int begin, int end)
+{
+    BatchStepRangeScalar(batch, begin, end);
+}
+
+const char *BatchSimdName(void)
+{
+    return "scalar";
+}
+
+#endif
+
+void BatchAutopilot(FlappyBatch *batch, int begin, int end, void *user)
+{
+    (void)user;
+    for (int i = begin; i < end; i++)
+    {
+        bool firstAhead = batch->pipeHeadX[i] + PIPE_WIDTH + BIRD_RADIUS > BIRD_X;
+        float gapBottom = (firstAhead ? batch->gapY[0][i] : batch->gapY[1][i]) + GAP_SIZE;
+        batch->flap[i] = batch->birdVelocity[i] >= 0.0f && batch->birdY[i] + BIRD_RADIUS > gapBottom - 24.0f;
+    }
+}
+
+bool BatchInit(FlappyBatch *batch, int count, uint64_t seed)
+{
+    *batch = (FlappyBatch){0};
+    batch->count = count;
+
+    batch->birdY = calloc(count, sizeof(float));
+    batch->birdVelocity = calloc(count, sizeof(float));
+    batch->birdRotation = calloc(count, sizeof(float));
+    batch->pipeHeadX = calloc(count, sizeof(float));
+    for (int k = 0; k < BATCH_PIPE_WINDOW; k++)
+        batch->gapY[k] = calloc(count, sizeof(float));
+    batch->passed = calloc(count, sizeof(int32_t));
+    batch->score = calloc(count, sizeof(int32_t));
+    batch->rng = calloc(count, sizeof(uint32_t));
+    // Padded so the SIMD path can read four flags at the tail
+    batch->flap = calloc(count + 4, sizeof(uint8_t));
+    batch->episodes = calloc(count, sizeof(int32_t));
+    batch->bestScore = calloc(count, sizeof(int32_t));
+    batch->scoreSum = calloc(count, sizeof(int64_t));
+
+    bool ok = batch->birdY && batch->birdVelocity && batch->birdRotation && batch->pipeHeadX && batch->passed &&
+              batch->score && batch->rng && batch->flap && batch->episodes && batch->bestScore && batch->scoreSum;
+    for (int k = 0; k < BATCH_PIPE_WINDOW; k++)
+        ok = ok && batch->gapY[k];
+
+    if (!ok)
+    {
+        BatchFree(batch);
+        return false;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        SimRng rng;
+        SimRngSeed(&rng, seed + (uint64_t)i);
+        batch->rng[i] = (uint32_t)rng.state | 1u;
+        ResetWorld(batch, i);
+    }
+    return true;
+}
+
+void BatchFree(FlappyBatch *batch)
+{
+    free(batch->birdY);
+    free(batch->birdVelocity);
+    free(batch->birdRotation);
+    free(batch->pipeHeadX);
+    for (int k = 0; k < BATCH_PIPE_WINDOW; k++)
+        free(batch->gapY[k]);
+    free(batch->passed);
+    free(batch->score);
+    free(batch->rng);
+    free(batch->flap);
+    free(batch->episodes);
+    free(batch->bestScore);
+    free(batch->scoreSum);
+    *batch = (FlappyBatch){0};
+}
+
+typedef struct BatchRunContext
+{
+    FlappyBatch *batch;
+    int ticks;
+    BatchPolicy policy;
+    void *user;
+} BatchRunContext;
+
+static void RunChunk(void *ctx, int jobIndex, int thread)
+{
+    (void)thread;
+    BatchRunContext *run = ctx;
+    int begin = jobIndex * BATCH_CHUNK;
+    int end = begin + BATCH_CHUNK;
+    if (end > run->batch->count)
+        end = run->batch->count;
+
+    for (int t = 0; t < run->ticks; t++)
+    {
+        run->policy(run->batch, begin, end, run->user);
+        BatchStepRange(run->batch, begin, end);
+    }
+}
+
+void BatchRun(FlappyBatch *batch, JobSystem *jobs, int ticks, BatchPolicy policy, void *user)
+{
+    BatchRunContext run = {batch, ticks, policy ? policy : BatchAutopilot, user};
+    int chunks = (batch->count + BATCH_CHUNK - 1) / BATCH_CHUNK;
+
+    if (jobs)
+        JobSystemRun(jobs, RunChunk, &run, chunks);
+    else
+    {
+        for (int j = 0; j < chunks; j++)
+            RunChunk(&run, j, 0);
+    }
+}
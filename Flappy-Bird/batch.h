@@ -0,0 +1,59 @@
+#ifndef FLAPPY_BATCH_H
+#define FLAPPY_BATCH_H
+
+#include "sim.h"
+#include "../common/jobs.h"
+
+// Many independent bird/pipe worlds stepped together in structure-of-arrays
+// layout. Physics and collision match SimStep, but each world only keeps the
+// BATCH_PIPE_WINDOW pipes nearest the bird and uses a per-world xorshift32
+// RNG, so a batch world is not bit-compatible with a Sim of the same seed.
+// Dead worlds restart immediately and their score is folded into the
+// episode counters.
+
+#define BATCH_PIPE_WINDOW 4
+#define BATCH_CHUNK 1024
+
+#if PIPE_SPACING < PIPE_WIDTH + 80
+#error "the batch simulator assumes the bird can only overlap the first two pipes"
+#endif
+
+typedef struct FlappyBatch
+{
+    int count;
+
+    float *birdY;
+    float *birdVelocity;
+    float *birdRotation;
+    float *pipeHeadX;
+    float *gapY[BATCH_PIPE_WINDOW];
+    int32_t *passed;
+    int32_t *score;
+    uint32_t *rng;
+
+    // Written by the policy each tick, read by the step
+    uint8_t *flap;
+
+    int32_t *episodes;
+    int32_t *bestScore;
+    int64_t *scoreSum;
+} FlappyBatch;
+
+// Fills batch->flap[begin..end) for the coming tick
+typedef void (*BatchPolicy)(FlappyBatch *batch, int begin, int end, void *user);
+
+bool BatchInit(FlappyBatch *batch, int count, uint64_t seed);
+void BatchFree(FlappyBatch *batch);
+
+void BatchStepRange(FlappyBatch *batch, int begin, int end);
+void BatchStepRangeScalar(FlappyBatch *batch, int begin, int end);
+
+// Steps every world ticks times. Worlds are split into BATCH_CHUNK sized jobs
+// that each run all ticks back to back, so threads never synchronise mid-run.
+void BatchRun(FlappyBatch *batch, JobSystem *jobs, int ticks, BatchPolicy policy, void *user);
+
+void BatchAutopilot(FlappyBatch *batch, int begin, int end, void *user);
+
+const char *BatchSimdName(void);
+
+#endif
@@ -0,0 +1,87 @@
+#include "batch.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Throughput of the batched simulator in bird-steps per second for 1..64
+// threads, after checking that the SIMD kernel matches the scalar one.
+// Usage: bench_batch [worlds] [ticks] [maxThreads]
+
+static bool SameFloats(const float *a, const float *b, int n)
+{
+    return memcmp(a, b, n * sizeof(float)) == 0;
+}
+
+static bool CheckSimdMatchesScalar(void)
+{
+    const int count = 4099;
+    FlappyBatch simd, scalar;
+    if (!BatchInit(&simd, count, 99) || !BatchInit(&scalar, count, 99))
+        return false;
+
+    for (int t = 0; t < 20000; t++)
+    {
+        BatchAutopilot(&simd, 0, count, NULL);
+        BatchAutopilot(&scalar, 0, count, NULL);
+        // Random extra flaps so that worlds die and restart
+        for (int i = t % 7; i < count; i += 97)
+            simd.flap[i] = scalar.flap[i] = 1;
+
+        BatchStepRange(&simd, 0, count);
+        BatchStepRangeScalar(&scalar, 0, count);
+    }
+
+    bool same = SameFloats(simd.birdY, scalar.birdY, count) &&
+                SameFloats(simd.birdVelocity, scalar.birdVelocity, count) &&
+                SameFloats(simd.birdRotation, scalar.birdRotation, count) &&
+                SameFloats(simd.pipeHeadX, scalar.pipeHeadX, count) &&
+                memcmp(simd.score, scalar.score, count * sizeof(int32_t)) == 0 &&
+                memcmp(simd.episodes, scalar.episodes, count * sizeof(int32_t)) == 0;
+
+    BatchFree(&simd);
+    BatchFree(&scalar);
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    int worlds = (argc > 1) ? atoi(argv[1]) : 65536;
+    int ticks = (argc > 2) ? atoi(argv[2]) : 600;
+    int maxThreads = (argc > 3) ? atoi(argv[3]) : 64;
+
+    bool parity = CheckSimdMatchesScalar();
+    printf("simd: %s, matches scalar: %s\n", BatchSimdName(), parity ? "yes" : "NO");
+    printf("worlds: %d, ticks: %d\n", worlds, ticks);
+    printf("%8s %16s %10s %12s\n", "threads", "bird-steps/s", "speedup", "episodes");
+
+    double baseline = 0.0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        FlappyBatch batch;
+        if (!BatchInit(&batch, worlds, 1))
+        {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        JobSystem *jobs = JobSystemCreate(threads);
+
+        double start = BenchNowSeconds();
+        BatchRun(&batch, jobs, ticks, BatchAutopilot, NULL);
+        double elapsed = BenchNowSeconds() - start;
+
+        long long episodes = 0;
+        for (int i = 0; i < worlds; i++)
+            episodes += batch.episodes[i];
+
+        double rate = (double)worlds * ticks / elapsed;
+        if (threads == 1)
+            baseline = rate;
+        printf("%8d %16.0f %9.2fx %12lld\n", threads, rate, rate / baseline, episodes);
+
+        JobSystemDestroy(jobs);
+        BatchFree(&batch);
+    }
+
+    return parity ? 0 : 1;
+}
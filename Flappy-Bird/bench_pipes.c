@@ -0,0 +1,48 @@
+#include "sim.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Per-tick cost of SimStep. Build it with different -DMAX_PIPES=... and
+// -DPIPE_SPACING=... values; the ns/tick column should not move with them.
+// Usage: bench_pipes [ticks] [runs]
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv)
+{
+    long long ticks = (argc > 1) ? atoll(argv[1]) : 2000000;
+    int runs = (argc > 2) ? atoi(argv[2]) : 5;
+    if (runs < 1)
+        runs = 1;
+    if (runs > 32)
+        runs = 32;
+
+    static Sim sim;
+    double nsPerTick[32];
+    int checksum = 0;
+
+    for (int r = 0; r < runs; r++)
+    {
+        SimInit(&sim, 1234 + r);
+
+        double start = BenchNowSeconds();
+        for (long long t = 0; t < ticks; t++)
+            SimStep(&sim, SimAutopilot(&sim), SIM_DT);
+        nsPerTick[r] = (BenchNowSeconds() - start) * 1e9 / (double)ticks;
+
+        checksum += sim.score;
+    }
+
+    qsort(nsPerTick, runs, sizeof(double), CompareDouble);
+
+    printf("MAX_PIPES=%d PIPE_SPACING=%d ticks=%lld runs=%d\n", MAX_PIPES, PIPE_SPACING, ticks, runs);
+    printf("ns/tick: min %.1f  median %.1f  max %.1f  (checksum %d)\n",
+           nsPerTick[0], nsPerTick[runs / 2], nsPerTick[runs - 1], checksum);
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "sim.h"
+#include "batch.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Seeded Flappy Bird scenarios for the `bench` build target. Prints a table
+// and writes the results as JSON for comparing commits.
+// Usage: flappy_bench_suite [out.json] [repeats]
+
+#define BATCH_WORLDS 4096
+
+typedef struct SimBench
+{
+    Sim sim;
+} SimBench;
+
+static void SetupSim(void *ctx)
+{
+    SimInit(&((SimBench *)ctx)->sim, 1234);
+}
+
+// One UpdateGame tick: the autopilot's input then SimStep
+static uint64_t RunSim(void *ctx, long long ops)
+{
+    Sim *sim = &((SimBench *)ctx)->sim;
+    uint64_t hash = BENCH_HASH_START;
+    for (long long t = 0; t < ops; t++)
+    {
+        SimStep(sim, SimAutopilot(sim), SIM_DT);
+        hash = BenchHash(hash, (uint64_t)sim->score);
+    }
+    uint32_t y;
+    memcpy(&y, &sim->bird.position.y, sizeof(y));
+    return BenchHash(hash, y);
+}
+
+typedef struct BatchBench
+{
+    FlappyBatch batch;
+} BatchBench;
+
+static void SetupBatch(void *ctx)
+{
+    BatchBench *b = ctx;
+    BatchFree(&b->batch);
+    BatchInit(&b->batch, BATCH_WORLDS, 99);
+}
+
+// One bird-step of the batched simulator on a single thread
+static uint64_t RunBatch(void *ctx, long long ops)
+{
+    FlappyBatch *batch = &((BatchBench *)ctx)->batch;
+    long long ticks = ops / BATCH_WORLDS;
+    for (long long t = 0; t < ticks; t++)
+    {
+        BatchAutopilot(batch, 0, BATCH_WORLDS, NULL);
+        BatchStepRange(batch, 0, BATCH_WORLDS);
+    }
+    uint64_t hash = BENCH_HASH_START;
+    for (int i = 0; i < BATCH_WORLDS; i++)
+        hash = BenchHash(hash, (uint64_t)batch->score[i] + ((uint64_t)batch->episodes[i] << 32));
+    return hash;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = (argc > 1) ? argv[1] : "flappy_bench.json";
+    int repeats = (argc > 2) ? atoi(argv[2]) : 7;
+
+    static SimBench sim;
+    static BatchBench batch;
+    BenchResult results[2];
+    int count = 0;
+
+    results[count++] = BenchMeasure("update_game", "tick", SetupSim, RunSim, &sim, 1000000, repeats);
+    BenchPrint(&results[count - 1]);
+    results[count++] = BenchMeasure("batch_step", "bird-step", SetupBatch, RunBatch, &batch, (long long)BATCH_WORLDS * 600, repeats);
+    BenchPrint(&results[count - 1]);
+    BatchFree(&batch.batch);
+
+    if (!BenchWriteJson(path, "flappy", results, count))
+    {
+        fprintf(stderr, "could not write %s\n", path);
+        return 1;
+    }
+    for (int i = 0; i < count; i++)
+    {
+        if (!results[i].reproducible)
+            return 1;
+    }
+    return 0;
+}
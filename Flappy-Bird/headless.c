@@ -0,0 +1,45 @@
+#include "sim.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Runs the simulation without a window as fast as the CPU allows.
+// Usage: flappy_headless [ticks] [seed]
+
+int main(int argc, char **argv)
+{
+    long long ticks = (argc > 1) ? atoll(argv[1]) : 10000000;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1;
+
+    static Sim sim;
+    SimInit(&sim, seed);
+
+    long long games = 0;
+    long long totalScore = 0;
+    int bestScore = 0;
+
+    double start = BenchNowSeconds();
+    for (long long t = 0; t < ticks; t++)
+    {
+        SimInput input = SimAutopilot(&sim);
+        if (input.restart)
+        {
+            games++;
+            totalScore += sim.score;
+            if (sim.score > bestScore)
+                bestScore = sim.score;
+        }
+        SimStep(&sim, input, SIM_DT);
+    }
+    double elapsed = BenchNowSeconds() - start;
+
+    printf("ticks:        %lld\n", ticks);
+    printf("seconds:      %.3f\n", elapsed);
+    printf("ticks/sec:    %.0f\n", ticks / elapsed);
+    printf("realtime x:   %.0f\n", (ticks / (double)SIM_TICK_RATE) / elapsed);
+    printf("games:        %lld\n", games);
+    printf("avg score:    %.2f\n", games ? (double)totalScore / games : 0.0);
+    printf("best score:   %d\n", bestScore);
+    printf("final score:  %d%s\n", sim.score, sim.gameOver ? " (dead)" : "");
+    return 0;
+}
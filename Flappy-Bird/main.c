@@ -1,62 +1,163 @@
 #include "raylib.h"
 #include "rlgl.h"
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "replay.h"
+#include "../common/profile.h"
+#include "../common/hudtext.h"
+
+static Sim sim;
+static Replay replay = {0};
+static const char *replayPath = NULL;
+static SimInput pendingInput = {0};
+static float accumulator = 0.0f;
+
+// Pipe pass counters for the F1 overlay. F2 toggles the batched quad stream,
+// F3 toggles culling so both savings can be compared live. F4 shows zone
+// timings and F5 saves them as a trace (builds with -DPROFILE).
+typedef struct DrawStats
+{
+    int pipesDrawn;
+    int drawCalls;
+    int vertices;
+} DrawStats;
+
+static DrawStats drawStats = {0};
+static HudText hudText;
+// Text quads and batches of the previous frame, for the F1 overlay
+static int textQuads = 0;
+static int textCalls = 0;
+static bool showDrawStats = false;
+static bool showProfile = false;
+static bool batchPipes = true;
+static bool cullPipes = true;
 
-#define SCREEN_WIDTH 800
-#define SCREEN_HEIGHT 450
+void InitGame(void);
+void UpdateGame(void);
+void DrawGame(void);
+void UnloadGame(void);
+void UpdateDrawFrame(void);
 
-#define MAX_PIPES 100
-#define PIPE_WIDTH 80
-#define PIPE_CAP_HEIGHT 30
-#define PIPE_SPACING 320
-#define GAP_SIZE 140
+static void PushQuad(Rectangle r, Color c)
+{
+    rlColor4ub(c.r, c.g, c.b, c.a);
+    rlVertex2f(r.x, r.y);
+    rlVertex2f(r.x, r.y + r.height);
+    rlVertex2f(r.x + r.width, r.y + r.height);
+    rlVertex2f(r.x + r.width, r.y);
+    drawStats.vertices += 4;
+}
 
-#define GRAVITY 1100.0f
-#define JUMP_STRENGTH 380.0f
-#define PIPE_SPEED 220.0f
-#define ROTATION_SPEED 3.0f
+// Same strips DrawRectangleLinesEx emits
+static void PushQuadLines(Rectangle r, float thick, Color c)
+{
+    PushQuad((Rectangle){r.x, r.y, r.width, thick}, c);
+    PushQuad((Rectangle){r.x, r.y + r.height - thick, r.width, thick}, c);
+    PushQuad((Rectangle){r.x, r.y + thick, thick, r.height - thick * 2}, c);
+    PushQuad((Rectangle){r.x + r.width - thick, r.y + thick, thick, r.height - thick * 2}, c);
+}
 
-typedef struct Bird
+static void PushPipeHalf(Rectangle body, Rectangle cap, Color fill, Color outline, Color highlight)
 {
-    Vector2 position;
-    float radius;
-    float velocity;
-    float rotation;
-} Bird;
+    PushQuad(body, fill);
+    PushQuadLines(body, 3, outline);
+    PushQuad(cap, fill);
+    PushQuadLines(cap, 3, outline);
+    PushQuad((Rectangle){body.x + 10, body.y, 10, body.height}, highlight);
+}
 
-typedef struct Pipe
+static void DrawPipeHalf(Rectangle body, Rectangle cap, Color fill, Color outline, Color highlight)
 {
-    Rectangle topRect;
-    Rectangle bottomRect;
-    bool active;
-    bool passed;
-} Pipe;
+    DrawRectangleRec(body, fill);
+    DrawRectangleLinesEx(body, 3, outline);
+    DrawRectangleRec(cap, fill);
+    DrawRectangleLinesEx(cap, 3, outline);
+    DrawRectangle(body.x + 10, body.y, 10, body.height, highlight);
+    drawStats.drawCalls += 5;
+    drawStats.vertices += 4 + 16 + 4 + 16 + 4;
+}
 
-typedef struct Cloud
+static void DrawPipes(void)
 {
-    Vector2 pos;
-    float speed;
-    int size;
-} Cloud;
-
-static Bird bird = {0};
-static Pipe pipes[MAX_PIPES] = {0};
-static Cloud clouds[5] = {0}; 
-static int score = 0;
-static int highScore = 0;
-static bool gameOver = false;
-static bool gamePaused = false;
-static float flashTimer = 0.0f;
+    Color pipeColor = (Color){0, 200, 0, 255};
+    Color pipeOutline = DARKGREEN;
+    Color highlight = Fade(WHITE, 0.3f);
 
-void InitGame(void);
-void UpdateGame(void);
-void DrawGame(void);
-void UnloadGame(void);
-void UpdateDrawFrame(void);
+    // Ring order is left to right, so the visible pipes form a contiguous run
+    int first = 0;
+    int count = MAX_PIPES;
+    if (cullPipes)
+    {
+        while (first < MAX_PIPES && SimPipeX(&sim, first) + PIPE_WIDTH + 4 <= 0)
+            first++;
+        count = 0;
+        while (first + count < MAX_PIPES && SimPipeX(&sim, first + count) - 4 < SCREEN_WIDTH)
+            count++;
+    }
+
+    drawStats.pipesDrawn = count;
+
+    if (batchPipes)
+    {
+        rlCheckRenderBatchLimit(count * 2 * 11 * 4);
+        rlSetTexture(rlGetTextureIdDefault());
+        rlBegin(RL_QUADS);
+        rlNormal3f(0.0f, 0.0f, 1.0f);
+    }
+
+    for (int k = first; k < first + count; k++)
+    {
+        Rectangle topRect = SimPipeTopRect(&sim, k);
+        Rectangle bottomRect = SimPipeBottomRect(&sim, k);
+        Rectangle topCap = {topRect.x - 4, topRect.height - PIPE_CAP_HEIGHT, PIPE_WIDTH + 8, PIPE_CAP_HEIGHT};
+        Rectangle botCap = {bottomRect.x - 4, bottomRect.y, PIPE_WIDTH + 8, PIPE_CAP_HEIGHT};
+
+        if (batchPipes)
+        {
+            PushPipeHalf(topRect, topCap, pipeColor, pipeOutline, highlight);
+            PushPipeHalf(bottomRect, botCap, pipeColor, pipeOutline, highlight);
+        }
+        else
+        {
+            DrawPipeHalf(topRect, topCap, pipeColor, pipeOutline, highlight);
+            DrawPipeHalf(bottomRect, botCap, pipeColor, pipeOutline, highlight);
+        }
+    }
+
+    if (batchPipes)
+    {
+        rlEnd();
+        rlSetTexture(0);
+        drawStats.drawCalls++;
+    }
+}
+
+static void DrawStatsOverlay(void)
+{
+    char line[64];
+    DrawRectangle(10, 10, 250, 108, Fade(BLACK, 0.6f));
+    snprintf(line, sizeof(line), "pipes: %i / %i %s", drawStats.pipesDrawn, MAX_PIPES, cullPipes ? "(culled)" : "");
+    HudTextDraw(&hudText, line, 20, 18, 10, WHITE);
+    snprintf(line, sizeof(line), "pipe draw calls: %i", drawStats.drawCalls);
+    HudTextDraw(&hudText, line, 20, 36, 10, WHITE);
+    snprintf(line, sizeof(line), "pipe vertices: %i", drawStats.vertices);
+    HudTextDraw(&hudText, line, 20, 54, 10, WHITE);
+    HudTextDraw(&hudText, batchPipes ? "mode: batched rlgl quads [F2]" : "mode: immediate shapes [F2]", 20, 72, 10, WHITE);
+    snprintf(line, sizeof(line), "text: %i glyphs in %i batches", textQuads, textCalls);
+    HudTextDraw(&hudText, line, 20, 90, 10, WHITE);
+}
 
-int main(void)
+int main(int argc, char **argv)
 {
+    // flappy bird -record session.rpl
+    if (argc > 2 && strcmp(argv[1], "-record") == 0)
+        replayPath = argv[2];
+
     InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "flappy bird");
+    HudTextInit(&hudText, GetFontDefault());
     InitGame();
     SetTargetFPS(60);
 
@@ -66,143 +167,57 @@ int main(void)
     }
 
     UnloadGame();
+    HudTextFree(&hudText);
+    ProfileShutdown();
     CloseWindow();
     return 0;
 }
 
 void InitGame(void)
 {
-    score = 0;
-    gameOver = false;
-    gamePaused = false;
-    flashTimer = 0.0f;
-
-    bird.position = (Vector2){100, SCREEN_HEIGHT / 2.0f};
-    bird.velocity = 0;
-    bird.radius = 18;
-    bird.rotation = 0;
-
-    for (int i = 0; i < MAX_PIPES; i++)
-    {
-        pipes[i].active = true;
-        pipes[i].passed = false;
-
-        float posX = SCREEN_WIDTH + 200 + i * PIPE_SPACING;
-
-        float gapY = GetRandomValue(80, SCREEN_HEIGHT - 80 - GAP_SIZE);
-
-        pipes[i].topRect = (Rectangle){posX, 0, PIPE_WIDTH, gapY};
-        pipes[i].bottomRect = (Rectangle){posX, gapY + GAP_SIZE, PIPE_WIDTH, SCREEN_HEIGHT - (gapY + GAP_SIZE)};
-    }
-
-    for (int i = 0; i < 5; i++)
-    {
-        clouds[i].pos = (Vector2){(float)GetRandomValue(0, SCREEN_WIDTH), (float)GetRandomValue(20, 150)};
-        clouds[i].speed = (float)GetRandomValue(20, 50);
-        clouds[i].size = GetRandomValue(30, 60);
-    }
+    uint64_t seed = (uint64_t)time(NULL);
+    SimInit(&sim, seed);
+    if (replayPath)
+        ReplayBegin(&replay, seed);
+    pendingInput = (SimInput){0};
+    accumulator = 0.0f;
 }
 
 void UpdateGame(void)
 {
-    float dt = GetFrameTime();
-
-    if (!gameOver)
+    PROFILE_BEGIN(input, "input");
+    if (IsKeyPressed(KEY_F1))
+        showDrawStats = !showDrawStats;
+    if (IsKeyPressed(KEY_F2))
+        batchPipes = !batchPipes;
+    if (IsKeyPressed(KEY_F3))
+        cullPipes = !cullPipes;
+    if (IsKeyPressed(KEY_F4))
+        showProfile = !showProfile;
+    if (IsKeyPressed(KEY_F5) && !ProfileWriteChromeTrace("profile.json"))
+        TraceLog(LOG_WARNING, "Could not write profile.json");
+
+    if (IsKeyPressed('P'))
+        pendingInput.pause = true;
+    if (IsKeyPressed(KEY_SPACE) || IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
+        pendingInput.flap = true;
+    if (IsKeyPressed(KEY_ENTER))
+        pendingInput.restart = true;
+    PROFILE_END(input);
+
+    // Presses latch until the next fixed tick consumes them
+    PROFILE_ZONE("physics");
+    accumulator += GetFrameTime();
+    if (accumulator > 0.25f)
+        accumulator = 0.25f;
+
+    while (accumulator >= SIM_DT)
     {
-        if (IsKeyPressed('P'))
-            gamePaused = !gamePaused;
-
-        if (!gamePaused)
-        {
-            for (int i = 0; i < 5; i++)
-            {
-                clouds[i].pos.x -= clouds[i].speed * dt;
-                if (clouds[i].pos.x < -100)
-                    clouds[i].pos.x = SCREEN_WIDTH + 100;
-            }
-
-            if (IsKeyPressed(KEY_SPACE) || IsMouseButtonPressed(MOUSE_LEFT_BUTTON))
-            {
-                bird.velocity = -JUMP_STRENGTH;
-                bird.rotation = -25.0f;
-            }
-
-            bird.velocity += GRAVITY * dt;
-            bird.position.y += bird.velocity * dt;
-
-            if (bird.velocity > 100)
-            {
-                bird.rotation += ROTATION_SPEED;
-                if (bird.rotation > 90.0f)
-                    bird.rotation = 90.0f;
-            }
-
-            for (int i = 0; i < MAX_PIPES; i++)
-            {
-                pipes[i].topRect.x -= PIPE_SPEED * dt;
-                pipes[i].bottomRect.x -= PIPE_SPEED * dt;
-
-                if (pipes[i].topRect.x + pipes[i].topRect.width < 0)
-                {
-                    float furthestX = 0;
-                    for (int j = 0; j < MAX_PIPES; j++)
-                    {
-                        if (pipes[j].topRect.x > furthestX)
-                            furthestX = pipes[j].topRect.x;
-                    }
-
-                    float newX = furthestX + PIPE_SPACING;
-                    float gapY = GetRandomValue(80, SCREEN_HEIGHT - 80 - GAP_SIZE);
-
-                    pipes[i].topRect.x = newX;
-                    pipes[i].topRect.height = gapY;
-                    pipes[i].bottomRect.x = newX;
-                    pipes[i].bottomRect.y = gapY + GAP_SIZE;
-                    pipes[i].bottomRect.height = SCREEN_HEIGHT - (gapY + GAP_SIZE);
-                    pipes[i].passed = false;
-                }
-
-                if (CheckCollisionCircleRec(bird.position, bird.radius, pipes[i].topRect))
-                {
-                    gameOver = true;
-                    flashTimer = 1.0f;
-                }
-                if (CheckCollisionCircleRec(bird.position, bird.radius, pipes[i].bottomRect))
-                {
-                    gameOver = true;
-                    flashTimer = 1.0f;
-                }
-
-                if (!pipes[i].passed && bird.position.x > pipes[i].topRect.x + PIPE_WIDTH)
-                {
-                    score++;
-                    pipes[i].passed = true;
-                }
-            }
-
-            if ((bird.position.y - bird.radius) < 0)
-            {
-                bird.position.y = bird.radius;
-                bird.velocity = 0;
-            }
-            if ((bird.position.y + bird.radius) > SCREEN_HEIGHT)
-            {
-                gameOver = true;
-                flashTimer = 1.0f;
-            }
-        }
-    }
-    else
-    {
-        if (bird.position.y < SCREEN_HEIGHT + 50)
-        {
-            bird.velocity += GRAVITY * dt;
-            bird.position.y += bird.velocity * dt;
-            bird.rotation += 5.0f;
-        }
-
-        if (IsKeyPressed(KEY_ENTER))
-            InitGame();
+        if (replayPath)
+            ReplayRecord(&replay, pendingInput);
+        SimStep(&sim, pendingInput, SIM_DT);
+        pendingInput = (SimInput){0};
+        accumulator -= SIM_DT;
     }
 }
 
@@ -229,9 +244,12 @@ void DrawBird(Bird b)
 void DrawGame(void)
 {
     BeginDrawing();
+    PROFILE_BEGIN(draw, "draw");
     ClearBackground(SKYBLUE);
 
-    for (int i = 0; i < 5; i++)
+    const Cloud *clouds = sim.clouds;
+
+    for (int i = 0; i < MAX_CLOUDS; i++)
     {
         DrawCircle((int)clouds[i].pos.x, (int)clouds[i].pos.y, clouds[i].size, Fade(WHITE, 0.5f));
         DrawCircle((int)clouds[i].pos.x + 20, (int)clouds[i].pos.y + 10, clouds[i].size * 0.8, Fade(WHITE, 0.5f));
@@ -240,51 +258,57 @@ void DrawGame(void)
     DrawRectangle(0, SCREEN_HEIGHT - 50, SCREEN_WIDTH, 50, (Color){100, 200, 100, 255}); 
     DrawLine(0, SCREEN_HEIGHT - 50, SCREEN_WIDTH, SCREEN_HEIGHT - 50, DARKGREEN);        
 
-    Color pipeColor = (Color){0, 200, 0, 255}; 
-    Color pipeOutline = DARKGREEN;
-
-    for (int i = 0; i < MAX_PIPES; i++)
-    {
-        DrawRectangleRec(pipes[i].topRect, pipeColor);
-        DrawRectangleLinesEx(pipes[i].topRect, 3, pipeOutline);
-
-        Rectangle topCap = {pipes[i].topRect.x - 4, pipes[i].topRect.height - PIPE_CAP_HEIGHT, PIPE_WIDTH + 8, PIPE_CAP_HEIGHT};
-        DrawRectangleRec(topCap, pipeColor);
-        DrawRectangleLinesEx(topCap, 3, pipeOutline);
-
-        DrawRectangle(pipes[i].topRect.x + 10, 0, 10, pipes[i].topRect.height, Fade(WHITE, 0.3f));
+    drawStats = (DrawStats){0};
+    DrawPipes();
 
-        DrawRectangleRec(pipes[i].bottomRect, pipeColor);
-        DrawRectangleLinesEx(pipes[i].bottomRect, 3, pipeOutline);
+    DrawBird(sim.bird);
+    PROFILE_END(draw);
 
-        Rectangle botCap = {pipes[i].bottomRect.x - 4, pipes[i].bottomRect.y, PIPE_WIDTH + 8, PIPE_CAP_HEIGHT};
-        DrawRectangleRec(botCap, pipeColor);
-        DrawRectangleLinesEx(botCap, 3, pipeOutline);
-
-        DrawRectangle(pipes[i].bottomRect.x + 10, pipes[i].bottomRect.y, 10, pipes[i].bottomRect.height, Fade(WHITE, 0.3f));
-    }
+    PROFILE_BEGIN(hud, "hud");
+    char score[16];
+    snprintf(score, sizeof(score), "%i", sim.score);
+    HudTextDraw(&hudText, score, SCREEN_WIDTH / 2, 50, 50, WHITE);
+    HudTextDraw(&hudText, score, SCREEN_WIDTH / 2 + 2, 52, 50, BLACK);
 
-    DrawBird(bird);
-
-    DrawText(TextFormat("%i", score), SCREEN_WIDTH / 2, 50, 50, WHITE);
-    DrawText(TextFormat("%i", score), SCREEN_WIDTH / 2 + 2, 52, 50, BLACK); 
-
-    if (gameOver)
+    if (sim.gameOver)
     {
-        if (flashTimer > 0)
+        // The flash goes over the score, so the score is drawn first
+        if (sim.flashTimer > 0)
         {
-            DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(WHITE, flashTimer));
-            flashTimer -= 0.05f;
+            HudTextFlush(&hudText);
+            DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, Fade(WHITE, sim.flashTimer));
         }
 
-        DrawText("GAME OVER", SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, 40, WHITE);
-        DrawText("PRESS [ENTER]", SCREEN_WIDTH / 2 - 110, SCREEN_HEIGHT / 2 + 20, 30, WHITE);
+        HudTextDraw(&hudText, "GAME OVER", SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 50, 40, WHITE);
+        HudTextDraw(&hudText, "PRESS [ENTER]", SCREEN_WIDTH / 2 - 110, SCREEN_HEIGHT / 2 + 20, 30, WHITE);
     }
 
+    if (showDrawStats)
+        DrawStatsOverlay();
+    HudTextFlush(&hudText);
+    textQuads = hudText.flushedQuads;
+    textCalls = hudText.flushes;
+    HudTextResetStats(&hudText);
+    PROFILE_END(hud);
+
+    if (showProfile)
+        ProfileDrawOverlay(SCREEN_WIDTH - 310, 10);
+
     EndDrawing();
+    ProfileFrameEnd();
+}
+
+void UnloadGame(void)
+{
+    if (replayPath)
+    {
+        ReplayFinish(&replay, &sim);
+        if (!ReplaySave(&replay, replayPath))
+            TraceLog(LOG_WARNING, "Could not write replay %s", replayPath);
+        ReplayFree(&replay);
+    }
 }
 
-void UnloadGame(void) {}
 void UpdateDrawFrame(void)
 {
     UpdateGame();
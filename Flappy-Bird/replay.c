@@ -0,0 +1,265 @@
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_HEADER_SIZE 48
+
+static void PutU16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void PutU32(uint8_t *p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void PutU64(uint8_t *p, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void PutF32(uint8_t *p, float f)
+{
+    uint32_t v;
+    memcpy(&v, &f, sizeof(v));
+    PutU32(p, v);
+}
+
+static uint16_t GetU16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t GetU32(const uint8_t *p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++)
+        v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+static uint64_t GetU64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+static float GetF32(const uint8_t *p)
+{
+    uint32_t v = GetU32(p);
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+static void PushByte(Replay *replay, uint8_t byte)
+{
+    if (replay->eventBytes == replay->eventCapacity)
+    {
+        size_t capacity = replay->eventCapacity ? replay->eventCapacity * 2 : 256;
+        uint8_t *events = realloc(replay->events, capacity);
+        if (!events)
+        {
+            replay->failed = true;
+            return;
+        }
+        replay->events = events;
+        replay->eventCapacity = capacity;
+    }
+    replay->events[replay->eventBytes++] = byte;
+}
+
+static uint8_t InputFlags(SimInput input)
+{
+    return (uint8_t)((input.flap ? REPLAY_FLAP : 0) | (input.pause ? REPLAY_PAUSE : 0) | (input.restart ? REPLAY_RESTART : 0));
+}
+
+void ReplayBegin(Replay *replay, uint64_t seed)
+{
+    ReplayFree(replay);
+    replay->seed = seed;
+}
+
+void ReplayRecord(Replay *replay, SimInput input)
+{
+    uint8_t flags = InputFlags(input);
+    uint32_t tick = replay->tickCount++;
+
+    if (!flags)
+        return;
+
+    uint32_t delta = tick - replay->lastEventTick;
+    replay->lastEventTick = tick;
+
+    do
+    {
+        uint8_t byte = delta & 0x7F;
+        delta >>= 7;
+        PushByte(replay, delta ? (byte | 0x80) : byte);
+    } while (delta);
+
+    PushByte(replay, flags);
+}
+
+ReplayEnd ReplayCapture(const Sim *sim)
+{
+    return (ReplayEnd){
+        .score = sim->score,
+        .highScore = sim->highScore,
+        .birdY = sim->bird.position.y,
+        .birdVelocity = sim->bird.velocity,
+        .birdRotation = sim->bird.rotation,
+        .gameOver = sim->gameOver,
+    };
+}
+
+bool ReplayEndEquals(ReplayEnd a, ReplayEnd b)
+{
+    return a.score == b.score && a.highScore == b.highScore && a.gameOver == b.gameOver &&
+           memcmp(&a.birdY, &b.birdY, sizeof(float)) == 0 &&
+           memcmp(&a.birdVelocity, &b.birdVelocity, sizeof(float)) == 0 &&
+           memcmp(&a.birdRotation, &b.birdRotation, sizeof(float)) == 0;
+}
+
+void ReplayFinish(Replay *replay, const Sim *sim)
+{
+    replay->end = ReplayCapture(sim);
+}
+
+void ReplayFree(Replay *replay)
+{
+    free(replay->events);
+    *replay = (Replay){0};
+}
+
+bool ReplaySave(const Replay *replay, const char *path)
+{
+    if (replay->failed)
+        return false;
+
+    uint8_t header[REPLAY_HEADER_SIZE] = {0};
+    PutU32(header + 0, REPLAY_MAGIC);
+    PutU16(header + 4, REPLAY_VERSION);
+    PutU64(header + 8, replay->seed);
+    PutU32(header + 16, replay->tickCount);
+    PutU32(header + 20, (uint32_t)replay->eventBytes);
+    PutU32(header + 24, (uint32_t)replay->end.score);
+    PutU32(header + 28, (uint32_t)replay->end.highScore);
+    PutF32(header + 32, replay->end.birdY);
+    PutF32(header + 36, replay->end.birdVelocity);
+    PutF32(header + 40, replay->end.birdRotation);
+    header[44] = replay->end.gameOver;
+
+    FILE *file = fopen(path, "wb");
+    if (!file)
+        return false;
+
+    bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    if (ok && replay->eventBytes)
+        ok = fwrite(replay->events, 1, replay->eventBytes, file) == replay->eventBytes;
+
+    return (fclose(file) == 0) && ok;
+}
+
+bool ReplayLoad(Replay *replay, const char *path)
+{
+    ReplayFree(replay);
+
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    uint8_t header[REPLAY_HEADER_SIZE];
+    bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+              GetU32(header) == REPLAY_MAGIC && GetU16(header + 4) == REPLAY_VERSION;
+
+    if (ok)
+    {
+        replay->seed = GetU64(header + 8);
+        replay->tickCount = GetU32(header + 16);
+        replay->eventBytes = GetU32(header + 20);
+        replay->end.score = (int32_t)GetU32(header + 24);
+        replay->end.highScore = (int32_t)GetU32(header + 28);
+        replay->end.birdY = GetF32(header + 32);
+        replay->end.birdVelocity = GetF32(header + 36);
+        replay->end.birdRotation = GetF32(header + 40);
+        replay->end.gameOver = header[44] != 0;
+
+        replay->eventCapacity = replay->eventBytes;
+        replay->events = malloc(replay->eventBytes ? replay->eventBytes : 1);
+        ok = replay->events && fread(replay->events, 1, replay->eventBytes, file) == replay->eventBytes;
+    }
+
+    fclose(file);
+    if (!ok)
+        ReplayFree(replay);
+    return ok;
+}
+
+// Decodes the next event; returns false at the end of the stream
+static bool NextEvent(const Replay *replay, size_t *cursor, uint32_t *tick, uint8_t *flags)
+{
+    uint32_t delta = 0;
+    int shift = 0;
+
+    while (*cursor < replay->eventBytes)
+    {
+        // A 32-bit delta takes at most five bytes
+        if (shift > 28)
+            return false;
+        uint8_t byte = replay->events[(*cursor)++];
+        delta |= (uint32_t)(byte & 0x7F) << shift;
+        shift += 7;
+
+        if (!(byte & 0x80))
+        {
+            if (*cursor >= replay->eventBytes)
+                return false;
+            *tick += delta;
+            *flags = replay->events[(*cursor)++];
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ReplayPlay(const Replay *replay, Sim *sim)
+{
+    SimInit(sim, replay->seed);
+
+    size_t cursor = 0;
+    uint32_t eventTick = 0;
+    uint8_t flags = 0;
+    bool pending = NextEvent(replay, &cursor, &eventTick, &flags);
+
+    uint32_t tick = 0;
+    while (tick < replay->tickCount)
+    {
+        // Fast-forward the idle stretch up to the next event in one tight loop
+        uint32_t idleEnd = (pending && eventTick < replay->tickCount) ? eventTick : replay->tickCount;
+        for (; tick < idleEnd; tick++)
+            SimStep(sim, (SimInput){0}, SIM_DT);
+
+        if (tick == replay->tickCount)
+            break;
+
+        SimInput input = {
+            .flap = (flags & REPLAY_FLAP) != 0,
+            .pause = (flags & REPLAY_PAUSE) != 0,
+            .restart = (flags & REPLAY_RESTART) != 0,
+        };
+        SimStep(sim, input, SIM_DT);
+        tick++;
+
+        pending = NextEvent(replay, &cursor, &eventTick, &flags);
+    }
+
+    return ReplayEndEquals(ReplayCapture(sim), replay->end);
+}
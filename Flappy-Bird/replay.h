@@ -0,0 +1,60 @@
+#ifndef FLAPPY_REPLAY_H
+#define FLAPPY_REPLAY_H
+
+#include "sim.h"
+#include <stddef.h>
+
+// Binary replay of one play session: the RNG seed, every non-idle tick input
+// and the state the session ended in. Idle ticks are not stored; each event
+// is a LEB128 tick delta from the previous event followed by one flag byte,
+// so a typical game of a few thousand ticks fits in a few hundred bytes.
+//
+// Playback relies on SimStep being bit-for-bit deterministic, so replays are
+// only guaranteed to verify against a build using the same float settings.
+
+#define REPLAY_MAGIC 0x50524246u
+#define REPLAY_VERSION 1
+
+#define REPLAY_FLAP 0x01
+#define REPLAY_PAUSE 0x02
+#define REPLAY_RESTART 0x04
+
+typedef struct ReplayEnd
+{
+    int32_t score;
+    int32_t highScore;
+    float birdY;
+    float birdVelocity;
+    float birdRotation;
+    bool gameOver;
+} ReplayEnd;
+
+typedef struct Replay
+{
+    uint64_t seed;
+    uint32_t tickCount;
+    uint32_t lastEventTick;
+    uint8_t *events;
+    size_t eventBytes;
+    size_t eventCapacity;
+    bool failed; // an event was dropped when the buffer could not grow
+    ReplayEnd end;
+} Replay;
+
+void ReplayBegin(Replay *replay, uint64_t seed);
+void ReplayRecord(Replay *replay, SimInput input);
+void ReplayFinish(Replay *replay, const Sim *sim);
+void ReplayFree(Replay *replay);
+
+// Fails if the recording lost an event to an allocation failure
+bool ReplaySave(const Replay *replay, const char *path);
+bool ReplayLoad(Replay *replay, const char *path);
+
+ReplayEnd ReplayCapture(const Sim *sim);
+bool ReplayEndEquals(ReplayEnd a, ReplayEnd b);
+
+// Re-runs the recording into sim and reports whether it ended in the
+// recorded state. sim is left in the final state for inspection.
+bool ReplayPlay(const Replay *replay, Sim *sim);
+
+#endif
@@ -0,0 +1,107 @@
+#include "replay.h"
+#include "../common/bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// flappy_replay record <out.rpl> <seed> [noise]
+//     Plays one autopilot game until the bird dies and saves it. noise is the
+//     per-tick chance (0..1) of overriding the autopilot with a random choice.
+// flappy_replay verify [-n repeat] <file.rpl>...
+//     Re-simulates every replay headlessly and checks the recorded end state.
+
+#define RECORD_TICK_LIMIT 1000000
+
+static int Record(const char *path, uint64_t seed, float noise)
+{
+    static Sim sim;
+    Replay replay = {0};
+    SimRng noiseRng;
+
+    SimInit(&sim, seed);
+    SimRngSeed(&noiseRng, seed ^ 0xA5A5A5A5u);
+    ReplayBegin(&replay, seed);
+
+    for (int t = 0; t < RECORD_TICK_LIMIT && !sim.gameOver; t++)
+    {
+        SimInput input = SimAutopilot(&sim);
+        if ((float)SimRngNext(&noiseRng) / 4294967296.0f < noise)
+            input.flap = (SimRngNext(&noiseRng) & 1) != 0;
+
+        ReplayRecord(&replay, input);
+        SimStep(&sim, input, SIM_DT);
+    }
+
+    ReplayFinish(&replay, &sim);
+    bool ok = ReplaySave(&replay, path);
+    printf("%s: %u ticks, %zu event bytes, score %d\n", path, replay.tickCount, replay.eventBytes, sim.score);
+    ReplayFree(&replay);
+    return ok ? 0 : 1;
+}
+
+static int Verify(int count, char **paths, int repeat)
+{
+    Replay *replays = calloc(count, sizeof(Replay));
+    static Sim sim;
+    int failures = 0;
+    long long ticks = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!ReplayLoad(&replays[i], paths[i]))
+        {
+            printf("%s: cannot load\n", paths[i]);
+            failures++;
+        }
+    }
+
+    double start = BenchNowSeconds();
+    for (int r = 0; r < repeat; r++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            if (!replays[i].events && replays[i].tickCount == 0)
+                continue;
+
+            bool match = ReplayPlay(&replays[i], &sim);
+            ticks += replays[i].tickCount;
+
+            if (!match && r == 0)
+            {
+                failures++;
+                printf("%s: MISMATCH score %d/%d bird y %.3f/%.3f\n", paths[i], sim.score, replays[i].end.score,
+                       sim.bird.position.y, replays[i].end.birdY);
+            }
+        }
+    }
+    double elapsed = BenchNowSeconds() - start;
+
+    printf("replays: %d x %d, failures: %d\n", count, repeat, failures);
+    printf("games/sec: %.0f  ticks/sec: %.0f\n", (double)count * repeat / elapsed, ticks / elapsed);
+
+    for (int i = 0; i < count; i++)
+        ReplayFree(&replays[i]);
+    free(replays);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "record") == 0)
+        return Record(argv[2], strtoull(argv[3], NULL, 10), (argc > 4) ? (float)atof(argv[4]) : 0.005f);
+
+    if (argc >= 3 && strcmp(argv[1], "verify") == 0)
+    {
+        int first = 2;
+        int repeat = 1;
+        if (argc >= 5 && strcmp(argv[2], "-n") == 0)
+        {
+            repeat = atoi(argv[3]);
+            first = 4;
+        }
+        return Verify(argc - first, argv + first, repeat < 1 ? 1 : repeat);
+    }
+
+    fprintf(stderr, "usage: %s record <out.rpl> <seed> [noise]\n       %s verify [-n repeat] <file.rpl>...\n", argv[0], argv[0]);
+    return 2;
+}
@@ -0,0 +1,259 @@
+#include "sim.h"
+#include <math.h>
+
+static bool CircleRecOverlap(Vector2 center, float radius, Rectangle rec)
+{
+    float halfW = rec.width / 2.0f;
+    float halfH = rec.height / 2.0f;
+    float dx = fabsf(center.x - (rec.x + halfW));
+    float dy = fabsf(center.y - (rec.y + halfH));
+
+    if (dx > halfW + radius)
+        return false;
+    if (dy > halfH + radius)
+        return false;
+    if (dx <= halfW)
+        return true;
+    if (dy <= halfH)
+        return true;
+
+    float cx = dx - halfW;
+    float cy = dy - halfH;
+    return (cx * cx + cy * cy) <= (radius * radius);
+}
+
+static int PipeSlot(const Sim *sim, int k)
+{
+    int slot = sim->pipeHead + k;
+    return (slot >= MAX_PIPES) ? slot - MAX_PIPES : slot;
+}
+
+static float RandomGapY(Sim *sim)
+{
+    return (float)SimRandomValue(&sim->rng, 80, SCREEN_HEIGHT - 80 - GAP_SIZE);
+}
+
+// The pipe that scrolled off the left edge becomes the new tail, one spacing
+// behind the previous tail.
+static void RecyclePipe(Sim *sim)
+{
+    Pipe *pipe = &sim->pipes[sim->pipeHead];
+    pipe->gapY = RandomGapY(sim);
+    pipe->passed = false;
+
+    sim->pipeTail = sim->pipeHead;
+    sim->pipeHead = (sim->pipeHead + 1 == MAX_PIPES) ? 0 : sim->pipeHead + 1;
+    sim->pipeHeadX += PIPE_SPACING;
+}
+
+static void KillBird(Sim *sim)
+{
+    sim->gameOver = true;
+    sim->flashTimer = 1.0f;
+}
+
+void SimRngSeed(SimRng *rng, uint64_t seed)
+{
+    // splitmix64 so that nearby seeds still give unrelated streams
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    rng->state = z ^ (z >> 31);
+}
+
+uint32_t SimRngNext(SimRng *rng)
+{
+    // PCG-XSH-RR
+    uint64_t old = rng->state;
+    rng->state = old * 6364136223846793005ull + 1442695040888963407ull;
+    uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+    uint32_t rot = (uint32_t)(old >> 59);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+int SimRandomValue(SimRng *rng, int min, int max)
+{
+    if (min > max)
+    {
+        int tmp = max;
+        max = min;
+        min = tmp;
+    }
+    uint32_t range = (uint32_t)(max - min) + 1u;
+    return min + (int)(SimRngNext(rng) % range);
+}
+
+void SimInit(Sim *sim, uint64_t seed)
+{
+    *sim = (Sim){0};
+    SimRngSeed(&sim->rng, seed);
+    SimReset(sim);
+}
+
+void SimReset(Sim *sim)
+{
+    sim->score = 0;
+    sim->gameOver = false;
+    sim->gamePaused = false;
+    sim->flashTimer = 0.0f;
+
+    sim->bird.position = (Vector2){100, SCREEN_HEIGHT / 2.0f};
+    sim->bird.velocity = 0;
+    sim->bird.radius = 18;
+    sim->bird.rotation = 0;
+
+    sim->pipeHead = 0;
+    sim->pipeTail = MAX_PIPES - 1;
+    sim->pipeHeadX = SCREEN_WIDTH + 200;
+    for (int i = 0; i < MAX_PIPES; i++)
+    {
+        sim->pipes[i].passed = false;
+        sim->pipes[i].gapY = RandomGapY(sim);
+    }
+
+    for (int i = 0; i < MAX_CLOUDS; i++)
+    {
+        sim->clouds[i].pos = (Vector2){(float)SimRandomValue(&sim->rng, 0, SCREEN_WIDTH), (float)SimRandomValue(&sim->rng, 20, 150)};
+        sim->clouds[i].speed = (float)SimRandomValue(&sim->rng, 20, 50);
+        sim->clouds[i].size = SimRandomValue(&sim->rng, 30, 60);
+    }
+}
+
+void SimStep(Sim *sim, SimInput input, float dt)
+{
+    Bird *bird = &sim->bird;
+    sim->tick++;
+
+    if (!sim->gameOver)
+    {
+        if (input.pause)
+            sim->gamePaused = !sim->gamePaused;
+
+        if (sim->gamePaused)
+            return;
+
+        for (int i = 0; i < MAX_CLOUDS; i++)
+        {
+            sim->clouds[i].pos.x -= sim->clouds[i].speed * dt;
+            if (sim->clouds[i].pos.x < -100)
+                sim->clouds[i].pos.x = SCREEN_WIDTH + 100;
+        }
+
+        if (input.flap)
+        {
+            bird->velocity = -JUMP_STRENGTH;
+            bird->rotation = -25.0f;
+        }
+
+        bird->velocity += GRAVITY * dt;
+        bird->position.y += bird->velocity * dt;
+
+        if (bird->velocity > 100)
+        {
+            bird->rotation += ROTATION_SPEED;
+            if (bird->rotation > 90.0f)
+                bird->rotation = 90.0f;
+        }
+
+        sim->pipeHeadX -= PIPE_SPEED * dt;
+        while (sim->pipeHeadX + PIPE_WIDTH < 0)
+            RecyclePipe(sim);
+
+        // Everything past the right edge of the screen cannot touch the bird
+        for (int k = 0; k < MAX_PIPES; k++)
+        {
+            float x = sim->pipeHeadX + k * PIPE_SPACING;
+            if (x >= SCREEN_WIDTH)
+                break;
+
+            Pipe *pipe = &sim->pipes[PipeSlot(sim, k)];
+            Rectangle topRect = {x, 0, PIPE_WIDTH, pipe->gapY};
+            Rectangle bottomRect = {x, pipe->gapY + GAP_SIZE, PIPE_WIDTH, SCREEN_HEIGHT - (pipe->gapY + GAP_SIZE)};
+
+            if (CircleRecOverlap(bird->position, bird->radius, topRect) ||
+                CircleRecOverlap(bird->position, bird->radius, bottomRect))
+                KillBird(sim);
+
+            if (!pipe->passed && bird->position.x > x + PIPE_WIDTH)
+            {
+                sim->score++;
+                pipe->passed = true;
+            }
+        }
+
+        if ((bird->position.y - bird->radius) < 0)
+        {
+            bird->position.y = bird->radius;
+            bird->velocity = 0;
+        }
+        if ((bird->position.y + bird->radius) > SCREEN_HEIGHT)
+            KillBird(sim);
+
+        if (sim->gameOver && sim->score > sim->highScore)
+            sim->highScore = sim->score;
+    }
+    else
+    {
+        if (bird->position.y < SCREEN_HEIGHT + 50)
+        {
+            bird->velocity += GRAVITY * dt;
+            bird->position.y += bird->velocity * dt;
+            bird->rotation += 5.0f;
+        }
+
+        // The flash used to fade by 0.05 per rendered frame at 60 FPS
+        if (sim->flashTimer > 0)
+            sim->flashTimer -= 3.0f * dt;
+
+        if (input.restart)
+            SimReset(sim);
+    }
+}
+
+SimInput SimAutopilot(const Sim *sim)
+{
+    SimInput input = {0};
+    const Bird *bird = &sim->bird;
+
+    if (sim->gameOver)
+    {
+        input.restart = true;
+        return input;
+    }
+
+    float gapBottom = SCREEN_HEIGHT / 2.0f + GAP_SIZE / 2.0f;
+    for (int k = 0; k < MAX_PIPES; k++)
+    {
+        if (SimPipeX(sim, k) + PIPE_WIDTH + bird->radius > bird->position.x)
+        {
+            gapBottom = SimPipeAt(sim, k)->gapY + GAP_SIZE;
+            break;
+        }
+    }
+
+    if (bird->velocity >= 0 && bird->position.y + bird->radius > gapBottom - 24.0f)
+        input.flap = true;
+
+    return input;
+}
+
+const Pipe *SimPipeAt(const Sim *sim, int k)
+{
+    return &sim->pipes[PipeSlot(sim, k)];
+}
+
+float SimPipeX(const Sim *sim, int k)
+{
+    return sim->pipeHeadX + k * PIPE_SPACING;
+}
+
+Rectangle SimPipeTopRect(const Sim *sim, int k)
+{
+    return (Rectangle){SimPipeX(sim, k), 0, PIPE_WIDTH, SimPipeAt(sim, k)->gapY};
+}
+
+Rectangle SimPipeBottomRect(const Sim *sim, int k)
+{
+    float bottomY = SimPipeAt(sim, k)->gapY + GAP_SIZE;
+    return (Rectangle){SimPipeX(sim, k), bottomY, PIPE_WIDTH, SCREEN_HEIGHT - bottomY};
+}
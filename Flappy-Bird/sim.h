@@ -0,0 +1,120 @@
+#ifndef FLAPPY_SIM_H
+#define FLAPPY_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Pure game logic for Flappy Bird: no window, no input polling, no global RNG.
+// Include after raylib.h when used together; the shared types below are only
+// defined when raylib has not already provided them.
+
+#define SCREEN_WIDTH 800
+#define SCREEN_HEIGHT 450
+
+#ifndef MAX_PIPES
+#define MAX_PIPES 100
+#endif
+#define MAX_CLOUDS 5
+#define PIPE_WIDTH 80
+#define PIPE_CAP_HEIGHT 30
+#ifndef PIPE_SPACING
+#define PIPE_SPACING 320
+#endif
+#define GAP_SIZE 140
+
+#define GRAVITY 1100.0f
+#define JUMP_STRENGTH 380.0f
+#define PIPE_SPEED 220.0f
+#define ROTATION_SPEED 3.0f
+
+#define SIM_TICK_RATE 60
+#define SIM_DT (1.0f / SIM_TICK_RATE)
+
+#if !defined(RL_VECTOR2_TYPE)
+typedef struct Vector2
+{
+    float x;
+    float y;
+} Vector2;
+#define RL_VECTOR2_TYPE
+#endif
+
+#if !defined(RL_RECTANGLE_TYPE)
+typedef struct Rectangle
+{
+    float x;
+    float y;
+    float width;
+    float height;
+} Rectangle;
+#define RL_RECTANGLE_TYPE
+#endif
+
+typedef struct Bird
+{
+    Vector2 position;
+    float radius;
+    float velocity;
+    float rotation;
+} Bird;
+
+// Pipes are evenly spaced, so only the gap is stored per pipe; the x of the
+// k-th pipe after the ring head is pipeHeadX + k * PIPE_SPACING.
+typedef struct Pipe
+{
+    float gapY;
+    bool passed;
+} Pipe;
+
+typedef struct Cloud
+{
+    Vector2 pos;
+    float speed;
+    int size;
+} Cloud;
+
+// Edge-triggered actions for a single tick
+typedef struct SimInput
+{
+    bool flap;
+    bool pause;
+    bool restart;
+} SimInput;
+
+typedef struct SimRng
+{
+    uint64_t state;
+} SimRng;
+
+typedef struct Sim
+{
+    Bird bird;
+    Pipe pipes[MAX_PIPES];
+    int pipeHead;
+    int pipeTail;
+    float pipeHeadX;
+    Cloud clouds[MAX_CLOUDS];
+    int score;
+    int highScore;
+    bool gameOver;
+    bool gamePaused;
+    float flashTimer;
+    uint64_t tick;
+    SimRng rng;
+} Sim;
+
+void SimInit(Sim *sim, uint64_t seed);
+void SimReset(Sim *sim);
+void SimStep(Sim *sim, SimInput input, float dt);
+SimInput SimAutopilot(const Sim *sim);
+
+const Pipe *SimPipeAt(const Sim *sim, int k);
+float SimPipeX(const Sim *sim, int k);
+Rectangle SimPipeTopRect(const Sim *sim, int k);
+Rectangle SimPipeBottomRect(const Sim *sim, int k);
+
+void SimRngSeed(SimRng *rng, uint64_t seed);
+uint32_t SimRngNext(SimRng *rng);
+int SimRandomValue(SimRng *rng, int min, int max);
+
+#endif
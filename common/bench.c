@@ -0,0 +1,77 @@
+// clock_gettime is POSIX, not C11
+#define _POSIX_C_SOURCE 199309L
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#define NOUSER
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+double BenchNowSeconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, now;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart/(double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+#endif
+}
+
+static int CompareDouble(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+BenchResult BenchMeasure(const char *name, const char *unit, BenchSetup setup, BenchRun run, void *ctx, long long ops, int repeats) {
+    if (repeats < 1) repeats = 1;
+    if (repeats > BENCH_MAX_REPEATS) repeats = BENCH_MAX_REPEATS;
+    if (ops < 1) ops = 1;
+
+    BenchResult result = { name, unit, ops, repeats, 0, 0, 0, 0, true };
+    double ns[BENCH_MAX_REPEATS];
+    for (int r = 0; r < repeats; r++) {
+        if (setup) setup(ctx);
+        double start = BenchNowSeconds();
+        uint64_t checksum = run(ctx, ops);
+        ns[r] = (BenchNowSeconds() - start)*1e9/(double)ops;
+        if (r == 0) result.checksum = checksum;
+        else result.reproducible &= checksum == result.checksum;
+    }
+    qsort(ns, repeats, sizeof(double), CompareDouble);
+    result.minNs = ns[0];
+    result.medianNs = ns[repeats/2];
+    result.maxNs = ns[repeats - 1];
+    return result;
+}
+
+void BenchPrint(const BenchResult *result) {
+    printf("%-22s %10.1f ns/%s (min %.1f, max %.1f, %d x %lld)  checksum %016llx%s\n",
+           result->name, result->medianNs, result->unit, result->minNs, result->maxNs, result->repeats, result->ops,
+           (unsigned long long)result->checksum, result->reproducible ? "" : "  NOT REPRODUCIBLE");
+    fflush(stdout);
+}
+
+bool BenchWriteJson(const char *path, const char *suite, const BenchResult *results, int count) {
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+    fprintf(file, "{\n  \"suite\": \"%s\",\n  \"benchmarks\": [\n", suite);
+    for (int i = 0; i < count; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(file, "    {\"name\": \"%s\", \"unit\": \"%s\", \"ops\": %lld, \"repeats\": %d, "
+                      "\"min_ns\": %.3f, \"median_ns\": %.3f, \"max_ns\": %.3f, \"checksum\": \"%016llx\", \"reproducible\": %s}%s\n",
+                r->name, r->unit, r->ops, r->repeats, r->minNs, r->medianNs, r->maxNs,
+                (unsigned long long)r->checksum, r->reproducible ? "true" : "false", i + 1 < count ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
@@ -0,0 +1,54 @@
+#ifndef COMMON_BENCH_H
+#define COMMON_BENCH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Timing and JSON output for the benchmark suites the `bench` build target
+// runs. A scenario is a setup function that puts ctx back into the same
+// seeded state and a run function that does ops operations and returns a
+// checksum of what they produced. Each repeat runs setup (not timed) then
+// run, so every repeat measures the same work; a checksum that differs
+// between repeats marks the result as not reproducible.
+
+typedef void (*BenchSetup)(void *ctx);
+typedef uint64_t (*BenchRun)(void *ctx, long long ops);
+
+typedef struct {
+    const char *name;
+    const char *unit;       // what one operation is
+    long long ops;          // per repeat
+    int repeats;
+    double minNs;           // per operation
+    double medianNs;
+    double maxNs;
+    uint64_t checksum;
+    bool reproducible;
+} BenchResult;
+
+#define BENCH_MAX_REPEATS 32
+
+BenchResult BenchMeasure(const char *name, const char *unit, BenchSetup setup, BenchRun run, void *ctx, long long ops, int repeats);
+void BenchPrint(const BenchResult *result);
+bool BenchWriteJson(const char *path, const char *suite, const BenchResult *results, int count);
+
+// FNV-1a step for building checksums
+static inline uint64_t BenchHash(uint64_t hash, uint64_t value) {
+    for (int i = 0; i < 8; i++) hash = (hash ^ ((value >> (8*i)) & 0xFF))*1099511628211ull;
+    return hash;
+}
+
+#define BENCH_HASH_START 1469598103934665603ull
+
+// Monotonic wall clock in seconds, for the tools that time their own loops
+double BenchNowSeconds(void);
+
+// xorshift32 step on the caller's seed, scaled to [min, max]
+static inline float BenchRandomFloat(unsigned int *seed, float min, float max) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return min + (max - min)*(float)(*seed & 0xFFFFFF)/16777215.0f;
+}
+
+#endif
@@ -0,0 +1,179 @@
+#include "hudtext.h"
+#include <stdlib.h>
+#include <string.h>
+
+// DrawText and MeasureText never go below size 10 and space letters by a
+// tenth of the size
+#define HUD_TEXT_MIN_SIZE 10
+// raylib's default for SetTextLineSpacing
+#define HUD_TEXT_LINE_SPACING 15.0f
+
+static int GlyphIndex(const Font *font, int codepoint) {
+    // As GetGlyphIndex: '?' for anything the font does not have
+    int fallback = 0;
+    for (int i = 0; i < font->glyphCount; i++) {
+        if (font->glyphs[i].value == '?') fallback = i;
+        if (font->glyphs[i].value == codepoint) return i;
+    }
+    return fallback;
+}
+
+// One UTF-8 codepoint; malformed bytes come out as '?' one at a time
+static int NextCodepoint(const char *text, int *bytes) {
+    const unsigned char *s = (const unsigned char *)text;
+    *bytes = 1;
+    if (s[0] < 0x80) return s[0];
+    int length = (s[0] >= 0xF0) ? 4 : (s[0] >= 0xE0) ? 3 : (s[0] >= 0xC0) ? 2 : 0;
+    if (length == 0) return '?';
+    int codepoint = s[0] & (0x3F >> (length - 1));
+    for (int i = 1; i < length; i++) {
+        if ((s[i] & 0xC0) != 0x80) return '?';
+        codepoint = (codepoint << 6) | (s[i] & 0x3F);
+    }
+    *bytes = length;
+    return codepoint;
+}
+
+bool HudTextInit(HudText *hud, Font font) {
+    memset(hud, 0, sizeof(*hud));
+    hud->font = font;
+    for (int c = 0; c < 128; c++) hud->asciiGlyph[c] = (short)GlyphIndex(&font, c);
+    hud->entries = calloc(HUD_TEXT_SETS*HUD_TEXT_WAYS, sizeof(HudTextEntry));
+    hud->queue = malloc(HUD_TEXT_MAX_QUADS*sizeof(HudGlyphQuad));
+    hud->queueColors = malloc(HUD_TEXT_MAX_QUADS*sizeof(Color));
+    if (!hud->entries || !hud->queue || !hud->queueColors) {
+        HudTextFree(hud);
+        return false;
+    }
+    return true;
+}
+
+void HudTextFree(HudText *hud) {
+    free(hud->entries);
+    free(hud->queue);
+    free(hud->queueColors);
+    memset(hud, 0, sizeof(*hud));
+}
+
+void HudTextResetStats(HudText *hud) {
+    hud->hits = hud->misses = hud->flushes = hud->flushedQuads = 0;
+}
+
+// The glyph placement of DrawTextEx and the width of MeasureTextEx
+int HudTextLayout(const HudText *hud, const char *text, int fontSize, HudGlyphQuad *out, int maxOut, int *width) {
+    const Font *font = &hud->font;
+    if (fontSize < HUD_TEXT_MIN_SIZE) fontSize = HUD_TEXT_MIN_SIZE;
+    float spacing = (float)(fontSize/HUD_TEXT_MIN_SIZE);
+    float scale = (float)fontSize/(float)font->baseSize;
+    float padding = (float)font->glyphPadding;
+
+    int count = 0;
+    int letters = 0, widestLetters = 0;
+    float x = 0.0f, y = 0.0f;
+    float lineWidth = 0.0f, widest = 0.0f;
+    for (int i = 0; text[i] != '\0';) {
+        int bytes;
+        int codepoint = NextCodepoint(&text[i], &bytes);
+        i += bytes;
+        int index = codepoint < 128 ? hud->asciiGlyph[codepoint] : GlyphIndex(font, codepoint);
+        const GlyphInfo *glyph = &font->glyphs[index];
+        const Rectangle *rec = &font->recs[index];
+
+        if (codepoint == '\n') {
+            y += HUD_TEXT_LINE_SPACING;
+            x = 0.0f;
+            if (lineWidth > widest) widest = lineWidth;
+            if (letters > widestLetters) widestLetters = letters;
+            lineWidth = 0.0f;
+            letters = 0;
+            continue;
+        }
+        letters++;
+        lineWidth += glyph->advanceX != 0 ? (float)glyph->advanceX : rec->width + (float)glyph->offsetX;
+
+        if (codepoint != ' ' && codepoint != '\t') {
+            if (count < maxOut) {
+                out[count].source = (Rectangle){ rec->x - padding, rec->y - padding, rec->width + 2.0f*padding, rec->height + 2.0f*padding };
+                out[count].dest = (Rectangle){ x + ((float)glyph->offsetX - padding)*scale, y + ((float)glyph->offsetY - padding)*scale,
+                                               (rec->width + 2.0f*padding)*scale, (rec->height + 2.0f*padding)*scale };
+            }
+            count++;
+        }
+        x += (glyph->advanceX != 0 ? (float)glyph->advanceX*scale : rec->width*scale) + spacing;
+    }
+    if (lineWidth > widest) widest = lineWidth;
+    if (letters > widestLetters) widestLetters = letters;
+    if (width) *width = (int)(widest*scale + (float)(widestLetters > 0 ? (widestLetters - 1) : 0)*spacing);
+    return count;
+}
+
+static uint32_t HashText(const char *text, int fontSize, int *length) {
+    uint32_t hash = 2166136261u ^ (uint32_t)fontSize;
+    int n = 0;
+    for (; text[n] != '\0'; n++) hash = (hash ^ (unsigned char)text[n])*16777619u;
+    *length = n;
+    return hash;
+}
+
+// The entry for text, laid out now if it was not cached; NULL when the text
+// is too long to cache
+static const HudTextEntry *Lookup(HudText *hud, const char *text, int fontSize) {
+    int length;
+    uint32_t hash = HashText(text, fontSize, &length);
+    if (length == 0 || length > HUD_TEXT_MAX_LENGTH) return NULL;
+
+    HudTextEntry *set = &hud->entries[(hash & (HUD_TEXT_SETS - 1))*HUD_TEXT_WAYS];
+    HudTextEntry *oldest = &set[0];
+    for (int w = 0; w < HUD_TEXT_WAYS; w++) {
+        HudTextEntry *e = &set[w];
+        if (e->length == length && e->hash == hash && e->fontSize == fontSize && memcmp(e->text, text, length) == 0) {
+            e->lastUsed = ++hud->frame;
+            hud->hits++;
+            return e;
+        }
+        if (e->length == 0 || (oldest->length != 0 && e->lastUsed < oldest->lastUsed)) oldest = e;
+    }
+
+    // Replace an empty or the least recently used way of the set
+    hud->misses++;
+    oldest->hash = hash;
+    oldest->fontSize = fontSize;
+    oldest->length = length;
+    memcpy(oldest->text, text, length + 1);
+    oldest->quadCount = HudTextLayout(hud, text, fontSize, oldest->quads, HUD_TEXT_MAX_LENGTH, &oldest->width);
+    oldest->lastUsed = ++hud->frame;
+    return oldest;
+}
+
+int HudTextMeasure(HudText *hud, const char *text, int fontSize) {
+    const HudTextEntry *e = Lookup(hud, text, fontSize);
+    if (e) return e->width;
+    int width = 0;
+    HudTextLayout(hud, text, fontSize, NULL, 0, &width);
+    return width;
+}
+
+static void Queue(HudText *hud, const HudGlyphQuad *quads, int count, int x, int y, Color color) {
+    // A full queue drops the rest of the text until the next flush
+    if (count > HUD_TEXT_MAX_QUADS - hud->queueCount) count = HUD_TEXT_MAX_QUADS - hud->queueCount;
+    for (int i = 0; i < count; i++) {
+        HudGlyphQuad *q = &hud->queue[hud->queueCount];
+        q->source = quads[i].source;
+        q->dest = (Rectangle){ quads[i].dest.x + (float)x, quads[i].dest.y + (float)y, quads[i].dest.width, quads[i].dest.height };
+        hud->queueColors[hud->queueCount++] = color;
+    }
+}
+
+void HudTextDraw(HudText *hud, const char *text, int x, int y, int fontSize, Color color) {
+    const HudTextEntry *e = Lookup(hud, text, fontSize);
+    if (e) {
+        Queue(hud, e->quads, e->quadCount, x, y, color);
+        return;
+    }
+    if (text[0] == '\0') return;
+
+    // Too long to cache: lay it out straight into the queue
+    HudGlyphQuad quads[256];
+    int count = HudTextLayout(hud, text, fontSize, quads, 256, NULL);
+    Queue(hud, quads, count < 256 ? count : 256, x, y, color);
+}
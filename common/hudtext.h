@@ -0,0 +1,71 @@
+#ifndef COMMON_HUDTEXT_H
+#define COMMON_HUDTEXT_H
+
+#include "raylib.h"
+#include <stdint.h>
+
+// HUD text that is laid out once per distinct string. HudTextDraw looks the
+// string up by content and size, laying its glyph quads out only on a miss,
+// and queues them; HudTextFlush sends everything queued as one textured quad
+// batch. A changed value is a new string, so only that entry is laid out
+// again and stale ones age out of the cache. Measuring and drawing match
+// MeasureText and DrawText with the same font. Nothing is allocated after
+// HudTextInit.
+
+#define HUD_TEXT_SETS 64            // power of two
+#define HUD_TEXT_WAYS 4
+#define HUD_TEXT_MAX_LENGTH 63      // longer strings are laid out every time
+#define HUD_TEXT_MAX_QUADS 4096     // queued between flushes; more is dropped
+
+typedef struct {
+    Rectangle source;   // in the font texture
+    Rectangle dest;     // from the text's top left corner
+} HudGlyphQuad;
+
+typedef struct {
+    uint32_t hash;
+    int fontSize;
+    int length;         // 0 for an empty slot
+    int width;
+    int quadCount;
+    uint32_t lastUsed;
+    char text[HUD_TEXT_MAX_LENGTH + 1];
+    HudGlyphQuad quads[HUD_TEXT_MAX_LENGTH];
+} HudTextEntry;
+
+typedef struct {
+    Font font;
+    short asciiGlyph[128];      // glyph index per ASCII codepoint
+    HudTextEntry *entries;      // HUD_TEXT_SETS*HUD_TEXT_WAYS
+    uint32_t frame;
+
+    HudGlyphQuad *queue;
+    Color *queueColors;
+    int queueCount;
+
+    // Since the last HudTextResetStats
+    int hits;
+    int misses;
+    int flushes;
+    int flushedQuads;
+} HudText;
+
+bool HudTextInit(HudText *hud, Font font);
+void HudTextFree(HudText *hud);
+
+// Same width as MeasureText
+int HudTextMeasure(HudText *hud, const char *text, int fontSize);
+
+// Queues text where DrawText would put it
+void HudTextDraw(HudText *hud, const char *text, int x, int y, int fontSize, Color color);
+
+// Draws everything queued in one batch (hudtext_draw.c, needs Raylib)
+void HudTextFlush(HudText *hud);
+
+// Lays text out without the cache, as DrawText does every call. Writes up to
+// maxOut quads and returns how many the text has.
+int HudTextLayout(const HudText *hud, const char *text, int fontSize, HudGlyphQuad *out, int maxOut, int *width);
+
+void HudTextResetStats(HudText *hud);
+
+#endif
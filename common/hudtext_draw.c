@@ -0,0 +1,37 @@
+#include "hudtext.h"
+#include "rlgl.h"
+
+// The quads DrawTexturePro would emit for each glyph, all inside one
+// rlBegin/rlEnd on the font texture
+void HudTextFlush(HudText *hud) {
+    if (hud->queueCount == 0) return;
+    const Texture2D *texture = &hud->font.texture;
+    float invWidth = 1.0f/(float)texture->width;
+    float invHeight = 1.0f/(float)texture->height;
+
+    rlCheckRenderBatchLimit(4*hud->queueCount);
+    rlSetTexture(texture->id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for (int i = 0; i < hud->queueCount; i++) {
+        const Rectangle *s = &hud->queue[i].source;
+        const Rectangle *d = &hud->queue[i].dest;
+        Color c = hud->queueColors[i];
+        rlColor4ub(c.r, c.g, c.b, c.a);
+
+        rlTexCoord2f(s->x*invWidth, s->y*invHeight);
+        rlVertex2f(d->x, d->y);
+        rlTexCoord2f(s->x*invWidth, (s->y + s->height)*invHeight);
+        rlVertex2f(d->x, d->y + d->height);
+        rlTexCoord2f((s->x + s->width)*invWidth, (s->y + s->height)*invHeight);
+        rlVertex2f(d->x + d->width, d->y + d->height);
+        rlTexCoord2f((s->x + s->width)*invWidth, s->y*invHeight);
+        rlVertex2f(d->x + d->width, d->y);
+    }
+    rlEnd();
+    rlSetTexture(0);
+
+    hud->flushes++;
+    hud->flushedQuads += hud->queueCount;
+    hud->queueCount = 0;
+}
@@ -0,0 +1,202 @@
+#include "jobs.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define JOBS_MAX_THREADS 64
+
+// begin | end << 32 of the indices a thread has left, on its own cache line
+typedef struct {
+    _Alignas(64) atomic_uint_least64_t range;
+} JobRange;
+
+typedef struct {
+    JobSystem *jobs;
+    int thread;
+} JobWorker;
+
+struct JobSystem {
+    pthread_t threads[JOBS_MAX_THREADS];
+    JobWorker workers[JOBS_MAX_THREADS];
+    int threadCount;
+    JobRange ranges[JOBS_MAX_THREADS];
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned generation;
+    int busyWorkers;
+    bool quit;
+
+    JobFunc job;
+    void *ctx;
+    atomic_llong steals;
+};
+
+static uint64_t PackRange(uint32_t begin, uint32_t end) {
+    return (uint64_t)begin | (uint64_t)end << 32;
+}
+
+// Takes the first index of the thread's own range, or returns -1 when empty
+static int TakeOwn(JobRange *own) {
+    uint64_t range = atomic_load_explicit(&own->range, memory_order_acquire);
+    for (;;) {
+        uint32_t begin = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (begin >= end) return -1;
+        if (atomic_compare_exchange_weak_explicit(&own->range, &range, PackRange(begin + 1, end),
+                                                  memory_order_acq_rel, memory_order_acquire)) {
+            return (int)begin;
+        }
+    }
+}
+
+// Moves the back half of the fullest other range into this thread's own
+static bool Steal(JobSystem *jobs, int thread) {
+    for (;;) {
+        int victim = -1;
+        uint64_t victimRange = 0;
+        uint32_t most = 0;
+        for (int i = 1; i < jobs->threadCount; i++) {
+            int t = (thread + i) % jobs->threadCount;
+            uint64_t range = atomic_load_explicit(&jobs->ranges[t].range, memory_order_acquire);
+            uint32_t begin = (uint32_t)range, end = (uint32_t)(range >> 32);
+            if (end > begin && end - begin > most) {
+                most = end - begin;
+                victim = t;
+                victimRange = range;
+            }
+        }
+        if (victim < 0) return false;
+
+        uint32_t begin = (uint32_t)victimRange, end = (uint32_t)(victimRange >> 32);
+        uint32_t middle = begin + (end - begin)/2;
+        if (atomic_compare_exchange_strong_explicit(&jobs->ranges[victim].range, &victimRange, PackRange(begin, middle),
+                                                    memory_order_acq_rel, memory_order_acquire)) {
+            // Nobody steals from an empty range, so this one is ours to write
+            atomic_store_explicit(&jobs->ranges[thread].range, PackRange(middle, end), memory_order_release);
+            atomic_fetch_add_explicit(&jobs->steals, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+static void Work(JobSystem *jobs, int thread) {
+    JobRange *own = &jobs->ranges[thread];
+    do {
+        int index;
+        while ((index = TakeOwn(own)) >= 0) jobs->job(jobs->ctx, index, thread);
+    } while (Steal(jobs, thread));
+}
+
+static void *WorkerMain(void *arg) {
+    JobWorker *worker = arg;
+    JobSystem *jobs = worker->jobs;
+    unsigned seen = 0;
+
+    pthread_mutex_lock(&jobs->lock);
+    for (;;) {
+        while (!jobs->quit && jobs->generation == seen) pthread_cond_wait(&jobs->wake, &jobs->lock);
+        if (jobs->quit) break;
+
+        seen = jobs->generation;
+        pthread_mutex_unlock(&jobs->lock);
+
+        Work(jobs, worker->thread);
+
+        pthread_mutex_lock(&jobs->lock);
+        if (--jobs->busyWorkers == 0) pthread_cond_signal(&jobs->done);
+    }
+    pthread_mutex_unlock(&jobs->lock);
+    return NULL;
+}
+
+JobSystem *JobSystemCreate(int threadCount) {
+    JobSystem *jobs = calloc(1, sizeof(JobSystem));
+    if (!jobs) return NULL;
+
+    if (threadCount < 1) threadCount = JobSystemCoreCount();
+    jobs->threadCount = (threadCount > JOBS_MAX_THREADS) ? JOBS_MAX_THREADS : threadCount;
+    pthread_mutex_init(&jobs->lock, NULL);
+    pthread_cond_init(&jobs->wake, NULL);
+    pthread_cond_init(&jobs->done, NULL);
+
+    // Runs on the threads that did start; with none but this one every run
+    // is serial. Workers only read threadCount once a run wakes them.
+    int started = 1;
+    while (started < jobs->threadCount) {
+        jobs->workers[started] = (JobWorker){ jobs, started };
+        if (pthread_create(&jobs->threads[started], NULL, WorkerMain, &jobs->workers[started]) != 0) break;
+        started++;
+    }
+    jobs->threadCount = started;
+    return jobs;
+}
+
+void JobSystemDestroy(JobSystem *jobs) {
+    if (!jobs) return;
+
+    pthread_mutex_lock(&jobs->lock);
+    jobs->quit = true;
+    pthread_cond_broadcast(&jobs->wake);
+    pthread_mutex_unlock(&jobs->lock);
+
+    for (int i = 1; i < jobs->threadCount; i++) pthread_join(jobs->threads[i], NULL);
+
+    pthread_cond_destroy(&jobs->done);
+    pthread_cond_destroy(&jobs->wake);
+    pthread_mutex_destroy(&jobs->lock);
+    free(jobs);
+}
+
+int JobSystemSize(const JobSystem *jobs) {
+    return jobs->threadCount;
+}
+
+long long JobSystemSteals(const JobSystem *jobs) {
+    return atomic_load_explicit((atomic_llong *)&jobs->steals, memory_order_relaxed);
+}
+
+void JobSystemRun(JobSystem *jobs, JobFunc job, void *ctx, int count) {
+    if (jobs->threadCount == 1 || count <= 1) {
+        for (int i = 0; i < count; i++) job(ctx, i, 0);
+        return;
+    }
+
+    for (int t = 0; t < jobs->threadCount; t++) {
+        uint32_t begin = (uint32_t)((long long)count*t/jobs->threadCount);
+        uint32_t end = (uint32_t)((long long)count*(t + 1)/jobs->threadCount);
+        atomic_store_explicit(&jobs->ranges[t].range, PackRange(begin, end), memory_order_relaxed);
+    }
+
+    pthread_mutex_lock(&jobs->lock);
+    jobs->job = job;
+    jobs->ctx = ctx;
+    jobs->busyWorkers = jobs->threadCount - 1;
+    jobs->generation++;
+    pthread_cond_broadcast(&jobs->wake);
+    pthread_mutex_unlock(&jobs->lock);
+
+    Work(jobs, 0);
+
+    pthread_mutex_lock(&jobs->lock);
+    while (jobs->busyWorkers > 0) pthread_cond_wait(&jobs->done, &jobs->lock);
+    pthread_mutex_unlock(&jobs->lock);
+}
+
+int JobSystemCoreCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int count = (int)info.dwNumberOfProcessors;
+#else
+    int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return (count < 1) ? 1 : count;
+}
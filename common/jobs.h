@@ -0,0 +1,30 @@
+#ifndef COMMON_JOBS_H
+#define COMMON_JOBS_H
+
+// Work-stealing job system. JobSystemRun splits the indices of a job evenly
+// between the threads; each thread works through its own range from the
+// front, and a thread that runs out steals the back half of the fullest
+// range it finds. Ranges are packed into one atomic word per thread, so
+// taking and stealing are single compare-and-swaps with no locks. The caller
+// is thread 0 and works too, so a system of N threads starts N-1 workers.
+
+typedef void (*JobFunc)(void *ctx, int index, int thread);
+
+typedef struct JobSystem JobSystem;
+
+// threadCount < 1 means one per core
+JobSystem *JobSystemCreate(int threadCount);
+void JobSystemDestroy(JobSystem *jobs);
+int JobSystemSize(const JobSystem *jobs);
+
+// Runs job(ctx, i, thread) for every i in [0, count) and returns when all are
+// done. thread is in [0, JobSystemSize) and no two calls at the same time
+// share it, so it can pick per-thread scratch space.
+void JobSystemRun(JobSystem *jobs, JobFunc job, void *ctx, int count);
+
+// Successful steals since the system was created
+long long JobSystemSteals(const JobSystem *jobs);
+
+int JobSystemCoreCount(void);
+
+#endif
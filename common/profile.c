@@ -0,0 +1,247 @@
+// clock_gettime and pthreads are POSIX, not C11
+#define _POSIX_C_SOURCE 200112L
+
+#include "profile.h"
+
+#ifdef PROFILE_ENABLED
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#define NOUSER
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+typedef struct {
+    int zone;
+    long long start;
+    long long end;
+} ProfileEvent;
+
+// Written only by its owner; head counts every event ever written. A ring
+// whose thread exited keeps its events until another thread takes it over.
+typedef struct {
+    ProfileEvent events[PROFILE_RING_SIZE];
+    atomic_llong head;
+    int id;
+    bool owned;
+} ProfileRing;
+
+typedef struct {
+    const char *name;
+    atomic_llong frameNs;           // added to by every thread during a frame
+    long long history[PROFILE_HISTORY];
+} ProfileZone;
+
+static pthread_mutex_t profileLock = PTHREAD_MUTEX_INITIALIZER;
+static ProfileZone zones[PROFILE_MAX_ZONES];
+static atomic_int zoneCount;
+static ProfileRing *rings[PROFILE_MAX_THREADS];
+static atomic_int ringCount;
+static _Thread_local ProfileRing *threadRing;
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t ringKey;       // only there for its destructor
+
+// Frame totals: history[frame % PROFILE_HISTORY] for every zone
+static long long frameHistory[PROFILE_HISTORY];
+static long long frameCount;
+static long long frameStart;
+
+static long long NowNs(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&now);
+    return (long long)((double)now.QuadPart*1e9/(double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec*1000000000ll + ts.tv_nsec;
+#endif
+}
+
+static int RegisterZone(const char *name) {
+    pthread_mutex_lock(&profileLock);
+    int count = atomic_load(&zoneCount);
+    int zone = 0;
+    while (zone < count && strcmp(zones[zone].name, name) != 0) zone++;
+    if (zone == count) {
+        if (count == PROFILE_MAX_ZONES) {
+            zone = -1;
+        } else {
+            zones[zone].name = name;
+            atomic_store(&zoneCount, count + 1);
+        }
+    }
+    pthread_mutex_unlock(&profileLock);
+    return zone;
+}
+
+static void ReleaseRing(void *ring) {
+    pthread_mutex_lock(&profileLock);
+    ((ProfileRing *)ring)->owned = false;
+    pthread_mutex_unlock(&profileLock);
+}
+
+static void CreateRingKey(void) {
+    pthread_key_create(&ringKey, ReleaseRing);
+}
+
+// A ring left by a thread that exited, or a new one while there is room, so
+// job systems that come and go do not use up the rings
+static ProfileRing *RegisterThread(void) {
+    pthread_once(&ringKeyOnce, CreateRingKey);
+    pthread_mutex_lock(&profileLock);
+    ProfileRing *ring = NULL;
+    int count = atomic_load(&ringCount);
+    for (int i = 0; i < count && !ring; i++) {
+        if (!rings[i]->owned) ring = rings[i];
+    }
+    if (!ring && count < PROFILE_MAX_THREADS && (ring = calloc(1, sizeof(ProfileRing)))) {
+        ring->id = count;
+        rings[count] = ring;
+        atomic_store(&ringCount, count + 1);
+    }
+    if (ring) ring->owned = true;
+    pthread_mutex_unlock(&profileLock);
+    if (ring) pthread_setspecific(ringKey, ring);
+    return ring;
+}
+
+ProfileScope ProfileBegin(atomic_int *zone, const char *name) {
+    int id = atomic_load_explicit(zone, memory_order_relaxed);
+    if (id < 0) {
+        // Threads racing here all get the same id back
+        id = RegisterZone(name);
+        atomic_store_explicit(zone, id, memory_order_relaxed);
+    }
+    return (ProfileScope){ id, NowNs() };
+}
+
+void ProfileEnd(ProfileScope *scope) {
+    if (scope->zone < 0) return;
+    long long end = NowNs();
+    atomic_fetch_add_explicit(&zones[scope->zone].frameNs, end - scope->start, memory_order_relaxed);
+
+    if (!threadRing) threadRing = RegisterThread();
+    ProfileRing *ring = threadRing;
+    if (!ring) return;
+    long long head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ring->events[head % PROFILE_RING_SIZE] = (ProfileEvent){ scope->zone, scope->start, end };
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void ProfileFrameEnd(void) {
+    long long now = NowNs();
+    if (frameStart != 0) {
+        int slot = (int)(frameCount % PROFILE_HISTORY);
+        frameHistory[slot] = now - frameStart;
+        int count = atomic_load(&zoneCount);
+        for (int i = 0; i < count; i++) zones[i].history[slot] = atomic_exchange(&zones[i].frameNs, 0);
+        frameCount++;
+    }
+    frameStart = now;
+}
+
+static int CompareLongLong(const void *a, const void *b) {
+    long long x = *(const long long *)a, y = *(const long long *)b;
+    return (x > y) - (x < y);
+}
+
+static ProfileZoneStats Stats(const char *name, const long long *history) {
+    ProfileZoneStats stats = { name, 0.0, 0.0, 0.0 };
+    int count = frameCount < PROFILE_HISTORY ? (int)frameCount : PROFILE_HISTORY;
+    if (count == 0) return stats;
+
+    long long sorted[PROFILE_HISTORY];
+    memcpy(sorted, history, count*sizeof(long long));
+    qsort(sorted, count, sizeof(long long), CompareLongLong);
+    stats.lastMs = (double)history[(frameCount - 1) % PROFILE_HISTORY]*1e-6;
+    stats.p50Ms = (double)sorted[count/2]*1e-6;
+    stats.p99Ms = (double)sorted[(count*99)/100]*1e-6;
+    return stats;
+}
+
+int ProfileGetStats(ProfileZoneStats *out, int maxOut) {
+    int count = atomic_load(&zoneCount);
+    int written = 0;
+    if (written < maxOut) out[written++] = Stats("frame", frameHistory);
+    for (int i = 0; i < count && written < maxOut; i++) out[written++] = Stats(zones[i].name, zones[i].history);
+    return written;
+}
+
+static void WriteJsonString(FILE *file, const char *text) {
+    fputc('"', file);
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\') fputc('\\', file);
+        if ((unsigned char)*text >= 0x20) fputc(*text, file);
+    }
+    fputc('"', file);
+}
+
+bool ProfileWriteChromeTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+
+    // Times count from the oldest event kept, so none come out negative
+    int threads = atomic_load(&ringCount);
+    long long origin = 0;
+    for (int t = 0; t < threads; t++) {
+        ProfileRing *ring = rings[t];
+        long long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        long long oldest = head > PROFILE_RING_SIZE ? head - PROFILE_RING_SIZE : 0;
+        for (long long e = oldest; e < head; e++) {
+            long long start = ring->events[e % PROFILE_RING_SIZE].start;
+            if (origin == 0 || start < origin) origin = start;
+        }
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    for (int t = 0; t < threads; t++) {
+        ProfileRing *ring = rings[t];
+        // The first thread to record a zone is normally the main one
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", ring->id, ring->id);
+        first = false;
+
+        long long head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        long long oldest = head > PROFILE_RING_SIZE ? head - PROFILE_RING_SIZE : 0;
+        for (long long e = oldest; e < head; e++) {
+            const ProfileEvent *event = &ring->events[e % PROFILE_RING_SIZE];
+            fprintf(file, ",\n{\"name\":");
+            WriteJsonString(file, zones[event->zone].name);
+            // Chrome trace times are in microseconds
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    ring->id, (double)(event->start - origin)*1e-3, (double)(event->end - event->start)*1e-3);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+void ProfileShutdown(void) {
+    pthread_mutex_lock(&profileLock);
+    int count = atomic_load(&ringCount);
+    for (int i = 0; i < count; i++) {
+        free(rings[i]);
+        rings[i] = NULL;
+    }
+    atomic_store(&ringCount, 0);
+    threadRing = NULL;
+    pthread_mutex_unlock(&profileLock);
+    // The calling thread's ring is gone; its exit must not touch it
+    pthread_once(&ringKeyOnce, CreateRingKey);
+    pthread_setspecific(ringKey, NULL);
+}
+
+#endif
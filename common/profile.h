@@ -0,0 +1,94 @@
+#ifndef COMMON_PROFILE_H
+#define COMMON_PROFILE_H
+
+#include <stdbool.h>
+
+// Scoped timing zones shared by both games. Build with -DPROFILE and add
+// profile.c (and profile_overlay.c for the on-screen table) to record them;
+// without it every macro below compiles to nothing and the functions are
+// empty inline stubs, so the zones can stay in the code.
+//
+//     { PROFILE_ZONE("physics"); ... }   // timed until the end of the block
+//     PROFILE_BEGIN(hud, "hud"); ... PROFILE_END(hud);
+//
+// Each thread writes finished zones into its own ring of the last
+// PROFILE_RING_SIZE events (handed on to a later thread once it exits), and
+// every zone adds its time to a per-frame total. ProfileFrameEnd closes the
+// frame and keeps the totals of the last PROFILE_HISTORY frames for the
+// p50/p99 table. Zones need GCC or Clang (cleanup attribute); other
+// compilers build them as no-ops.
+
+#define PROFILE_MAX_ZONES 32
+#define PROFILE_MAX_THREADS 64
+#define PROFILE_RING_SIZE 16384
+#define PROFILE_HISTORY 256
+
+typedef struct {
+    const char *name;
+    double lastMs;      // total in the last finished frame
+    double p50Ms;
+    double p99Ms;
+} ProfileZoneStats;
+
+#if defined(PROFILE) && (defined(__GNUC__) || defined(__clang__))
+#define PROFILE_ENABLED 1
+#endif
+
+#ifdef PROFILE_ENABLED
+
+#include <stdatomic.h>
+
+typedef struct {
+    int zone;
+    long long start;
+} ProfileScope;
+
+// Zones are registered by name on first use, so the same name from two call
+// sites is one zone. zone is shared by every thread passing that call site.
+ProfileScope ProfileBegin(atomic_int *zone, const char *name);
+void ProfileEnd(ProfileScope *scope);
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) \
+    static atomic_int PROFILE_CONCAT(profileZone, __LINE__) = -1; \
+    ProfileScope PROFILE_CONCAT(profileScope, __LINE__) __attribute__((cleanup(ProfileEnd))) = \
+        ProfileBegin(&PROFILE_CONCAT(profileZone, __LINE__), name)
+
+// For stretches of code that are not a block of their own
+#define PROFILE_BEGIN(id, name) \
+    static atomic_int profileZone_##id = -1; \
+    ProfileScope profileScope_##id = ProfileBegin(&profileZone_##id, name)
+#define PROFILE_END(id) ProfileEnd(&profileScope_##id)
+
+void ProfileFrameEnd(void);
+
+// Stats for up to maxOut zones, the whole frame first; returns how many
+int ProfileGetStats(ProfileZoneStats *out, int maxOut);
+
+// Table of zone times, drawn with Raylib (profile_overlay.c)
+void ProfileDrawOverlay(int x, int y);
+
+// Every event still in the rings as Chrome trace JSON (chrome://tracing or
+// ui.perfetto.dev). Call it between frames; rings still being written from
+// other threads may show torn events.
+bool ProfileWriteChromeTrace(const char *path);
+
+// Frees every ring. Only once no other thread records zones, e.g. at exit.
+void ProfileShutdown(void);
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_BEGIN(id, name) ((void)0)
+#define PROFILE_END(id) ((void)0)
+
+static inline void ProfileFrameEnd(void) {}
+static inline int ProfileGetStats(ProfileZoneStats *out, int maxOut) { (void)out; (void)maxOut; return 0; }
+static inline void ProfileDrawOverlay(int x, int y) { (void)x; (void)y; }
+static inline bool ProfileWriteChromeTrace(const char *path) { (void)path; return false; }
+static inline void ProfileShutdown(void) {}
+
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+#include "profile.h"
+
+#ifdef PROFILE_ENABLED
+
+#include "raylib.h"
+
+void ProfileDrawOverlay(int x, int y) {
+    ProfileZoneStats stats[PROFILE_MAX_ZONES + 1];
+    int count = ProfileGetStats(stats, PROFILE_MAX_ZONES + 1);
+
+    DrawRectangle(x, y, 300, 30 + 18*count, Fade(BLACK, 0.7f));
+    DrawText("zone            last    p50    p99 ms", x + 10, y + 8, 10, LIGHTGRAY);
+    for (int i = 0; i < count; i++) {
+        int rowY = y + 26 + 18*i;
+        DrawText(stats[i].name, x + 10, rowY, 10, i == 0 ? YELLOW : WHITE);
+        DrawText(TextFormat("%6.2f %6.2f %6.2f", stats[i].lastMs, stats[i].p50Ms, stats[i].p99Ms), x + 130, rowY, 10, i == 0 ? YELLOW : WHITE);
+    }
+}
+
+#endif